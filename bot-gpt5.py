@@ -158,6 +158,9 @@ async def run_bot(transport: BaseTransport, runner_args: RunnerArguments):
         logger.info(f"!!! Client message: {message}")
         if message.type == "mute-unmute":
             mute = message.data.get("mute", True)
+            # In-engine capture gate when the transport has one
+            if getattr(transport, "set_input_muted", None) and transport.set_input_muted(bool(mute)):
+                return
             if mute:
                 await transport.input().process_frame(StopFrame(), FrameDirection.DOWNSTREAM)
             else:
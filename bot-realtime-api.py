@@ -157,12 +157,11 @@ async def run_bot(transport: BaseTransport, runner_args: RunnerArguments):
             if d.get("type") != "mute-unmute":
                 return
             mute = bool(d.get("mute"))
-            if mute:
-                await transport.input().process_frame(StopFrame(), FrameDirection.DOWNSTREAM)
-                logger.info("Input muted via client-message")
-            else:
-                await transport.input().process_frame(StartFrame(), FrameDirection.DOWNSTREAM)
-                logger.info("Input unmuted via client-message")
+            # In-engine capture gate when available; else restart the input
+            if not (getattr(transport, "set_input_muted", None) and transport.set_input_muted(mute)):
+                frame = StopFrame() if mute else StartFrame()
+                await transport.input().process_frame(frame, FrameDirection.DOWNSTREAM)
+            logger.info(f"Input {'muted' if mute else 'unmuted'} via client-message")
         except Exception:
             logger.exception("Error handling client-message (mute-unmute)")
 
@@ -110,6 +110,14 @@ async def run_bot(transport: BaseTransport, runner_args: RunnerArguments):
     async def on_client_disconnected(transport, client):
         await task.cancel()
 
+    async def set_input_muted(mute: bool):
+        # In-engine capture gate when the transport has one; otherwise stop
+        # and restart the input
+        if getattr(transport, "set_input_muted", None) and transport.set_input_muted(mute):
+            return
+        frame = StopFrame() if mute else StartFrame()
+        await transport.input().process_frame(frame, FrameDirection.DOWNSTREAM)
+
     @rtvi.event_handler("on_client_message")
     async def on_client_message(rtvi, message):
         # called for rtvi-ai messages of type "client-message"
@@ -118,12 +126,8 @@ async def run_bot(transport: BaseTransport, runner_args: RunnerArguments):
         if getattr(message, "type", None) == "mute-unmute":
             try:
                 mute = bool(getattr(message, "data", {}).get("mute"))
-                if mute:
-                    await transport.input().process_frame(StopFrame(), FrameDirection.DOWNSTREAM)
-                    logger.info("Input muted via client-message (typed)")
-                else:
-                    await transport.input().process_frame(StartFrame(), FrameDirection.DOWNSTREAM)
-                    logger.info("Input unmuted via client-message (typed)")
+                await set_input_muted(mute)
+                logger.info(f"Input {'muted' if mute else 'unmuted'} via client-message (typed)")
             except Exception:
                 logger.exception("Failed to toggle mute from client-message (typed)")
         elif message.type == "llm-input":
@@ -134,16 +138,8 @@ async def run_bot(transport: BaseTransport, runner_args: RunnerArguments):
             if isinstance(d, dict) and d.get("type") == "mute-unmute":
                 try:
                     mute = bool(d.get("mute"))
-                    if mute:
-                        await transport.input().process_frame(
-                            StopFrame(), FrameDirection.DOWNSTREAM
-                        )
-                        logger.info("Input muted via client-message")
-                    else:
-                        await transport.input().process_frame(
-                            StartFrame(), FrameDirection.DOWNSTREAM
-                        )
-                        logger.info("Input unmuted via client-message")
+                    await set_input_muted(mute)
+                    logger.info(f"Input {'muted' if mute else 'unmuted'} via client-message")
                 except Exception:
                     logger.exception("Failed to toggle mute from client-message")
             else:
@@ -1,12 +1,20 @@
 from __future__ import annotations
 
 import asyncio
+import collections
+import importlib.machinery
+import importlib.util
+import math
 import os
 import platform
+import subprocess
+import time
+from types import SimpleNamespace
 from typing import Any, Optional, Set
 
 from loguru import logger
 
+from pipecat.audio.vad.vad_analyzer import VADState
 from pipecat.frames.frames import (
     InputAudioRawFrame,
     OutputAudioRawFrame,
@@ -21,10 +29,23 @@ from pipecat.transports.base_output import BaseOutputTransport
 from pipecat.transports.base_transport import BaseTransport, TransportParams
 
 
+# vpio_frame_info.flags (see vpio_helper.c)
+_FRAME_OVERRUN = 1
+_FRAME_VAD_KNOWN = 2
+_FRAME_VAD_OPEN = 4
+_FRAME_KEEPALIVE = 8
+
+
 def _is_macos():
     return platform.system() == "Darwin"
 
 
+def _default_lib_path() -> str:
+    # Off macOS the helper builds as a shared object with only the replay device
+    name = "libvpio.dylib" if _is_macos() else "libvpio.so"
+    return os.path.abspath(os.path.join("./macos", name))
+
+
 class LocalMacTransportParams(TransportParams):
     audio_in_sample_rate: Optional[int] = 16000
     audio_out_sample_rate: Optional[int] = 16000
@@ -34,23 +55,95 @@ class LocalMacTransportParams(TransportParams):
     audio_out_10ms_chunks: int = 1
     # Ring buffer capacity in seconds (approx)
     ring_capacity_secs: float = 2.0
+    # Staging ring (10 ms frames waiting for the playback pacer) grows on
+    # bursts up to staging_budget_secs (0 = unbounded; frames past it are
+    # refused) and halves back toward its start size once the backlog has
+    # stayed small for staging_shrink_after_ms (0 = never).
+    staging_budget_secs: float = 0.0
+    staging_shrink_after_ms: int = 2000
+    # Bounded playback: once playback_max_ahead_secs of audio is queued,
+    # write_audio_frame waits for the helper's writable event (the backlog
+    # drained to half) instead of buffering more, which paces a fast TTS to
+    # real time. 0 = unbounded.
+    playback_max_ahead_secs: float = 0.0
     # Playback pacing parameters
     preroll_ms: int = 40
     slice_ms: int = 5
     playback_headroom_ms: int = 10
+    # Native VAD pre-gate: skip the (neural) VAD analyzer on frames the helper
+    # classifies as clear silence. Hangover should cover the analyzer's stop_secs.
+    vad_pregate: bool = False
+    vad_pregate_margin_db: float = 9.0
+    vad_pregate_hangover_ms: int = 1000
+    vad_pregate_onset_blocks: int = 1
+    # Frames replayed into the analyzer when the gate opens (onset lookback)
+    vad_pregate_lookback_ms: int = 300
+    # Discontinuous transmission: don't forward frames the pre-gate marks as
+    # silence. The next forwarded frame carries the skipped sample count in
+    # metadata["vpio_silence_samples"]; a keepalive frame is sent every
+    # dtx_keepalive_ms (0 = never).
+    dtx: bool = False
+    dtx_keepalive_ms: int = 1000
+    # Capture frame duration delivered by the helper (engine-side framing)
+    capture_frame_ms: int = 20
+    # Software echo canceller in the helper, fed with what was actually played.
+    # Runs on top of Apple's voice processing (VPIO_BYPASS_VP=1 disables the
+    # latter to evaluate it alone). software_aec_delay_ms is bulk delay on the
+    # reference (-1 = follow the delay estimator); software_aec_tail_ms the
+    # echo path length covered.
+    software_aec: bool = False
+    software_aec_tail_ms: int = 128
+    software_aec_delay_ms: int = 0
+    # Render -> capture delay estimator (reported in VPIO_DEBUG pacer logs)
+    delay_estimator: bool = False
+    delay_estimator_max_ms: int = 0
+    # Capture noise suppressor in the helper (works with Apple processing
+    # bypassed). Blocks over the CPU budget (percent of block time) make it
+    # reuse its previous gains for a while instead of re-estimating.
+    noise_suppression: bool = False
+    noise_suppression_max_db: float = 20.0
+    noise_suppression_budget_pct: int = 30
+    # Engine-side AGC + lookahead limiter. Capture steers speech to
+    # agc_target_dbfs (boosting at most agc_max_gain_db); playback is
+    # limiter-only unless playback_agc_target_dbfs < 0.
+    agc: bool = False
+    agc_target_dbfs: float = -20.0
+    agc_max_gain_db: float = 24.0
+    playback_agc: bool = False
+    playback_agc_target_dbfs: float = 0.0
+    limiter_ceiling_dbfs: float = -1.0
+    # Session recorder: raw mic, processed capture and played audio written by
+    # a helper thread to <record_path>-*.wav ("wav") or <record_path>.vprec
+    # ("framed", with per-block timestamps). VPIO_RECORD sets a path too.
+    record_path: Optional[str] = None
+    record_format: str = "wav"
+    # File replay device instead of the audio unit (regression runs; works on
+    # Linux too). Capture comes from replay_capture_path (16-bit WAV or raw
+    # PCM) and what the engine plays goes to replay_playback_path (WAV if it
+    # ends in .wav, else raw). replay_realtime=False runs as fast as the
+    # reader keeps up (capture-side runs: the playback pacer stays on the wall
+    # clock); replay_block_frames cycles irregular callback sizes.
+    replay_capture_path: Optional[str] = None
+    replay_playback_path: Optional[str] = None
+    replay_realtime: bool = True
+    replay_block_frames: Optional[list[int]] = None
+    # Helper binding: "extension" (_vpio module), "ctypes" (libvpio.dylib),
+    # "daemon" (engine in a separate vpiod process over shared memory) or
+    # "auto" (extension if built, else ctypes). VPIO_BINDING overrides.
+    engine_binding: str = "auto"
 
 
 class _VPIOLib:
-    def __init__(self, lib_path: Optional[str] = None):
-        if not _is_macos():
-            raise RuntimeError("LocalMacTransport only supported on macOS")
+    def __init__(self, lib_path: Optional[str] = None, replay: bool = False):
+        if not _is_macos() and not replay:
+            raise RuntimeError("LocalMacTransport only supported on macOS (or with a replay device)")
         import ctypes as C
 
         # Resolve dylib path
-        lib_path = lib_path or os.getenv("VPIO_LIB", os.path.abspath("./macos/libvpio.dylib"))
+        lib_path = lib_path or os.getenv("VPIO_LIB", _default_lib_path())
         if not os.path.exists(lib_path):
             raise FileNotFoundError(
-                f"VPIO helper library not found at {lib_path}. Build it with: clang -dynamiclib -o macos/libvpio.dylib macos/vpio_helper.c -framework AudioToolbox -framework AudioUnit"
+                f"VPIO helper library not found at {lib_path}. Build it with: make -C macos"
             )
         self.C = C
         self.path = lib_path
@@ -60,60 +153,349 @@ class _VPIOLib:
         self.lib.vpio_init.argtypes = [C.c_double, C.c_int]
         self.lib.vpio_init.restype = C.c_int
 
-        # Streaming API (optional: implemented below in C helper)
-        # vpio_start_stream(double sr, int ch, size_t capBytes)
+        # Capability bitmask (newer helpers) decides which optional groups are
+        # bound; a symbol missing from an advertised group is a broken build
+        # and raises. Helpers from before the bitmask are probed instead.
         try:
-            self.lib.vpio_start_stream.argtypes = [C.c_double, C.c_int, C.c_size_t]
-            self.lib.vpio_start_stream.restype = C.c_int
-            self.has_stream = True
-        except Exception:
-            self.has_stream = False
+            self.lib.vpio_get_capabilities.argtypes = []
+            self.lib.vpio_get_capabilities.restype = C.c_uint32
+            self._caps: Optional[int] = int(self.lib.vpio_get_capabilities())
+        except AttributeError:
+            self._caps = None
 
-        # vpio_stop_stream()
-        try:
-            self.lib.vpio_stop_stream.argtypes = []
-            self.lib.vpio_stop_stream.restype = None
-        except Exception:
-            pass
+        # Streaming API: vpio_start_stream, read_capture, write_playback
+        self.has_stream = self._bind(
+            _CAP_STREAM,
+            ("vpio_start_stream", [C.c_double, C.c_int, C.c_size_t], C.c_int),
+            ("vpio_stop_stream", [], None),
+            ("vpio_read_capture", [C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_write_playback", [C.c_void_p, C.c_size_t], C.c_size_t),
+        )
+        # C-paced playback thread fed in 10 ms frames
+        self.has_play_thread = self._bind(
+            _CAP_PLAY_THREAD,
+            ("vpio_write_frame_10ms", [C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_start_playback_thread", [C.c_int, C.c_int], C.c_int),
+            ("vpio_stop_playback_thread", [], None),
+            ("vpio_set_target_headroom_ms", [C.c_int], None),
+        )
+        self.has_write_10ms = self.has_play_thread
+        # Flush of the playback and staging rings
+        self.has_flush = self._bind(_CAP_FLUSH, ("vpio_flush_playback", [], None))
+        self.has_flush_input = self._bind(_CAP_FLUSH, ("vpio_flush_input", [], None))
 
-        # vpio_read_capture(void* dst, size_t maxlen) -> size_t
-        try:
-            self.lib.vpio_read_capture.argtypes = [C.c_void_p, C.c_size_t]
-            self.lib.vpio_read_capture.restype = C.c_size_t
-        except Exception:
-            pass
+        # Native VAD pre-gate
+        self.has_vad_gate = self._bind(
+            _CAP_VAD_GATE,
+            ("vpio_set_vad_gate", [C.c_int, C.c_double, C.c_int, C.c_int], None),
+            ("vpio_vad_gate_query", [C.c_size_t, C.c_size_t], C.c_int),
+            ("vpio_get_vad_stats", [C.POINTER(C.c_size_t), C.POINTER(C.c_size_t)], None),
+            ("vpio_read_capture_pos", [C.c_void_p, C.c_size_t, C.POINTER(C.c_size_t)], C.c_size_t),
+        )
+        # Engine-side capture framing
+        class FrameInfo(C.Structure):
+            _fields_ = [
+                ("seq", C.c_uint64),
+                ("sample_index", C.c_uint64),
+                ("host_time_ns", C.c_uint64),
+                ("flags", C.c_uint32),
+                ("silence_before", C.c_uint32),
+            ]
 
-        # vpio_write_playback(const void* src, size_t len) -> size_t
-        try:
-            self.lib.vpio_write_playback.argtypes = [C.c_void_p, C.c_size_t]
-            self.lib.vpio_write_playback.restype = C.c_size_t
-        except Exception:
-            pass
+        self.FrameInfo = FrameInfo
+        self.has_frames = self._bind(
+            _CAP_FRAMES,
+            ("vpio_set_capture_frame_ms", [C.c_int], C.c_size_t),
+            ("vpio_read_frame", [C.c_void_p, C.c_size_t, C.POINTER(FrameInfo)], C.c_size_t),
+            ("vpio_host_time_now_ns", [], C.c_uint64),
+        )
+        self.has_read_frames = self.has_frames and self._bind(
+            _CAP_FRAMES,
+            ("vpio_read_frames", [C.c_void_p, C.c_size_t, C.c_size_t, C.POINTER(FrameInfo)], C.c_size_t),
+        )
 
-        # New C-paced playback APIs (optional)
-        try:
-            self.lib.vpio_write_frame_10ms.argtypes = [C.c_void_p, C.c_size_t]
-            self.lib.vpio_write_frame_10ms.restype = C.c_size_t
-            self.has_write_10ms = True
-        except Exception:
-            self.has_write_10ms = False
-        try:
-            self.lib.vpio_start_playback_thread.argtypes = [C.c_int, C.c_int]
-            self.lib.vpio_start_playback_thread.restype = C.c_int
-            self.lib.vpio_stop_playback_thread.argtypes = []
-            self.lib.vpio_stop_playback_thread.restype = None
-            self.lib.vpio_set_target_headroom_ms.argtypes = [C.c_int]
-            self.lib.vpio_set_target_headroom_ms.restype = None
-            # Optional flush for staging ring
-            try:
-                self.lib.vpio_flush_input.argtypes = []
-                self.lib.vpio_flush_input.restype = None
-                self.has_flush_input = True
-            except Exception:
-                self.has_flush_input = False
-            self.has_play_thread = True
-        except Exception:
-            self.has_play_thread = False
+        # Single-call stats snapshot; fields mirror vpio_stats
+        class Stats(C.Structure):
+            _fields_ = [
+                (name, C.c_uint64)
+                for name in (
+                    "cap_level",
+                    "cap_capacity",
+                    "play_level",
+                    "play_capacity",
+                    "staging_level",
+                    "staging_capacity",
+                    "underflows",
+                    "render_last_bytes",
+                    "render_max_bytes",
+                    "vad_blocks",
+                    "vad_open_blocks",
+                    "dtx_frames_sent",
+                    "dtx_frames_suppressed",
+                    "aec_blocks",
+                )
+            ] + [
+                ("aec_erle_db", C.c_double),
+                ("delay_blocks", C.c_uint64),
+                ("delay_ms", C.c_double),
+                ("delay_confidence", C.c_double),
+                ("aec_delay_ms", C.c_double),
+                ("ns_blocks", C.c_uint64),
+                ("ns_over_budget", C.c_uint64),
+                ("ns_max_block_us", C.c_double),
+                ("ns_noise_dbfs", C.c_double),
+                ("agc_capture_gain_db", C.c_double),
+                ("agc_capture_limit_db", C.c_double),
+                ("agc_playback_gain_db", C.c_double),
+                ("agc_playback_limit_db", C.c_double),
+                ("rec_bytes", C.c_uint64),
+                ("rec_dropped", C.c_uint64),
+                ("replay_frames", C.c_uint64),
+                ("replay_eof", C.c_uint64),
+                ("ipc_dropped", C.c_uint64),
+                ("cap_overruns", C.c_uint64),
+                ("cap_overrun_bytes", C.c_uint64),
+                ("clip_voices", C.c_uint64),
+                ("events_dropped", C.c_uint64),
+                ("play_overruns", C.c_uint64),
+                ("play_overrun_bytes", C.c_uint64),
+                ("playout_breaks_lost", C.c_uint64),
+            ]
+
+        self.Stats = Stats
+        self.has_stats = self._bind(_CAP_STATS, ("vpio_get_stats", [C.c_void_p, C.c_size_t], C.c_size_t))
+        # Discontinuous transmission (requires the VAD gate and framing)
+        self.has_dtx = (
+            self._bind(
+                _CAP_DTX,
+                ("vpio_set_dtx", [C.c_int, C.c_int], None),
+                ("vpio_get_dtx_stats", [C.POINTER(C.c_size_t), C.POINTER(C.c_size_t)], None),
+            )
+            and self.has_vad_gate
+            and self.has_frames
+        )
+        # Capture DSP: echo canceller, delay estimator, noise suppressor, AGC
+        self.has_aec = self._bind(_CAP_AEC, ("vpio_set_aec", [C.c_int, C.c_int, C.c_int], C.c_int))
+        self.has_delay_est = self._bind(
+            _CAP_DELAY_EST,
+            ("vpio_set_delay_estimator", [C.c_int, C.c_int], C.c_int),
+            ("vpio_get_delay_estimate", [C.POINTER(C.c_double), C.POINTER(C.c_double)], C.c_int),
+        )
+        self.has_ns = self._bind(
+            _CAP_NS, ("vpio_set_noise_suppressor", [C.c_int, C.c_double, C.c_int], C.c_int)
+        )
+        self.has_agc = self._bind(
+            _CAP_AGC, ("vpio_set_agc", [C.c_int, C.c_int, C.c_double, C.c_double, C.c_double], C.c_int)
+        )
+        # Session recorder
+        self.has_recorder = self._bind(
+            _CAP_RECORDER,
+            ("vpio_start_recording", [C.c_char_p, C.c_int, C.c_uint], C.c_int),
+            ("vpio_stop_recording", [], None),
+        )
+        # File replay device
+        self.has_replay = self._bind(
+            _CAP_REPLAY,
+            (
+                "vpio_set_replay",
+                [C.c_char_p, C.c_char_p, C.c_int, C.POINTER(C.c_uint32), C.c_size_t],
+                C.c_int,
+            ),
+        )
+        # Client for an out-of-process engine
+        self.has_remote = self._bind(
+            _CAP_REMOTE,
+            ("vpio_remote_attach", [C.c_char_p, C.c_int], C.c_int),
+            ("vpio_remote_detach", [], None),
+            ("vpio_remote_capabilities", [], C.c_uint32),
+            (
+                "vpio_remote_call",
+                [C.c_int, C.POINTER(C.c_int32), C.POINTER(C.c_double), C.c_char_p, C.POINTER(C.c_double)],
+                C.c_int64,
+            ),
+            ("vpio_remote_get_levels", [C.c_int, C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_remote_read_frames", [C.c_void_p, C.c_size_t, C.c_size_t, C.c_void_p], C.c_size_t),
+            ("vpio_remote_write_playback", [C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_remote_get_stats", [C.c_void_p, C.c_size_t], C.c_size_t),
+        )
+        # Extra capture readers with their own cursors
+        self.has_capture_readers = self._bind(
+            _CAP_READERS,
+            ("vpio_capture_reader_open", [], C.c_int),
+            ("vpio_capture_reader_close", [C.c_int], None),
+            (
+                "vpio_capture_reader_read_frames",
+                [C.c_int, C.c_void_p, C.c_size_t, C.c_size_t, C.POINTER(FrameInfo)],
+                C.c_size_t,
+            ),
+            (
+                "vpio_capture_reader_peek",
+                [
+                    C.c_int,
+                    C.c_size_t,
+                    C.POINTER(C.c_void_p),
+                    C.POINTER(C.c_size_t),
+                    C.POINTER(C.c_void_p),
+                    C.POINTER(C.c_size_t),
+                    C.POINTER(C.c_size_t),
+                ],
+                C.c_size_t,
+            ),
+            ("vpio_capture_reader_consume", [C.c_int, C.c_size_t], C.c_int),
+            (
+                "vpio_capture_reader_stats",
+                [C.c_int, C.POINTER(C.c_uint64), C.POINTER(C.c_uint64), C.POINTER(C.c_size_t)],
+                C.c_int,
+            ),
+        )
+        # Extra playback streams mixed in the render path
+        self.has_mixer = self._bind(
+            _CAP_MIXER,
+            ("vpio_play_stream_open", [C.c_int, C.c_double, C.c_double], C.c_int),
+            ("vpio_play_stream_set", [C.c_int, C.c_int, C.c_double, C.c_double], C.c_int),
+            ("vpio_play_stream_write", [C.c_int, C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_play_stream_flush", [C.c_int], None),
+            ("vpio_play_stream_close", [C.c_int], None),
+            (
+                "vpio_play_stream_stats",
+                [C.c_int, C.POINTER(C.c_size_t), C.POINTER(C.c_uint64), C.POINTER(C.c_double)],
+                C.c_int,
+            ),
+        )
+        # Clip bank and engine event queue; fields mirror vpio_event
+        class Event(C.Structure):
+            _fields_ = [
+                ("type", C.c_uint32),
+                ("id", C.c_uint32),
+                ("arg", C.c_uint64),
+                ("host_time_ns", C.c_uint64),
+            ]
+
+        self._Event = Event
+        self.has_clips = self._bind(
+            _CAP_CLIPS,
+            ("vpio_clip_register", [C.c_void_p, C.c_size_t], C.c_int),
+            ("vpio_clip_unregister", [C.c_int], C.c_int),
+            ("vpio_clip_trigger", [C.c_int, C.c_double], C.c_int),
+            ("vpio_clip_stop", [C.c_int], C.c_int),
+        )
+        self.has_events = self._bind(
+            _CAP_EVENTS,
+            ("vpio_event_fd", [], C.c_int),
+            ("vpio_poll_events", [C.POINTER(Event), C.c_size_t], C.c_size_t),
+        )
+        # Start on a worker thread with startup milestones; fields mirror
+        # vpio_start_timings
+        class StartTimings(C.Structure):
+            _fields_ = [
+                ("start_ns", C.c_uint64),
+                ("component_ms", C.c_double),
+                ("configure_ms", C.c_double),
+                ("initialize_ms", C.c_double),
+                ("unit_start_ms", C.c_double),
+                ("ready_ms", C.c_double),
+                ("first_render_ms", C.c_double),
+                ("first_capture_ms", C.c_double),
+                ("first_played_ms", C.c_double),
+            ]
+
+        self._StartTimings = StartTimings
+        self.has_async_start = self._bind(
+            _CAP_ASYNC_START,
+            ("vpio_start_stream_async", [C.c_double, C.c_int, C.c_size_t], C.c_int),
+            ("vpio_start_stream_result", [C.POINTER(C.c_int)], C.c_int),
+            ("vpio_get_start_timings", [C.c_void_p, C.c_size_t], C.c_size_t),
+        )
+        # In-engine capture mute/pause
+        self.has_capture_gate = self._bind(
+            _CAP_CAPTURE_GATE, ("vpio_set_capture_gate", [C.c_int, C.c_int], C.c_int)
+        )
+        # Ring budgets and memory accounting; fields mirror vpio_ring_memory
+        class RingMemory(C.Structure):
+            _fields_ = [
+                ("committed", C.c_uint64),
+                ("committed_high", C.c_uint64),
+                ("level", C.c_uint64),
+                ("level_high", C.c_uint64),
+                ("budget", C.c_uint64),
+                ("grows", C.c_uint64),
+                ("shrinks", C.c_uint64),
+                ("rejected_bytes", C.c_uint64),
+            ]
+
+        self._RingMemory = RingMemory
+        self.has_ring_budget = self._bind(
+            _CAP_RING_BUDGET,
+            ("vpio_set_ring_budget", [C.c_int, C.c_size_t, C.c_int], C.c_int),
+            ("vpio_get_ring_memory", [C.c_int, C.c_void_p, C.c_size_t], C.c_size_t),
+        )
+        # Bounded playback writes; writability comes as an event
+        self.has_backpressure = (
+            self._bind(
+                _CAP_BACKPRESSURE,
+                ("vpio_set_playback_watermarks", [C.c_size_t, C.c_size_t], C.c_int),
+                ("vpio_get_playback_space", [C.POINTER(C.c_size_t)], C.c_size_t),
+            )
+            and self.has_events
+        )
+        # Level meters; fields mirror vpio_level
+        class Level(C.Structure):
+            _fields_ = [
+                ("seq", C.c_uint64),
+                ("rms", C.c_float),
+                ("peak", C.c_float),
+                ("clipped", C.c_uint32),
+                ("samples", C.c_uint32),
+            ]
+
+        self.Level = Level
+        self.has_levels = self._bind(
+            _CAP_LEVELS, ("vpio_get_levels", [C.c_int, C.POINTER(Level), C.c_size_t], C.c_size_t)
+        )
+        if self.has_levels:
+            self._levels_buf = (Level * 128)()
+        # Playout clock and utterance marks; fields mirror vpio.h
+        class PlayoutClock(C.Structure):
+            _fields_ = [
+                ("written", C.c_uint64),
+                ("rendered", C.c_uint64),
+                ("position", C.c_uint64),
+                ("dropped", C.c_uint64),
+            ]
+
+        class PlayoutMark(C.Structure):
+            _fields_ = [
+                ("tag", C.c_uint64),
+                ("start", C.c_uint64),
+                ("written", C.c_uint64),
+                ("heard", C.c_uint64),
+                ("pending", C.c_uint64),
+            ]
+
+        self._PlayoutClock = PlayoutClock
+        self._PlayoutMark = PlayoutMark
+        self.has_playout = self._bind(
+            _CAP_PLAYOUT,
+            ("vpio_playout_mark", [C.c_int, C.c_uint64], C.c_int),
+            ("vpio_get_playout_clock", [C.c_int, C.c_void_p, C.c_size_t], C.c_size_t),
+            ("vpio_get_playout_mark", [C.c_int, C.c_uint64, C.c_void_p, C.c_size_t], C.c_size_t),
+        )
+        # Debug getters
+        self.has_debug = self._bind(
+            _CAP_DEBUG,
+            ("vpio_get_bypass", [C.POINTER(C.c_uint)], C.c_int),
+            ("vpio_get_in_sample_rate", [], C.c_double),
+            ("vpio_get_out_sample_rate", [], C.c_double),
+            ("vpio_get_ring_levels", [C.POINTER(C.c_size_t), C.POINTER(C.c_size_t)], C.c_size_t),
+            ("vpio_get_underflow_count", [], C.c_size_t),
+            ("vpio_reset_underflow_count", [], None),
+        )
+        self._bind(
+            _CAP_DEBUG,
+            ("vpio_get_staging_level", [], C.c_size_t),
+            ("vpio_get_staging_capacity", [], C.c_size_t),
+        )
+        self.capabilities = self._caps if self._caps is not None else self._probed_caps()
 
         # Fallback single-shot API
         self.lib.vpio_record.argtypes = [C.c_double]
@@ -122,46 +504,294 @@ class _VPIOLib:
         self.lib.vpio_get_capture_size.restype = C.c_size_t
         self.lib.vpio_copy_capture.argtypes = [C.c_void_p, C.c_size_t]
         self.lib.vpio_copy_capture.restype = C.c_size_t
-        try:
-            self.lib.vpio_reset_capture.argtypes = []
-            self.lib.vpio_reset_capture.restype = C.c_size_t
-            self.has_reset_capture = True
-        except Exception:
-            self.has_reset_capture = False
+        self.has_reset_capture = self._bind(0, ("vpio_reset_capture", [], C.c_size_t))
         self.lib.vpio_play.argtypes = [C.c_void_p, C.c_size_t]
         self.lib.vpio_play.restype = C.c_int
 
         # Shutdown
         self.lib.vpio_shutdown.argtypes = []
         self.lib.vpio_shutdown.restype = None
-        # Debug functions (optional)
+
+    def _bind(self, cap: int, *protos) -> bool:
+        """Set prototypes for one optional symbol group; returns whether it is usable.
+
+        With a capability bitmask the group is bound iff its bit is set
+        (cap 0: symbols that predate the bitmask, always probed). Without one
+        every symbol is probed.
+        """
+        if self._caps is not None and cap:
+            if not self._caps & cap:
+                return False
+            for name, argtypes, restype in protos:
+                fn = getattr(self.lib, name)
+                fn.argtypes = argtypes
+                fn.restype = restype
+            return True
         try:
-            self.lib.vpio_get_bypass.argtypes = [self.C.POINTER(self.C.c_uint)]
-            self.lib.vpio_get_bypass.restype = self.C.c_int
-            self.lib.vpio_get_in_sample_rate.argtypes = []
-            self.lib.vpio_get_in_sample_rate.restype = self.C.c_double
-            self.lib.vpio_get_out_sample_rate.argtypes = []
-            self.lib.vpio_get_out_sample_rate.restype = self.C.c_double
-            self.lib.vpio_get_ring_levels.argtypes = [
-                self.C.POINTER(self.C.c_size_t),
-                self.C.POINTER(self.C.c_size_t),
-            ]
-            self.lib.vpio_get_ring_levels.restype = self.C.c_size_t
-            self.lib.vpio_get_underflow_count.argtypes = []
-            self.lib.vpio_get_underflow_count.restype = self.C.c_size_t
-            self.lib.vpio_reset_underflow_count.argtypes = []
-            self.lib.vpio_reset_underflow_count.restype = None
-            # Optional: staging ring debug
-            try:
-                self.lib.vpio_get_staging_level.argtypes = []
-                self.lib.vpio_get_staging_level.restype = self.C.c_size_t
-                self.lib.vpio_get_staging_capacity.argtypes = []
-                self.lib.vpio_get_staging_capacity.restype = self.C.c_size_t
-            except Exception:
-                pass
-            self.has_debug = True
-        except Exception:
-            self.has_debug = False
+            for name, argtypes, restype in protos:
+                fn = getattr(self.lib, name)
+                fn.argtypes = argtypes
+                fn.restype = restype
+        except AttributeError:
+            return False
+        return True
+
+    def _probed_caps(self) -> int:
+        """Capability bits equivalent to what probing found on an old helper."""
+        flags = (
+            (_CAP_STREAM, self.has_stream),
+            (_CAP_PLAY_THREAD, self.has_play_thread),
+            (_CAP_FLUSH, self.has_flush and self.has_flush_input),
+            (_CAP_DEBUG, self.has_debug),
+            (_CAP_VAD_GATE, self.has_vad_gate),
+            (_CAP_FRAMES, self.has_frames),
+            (_CAP_DTX, self.has_dtx),
+            (_CAP_STATS, self.has_stats),
+            (_CAP_AEC, self.has_aec),
+            (_CAP_DELAY_EST, self.has_delay_est),
+            (_CAP_NS, self.has_ns),
+            (_CAP_AGC, self.has_agc),
+            (_CAP_LEVELS, self.has_levels),
+            (_CAP_RECORDER, self.has_recorder),
+            (_CAP_REPLAY, self.has_replay),
+            (_CAP_REMOTE, self.has_remote),
+            (_CAP_READERS, self.has_capture_readers),
+            (_CAP_MIXER, self.has_mixer),
+            (_CAP_CLIPS, self.has_clips),
+            (_CAP_EVENTS, self.has_events),
+            (_CAP_ASYNC_START, self.has_async_start),
+            (_CAP_CAPTURE_GATE, self.has_capture_gate),
+            (_CAP_RING_BUDGET, self.has_ring_budget),
+            (_CAP_BACKPRESSURE, self.has_backpressure),
+            (_CAP_PLAYOUT, self.has_playout),
+        )
+        return sum(bit for bit, ok in flags if ok)
+
+    binding = "ctypes"
+
+    def get_stats(self):
+        """Snapshot all helper counters in one FFI call (None if unsupported)."""
+        if not self.has_stats:
+            return None
+        st = self.Stats()
+        self.lib.vpio_get_stats(self.C.byref(st), self.C.sizeof(st))
+        return st
+
+    # Binding-neutral operations (mirrored by _VPIOExt)
+    def set_vad_gate(self, enabled: bool, margin_db: float, hangover_ms: int, onset_blocks: int):
+        self.lib.vpio_set_vad_gate(int(enabled), float(margin_db), int(hangover_ms), int(onset_blocks))
+
+    def set_dtx(self, enabled: bool, keepalive_ms: int):
+        self.lib.vpio_set_dtx(int(enabled), int(keepalive_ms))
+
+    def set_capture_frame_ms(self, ms: int) -> int:
+        return int(self.lib.vpio_set_capture_frame_ms(int(ms)))
+
+    def set_aec(self, enabled: bool, tail_ms: int, delay_ms: int) -> bool:
+        return self.lib.vpio_set_aec(int(enabled), int(tail_ms), int(delay_ms)) == 0
+
+    def set_delay_estimator(self, enabled: bool, max_delay_ms: int) -> bool:
+        return self.lib.vpio_set_delay_estimator(int(enabled), int(max_delay_ms)) == 0
+
+    def set_noise_suppressor(self, enabled: bool, max_atten_db: float, budget_pct: int) -> bool:
+        return self.lib.vpio_set_noise_suppressor(int(enabled), float(max_atten_db), int(budget_pct)) == 0
+
+    def set_agc(
+        self, direction: int, enabled: bool, target_dbfs: float, max_gain_db: float, ceiling_dbfs: float
+    ) -> bool:
+        return (
+            self.lib.vpio_set_agc(
+                int(direction), int(enabled), float(target_dbfs), float(max_gain_db), float(ceiling_dbfs)
+            )
+            == 0
+        )
+
+    def start_recording(self, path_prefix: str, fmt: int, taps: int) -> bool:
+        return self.lib.vpio_start_recording(os.fsencode(path_prefix), int(fmt), int(taps)) == 0
+
+    def stop_recording(self):
+        self.lib.vpio_stop_recording()
+
+    def set_replay(self, capture_path, playback_path, realtime: bool, pattern) -> bool:
+        C = self.C
+        pattern = list(pattern or [])
+        arr = (C.c_uint32 * len(pattern))(*pattern) if pattern else None
+        return (
+            self.lib.vpio_set_replay(
+                os.fsencode(capture_path) if capture_path else None,
+                os.fsencode(playback_path) if playback_path else None,
+                int(bool(realtime)),
+                arr,
+                len(pattern),
+            )
+            == 0
+        )
+
+    def get_levels(self, direction: int, max_entries: int):
+        """Latest 10 ms meter blocks as (seq, rms, peak, clipped, samples), oldest first."""
+        buf = self._levels_buf
+        n = int(self.lib.vpio_get_levels(int(direction), buf, min(int(max_entries), len(buf))))
+        return [(e.seq, e.rms, e.peak, e.clipped, e.samples) for e in buf[:n]]
+
+    def get_delay_estimate(self):
+        """(delay_ms, confidence), or None before the first estimate."""
+        delay = self.C.c_double(0.0)
+        conf = self.C.c_double(0.0)
+        if not self.lib.vpio_get_delay_estimate(self.C.byref(delay), self.C.byref(conf)):
+            return None
+        return delay.value, conf.value
+
+    def alloc_frames(self, max_frames: int, frame_bytes: int):
+        """Allocate a capture buffer suitable for read_frames()."""
+        if not self.has_read_frames:
+            max_frames = 1
+        cbuf = (self.C.c_ubyte * (frame_bytes * max_frames))()
+        return cbuf, (self.FrameInfo * max_frames)()
+
+    def read_frames(self, bufs, max_frames: int, frame_bytes: int):
+        """Read whole capture frames into bufs[0]; returns their FrameInfo list."""
+        cbuf, infos = bufs
+        if self.has_read_frames:
+            n = int(self.lib.vpio_read_frames(cbuf, max_frames, frame_bytes, infos))
+        else:
+            n = 1 if self.lib.vpio_read_frame(cbuf, frame_bytes, infos) else 0
+        return infos[:n]
+
+    def open_capture_reader(self) -> int:
+        """Extra capture reader at the newest capture; its id, or -1 if none is free."""
+        return int(self.lib.vpio_capture_reader_open())
+
+    def close_capture_reader(self, reader: int):
+        self.lib.vpio_capture_reader_close(int(reader))
+
+    def read_reader_frames(self, reader: int, bufs, max_frames: int, frame_bytes: int):
+        """read_frames() through an extra capture reader."""
+        cbuf, infos = bufs
+        n = int(self.lib.vpio_capture_reader_read_frames(int(reader), cbuf, max_frames, frame_bytes, infos))
+        return infos[:n]
+
+    def peek_capture(self, reader: int, max_bytes: int):
+        """(pos, [memoryview]) straight over the capture ring; see consume_capture."""
+        C = self.C
+        p1, p2 = C.c_void_p(), C.c_void_p()
+        n1, n2, pos = C.c_size_t(), C.c_size_t(), C.c_size_t()
+        self.lib.vpio_capture_reader_peek(
+            int(reader), int(max_bytes), C.byref(p1), C.byref(n1), C.byref(p2), C.byref(n2), C.byref(pos)
+        )
+        views = [
+            memoryview((C.c_ubyte * n.value).from_address(p.value)).cast("B").toreadonly()
+            for p, n in ((p1, n1), (p2, n2))
+            if n.value
+        ]
+        return pos.value, views
+
+    def consume_capture(self, reader: int, n: int) -> bool:
+        """Release peeked bytes; False if the writer overwrote them meanwhile."""
+        return self.lib.vpio_capture_reader_consume(int(reader), int(n)) == 0
+
+    def capture_reader_stats(self, reader: int):
+        """(overruns, dropped_bytes, level) of a reader, or None if it isn't open."""
+        C = self.C
+        overruns, dropped, level = C.c_uint64(), C.c_uint64(), C.c_size_t()
+        if self.lib.vpio_capture_reader_stats(
+            int(reader), C.byref(overruns), C.byref(dropped), C.byref(level)
+        ):
+            return None
+        return overruns.value, dropped.value, level.value
+
+    def open_play_stream(self, priority: int, gain_db: float, duck_db: float) -> int:
+        """Extra playback stream mixed over the main one; its id, or -1."""
+        return int(self.lib.vpio_play_stream_open(int(priority), float(gain_db), float(duck_db)))
+
+    def set_play_stream(self, stream: int, priority: int, gain_db: float, duck_db: float) -> bool:
+        return self.lib.vpio_play_stream_set(int(stream), int(priority), float(gain_db), float(duck_db)) == 0
+
+    def write_play_stream(self, stream: int, data: bytes) -> int:
+        c_arr = (self.C.c_ubyte * len(data)).from_buffer_copy(data)
+        return int(self.lib.vpio_play_stream_write(int(stream), c_arr, len(data)))
+
+    def flush_play_stream(self, stream: int):
+        self.lib.vpio_play_stream_flush(int(stream))
+
+    def close_play_stream(self, stream: int):
+        self.lib.vpio_play_stream_close(int(stream))
+
+    def play_stream_stats(self, stream: int):
+        """(queued_bytes, played_bytes, duck_db), or None if the stream isn't open."""
+        C = self.C
+        queued, played, duck = C.c_size_t(), C.c_uint64(), C.c_double()
+        if self.lib.vpio_play_stream_stats(int(stream), C.byref(queued), C.byref(played), C.byref(duck)):
+            return None
+        return queued.value, played.value, duck.value
+
+    def playout_mark(self, stream: int, tag: int) -> bool:
+        return self.lib.vpio_playout_mark(int(stream), int(tag)) == 0
+
+    def playout_clock(self, stream: int) -> Optional[dict]:
+        c = self._PlayoutClock()
+        if not self.lib.vpio_get_playout_clock(int(stream), self.C.byref(c), self.C.sizeof(c)):
+            return None
+        return {name: int(getattr(c, name)) for name, _ in c._fields_}
+
+    def playout_mark_info(self, stream: int, tag: int) -> Optional[dict]:
+        m = self._PlayoutMark()
+        if not self.lib.vpio_get_playout_mark(int(stream), int(tag), self.C.byref(m), self.C.sizeof(m)):
+            return None
+        return {name: int(getattr(m, name)) for name, _ in m._fields_}
+
+    def register_clip(self, pcm: bytes) -> int:
+        """Copy pcm into the clip bank once; its id, or -1."""
+        c_arr = (self.C.c_ubyte * len(pcm)).from_buffer_copy(pcm)
+        return int(self.lib.vpio_clip_register(c_arr, len(pcm)))
+
+    def unregister_clip(self, clip: int) -> bool:
+        return self.lib.vpio_clip_unregister(int(clip)) == 0
+
+    def trigger_clip(self, clip: int, gain_db: float) -> int:
+        """Start a voice on a registered clip; its handle, or -1."""
+        return int(self.lib.vpio_clip_trigger(int(clip), float(gain_db)))
+
+    def stop_clip(self, voice: int) -> bool:
+        return self.lib.vpio_clip_stop(int(voice)) == 0
+
+    def event_fd(self) -> int:
+        return int(self.lib.vpio_event_fd())
+
+    def poll_events(self, max_events: int = 64):
+        """Queued engine events as (type, id, arg, host_time_ns) tuples."""
+        buf = (self._Event * max(1, int(max_events)))()
+        n = int(self.lib.vpio_poll_events(buf, len(buf)))
+        return [(e.type, e.id, e.arg, e.host_time_ns) for e in buf[:n]]
+
+    def write_frames(self, data: bytes) -> int:
+        c_arr = (self.C.c_ubyte * len(data)).from_buffer_copy(data)
+        return int(self.lib.vpio_write_frame_10ms(c_arr, len(data)))
+
+    def write_playback(self, data: bytes) -> int:
+        c_arr = (self.C.c_ubyte * len(data)).from_buffer_copy(data)
+        try:
+            return int(self.lib.vpio_write_playback(c_arr, len(data)))
+        except AttributeError:
+            # Fallback to blocking play (will be choppy, but avoids crashing)
+            self.lib.vpio_play(c_arr, len(data))
+            return len(data)
+
+    def flush_playback(self):
+        if self.has_flush:
+            self.lib.vpio_flush_playback()
+
+    def flush_input(self):
+        if self.has_flush_input:
+            self.lib.vpio_flush_input()
+
+    def set_target_headroom_ms(self, ms: int):
+        self.lib.vpio_set_target_headroom_ms(int(ms))
+
+    def start_playback_thread(self, slice_ms: int, preroll_ms: int) -> int:
+        return int(self.lib.vpio_start_playback_thread(int(slice_ms), int(preroll_ms)))
+
+    def stop_playback_thread(self):
+        self.lib.vpio_stop_playback_thread()
 
     def start_stream(self, sr: int, ch: int, cap_bytes: int) -> bool:
         if self.has_stream:
@@ -173,6 +803,41 @@ class _VPIOLib:
             rc = self.lib.vpio_init(self.C.c_double(sr), self.C.c_int(ch))
             return rc == 0
 
+    def start_stream_async(self, sr: int, ch: int, cap_bytes: int) -> bool:
+        return self.lib.vpio_start_stream_async(float(sr), int(ch), int(cap_bytes)) == 0
+
+    def set_capture_gate(self, gate: int, keep_echo: bool) -> bool:
+        return self.lib.vpio_set_capture_gate(int(gate), 1 if keep_echo else 0) == 0
+
+    def set_ring_budget(self, ring: int, max_bytes: int, shrink_after_ms: int) -> bool:
+        return self.lib.vpio_set_ring_budget(int(ring), int(max_bytes), int(shrink_after_ms)) == 0
+
+    def set_playback_watermarks(self, high_bytes: int, low_bytes: int = 0) -> bool:
+        return self.lib.vpio_set_playback_watermarks(int(high_bytes), int(low_bytes)) == 0
+
+    def playback_space(self) -> tuple[int, int]:
+        """(bytes writable now, bytes queued for playback)."""
+        queued = self.C.c_size_t()
+        space = int(self.lib.vpio_get_playback_space(self.C.byref(queued)))
+        return space, int(queued.value)
+
+    def ring_memory(self, ring: int) -> dict:
+        m = self._RingMemory()
+        if not self.lib.vpio_get_ring_memory(int(ring), self.C.byref(m), self.C.sizeof(m)):
+            raise ValueError("unknown ring")
+        return {name: int(getattr(m, name)) for name, _ in m._fields_}
+
+    def start_stream_result(self) -> Optional[int]:
+        """None while an async start is pending, then its result (0 ok); -1 if none."""
+        rc = self.C.c_int()
+        state = self.lib.vpio_start_stream_result(self.C.byref(rc))
+        return None if state == 0 else (rc.value if state > 0 else -1)
+
+    def start_timings(self):
+        t = self._StartTimings()
+        self.lib.vpio_get_start_timings(self.C.byref(t), self.C.sizeof(t))
+        return t
+
     def stop_stream(self):
         try:
             self.lib.vpio_stop_stream()
@@ -181,6 +846,529 @@ class _VPIOLib:
         self.lib.vpio_shutdown()
 
 
+# Capability bits from vpio.h
+_CAP_STREAM = 1 << 0
+_CAP_PLAY_THREAD = 1 << 1
+_CAP_FLUSH = 1 << 2
+_CAP_DEBUG = 1 << 3
+_CAP_VAD_GATE = 1 << 4
+_CAP_FRAMES = 1 << 5
+_CAP_DTX = 1 << 6
+_CAP_STATS = 1 << 7
+_CAP_AEC = 1 << 8
+_CAP_DELAY_EST = 1 << 9
+_CAP_NS = 1 << 10
+_CAP_AGC = 1 << 11
+_CAP_LEVELS = 1 << 12
+_CAP_RECORDER = 1 << 13
+_CAP_REPLAY = 1 << 14
+_CAP_REMOTE = 1 << 15
+_CAP_READERS = 1 << 16
+_CAP_MIXER = 1 << 17
+_CAP_CLIPS = 1 << 18
+_CAP_EVENTS = 1 << 19
+_CAP_ASYNC_START = 1 << 20
+_CAP_CAPTURE_GATE = 1 << 21
+_CAP_RING_BUDGET = 1 << 22
+_CAP_BACKPRESSURE = 1 << 23
+_CAP_PLAYOUT = 1 << 24
+
+# Engine rings (VPIO_RING_* in vpio.h)
+_RINGS = {"capture": 0, "playback": 1, "staging": 2}
+
+# Capture gates (VPIO_GATE_* in vpio.h)
+_GATES = {"open": 0, "mute": 1, "pause": 2}
+
+# Engine event types (VPIO_EVENT_* in vpio.h)
+_EVENT_CLIP_DONE = 1
+_EVENT_CLIP_STOPPED = 2
+_EVENT_STREAM_STARTED = 3
+_EVENT_PLAYBACK_WRITABLE = 4
+
+_DIR_CAPTURE = 0
+_DIR_PLAYBACK = 1
+
+_REC_TAPS_ALL = 1 | 2 | 4  # raw mic, processed capture, playback
+_REC_FORMATS = {"wav": 0, "framed": 1}
+
+
+class _VPIOExt:
+    """Helper bound through the compiled _vpio extension module.
+
+    Same surface as _VPIOLib's binding-neutral methods, but capture and
+    playback data go through the buffer protocol, blocking calls release the
+    GIL, and features come from the engine's capability mask rather than
+    symbol probing. There is no ctypes handle (lib is None).
+    """
+
+    binding = "extension"
+
+    def __init__(self, ext_path: Optional[str] = None, replay: bool = False):
+        if not _is_macos() and not replay:
+            raise RuntimeError("LocalMacTransport only supported on macOS (or with a replay device)")
+        ext_path = ext_path or os.getenv("VPIO_EXT") or _find_extension()
+        if not ext_path or not os.path.exists(ext_path):
+            raise FileNotFoundError(
+                "VPIO extension module not found. Build it with: make -C macos ext"
+            )
+        import ctypes as C
+
+        # Only used for scratch values in debug metrics
+        self.C = C
+        spec = importlib.util.spec_from_file_location("_vpio", ext_path)
+        mod = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(mod)
+        self.mod = mod
+        self.path = ext_path
+        self.lib = None
+        self.engine = mod.Engine()
+        caps = int(self.engine.capabilities)
+        self.capabilities = caps
+        self.has_stream = bool(caps & _CAP_STREAM)
+        self.has_write_10ms = bool(caps & _CAP_PLAY_THREAD)
+        self.has_play_thread = bool(caps & _CAP_PLAY_THREAD)
+        self.has_flush = bool(caps & _CAP_FLUSH)
+        self.has_flush_input = bool(caps & _CAP_FLUSH)
+        self.has_vad_gate = bool(caps & _CAP_VAD_GATE)
+        self.has_frames = bool(caps & _CAP_FRAMES)
+        self.has_read_frames = self.has_frames
+        self.has_dtx = bool(caps & _CAP_DTX)
+        self.has_stats = bool(caps & _CAP_STATS)
+        self.has_aec = bool(caps & _CAP_AEC)
+        self.has_delay_est = bool(caps & _CAP_DELAY_EST)
+        self.has_ns = bool(caps & _CAP_NS)
+        self.has_agc = bool(caps & _CAP_AGC)
+        self.has_levels = bool(caps & _CAP_LEVELS)
+        self.has_recorder = bool(caps & _CAP_RECORDER)
+        self.has_replay = bool(caps & _CAP_REPLAY)
+        self.has_capture_readers = bool(caps & _CAP_READERS)
+        self.has_mixer = bool(caps & _CAP_MIXER)
+        self.has_clips = bool(caps & _CAP_CLIPS)
+        self.has_events = bool(caps & _CAP_EVENTS)
+        self.has_async_start = bool(caps & _CAP_ASYNC_START)
+        self.has_capture_gate = bool(caps & _CAP_CAPTURE_GATE)
+        self.has_ring_budget = bool(caps & _CAP_RING_BUDGET)
+        self.has_backpressure = bool(caps & _CAP_BACKPRESSURE)
+        self.has_playout = bool(caps & _CAP_PLAYOUT)
+        # Debug getters are only reachable through ctypes
+        self.has_debug = False
+
+    def start_stream(self, sr: int, ch: int, cap_bytes: int) -> bool:
+        return bool(self.engine.start(float(sr), int(ch), int(cap_bytes)))
+
+    def start_stream_async(self, sr: int, ch: int, cap_bytes: int) -> bool:
+        return bool(self.engine.start_async(float(sr), int(ch), int(cap_bytes)))
+
+    def set_capture_gate(self, gate: int, keep_echo: bool) -> bool:
+        return bool(self.engine.set_capture_gate(int(gate), bool(keep_echo)))
+
+    def set_ring_budget(self, ring: int, max_bytes: int, shrink_after_ms: int) -> bool:
+        return bool(self.engine.set_ring_budget(int(ring), int(max_bytes), int(shrink_after_ms)))
+
+    def ring_memory(self, ring: int) -> dict:
+        return self.engine.ring_memory(int(ring))
+
+    def set_playback_watermarks(self, high_bytes: int, low_bytes: int = 0) -> bool:
+        return bool(self.engine.set_playback_watermarks(int(high_bytes), int(low_bytes)))
+
+    def playback_space(self) -> tuple[int, int]:
+        return self.engine.playback_space()
+
+    def start_stream_result(self) -> Optional[int]:
+        return self.engine.start_result()
+
+    def start_timings(self):
+        return SimpleNamespace(**self.engine.start_timings())
+
+    def stop_stream(self):
+        self.engine.stop()
+
+    def get_stats(self):
+        return SimpleNamespace(**self.engine.stats()) if self.has_stats else None
+
+    def set_vad_gate(self, enabled: bool, margin_db: float, hangover_ms: int, onset_blocks: int):
+        self.engine.set_vad_gate(bool(enabled), float(margin_db), int(hangover_ms), int(onset_blocks))
+
+    def set_dtx(self, enabled: bool, keepalive_ms: int):
+        self.engine.set_dtx(bool(enabled), int(keepalive_ms))
+
+    def set_capture_frame_ms(self, ms: int) -> int:
+        return int(self.engine.set_capture_frame_ms(int(ms)))
+
+    def set_aec(self, enabled: bool, tail_ms: int, delay_ms: int) -> bool:
+        return bool(self.engine.set_aec(bool(enabled), int(tail_ms), int(delay_ms)))
+
+    def set_delay_estimator(self, enabled: bool, max_delay_ms: int) -> bool:
+        return bool(self.engine.set_delay_estimator(bool(enabled), int(max_delay_ms)))
+
+    def set_noise_suppressor(self, enabled: bool, max_atten_db: float, budget_pct: int) -> bool:
+        return bool(self.engine.set_noise_suppressor(bool(enabled), float(max_atten_db), int(budget_pct)))
+
+    def set_agc(
+        self, direction: int, enabled: bool, target_dbfs: float, max_gain_db: float, ceiling_dbfs: float
+    ) -> bool:
+        return bool(
+            self.engine.set_agc(
+                int(direction), bool(enabled), float(target_dbfs), float(max_gain_db), float(ceiling_dbfs)
+            )
+        )
+
+    def get_delay_estimate(self):
+        return self.engine.delay_estimate()
+
+    def start_recording(self, path_prefix: str, fmt: int, taps: int) -> bool:
+        return bool(self.engine.start_recording(os.fspath(path_prefix), int(fmt), int(taps)))
+
+    def stop_recording(self):
+        self.engine.stop_recording()
+
+    def set_replay(self, capture_path, playback_path, realtime: bool, pattern) -> bool:
+        return bool(
+            self.engine.set_replay(
+                os.fspath(capture_path) if capture_path else None,
+                os.fspath(playback_path) if playback_path else None,
+                bool(realtime),
+                list(pattern) if pattern else None,
+            )
+        )
+
+    def get_levels(self, direction: int, max_entries: int):
+        return self.engine.levels(int(direction), int(max_entries))
+
+    def alloc_frames(self, max_frames: int, frame_bytes: int):
+        return bytearray(frame_bytes * max_frames)
+
+    def read_frames(self, buf, max_frames: int, frame_bytes: int):
+        return self.engine.read_frames(buf, max_frames, frame_bytes)
+
+    def open_capture_reader(self) -> int:
+        return int(self.engine.open_capture_reader())
+
+    def close_capture_reader(self, reader: int):
+        self.engine.close_capture_reader(int(reader))
+
+    def read_reader_frames(self, reader: int, buf, max_frames: int, frame_bytes: int):
+        return self.engine.read_reader_frames(int(reader), buf, max_frames, frame_bytes)
+
+    def peek_capture(self, reader: int, max_bytes: int):
+        return self.engine.peek_capture(int(reader), int(max_bytes))
+
+    def consume_capture(self, reader: int, n: int) -> bool:
+        return bool(self.engine.consume_capture(int(reader), int(n)))
+
+    def capture_reader_stats(self, reader: int):
+        return self.engine.capture_reader_stats(int(reader))
+
+    def open_play_stream(self, priority: int, gain_db: float, duck_db: float) -> int:
+        return int(self.engine.open_play_stream(int(priority), float(gain_db), float(duck_db)))
+
+    def set_play_stream(self, stream: int, priority: int, gain_db: float, duck_db: float) -> bool:
+        return bool(self.engine.set_play_stream(int(stream), int(priority), float(gain_db), float(duck_db)))
+
+    def write_play_stream(self, stream: int, data: bytes) -> int:
+        return int(self.engine.write_play_stream(int(stream), data))
+
+    def flush_play_stream(self, stream: int):
+        self.engine.flush_play_stream(int(stream))
+
+    def close_play_stream(self, stream: int):
+        self.engine.close_play_stream(int(stream))
+
+    def play_stream_stats(self, stream: int):
+        return self.engine.play_stream_stats(int(stream))
+
+    def playout_mark(self, stream: int, tag: int) -> bool:
+        return bool(self.engine.playout_mark(int(stream), int(tag)))
+
+    def playout_clock(self, stream: int) -> Optional[dict]:
+        return self.engine.playout_clock(int(stream))
+
+    def playout_mark_info(self, stream: int, tag: int) -> Optional[dict]:
+        return self.engine.playout_mark_info(int(stream), int(tag))
+
+    def register_clip(self, pcm: bytes) -> int:
+        return int(self.engine.register_clip(pcm))
+
+    def unregister_clip(self, clip: int) -> bool:
+        return bool(self.engine.unregister_clip(int(clip)))
+
+    def trigger_clip(self, clip: int, gain_db: float) -> int:
+        return int(self.engine.trigger_clip(int(clip), float(gain_db)))
+
+    def stop_clip(self, voice: int) -> bool:
+        return bool(self.engine.stop_clip(int(voice)))
+
+    def event_fd(self) -> int:
+        return int(self.engine.event_fd())
+
+    def poll_events(self, max_events: int = 64):
+        return self.engine.poll_events(int(max_events))
+
+    def write_frames(self, data: bytes) -> int:
+        return int(self.engine.write(data))
+
+    def write_playback(self, data: bytes) -> int:
+        return int(self.engine.write_playback(data))
+
+    def flush_playback(self):
+        self.engine.flush_playback()
+
+    def flush_input(self):
+        self.engine.flush_input()
+
+    def set_target_headroom_ms(self, ms: int):
+        self.engine.set_target_headroom_ms(int(ms))
+
+    def start_playback_thread(self, slice_ms: int, preroll_ms: int) -> int:
+        return int(self.engine.start_playback_thread(int(slice_ms), int(preroll_ms)))
+
+    def stop_playback_thread(self):
+        self.engine.stop_playback_thread()
+
+
+# Mailbox operations (VPIO_SHM_OP_* in vpio_shm.h)
+_OP_STOP = 1
+_OP_FRAME_MS = 2
+_OP_VAD_GATE = 3
+_OP_DTX = 4
+_OP_AEC = 5
+_OP_DELAY_EST = 6
+_OP_DELAY_ESTIMATE = 7
+_OP_NS = 8
+_OP_AGC = 9
+_OP_START_REC = 10
+_OP_STOP_REC = 11
+_OP_FLUSH_PLAYBACK = 13
+_OP_FLUSH_INPUT = 14
+_OP_HEADROOM = 15
+_OP_START_PLAY_THREAD = 16
+_OP_STOP_PLAY_THREAD = 17
+_OP_CAPTURE_GATE = 18
+
+
+class _VPIORemote:
+    """Engine running in a separate vpiod process (macos/vpio_daemon.c).
+
+    Capture and playback cross shared-memory rings, so GC pauses and slow
+    handlers here can't starve the audio callbacks; the daemon keeps
+    capturing into and playing out of rings sized like the in-process ones.
+    Engine calls go through the segment's command mailbox. The libvpio
+    client functions do the mapping; this process runs no engine itself.
+    """
+
+    binding = "daemon"
+    _instances = 0
+
+    def __init__(self, lib_path: Optional[str] = None, replay: bool = False):
+        local = _VPIOLib(lib_path, replay=replay)
+        if not local.has_remote:
+            raise RuntimeError(f"{local.path} has no out-of-process client (vpio_remote_*)")
+        self.C = local.C
+        self._clib = local.lib
+        self._local = local
+        self.path = os.getenv("VPIO_DAEMON", os.path.abspath("./macos/vpiod"))
+        if not os.path.exists(self.path):
+            raise FileNotFoundError(
+                f"vpiod not found at {self.path}. Build it with: make -C macos vpiod"
+            )
+        # Debug getters would read this process's (idle) engine
+        self.lib = None
+        self.has_debug = False
+        self._proc: Optional[subprocess.Popen] = None
+        self._replay_args: list[str] = []
+        self._set_caps(
+            local.capabilities
+            & ~(
+                _CAP_DEBUG | _CAP_REMOTE | _CAP_READERS | _CAP_MIXER | _CAP_CLIPS | _CAP_EVENTS
+                | _CAP_ASYNC_START | _CAP_RING_BUDGET | _CAP_BACKPRESSURE | _CAP_PLAYOUT
+            )
+        )
+
+    def _set_caps(self, caps: int):
+        self.capabilities = caps
+        self.has_stream = bool(caps & _CAP_STREAM)
+        self.has_write_10ms = bool(caps & _CAP_PLAY_THREAD)
+        self.has_play_thread = bool(caps & _CAP_PLAY_THREAD)
+        self.has_flush = bool(caps & _CAP_FLUSH)
+        self.has_flush_input = bool(caps & _CAP_FLUSH)
+        self.has_vad_gate = bool(caps & _CAP_VAD_GATE)
+        self.has_frames = bool(caps & _CAP_FRAMES)
+        self.has_read_frames = self.has_frames
+        self.has_dtx = bool(caps & _CAP_DTX)
+        self.has_stats = bool(caps & _CAP_STATS)
+        self.has_aec = bool(caps & _CAP_AEC)
+        self.has_delay_est = bool(caps & _CAP_DELAY_EST)
+        self.has_ns = bool(caps & _CAP_NS)
+        self.has_agc = bool(caps & _CAP_AGC)
+        self.has_levels = bool(caps & _CAP_LEVELS)
+        self.has_recorder = bool(caps & _CAP_RECORDER)
+        self.has_replay = bool(caps & _CAP_REPLAY)
+        self.has_capture_gate = bool(caps & _CAP_CAPTURE_GATE)
+        # Extra readers, playback streams, clips and events live in the
+        # daemon; not exported
+        self.has_capture_readers = False
+        self.has_mixer = False
+        self.has_clips = False
+        self.has_events = False
+        # Starting spawns vpiod and waits for its segment instead
+        self.has_async_start = False
+        # vpiod keeps its default staging shrink policy; budgets are not exported
+        self.has_ring_budget = False
+        # Writability would come as an event, and events stay in vpiod
+        self.has_backpressure = False
+        # Marks and the playout clock are engine state in vpiod; not exported
+        self.has_playout = False
+
+    def _call(self, op: int, ints=(), doubles=(), path: Optional[str] = None, out=None) -> int:
+        C = self.C
+        iargs = (C.c_int32 * 4)(*[int(v) for v in ints])
+        dargs = (C.c_double * 4)(*[float(v) for v in doubles])
+        return int(self._clib.vpio_remote_call(op, iargs, dargs, os.fsencode(path) if path else None, out))
+
+    def start_stream(self, sr: int, ch: int, cap_bytes: int) -> bool:
+        _VPIORemote._instances += 1
+        name = f"/vpio-{os.getpid()}-{_VPIORemote._instances}"
+        args = [self.path, name, str(int(sr)), str(int(ch)), str(int(cap_bytes))] + self._replay_args
+        self._proc = subprocess.Popen(args)
+        if self._clib.vpio_remote_attach(name.encode(), 5000) != 0:
+            logger.error(f"vpiod did not come up (exit code {self._proc.poll()})")
+            self._reap()
+            return False
+        self._set_caps(int(self._clib.vpio_remote_capabilities()))
+        logger.info(f"VPIO engine running out of process (vpiod pid {self._proc.pid})")
+        return True
+
+    def stop_stream(self):
+        if self._proc is None:
+            return
+        self._call(_OP_STOP)
+        self._clib.vpio_remote_detach()
+        self._reap()
+
+    def _reap(self):
+        proc, self._proc = self._proc, None
+        try:
+            proc.wait(timeout=3)
+        except subprocess.TimeoutExpired:
+            logger.warning("vpiod did not exit; killing it")
+            proc.kill()
+            proc.wait()
+
+    def get_stats(self):
+        st = self._local.Stats()
+        self._clib.vpio_remote_get_stats(self.C.byref(st), self.C.sizeof(st))
+        return st
+
+    def set_replay(self, capture_path, playback_path, realtime: bool, pattern) -> bool:
+        args = ["--replay", os.fspath(capture_path)] if capture_path else []
+        if capture_path and playback_path:
+            args += ["--replay-out", os.fspath(playback_path)]
+        if capture_path and not realtime:
+            args.append("--replay-fast")
+        if capture_path and pattern:
+            args += ["--replay-pattern", ",".join(str(int(n)) for n in pattern)]
+        self._replay_args = args
+        return True
+
+    def set_vad_gate(self, enabled: bool, margin_db: float, hangover_ms: int, onset_blocks: int):
+        self._call(_OP_VAD_GATE, (int(enabled), hangover_ms, onset_blocks), (margin_db,))
+
+    def set_dtx(self, enabled: bool, keepalive_ms: int):
+        self._call(_OP_DTX, (int(enabled), keepalive_ms))
+
+    def set_capture_frame_ms(self, ms: int) -> int:
+        return max(0, self._call(_OP_FRAME_MS, (ms,)))
+
+    def set_aec(self, enabled: bool, tail_ms: int, delay_ms: int) -> bool:
+        return self._call(_OP_AEC, (int(enabled), tail_ms, delay_ms)) == 0
+
+    def set_delay_estimator(self, enabled: bool, max_delay_ms: int) -> bool:
+        return self._call(_OP_DELAY_EST, (int(enabled), max_delay_ms)) == 0
+
+    def get_delay_estimate(self):
+        out = (self.C.c_double * 2)()
+        if self._call(_OP_DELAY_ESTIMATE, out=out) != 1:
+            return None
+        return out[0], out[1]
+
+    def set_noise_suppressor(self, enabled: bool, max_atten_db: float, budget_pct: int) -> bool:
+        return self._call(_OP_NS, (int(enabled), budget_pct), (max_atten_db,)) == 0
+
+    def set_agc(
+        self, direction: int, enabled: bool, target_dbfs: float, max_gain_db: float, ceiling_dbfs: float
+    ) -> bool:
+        return self._call(_OP_AGC, (direction, int(enabled)), (target_dbfs, max_gain_db, ceiling_dbfs)) == 0
+
+    def start_recording(self, path_prefix: str, fmt: int, taps: int) -> bool:
+        return self._call(_OP_START_REC, (fmt, taps), path=os.path.abspath(os.fspath(path_prefix))) == 0
+
+    def stop_recording(self):
+        self._call(_OP_STOP_REC)
+
+    def get_levels(self, direction: int, max_entries: int):
+        buf = self._local._levels_buf
+        n = int(self._clib.vpio_remote_get_levels(int(direction), buf, min(int(max_entries), len(buf))))
+        return [(e.seq, e.rms, e.peak, e.clipped, e.samples) for e in buf[:n]]
+
+    def alloc_frames(self, max_frames: int, frame_bytes: int):
+        cbuf = (self.C.c_ubyte * (frame_bytes * max_frames))()
+        return cbuf, (self._local.FrameInfo * max_frames)()
+
+    def read_frames(self, bufs, max_frames: int, frame_bytes: int):
+        cbuf, infos = bufs
+        n = int(self._clib.vpio_remote_read_frames(cbuf, max_frames, frame_bytes, infos))
+        return infos[:n]
+
+    def write_frames(self, data: bytes) -> int:
+        return self.write_playback(data)
+
+    def write_playback(self, data: bytes) -> int:
+        c_arr = (self.C.c_ubyte * len(data)).from_buffer_copy(data)
+        return int(self._clib.vpio_remote_write_playback(c_arr, len(data)))
+
+    def flush_playback(self):
+        self._call(_OP_FLUSH_PLAYBACK)
+
+    def flush_input(self):
+        self._call(_OP_FLUSH_INPUT)
+
+    def set_target_headroom_ms(self, ms: int):
+        self._call(_OP_HEADROOM, (ms,))
+
+    def start_playback_thread(self, slice_ms: int, preroll_ms: int) -> int:
+        return self._call(_OP_START_PLAY_THREAD, (slice_ms, preroll_ms))
+
+    def stop_playback_thread(self):
+        self._call(_OP_STOP_PLAY_THREAD)
+
+    def set_capture_gate(self, gate: int, keep_echo: bool) -> bool:
+        return self._call(_OP_CAPTURE_GATE, (gate, 1 if keep_echo else 0)) == 0
+
+
+def _find_extension() -> Optional[str]:
+    here = os.path.dirname(os.path.abspath(__file__))
+    for suffix in importlib.machinery.EXTENSION_SUFFIXES:
+        path = os.path.join(here, "_vpio" + suffix)
+        if os.path.exists(path):
+            return path
+    return None
+
+
+def _load_vpio(lib_path: Optional[str], binding: str, replay: bool = False):
+    """Pick the helper binding: compiled extension when available, else ctypes."""
+    binding = os.getenv("VPIO_BINDING", binding or "auto")
+    if binding == "daemon":
+        return _VPIORemote(lib_path, replay=replay)
+    if binding == "extension":
+        return _VPIOExt(replay=replay)
+    if binding == "auto" and lib_path is None and (os.getenv("VPIO_EXT") or _find_extension()):
+        try:
+            return _VPIOExt(replay=replay)
+        except Exception:
+            logger.exception("Failed to load VPIO extension; falling back to ctypes")
+    return _VPIOLib(lib_path, replay=replay)
+
+
 class MacInputTransport(BaseInputTransport):
     _params: LocalMacTransportParams
 
@@ -191,6 +1379,12 @@ class MacInputTransport(BaseInputTransport):
         self._sample_rate = 0
         self._poll_task: Optional[asyncio.Task] = None
         self._stop = False
+        self._use_gate = False
+        self._use_dtx = False
+        self._gate_lookback: collections.deque[bytes] = collections.deque()
+        self._gate_skipped = 0
+        self._gate_analyzed = 0
+        self._gate_analyzer_cpu = 0.0
 
     async def start(self, frame: StartFrame):
         await super().start(frame)
@@ -200,9 +1394,30 @@ class MacInputTransport(BaseInputTransport):
         except Exception:
             logger.exception("Error starting VPIO stream for input")
         self._sample_rate = self._params.audio_in_sample_rate or frame.audio_in_sample_rate
-        # Start polling capture ring
+        # Configure the native VAD pre-gate before capture starts flowing
+        self._use_gate = bool(self._params.vad_pregate and self._vpio.has_vad_gate)
+        self._use_dtx = bool(self._params.dtx and self._vpio.has_dtx)
+        if self._use_gate or self._use_dtx:
+            self._vpio.set_vad_gate(
+                True,
+                self._params.vad_pregate_margin_db,
+                self._params.vad_pregate_hangover_ms,
+                self._params.vad_pregate_onset_blocks,
+            )
+            self._gate_lookback = collections.deque(
+                maxlen=max(1, self._params.vad_pregate_lookback_ms // max(1, self._params.capture_frame_ms))
+            )
+        elif self._params.vad_pregate or self._params.dtx:
+            logger.info("VPIO VAD pre-gate/DTX requested but not available in helper")
+        if self._use_dtx:
+            self._vpio.set_dtx(True, self._params.dtx_keepalive_ms)
+        # Start polling capture ring; prefer whole frames from the helper
         self._stop = False
-        self._poll_task = self.create_task(self._poll_capture())
+        if self._vpio.has_frames:
+            self._vpio.set_capture_frame_ms(self._params.capture_frame_ms)
+            self._poll_task = self.create_task(self._poll_frames())
+        else:
+            self._poll_task = self.create_task(self._poll_capture())
         await self.set_transport_ready(frame)
         # Notify parent that input is ready
         try:
@@ -211,7 +1426,7 @@ class MacInputTransport(BaseInputTransport):
             logger.exception("Error notifying parent of input ready")
         # Optional debug dump
         if os.getenv("VPIO_DEBUG"):
-            if self._vpio.has_debug:
+            if self._vpio.has_debug and self._vpio.lib is not None:
                 C = self._vpio.C
                 bypass = C.c_uint(0)
                 rc = self._vpio.lib.vpio_get_bypass(C.byref(bypass))
@@ -254,6 +1469,9 @@ class MacInputTransport(BaseInputTransport):
         C = self._vpio.C
         bytes_per_20ms = int(self._sample_rate * 0.02) * self._params.audio_in_channels * 2
         buf = bytearray()
+        # Capture byte offset of buf[0]; only tracked when the gate is in use
+        buf_pos = 0
+        pos = C.c_size_t(0)
         # Sane buffer to read from helper in chunks
         read_chunk = max(bytes_per_20ms, 1024)
         cbuf = (C.c_ubyte * read_chunk)()
@@ -261,7 +1479,14 @@ class MacInputTransport(BaseInputTransport):
             try:
                 n = 0
                 try:
-                    n = int(self._vpio.lib.vpio_read_capture(cbuf, read_chunk))
+                    if self._use_gate:
+                        n = int(self._vpio.lib.vpio_read_capture_pos(cbuf, read_chunk, C.byref(pos)))
+                        if n > 0 and pos.value != buf_pos + len(buf):
+                            # Ring overran (or first read): realign, dropping the partial frame
+                            buf.clear()
+                            buf_pos = pos.value
+                    else:
+                        n = int(self._vpio.lib.vpio_read_capture(cbuf, read_chunk))
                 except AttributeError:
                     # Fallback: periodic record small chunk (not ideal, but keeps example working)
                     self._vpio.lib.vpio_record(C.c_double(0.02))
@@ -287,6 +1512,10 @@ class MacInputTransport(BaseInputTransport):
                         sample_rate=self._sample_rate,
                         num_channels=self._params.audio_in_channels,
                     )
+                    if self._use_gate:
+                        gate = int(self._vpio.lib.vpio_vad_gate_query(buf_pos, bytes_per_20ms))
+                        frame.metadata["vpio_vad_gate"] = gate
+                        buf_pos += bytes_per_20ms
                     await self.push_audio_frame(frame)
 
                 await asyncio.sleep(0.005)
@@ -296,6 +1525,95 @@ class MacInputTransport(BaseInputTransport):
                 logger.warning(f"VPIO poll error: {e}")
                 await asyncio.sleep(0.02)
 
+    async def _poll_frames(self):
+        """Forward whole capture frames delivered by the helper.
+
+        Each frame carries its capture sample index, host-clock timestamp
+        (same clock as time.monotonic_ns on macOS) and gate/DTX marks in
+        frame.metadata, so VAD/STT events map to exact audio positions.
+        """
+        frame_bytes = int(self._sample_rate * self._params.capture_frame_ms / 1000) * (
+            self._params.audio_in_channels * 2
+        )
+        # Batched reads drain everything available in one FFI call per poll
+        max_frames = 16 if self._vpio.has_read_frames else 1
+        bufs = self._vpio.alloc_frames(max_frames, frame_bytes)
+        view = memoryview(bufs[0] if isinstance(bufs, tuple) else bufs).cast("B")
+        while not self._stop:
+            try:
+                while True:
+                    infos = self._vpio.read_frames(bufs, max_frames, frame_bytes)
+                    for i, info in enumerate(infos):
+                        frame = InputAudioRawFrame(
+                            audio=view[i * frame_bytes : (i + 1) * frame_bytes].tobytes(),
+                            sample_rate=self._sample_rate,
+                            num_channels=self._params.audio_in_channels,
+                        )
+                        self._annotate_frame(frame, info)
+                        await self.push_audio_frame(frame)
+                    if len(infos) < max_frames:
+                        break
+                await asyncio.sleep(0.005)
+            except asyncio.CancelledError:
+                break
+            except Exception as e:
+                logger.warning(f"VPIO poll error: {e}")
+                await asyncio.sleep(0.02)
+
+    def _annotate_frame(self, frame: InputAudioRawFrame, info: Any):
+        md = frame.metadata
+        md["vpio_seq"] = int(info.seq)
+        md["vpio_sample_index"] = int(info.sample_index)
+        if info.host_time_ns:
+            md["vpio_host_time_ns"] = int(info.host_time_ns)
+        if info.silence_before:
+            md["vpio_silence_samples"] = int(info.silence_before)
+        if info.flags & _FRAME_OVERRUN:
+            md["vpio_overrun"] = True
+        if info.flags & _FRAME_VAD_KNOWN:
+            md["vpio_vad_gate"] = 1 if info.flags & _FRAME_VAD_OPEN else 0
+        else:
+            md["vpio_vad_gate"] = -1
+
+    async def _vad_analyze(self, audio_frame: InputAudioRawFrame) -> VADState:
+        """Run the VAD analyzer only on frames the native pre-gate left open.
+
+        Gated-off frames report QUIET and are kept in a short lookback buffer;
+        when the gate opens they are replayed into the analyzer first so its
+        onset window sees the start of the utterance.
+        """
+        if not self._use_gate or not self.vad_analyzer:
+            return await super()._vad_analyze(audio_frame)
+        gate = audio_frame.metadata.get("vpio_vad_gate", -1)
+        if gate == 0:
+            self._gate_lookback.append(audio_frame.audio)
+            self._gate_skipped += 1
+            return VADState.QUIET
+        chunks = list(self._gate_lookback)
+        self._gate_lookback.clear()
+        chunks.append(audio_frame.audio)
+        state = await asyncio.get_running_loop().run_in_executor(
+            None, self._analyze_timed, self.vad_analyzer, chunks
+        )
+        # Replayed lookback frames were analyzed after all
+        self._gate_skipped -= len(chunks) - 1
+        self._gate_analyzed += len(chunks)
+        return state
+
+    def _analyze_timed(self, analyzer, chunks: list[bytes]) -> VADState:
+        # Executor thread: thread CPU time covers the analyzer only
+        t0 = time.thread_time()
+        state = VADState.QUIET
+        for a in chunks:
+            state = analyzer.analyze_audio(a)
+        self._gate_analyzer_cpu += time.thread_time() - t0
+        return state
+
+    def gate_stats(self) -> tuple[int, int, float]:
+        """Return (frames the analyzer never saw, frames sent to the analyzer,
+        analyzer CPU seconds spent on the analyzed frames)."""
+        return self._gate_skipped, self._gate_analyzed, self._gate_analyzer_cpu
+
     async def push_app_message(self, message: Any):
         """Push an application message into the input side of the pipeline.
 
@@ -322,15 +1640,15 @@ class MacOutputTransport(BaseOutputTransport):
         self._pacer_max_dt: float = 0.0
         self._pacer_slow_count: int = 0
         # Optional flush API
-        try:
-            self._vpio.lib.vpio_flush_playback.argtypes = []
-            self._vpio.lib.vpio_flush_playback.restype = None
-            self._has_flush = True
-        except Exception:
-            self._has_flush = False
+        self._has_flush = getattr(self._vpio, "has_flush", False)
         # Capability flags from helper
         self._has_play_thread = getattr(self._vpio, "has_play_thread", False)
         self._has_write_10ms = getattr(self._vpio, "has_write_10ms", False)
+        # Waits on the writable event when the helper refuses a write
+        self._bounded: bool = False
+        # Utterance tags from mark_utterance, placed in the helper at the next
+        # write so they land behind audio still queued in the pipeline
+        self._marks: collections.deque[int] = collections.deque()
 
     async def start(self, frame: StartFrame):
         # Initialize base (sample rate, chunking)
@@ -344,15 +1662,20 @@ class MacOutputTransport(BaseOutputTransport):
         if self._has_play_thread and self._has_write_10ms:
             # Configure headroom and start thread
             try:
-                self._vpio.lib.vpio_set_target_headroom_ms(self._params.playback_headroom_ms)
+                self._vpio.set_target_headroom_ms(self._params.playback_headroom_ms)
             except Exception:
                 pass
-            rc = self._vpio.lib.vpio_start_playback_thread(
-                self._params.slice_ms, self._params.preroll_ms
-            )
+            rc = self._vpio.start_playback_thread(self._params.slice_ms, self._params.preroll_ms)
             if rc != 0:
                 logger.warning("VPIO playback thread failed to start; falling back to Python pacer")
                 self._has_play_thread = False
+            elif self._params.playback_max_ahead_secs > 0:
+                if not getattr(self._vpio, "has_backpressure", False):
+                    logger.info("VPIO bounded playback requested but not available in helper")
+                else:
+                    high = int(self._params.playback_max_ahead_secs * self.sample_rate)
+                    high *= self._params.audio_out_channels * 2
+                    self._bounded = self._vpio.set_playback_watermarks(high)
         if not self._has_play_thread or not self._has_write_10ms:
             self._play_queue = asyncio.Queue()
             self._play_task = self.create_task(self._playback_pacer())
@@ -373,10 +1696,11 @@ class MacOutputTransport(BaseOutputTransport):
         if self._metrics_task:
             await self.cancel_task(self._metrics_task)
             self._metrics_task = None
+        self._release_bounded()
         # Stop C playback thread if running
         if self._has_play_thread:
             try:
-                self._vpio.lib.vpio_stop_playback_thread()
+                self._vpio.stop_playback_thread()
             except Exception:
                 pass
         await super().stop(frame)
@@ -393,9 +1717,10 @@ class MacOutputTransport(BaseOutputTransport):
         if self._metrics_task:
             await self.cancel_task(self._metrics_task)
             self._metrics_task = None
+        self._release_bounded()
         if self._has_play_thread:
             try:
-                self._vpio.lib.vpio_stop_playback_thread()
+                self._vpio.stop_playback_thread()
             except Exception:
                 pass
         await super().cancel(frame)
@@ -405,6 +1730,26 @@ class MacOutputTransport(BaseOutputTransport):
         except Exception:
             logger.exception("Error notifying parent of output cancel")
 
+    def _release_bounded(self):
+        if self._bounded:
+            self._bounded = False
+            self._vpio.set_playback_watermarks(0)
+
+    async def _write_bounded(self, audio: bytes) -> int:
+        # Refused while the helper holds playback_max_ahead_secs; wait for
+        # PLAYBACK_WRITABLE. The timeout only covers a missed event.
+        writable = self._parent._playback_writable
+        while self._bounded:
+            writable.clear()
+            written = self._vpio.write_frames(audio)
+            if written:
+                return written
+            try:
+                await asyncio.wait_for(writable.wait(), 1.0)
+            except asyncio.TimeoutError:
+                pass
+        return self._vpio.write_frames(audio)
+
     async def write_audio_frame(self, frame: OutputAudioRawFrame):
         if not frame.audio:
             return
@@ -432,11 +1777,18 @@ class MacOutputTransport(BaseOutputTransport):
         except Exception:
             pass
         if self._has_play_thread and self._has_write_10ms:
+            self._place_marks()
             # Push 10ms frames directly into helper staging ring
-            C = self._vpio.C
-            c_arr = (C.c_ubyte * len(frame.audio)).from_buffer_copy(frame.audio)
             try:
-                _ = self._vpio.lib.vpio_write_frame_10ms(c_arr, len(frame.audio))
+                if self._bounded:
+                    written = await self._write_bounded(frame.audio)
+                else:
+                    written = self._vpio.write_frames(frame.audio)
+                if written < len(frame.audio) and now - self._warn_ts >= 1.0:
+                    logger.warning(
+                        f"VPIO staging ring full; dropped {len(frame.audio) - written} bytes"
+                    )
+                    self._warn_ts = now
             except Exception as e:
                 logger.warning(f"vpio_write_frame_10ms failed: {e}; falling back to pacer queue")
                 if self._play_queue is None:
@@ -446,10 +1798,15 @@ class MacOutputTransport(BaseOutputTransport):
             # Enqueue raw bytes; pacer will slice to 10ms and feed helper at ~real-time
             if self._play_queue is None:
                 self._play_queue = asyncio.Queue()
+            while self._marks:
+                await self._play_queue.put(self._marks.popleft())
             await self._play_queue.put(frame.audio)
 
+    def _place_marks(self):
+        while self._marks:
+            self._vpio.playout_mark(0, self._marks.popleft())
+
     async def _playback_pacer(self):
-        C = self._vpio.C
         bytes_per_10ms = int(self.sample_rate / 100) * self._params.audio_out_channels * 2
         bytes_per_5ms = max(1, bytes_per_10ms // 2)
         buf = bytearray()
@@ -457,17 +1814,16 @@ class MacOutputTransport(BaseOutputTransport):
             while True:
                 if not buf:
                     chunk = await self._play_queue.get()
+                    if isinstance(chunk, int):
+                        # Utterance tag queued ahead of its audio
+                        self._vpio.playout_mark(0, chunk)
+                        continue
                     buf.extend(chunk)
                 # Write out in 5ms slices to pace near real-time
                 while len(buf) >= bytes_per_5ms:
                     slice = bytes(buf[:bytes_per_5ms])
                     del buf[:bytes_per_5ms]
-                    c_arr = (C.c_ubyte * len(slice)).from_buffer_copy(slice)
-                    try:
-                        self._vpio.lib.vpio_write_playback(c_arr, len(slice))
-                    except AttributeError:
-                        # Fallback to blocking play (will be choppy, but avoids crashing)
-                        self._vpio.lib.vpio_play(c_arr, len(slice))
+                    self._vpio.write_playback(slice)
                     # Pacer metrics and pacing
                     now = asyncio.get_running_loop().time()
                     if self._pacer_last_ts is not None:
@@ -508,8 +1864,38 @@ class MacOutputTransport(BaseOutputTransport):
                 underflows = 0
                 ring_play = C.c_size_t(0)
                 ring_cap = C.c_size_t(0)
+                stage = 0
+                stage_cap = 0
+                vad_total = vad_open = dtx_sent = dtx_suppressed = 0
+                aec_erle = None
+                delay_est = None
+                ns_info = None
+                agc_info = None
+                rec_info = None
+                stats = self._vpio.get_stats()
                 try:
-                    if self._vpio.has_debug:
+                    if stats is not None:
+                        # One FFI call for everything below
+                        underflows = int(stats.underflows)
+                        ring_cap.value = stats.cap_level
+                        ring_play.value = stats.play_level
+                        stage = int(stats.staging_level)
+                        stage_cap = int(stats.staging_capacity)
+                        vad_total = int(stats.vad_blocks)
+                        vad_open = int(stats.vad_open_blocks)
+                        dtx_sent = int(stats.dtx_frames_sent)
+                        dtx_suppressed = int(stats.dtx_frames_suppressed)
+                        if self._params.software_aec and stats.aec_blocks:
+                            aec_erle = float(stats.aec_erle_db)
+                        if stats.delay_ms >= 0:
+                            delay_est = (float(stats.delay_ms), float(stats.delay_confidence))
+                        if self._params.noise_suppression and stats.ns_blocks:
+                            ns_info = (float(stats.ns_noise_dbfs), int(stats.ns_over_budget))
+                        if self._params.agc:
+                            agc_info = (float(stats.agc_capture_gain_db), float(stats.agc_capture_limit_db))
+                        if stats.rec_bytes:
+                            rec_info = (int(stats.rec_bytes), int(stats.rec_dropped))
+                    elif self._vpio.has_debug and self._vpio.lib is not None:
                         underflows = int(self._vpio.lib.vpio_get_underflow_count())
                         _ = self._vpio.lib.vpio_get_ring_levels(
                             C.byref(ring_cap), C.byref(ring_play)
@@ -525,9 +1911,42 @@ class MacOutputTransport(BaseOutputTransport):
                     pass
                 delta_uf = underflows - last_underflows
                 last_underflows = underflows
+                gate_info = ""
+                if stats is None and getattr(self._vpio, "has_vad_gate", False):
+                    total = C.c_size_t(0)
+                    opened = C.c_size_t(0)
+                    self._vpio.lib.vpio_get_vad_stats(C.byref(total), C.byref(opened))
+                    vad_total, vad_open = total.value, opened.value
+                if stats is None and getattr(self._vpio, "has_dtx", False):
+                    sent = C.c_size_t(0)
+                    suppressed = C.c_size_t(0)
+                    self._vpio.lib.vpio_get_dtx_stats(C.byref(sent), C.byref(suppressed))
+                    dtx_sent, dtx_suppressed = sent.value, suppressed.value
+                inp = self._parent._input
+                if vad_total and inp is not None and inp._use_gate:
+                    skipped, analyzed, cpu = inp.gate_stats()
+                    # Skipped frames priced at the measured mean analyzer cost, over session audio time
+                    saved_ms = skipped * cpu / analyzed * 1000 if analyzed else 0.0
+                    audio_s = (skipped + analyzed) * self._params.capture_frame_ms / 1000
+                    gate_info = (
+                        f" vadGate={vad_open}/{vad_total} vadSkipped={skipped}/{skipped + analyzed}"
+                        f" vadCpuSaved={saved_ms:.0f}ms/{audio_s:.0f}s"
+                    )
+                if inp is not None and inp._use_dtx:
+                    gate_info += f" dtx={dtx_sent}/{dtx_sent + dtx_suppressed}"
+                if aec_erle is not None:
+                    gate_info += f" erle={aec_erle:.1f}dB"
+                if delay_est is not None:
+                    gate_info += f" echoDelay={delay_est[0]:.0f}ms(conf={delay_est[1]:.2f})"
+                if ns_info is not None:
+                    gate_info += f" nsFloor={ns_info[0]:.1f}dBFS nsOverBudget={ns_info[1]}"
+                if agc_info is not None:
+                    gate_info += f" agc={agc_info[0]:+.1f}dB limit={agc_info[1]:.1f}dB"
+                if rec_info is not None:
+                    gate_info += f" rec={rec_info[0] // 1024}KiB recDropped={rec_info[1]}"
                 try:
                     logger.info(
-                        f"VPIO pacer: avg={avg * 1000:.2f}ms max={mx * 1000:.2f}ms slow(>12ms)={slow} underflows+={delta_uf} playRing={ring_play.value} capRing={ring_cap.value} stageRing={stage}/{stage_cap}"
+                        f"VPIO pacer: avg={avg * 1000:.2f}ms max={mx * 1000:.2f}ms slow(>12ms)={slow} underflows+={delta_uf} playRing={ring_play.value} capRing={ring_cap.value} stageRing={stage}/{stage_cap}{gate_info}"
                     )
                 except Exception:
                     logger.info(
@@ -541,7 +1960,10 @@ class MacOutputTransport(BaseOutputTransport):
             return
         try:
             while True:
-                self._play_queue.get_nowait()
+                chunk = self._play_queue.get_nowait()
+                # Still place dropped tags so they report nothing heard
+                if isinstance(chunk, int):
+                    self._vpio.playout_mark(0, chunk)
         except asyncio.QueueEmpty:
             pass
 
@@ -550,10 +1972,8 @@ class MacOutputTransport(BaseOutputTransport):
         if isinstance(frame, StartInterruptionFrame):
             await self._clear_play_queue()
             try:
-                if self._has_flush:
-                    self._vpio.lib.vpio_flush_playback()
-                if getattr(self._vpio, "has_flush_input", False):
-                    self._vpio.lib.vpio_flush_input()
+                self._vpio.flush_playback()
+                self._vpio.flush_input()
             except Exception:
                 pass
         await super().process_frame(frame, direction)
@@ -566,6 +1986,109 @@ class MacOutputTransport(BaseOutputTransport):
             logger.exception("Error emitting transport message")
 
 
+class VPIOCaptureReader:
+    """Independent tap on the helper's capture ring (see open_capture_reader).
+
+    Has its own cursor, so a slow consumer here (a recorder, a second
+    recognizer) never holds back the transport's own capture, and the
+    transport never holds it back. If it falls a whole ring behind, the
+    helper skips it ahead: its next frame has FRAME_OVERRUN set and stats()
+    counts the loss.
+    """
+
+    def __init__(self, vpio, reader: int, frame_bytes: int, max_frames: int = 16):
+        self._vpio = vpio
+        self.reader = reader
+        self.frame_bytes = frame_bytes
+        self._max_frames = max_frames
+        self._bufs = vpio.alloc_frames(max_frames, frame_bytes)
+        self._view = memoryview(self._bufs[0] if isinstance(self._bufs, tuple) else self._bufs).cast("B")
+
+    def read_frames(self) -> list:
+        """Whole capture frames available to this reader, as (pcm, FrameInfo)."""
+        if self.reader < 0:
+            return []
+        fb = self.frame_bytes
+        infos = self._vpio.read_reader_frames(self.reader, self._bufs, self._max_frames, fb)
+        return [(self._view[i * fb : (i + 1) * fb].tobytes(), info) for i, info in enumerate(infos)]
+
+    def peek(self, max_bytes: int):
+        """(capture byte offset, [memoryview]) over unread bytes without copying.
+
+        The views point into the ring: finish with them, then call consume();
+        if it returns False the writer overwrote them meanwhile and what was
+        read from them must be discarded.
+        """
+        return self._vpio.peek_capture(self.reader, max_bytes)
+
+    def consume(self, n: int) -> bool:
+        return self._vpio.consume_capture(self.reader, n)
+
+    def stats(self):
+        """(overruns, dropped_bytes, backlog_bytes), or None once closed."""
+        return self._vpio.capture_reader_stats(self.reader) if self.reader >= 0 else None
+
+    def close(self):
+        if self.reader >= 0:
+            self._vpio.close_capture_reader(self.reader)
+            self.reader = -1
+
+
+class VPIOPlaybackStream:
+    """Extra playback stream mixed over the bot's voice (see open_playback_stream).
+
+    For earcons and notifications: audio queued here plays alongside TTS
+    instead of being spliced into it, and a barge-in flush of TTS leaves it
+    alone. PCM must be 16-bit at the stream rate and channel count.
+    """
+
+    def __init__(self, vpio, stream: int, bytes_per_ms: int):
+        self._vpio = vpio
+        self.stream = stream
+        self._bytes_per_ms = bytes_per_ms
+
+    def write(self, pcm: bytes) -> int:
+        """Queue as much of pcm as fits; returns the bytes accepted."""
+        return self._vpio.write_play_stream(self.stream, pcm) if self.stream > 0 else 0
+
+    async def play(self, pcm: bytes):
+        """Queue all of pcm, waiting for room when the stream's ring is full."""
+        view = memoryview(pcm)
+        while view and self.stream > 0:
+            n = self.write(view.tobytes())
+            view = view[n:]
+            if view:
+                await asyncio.sleep(0.01)
+
+    def flush(self):
+        """Drop what is still queued on this stream only."""
+        if self.stream > 0:
+            self._vpio.flush_play_stream(self.stream)
+
+    def configure(self, priority: int, gain_db: float = 0.0, duck_db: float = 0.0) -> bool:
+        return self._vpio.set_play_stream(self.stream, priority, gain_db, duck_db) if self.stream > 0 else False
+
+    def queued_ms(self) -> float:
+        st = self._vpio.play_stream_stats(self.stream) if self.stream > 0 else None
+        return st[0] / self._bytes_per_ms if st else 0.0
+
+    def mark(self, tag: int) -> bool:
+        """Tag the next sample written here; see LocalMacTransport.heard."""
+        if self.stream <= 0 or not getattr(self._vpio, "has_playout", False):
+            return False
+        return self._vpio.playout_mark(self.stream, tag)
+
+    def heard(self, tag: int) -> Optional[dict]:
+        if self.stream <= 0 or not getattr(self._vpio, "has_playout", False):
+            return None
+        return self._vpio.playout_mark_info(self.stream, tag)
+
+    def close(self):
+        if self.stream > 0:
+            self._vpio.close_play_stream(self.stream)
+            self.stream = -1
+
+
 class LocalMacTransport(BaseTransport):
     """Local macOS transport using VoiceProcessingIO (VPIO).
 
@@ -575,18 +2098,20 @@ class LocalMacTransport(BaseTransport):
     """
     def __init__(self, params: LocalMacTransportParams, lib_path: Optional[str] = None):
         super().__init__()
-        if not _is_macos():
-            raise RuntimeError("LocalMacTransport only supported on macOS")
+        replay = bool(params.replay_capture_path)
+        if not _is_macos() and not replay:
+            raise RuntimeError("LocalMacTransport only supported on macOS (or with a replay device)")
         self._params = params
-        self._vpio = _VPIOLib(lib_path)
+        self._vpio = _load_vpio(lib_path, params.engine_binding, replay=replay)
         logger.info(
-            f"Loaded VPIO helper: {self._vpio.path} (streaming={'yes' if self._vpio.has_stream else 'no'})"
+            f"Loaded VPIO helper: {self._vpio.path} via {self._vpio.binding} (streaming={'yes' if self._vpio.has_stream else 'no'})"
         )
         # Register compatible connection & message events
         self._register_event_handler("on_client_connected")
         self._register_event_handler("on_client_disconnected")
         self._register_event_handler("on_app_message")
         self._register_event_handler("on_transport_message")
+        self._register_event_handler("on_clip_finished")
 
         # Track readiness of sides
         required: Set[str] = set()
@@ -602,6 +2127,9 @@ class LocalMacTransport(BaseTransport):
         self._stream_started: bool = False
         self._input: Optional[MacInputTransport] = None
         self._output: Optional[MacOutputTransport] = None
+        self._event_fd: int = -1
+        self._stream_ready = asyncio.Event()
+        self._playback_writable = asyncio.Event()
 
     def input(self) -> FrameProcessor:
         if not self._input:
@@ -675,12 +2203,300 @@ class LocalMacTransport(BaseTransport):
             * ch
             * 2
         )
-        if not self._vpio.start_stream(sr, ch, cap_bytes):
+        if self._params.replay_capture_path:
+            if not getattr(self._vpio, "has_replay", False):
+                raise RuntimeError("VPIO replay device requested but not available in helper")
+            if not self._vpio.set_replay(
+                self._params.replay_capture_path,
+                self._params.replay_playback_path,
+                self._params.replay_realtime,
+                self._params.replay_block_frames,
+            ):
+                raise RuntimeError("VPIO replay device could not be configured")
+            logger.info(f"VPIO replaying {self._params.replay_capture_path}")
+        if getattr(self._vpio, "has_ring_budget", False):
+            budget = int(self._params.staging_budget_secs * sr * ch) * 2
+            self._vpio.set_ring_budget(
+                _RINGS["staging"], budget, self._params.staging_shrink_after_ms
+            )
+        self._watch_events()
+        if not await self._start_engine(sr, ch, cap_bytes):
             raise RuntimeError("Failed to start VPIO stream")
         self._stream_started = True
+        if self._params.delay_estimator:
+            if not getattr(self._vpio, "has_delay_est", False):
+                logger.info("VPIO delay estimator requested but not available in helper")
+            elif not self._vpio.set_delay_estimator(True, self._params.delay_estimator_max_ms):
+                logger.warning("VPIO delay estimator could not be enabled")
+        if self._params.software_aec:
+            if not getattr(self._vpio, "has_aec", False):
+                logger.info("VPIO software AEC requested but not available in helper")
+            elif not self._vpio.set_aec(
+                True, self._params.software_aec_tail_ms, self._params.software_aec_delay_ms
+            ):
+                logger.warning("VPIO software AEC could not be enabled")
+        if self._params.noise_suppression:
+            if not getattr(self._vpio, "has_ns", False):
+                logger.info("VPIO noise suppression requested but not available in helper")
+            elif not self._vpio.set_noise_suppressor(
+                True,
+                self._params.noise_suppression_max_db,
+                self._params.noise_suppression_budget_pct,
+            ):
+                logger.warning("VPIO noise suppression could not be enabled")
+        for direction, enabled, target, max_gain in (
+            (_DIR_CAPTURE, self._params.agc, self._params.agc_target_dbfs, self._params.agc_max_gain_db),
+            (_DIR_PLAYBACK, self._params.playback_agc, self._params.playback_agc_target_dbfs, 0.0),
+        ):
+            if not enabled:
+                continue
+            if not getattr(self._vpio, "has_agc", False):
+                logger.info("VPIO AGC requested but not available in helper")
+                break
+            if not self._vpio.set_agc(direction, True, target, max_gain, self._params.limiter_ceiling_dbfs):
+                logger.warning("VPIO AGC could not be enabled")
+        record_path = self._params.record_path or os.getenv("VPIO_RECORD")
+        if record_path:
+            fmt = _REC_FORMATS.get(self._params.record_format)
+            if not getattr(self._vpio, "has_recorder", False):
+                logger.info("VPIO session recording requested but not available in helper")
+            elif fmt is None:
+                logger.warning(f"Unknown record_format {self._params.record_format!r}; not recording")
+            elif not self._vpio.start_recording(record_path, fmt, _REC_TAPS_ALL):
+                logger.warning(f"VPIO session recording to {record_path} could not be started")
+            else:
+                logger.info(f"Recording VPIO session to {record_path} ({self._params.record_format})")
+
+    def _watch_events(self):
+        if getattr(self._vpio, "has_events", False) and self._event_fd < 0:
+            fd = self._vpio.event_fd()
+            if fd >= 0:
+                asyncio.get_running_loop().add_reader(fd, self._on_vpio_events)
+                self._event_fd = fd
+
+    async def _start_engine(self, sr: int, ch: int, cap_bytes: int) -> bool:
+        """Start the helper's stream, keeping device bring-up off the event loop when it can."""
+        if not getattr(self._vpio, "has_async_start", False):
+            return self._vpio.start_stream(sr, ch, cap_bytes)
+        self._stream_ready.clear()
+        if not self._vpio.start_stream_async(sr, ch, cap_bytes):
+            return False
+        # STREAM_STARTED wakes us; the timeout only covers a missed event
+        while (rc := self._vpio.start_stream_result()) is None:
+            try:
+                await asyncio.wait_for(self._stream_ready.wait(), 0.1)
+            except asyncio.TimeoutError:
+                pass
+        if rc != 0:
+            return False
+        t = self._vpio.start_timings()
+        logger.info(f"VPIO stream ready in {t.ready_ms:.1f} ms")
+        return True
+
+    def start_timings(self) -> Optional[dict]:
+        """Milestones of the last engine start, in ms since it began (-1 if not reached).
+
+        component/configure/initialize/unit_start cover the audio unit
+        bring-up, ready is when the stream could be used, and
+        first_render/first_capture/first_played time to first audio.
+        """
+        if not getattr(self._vpio, "has_async_start", False):
+            return None
+        t = self._vpio.start_timings()
+        return {
+            k: getattr(t, k + "_ms")
+            for k in (
+                "component",
+                "configure",
+                "initialize",
+                "unit_start",
+                "ready",
+                "first_render",
+                "first_capture",
+                "first_played",
+            )
+        }
+
+    def set_capture_gate(self, gate: str, keep_echo: bool = True) -> bool:
+        """Gate capture inside the helper: "open", "mute" or "pause".
+
+        Applies from the next input callback. The stream, rings and the
+        input task stay up. "mute" keeps 10 ms frames flowing as silence,
+        and "pause" stops them until "open". With keep_echo the echo
+        canceller keeps adapting on the real mic meanwhile. Returns False
+        when the helper has no gate, so the caller can fall back.
+        """
+        if gate not in _GATES or not getattr(self._vpio, "has_capture_gate", False):
+            return False
+        return self._vpio.set_capture_gate(_GATES[gate], keep_echo)
+
+    def set_input_muted(self, muted: bool) -> bool:
+        """Fast mic mute for bots and UIs; False if it needs the Stop/StartFrame fallback."""
+        ok = self.set_capture_gate("mute" if muted else "open")
+        if ok:
+            logger.info(f"VPIO capture {'muted' if muted else 'unmuted'}")
+        return ok
+
+    def ring_memory(self) -> Optional[dict]:
+        """Per-ring memory accounting: {"capture"|"playback"|"staging": {...}}.
+
+        Each entry has committed/level bytes now, their high-water marks since
+        the stream started, the budget (0 = none), grow/shrink counts and
+        rejected_bytes refused because of the budget.
+        """
+        if not getattr(self._vpio, "has_ring_budget", False):
+            return None
+        return {name: self._vpio.ring_memory(ring) for name, ring in _RINGS.items()}
+
+    def replay_finished(self) -> bool:
+        """True once the replay device has played out its whole capture file."""
+        stats = self._vpio.get_stats() if getattr(self._vpio, "has_stats", False) else None
+        return bool(stats and getattr(stats, "replay_eof", 0))
+
+    def open_capture_reader(self) -> Optional[VPIOCaptureReader]:
+        """Extra reader on processed capture, starting from now.
+
+        Frames are capture_frame_ms long, like the input transport's. Returns
+        None when the helper has no extra readers (e.g. the daemon binding)
+        or all are in use. Readers survive stream restarts; close() them.
+        """
+        if not getattr(self._vpio, "has_capture_readers", False):
+            return None
+        reader = self._vpio.open_capture_reader()
+        if reader < 0:
+            return None
+        sr = self._params.audio_in_sample_rate or 16000
+        frame_bytes = int(sr * self._params.capture_frame_ms / 1000) * self._params.audio_in_channels * 2
+        return VPIOCaptureReader(self._vpio, reader, frame_bytes)
+
+    def open_playback_stream(
+        self, priority: int = 1, gain_db: float = 0.0, duck_db: float = 0.0
+    ) -> Optional[VPIOPlaybackStream]:
+        """Extra playback stream mixed in the helper's render path.
+
+        While it has audio queued, streams of lower priority (the voice is 0
+        unless set_voice_mix says otherwise) are ducked by duck_db. Returns
+        None before the stream starts, with the daemon binding, or when all
+        streams are in use.
+        """
+        if not self._stream_started or not getattr(self._vpio, "has_mixer", False):
+            return None
+        stream = self._vpio.open_play_stream(priority, gain_db, duck_db)
+        if stream < 0:
+            return None
+        # The engine runs at the stream rate set in _ensure_stream_started
+        sr = self._params.audio_in_sample_rate or 16000
+        return VPIOPlaybackStream(self._vpio, stream, int(sr) * self._params.audio_in_channels * 2 // 1000)
+
+    def set_voice_mix(self, priority: int = 0, gain_db: float = 0.0, duck_db: float = 0.0) -> bool:
+        """Mix settings of the main (TTS) playback stream."""
+        if not self._stream_started or not getattr(self._vpio, "has_mixer", False):
+            return False
+        return self._vpio.set_play_stream(0, priority, gain_db, duck_db)
+
+    def mark_utterance(self, tag: int) -> bool:
+        """Tag the start of the next audio frame the output writes (e.g. on TTSStartedFrame).
+
+        The tag reaches the helper together with that frame, so audio of
+        earlier utterances still queued in the pipeline stays outside it. The
+        most recent 64 tags stay queryable through heard(). False when the
+        helper has no playout clock (e.g. the daemon binding).
+        """
+        if not self._output or not getattr(self._vpio, "has_playout", False):
+            return False
+        self._output._marks.append(int(tag))
+        return True
+
+    def heard(self, tag: int) -> Optional[dict]:
+        """How much of a marked utterance reached the device.
+
+        Returns {"tag", "start", "written", "heard", "pending"} in samples at
+        the stream rate: written counts everything queued under the tag up to
+        the next mark, heard what the render callback handed to the device,
+        pending what may still play. After a barge-in flush pending is 0 and
+        heard / written is the spoken fraction. None if the tag is unknown.
+        """
+        if not getattr(self._vpio, "has_playout", False):
+            return None
+        return self._vpio.playout_mark_info(0, tag)
+
+    def playout_clock(self) -> Optional[dict]:
+        """Voice stream sample counters: {"written", "rendered", "position", "dropped"}."""
+        if not self._stream_started or not getattr(self._vpio, "has_playout", False):
+            return None
+        return self._vpio.playout_clock(0)
+
+    def register_clip(self, pcm: bytes) -> int:
+        """Load a sound clip (16-bit PCM at the stream format) into the helper once.
+
+        Returns its id for play_clip, or -1 when the helper has no clip bank
+        (e.g. the daemon binding) or the bank is full. Clips outlive stream
+        restarts.
+        """
+        if not getattr(self._vpio, "has_clips", False):
+            return -1
+        return self._vpio.register_clip(pcm)
+
+    def play_clip(self, clip: int, gain_db: float = 0.0) -> int:
+        """Play a registered clip over the voice without copying or blocking.
+
+        Safe from any thread. Returns the voice handle reported to
+        on_clip_finished(clip, voice, stopped), or -1 if the stream isn't
+        running or all voices are busy.
+        """
+        if not self._stream_started or not getattr(self._vpio, "has_clips", False):
+            return -1
+        return self._vpio.trigger_clip(clip, gain_db)
+
+    def stop_clip(self, voice: int) -> bool:
+        """Fade a playing voice out; on_clip_finished reports it as stopped."""
+        return bool(getattr(self._vpio, "has_clips", False) and self._vpio.stop_clip(voice))
+
+    def unregister_clip(self, clip: int) -> bool:
+        return bool(getattr(self._vpio, "has_clips", False) and self._vpio.unregister_clip(clip))
+
+    def _on_vpio_events(self):
+        # Event loop reader callback on the helper's notifier fd
+        for etype, clip, voice, _ in self._vpio.poll_events():
+            if etype == _EVENT_STREAM_STARTED:
+                self._stream_ready.set()
+            elif etype == _EVENT_PLAYBACK_WRITABLE:
+                self._playback_writable.set()
+            elif etype in (_EVENT_CLIP_DONE, _EVENT_CLIP_STOPPED):
+                asyncio.create_task(
+                    self._call_event_handler(
+                        "on_clip_finished", int(clip), int(voice), etype == _EVENT_CLIP_STOPPED
+                    )
+                )
+
+    def audio_levels(self, window_ms: int = 40) -> Optional[dict]:
+        """Meter readings over the last window_ms, for VU displays.
+
+        Returns {"capture": (rms_dbfs, peak_dbfs, clipped), "playback": ...}
+        from the helper's 10 ms level history without touching audio data, or
+        None when the helper has no meters or the stream isn't running.
+        """
+        if not self._stream_started or not getattr(self._vpio, "has_levels", False):
+            return None
+        n = max(1, int(window_ms) // 10)
+        out = {}
+        for name, direction in (("capture", _DIR_CAPTURE), ("playback", _DIR_PLAYBACK)):
+            blocks = self._vpio.get_levels(direction, n)
+            total = sum(b[4] for b in blocks)
+            power = sum(b[1] * b[1] * b[4] for b in blocks) / total if total else 0.0
+            peak = max((b[2] for b in blocks), default=0.0)
+            out[name] = (
+                10.0 * math.log10(max(power, 1e-10)),
+                20.0 * math.log10(max(peak, 1e-5)),
+                sum(b[3] for b in blocks),
+            )
+        return out
 
     async def cleanup(self):
         await super().cleanup()
+        if self._event_fd >= 0:
+            asyncio.get_running_loop().remove_reader(self._event_fd)
+            self._event_fd = -1
         if self._stream_started:
             try:
                 self._vpio.stop_stream()
@@ -0,0 +1,58 @@
+// Echo canceller (vpio_aec.h) on a synthetic echo path: colored-noise far
+// end through a decaying random impulse response plus a little near-end
+// noise. Prints steady-state ERLE over the last 5 seconds and CPU per
+// channel-second for the tails vpio_set_aec covers, at the engine's 16 kHz
+// block size.
+#include "vpio_test.h"
+#include "vpio_aec.h"
+
+#define RATE 16000
+#define BLOCK 128 // dsp_block_size() at 16 kHz
+#define SECS 20
+#define PATH_MS 60 // echo path length
+#define PATH_DELAY 40 // samples of pure delay before the first reflection
+
+int main(void) {
+  size_t n = RATE * SECS, taps = RATE * PATH_MS / 1000;
+  float* far = (float*)calloc(n, sizeof(float));
+  float* near = (float*)calloc(n, sizeof(float));
+  float* h = (float*)calloc(taps, sizeof(float));
+  uint32_t seed = 1;
+  for (size_t k = PATH_DELAY; k < taps; k++) h[k] = 0.3f * test_randf(&seed) * expf(-(float)(k - PATH_DELAY) / 250.0f);
+  float lp = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    lp = 0.7f * lp + 0.3f * test_randf(&seed);
+    far[i] = 0.3f * lp;
+  }
+  for (size_t i = 0; i < n; i++) {
+    float acc = 0.0f;
+    for (size_t k = 0; k < taps && k <= i; k++) acc += h[k] * far[i - k];
+    near[i] = acc + 0.0003f * test_randf(&seed);
+  }
+  printf("%zu ms echo path, %d s at %d Hz, block %d\n", (size_t)PATH_MS, SECS, RATE, BLOCK);
+  printf("%8s %6s %9s %18s\n", "tail_ms", "parts", "ERLE_dB", "CPU_ms/channel-s");
+  static const int tails[] = {64, 128, 256};
+  for (size_t t = 0; t < sizeof(tails) / sizeof(tails[0]); t++) {
+    int parts = (tails[t] * RATE / 1000 + BLOCK - 1) / BLOCK;
+    vpio_aec* a = vpio_aec_create(BLOCK, parts, 0.5f);
+    float out[BLOCK];
+    double near_e = 0.0, err_e = 0.0;
+    double c0 = test_thread_cpu();
+    for (size_t i = 0; i + BLOCK <= n; i += BLOCK) {
+      vpio_aec_process(a, far + i, near + i, out);
+      if (i >= n - 5 * RATE) {
+        for (int j = 0; j < BLOCK; j++) {
+          near_e += (double)near[i + j] * near[i + j];
+          err_e += (double)out[j] * out[j];
+        }
+      }
+    }
+    double cpu = test_thread_cpu() - c0;
+    printf("%8d %6d %9.1f %18.3f\n", tails[t], parts, 10.0 * log10(near_e / (err_e + 1e-20)), cpu / SECS * 1000.0);
+    vpio_aec_destroy(a);
+  }
+  free(far);
+  free(near);
+  free(h);
+  return 0;
+}
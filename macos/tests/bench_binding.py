@@ -0,0 +1,85 @@
+"""Capture read cost per binding: FFI calls and reader CPU per frame.
+
+Replays a synthetic capture file as fast as the reader drains it and drains
+the backlog of 10 ms frames the way MacInputTransport._poll_frames does, one
+frame per call and batched. Prints FFI calls per second of audio and reader
+thread CPU per frame, one row per binding and batch size.
+
+    python3 bench_binding.py BUILD_DIR [SECONDS]
+
+BUILD_DIR holds libvpio.so and the _vpio extension (make -C macos/tests bench
+builds both); a binding that is not built is skipped.
+"""
+
+import os
+import sys
+import sysconfig
+import time
+import wave
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(HERE))
+
+import local_mac_transport as T  # noqa: E402
+
+RATE = 16000
+FRAME_MS = 10
+
+
+def make_capture(path: str, seconds: int):
+    n = RATE * seconds
+    pcm = bytearray(n * 2)
+    for i in range(n):
+        v = i % 32767 + 1
+        pcm[2 * i] = v & 0xFF
+        pcm[2 * i + 1] = v >> 8
+    with wave.open(path, "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(RATE)
+        w.writeframes(bytes(pcm))
+
+
+def run(vpio, capture: str, total_frames: int, max_frames: int):
+    assert vpio.set_replay(capture, None, False, [160])
+    assert vpio.start_stream(RATE, 1, 64000)
+    frame_bytes = vpio.set_capture_frame_ms(FRAME_MS)
+    bufs = vpio.alloc_frames(max_frames, frame_bytes)
+    calls = frames = 0
+    t0 = time.thread_time()
+    while frames < total_frames:
+        n = len(vpio.read_frames(bufs, max_frames, frame_bytes))
+        calls += 1
+        frames += n
+        if n < max_frames:
+            time.sleep(0.002)  # drained: wait for the replay thread to refill
+    cpu = time.thread_time() - t0
+    vpio.stop_stream()
+    return calls, frames, cpu
+
+
+def main():
+    build = sys.argv[1] if len(sys.argv) > 1 else os.path.join(HERE, "build")
+    seconds = int(sys.argv[2]) if len(sys.argv) > 2 else 60
+    capture = os.path.join(build, "bench_binding.wav")
+    make_capture(capture, seconds)
+    total = seconds * 1000 // FRAME_MS
+    lib = os.path.join(build, "libvpio.so")
+    ext = os.path.join(build, "_vpio" + sysconfig.get_config_var("EXT_SUFFIX"))
+    print(f"{seconds} s of 16 kHz mono capture, {FRAME_MS} ms frames")
+    print(f"{'binding':10} {'batch':>5} {'calls/audio-s':>14} {'us/frame':>9} {'frames/cpu-s':>13}")
+    for path, make in ((lib, T._VPIOLib), (ext, T._VPIOExt)):
+        if not os.path.exists(path):
+            print(f"{os.path.basename(path)} not built, skipped")
+            continue
+        vpio = make(path, replay=True)
+        for max_frames in (1, 16):
+            calls, frames, cpu = run(vpio, capture, total, max_frames)
+            print(
+                f"{vpio.binding:10} {max_frames:5d} {calls / seconds:14.1f} {cpu / frames * 1e6:9.2f}"
+                f" {frames / cpu:13.0f}"
+            )
+
+
+if __name__ == "__main__":
+    main()
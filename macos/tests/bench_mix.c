@@ -0,0 +1,67 @@
+// Playback mixer throughput: mix_streams over the main stream plus 0..7
+// extra streams at one 10ms callback, unity and non-unity gains, with a
+// high-priority stream ducking the rest. Built against the helper source to
+// time mix_streams alone; the replay device is never armed (nothing reads
+// capture), so no callback runs alongside.
+#include "../vpio_helper.c"
+#include "vpio_test.h"
+
+#define SECS 2
+#define ROUNDS 200 // callbacks per timed round
+
+static double run(int rate, int extra, double gain_db, int duck) {
+  size_t n = (size_t)rate / 100;
+  static int16_t pcm[48000], out[480];
+  for (size_t i = 0; i < (size_t)rate; i++) pcm[i] = (int16_t)(i * 37 % 4001 - 2000);
+  int ids[PLAY_STREAMS];
+  for (int s = 0; s < extra; s++) {
+    ids[s] = vpio_play_stream_open(duck && s == 0 ? 1 : 0, gain_db, duck && s == 0 ? 12.0 : 0.0);
+    CHECK(ids[s] > 0);
+  }
+  double cpu = 0.0;
+  size_t calls = 0;
+  while (calls < (size_t)SECS * 100 * 10) {
+    // Refill outside the timed part: ROUNDS callbacks' worth per stream
+    for (int s = 0; s < extra; s++) vpio_play_stream_write(ids[s], pcm, ROUNDS * n * sizeof(int16_t));
+    double c0 = test_thread_cpu();
+    for (int k = 0; k < ROUNDS; k++) {
+      memcpy(out, pcm, n * sizeof(int16_t));
+      mix_streams(out, n, n * sizeof(int16_t));
+    }
+    cpu += test_thread_cpu() - c0;
+    calls += ROUNDS;
+  }
+  for (int s = 0; s < extra; s++) vpio_play_stream_close(ids[s]);
+  return cpu / (double)calls;
+}
+
+int main(void) {
+  static const int rates[] = {16000, 48000};
+  int16_t* in = (int16_t*)calloc(48000, sizeof(int16_t));
+  for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+    CHECK(test_write_wav("mix_in.wav", in, (size_t)rates[r], rates[r], 1) == 0);
+    CHECK(vpio_set_replay("mix_in.wav", NULL, 0, NULL, 0) == 0);
+    if (vpio_start_stream(rates[r], 1, (size_t)rates[r] * 2 * 4) != 0) {
+      fprintf(stderr, "stream did not start\n");
+      return 1;
+    }
+    if (r == 0) {
+      printf("kernels: %s\n", gMix->isa);
+      printf("%6s %7s %14s %14s %14s %12s\n", "rate", "streams", "unity_us/cb", "-6dB_us/cb", "ducked_us/cb",
+             "Msamples/s");
+    }
+    for (int extra = 0; extra < PLAY_STREAMS; extra++) {
+      double unity = run(rates[r], extra, 0.0, 0);
+      double scaled = run(rates[r], extra, -6.0, 0);
+      double ducked = run(rates[r], extra, -6.0, 1);
+      // Samples of every stream, main included, through the mixer per second
+      double msps = (double)(extra + 1) * rates[r] / 100.0 / scaled / 1e6;
+      printf("%6d %7d %14.2f %14.2f %14.2f %12.1f\n", rates[r], extra + 1, unity * 1e6, scaled * 1e6,
+             ducked * 1e6, msps);
+    }
+    vpio_stop_stream();
+  }
+  vpio_shutdown();
+  free(in);
+  return 0;
+}
@@ -0,0 +1,64 @@
+// Session recorder sustained write bandwidth: 48 kHz mono replayed with
+// all three taps recording, the reader paced at a multiple of real time.
+// Shows how far past 1x the writer, draining every 20ms from two-second
+// rings, keeps up before tap blocks are dropped.
+#include "vpio.h"
+#include "vpio_test.h"
+#include <sched.h>
+#include <unistd.h>
+
+#define RATE 48000
+#define CH 1
+#define SECS 30
+
+static void run(int format, double speed) {
+  CHECK(vpio_set_replay("rec_in.wav", NULL, 0, NULL, 0) == 0);
+  if (vpio_start_stream(RATE, CH, RATE * CH * 2) != 0 ||
+      vpio_start_recording("bench_rec", format, VPIO_REC_TAP_MIC_RAW | VPIO_REC_TAP_CAPTURE |
+                                                    VPIO_REC_TAP_PLAYBACK) != 0) {
+    fprintf(stderr, "recording did not start\n");
+    vpio_stop_stream();
+    return;
+  }
+  static int16_t buf[RATE / 100 * CH];
+  size_t want = (size_t)RATE * CH * 2 * SECS, got = 0;
+  double t0 = test_now(), c0 = test_process_cpu();
+  while (got < want) {
+    got += vpio_read_capture(buf, sizeof(buf));
+    // Stay on the paced schedule; unpaced runs only wait for data
+    double due = t0 + (double)got / (RATE * CH * 2) / speed;
+    double now = test_now();
+    if (speed > 0.0 && due > now) usleep((useconds_t)((due - now) * 1e6));
+    else if (speed <= 0.0) sched_yield();
+  }
+  vpio_stop_recording();
+  double wall = test_now() - t0, cpu = test_process_cpu() - c0;
+  vpio_stats st;
+  vpio_get_stats(&st, sizeof(st));
+  vpio_stop_stream();
+  char speed_s[16];
+  if (speed > 0.0) snprintf(speed_s, sizeof(speed_s), "%.0fx", speed);
+  else snprintf(speed_s, sizeof(speed_s), "max");
+  printf("%7s %6s %9.1f %10.1f %9llu %9.2f\n", format == VPIO_REC_FRAMED ? "framed" : "wav", speed_s,
+         SECS / wall, (double)st.rec_bytes / wall / 1e6, (unsigned long long)st.rec_dropped, cpu / SECS * 1000.0);
+}
+
+int main(void) {
+  size_t n = (size_t)RATE * SECS;
+  int16_t* in = (int16_t*)malloc(n * CH * sizeof(int16_t));
+  uint32_t seed = 11;
+  for (size_t i = 0; i < n * CH; i++) in[i] = test_clip16(8000.0 * test_randf(&seed));
+  CHECK(test_write_wav("rec_in.wav", in, n, RATE, CH) == 0);
+  free(in);
+  printf("%d s of %d Hz x%d, taps mic-raw + capture + playback\n", SECS, RATE, CH);
+  printf("%7s %6s %9s %10s %9s %9s\n", "format", "pace", "audio_x", "MB/s", "dropped", "CPU_ms/s");
+  static const double speeds[] = {4.0, 16.0, 64.0, 256.0, 0.0};
+  for (int format = VPIO_REC_WAV; format <= VPIO_REC_FRAMED; format++)
+    for (size_t k = 0; k < sizeof(speeds) / sizeof(speeds[0]); k++) run(format, speeds[k]);
+  vpio_shutdown();
+  remove("bench_rec-mic-raw.wav");
+  remove("bench_rec-capture.wav");
+  remove("bench_rec-playback.wav");
+  remove("bench_rec.vprec");
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Engine ring throughput: vpio_ring against the queues it replaced, which
+// kept w and r as neighbouring globals (one cache line), loaded both with
+// acquire on every call and indexed with % on the byte capacity asked for.
+// One producer thread and one consumer thread move fixed-size chunks
+// (16-sample callbacks, 10ms at 16 and 48 kHz, 4 KiB); then both ends on one
+// thread, which is the per-call cost without cache line traffic.
+#include "vpio_ring.h"
+#include "vpio_test.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define CAP 64000 // bytes asked for; vpio_ring rounds up to 65536
+#define CROSS_BYTES ((size_t)256 << 20)
+#define SAME_BYTES ((size_t)1 << 30)
+
+typedef struct {
+  unsigned char* buf;
+  size_t cap;
+  _Atomic size_t w, r;
+} OldRing;
+
+static size_t old_write(OldRing* q, const void* src, size_t len) {
+  size_t w = atomic_load_explicit(&q->w, memory_order_relaxed);
+  size_t r = atomic_load_explicit(&q->r, memory_order_acquire);
+  size_t room = q->cap - (w - r), n = len < room ? len : room;
+  if (!n) return 0;
+  size_t widx = w % q->cap, first = q->cap - widx;
+  if (first > n) first = n;
+  memcpy(q->buf + widx, src, first);
+  if (n > first) memcpy(q->buf, (const unsigned char*)src + first, n - first);
+  atomic_store_explicit(&q->w, w + n, memory_order_release);
+  return n;
+}
+
+static size_t old_read(OldRing* q, void* dst, size_t len) {
+  size_t r = atomic_load_explicit(&q->r, memory_order_relaxed);
+  size_t w = atomic_load_explicit(&q->w, memory_order_acquire);
+  size_t n = w - r < len ? w - r : len;
+  if (!n) return 0;
+  size_t ridx = r % q->cap, first = q->cap - ridx;
+  if (first > n) first = n;
+  memcpy(dst, q->buf + ridx, first);
+  if (n > first) memcpy((unsigned char*)dst + first, q->buf, n - first);
+  atomic_store_explicit(&q->r, r + n, memory_order_release);
+  return n;
+}
+
+static OldRing gOld;
+static vpio_ring gNew;
+static int gImpl; // 0 old, 1 vpio_ring
+static size_t gChunk;
+
+static size_t ring_write(const void* src, size_t len) {
+  return gImpl ? vpio_ring_write(&gNew, src, len) : old_write(&gOld, src, len);
+}
+
+static size_t ring_read(void* dst, size_t len) {
+  return gImpl ? vpio_ring_read(&gNew, dst, len) : old_read(&gOld, dst, len);
+}
+
+static void ring_init(void) {
+  if (gImpl) {
+    CHECK(vpio_ring_alloc(&gNew, CAP) == 0);
+  } else {
+    gOld.buf = (unsigned char*)malloc(CAP);
+    gOld.cap = CAP;
+    atomic_store(&gOld.w, 0);
+    atomic_store(&gOld.r, 0);
+  }
+}
+
+static void ring_fini(void) {
+  if (gImpl) vpio_ring_free(&gNew);
+  else free(gOld.buf);
+}
+
+static void* producer(void* arg) {
+  static unsigned char buf[4096];
+  for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (unsigned char)i;
+  for (size_t done = 0; done < CROSS_BYTES;) {
+    size_t off = done % gChunk; // a short write resumes mid-chunk
+    size_t n = ring_write(buf + off, gChunk - off);
+    if (!n) sched_yield();
+    done += n;
+  }
+  return NULL;
+}
+
+// Best of three, GB/s; the consumer checks the bytes it got
+static double cross_thread(void) {
+  double best = 0.0;
+  static unsigned char buf[4096];
+  for (int rep = 0; rep < 3; rep++) {
+    ring_init();
+    size_t bad = 0;
+    pthread_t t;
+    double t0 = test_now();
+    pthread_create(&t, NULL, producer, NULL);
+    for (size_t done = 0; done < CROSS_BYTES;) {
+      size_t n = ring_read(buf, gChunk);
+      if (!n) sched_yield();
+      else bad += buf[0] != (unsigned char)(done % gChunk);
+      done += n;
+    }
+    pthread_join(t, NULL);
+    double gbs = (double)CROSS_BYTES / (test_now() - t0) / 1e9;
+    if (gbs > best) best = gbs;
+    CHECK(bad == 0);
+    ring_fini();
+  }
+  return best;
+}
+
+// ns per write + read of one chunk on one thread
+static double same_thread(void) {
+  static unsigned char buf[4096];
+  size_t iters = SAME_BYTES / gChunk;
+  ring_init();
+  double t0 = test_now();
+  for (size_t i = 0; i < iters; i++) {
+    ring_write(buf, gChunk);
+    ring_read(buf, gChunk);
+  }
+  double ns = (test_now() - t0) * 1e9 / (double)iters;
+  ring_fini();
+  return ns;
+}
+
+int main(void) {
+  static const size_t chunks[] = {32, 320, 960, 4096};
+  printf("%6s %12s %12s %8s %12s %12s %8s\n", "chunk", "old_GB/s", "ring_GB/s", "x", "old_ns/op", "ring_ns/op",
+         "x");
+  for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    gChunk = chunks[c];
+    double gbs[2], ns[2];
+    for (gImpl = 0; gImpl < 2; gImpl++) {
+      gbs[gImpl] = cross_thread();
+      ns[gImpl] = same_thread();
+    }
+    printf("%6zu %12.2f %12.2f %8.2f %12.1f %12.1f %8.2f\n", gChunk, gbs[0], gbs[1], gbs[1] / gbs[0], ns[0], ns[1],
+           ns[0] / ns[1]);
+  }
+  return gTestFailures != 0;
+}
@@ -0,0 +1,230 @@
+// Regression runner over a corpus of recorded sessions. Each session is a
+// directory holding mic.wav (capture, 16-bit mono) and optionally far.wav
+// (far end queued for playback before the first read). Both go through the
+// full capture chain (AEC with delay estimation, NS, capture AGC) on the
+// fast replay backend, which makes runs reproducible; the processed capture
+// and what render played land in out-capture.wav and out-playback.wav and
+// are compared with ref-capture.wav and ref-playback.wav.
+//
+//   run_corpus [-u] [-t min_snr_db] [-p blocks,...] corpus_dir
+//   run_corpus -s corpus_dir     write a small synthetic corpus
+//
+// -u writes the references from this run. Outputs match when bit-exact or
+// when the reference over the difference is at least min_snr_db (default
+// 50; SIMD kernels may round differently across machines). -p sets the
+// callback block pattern (default 10ms). Exit status 1 if any session fails.
+#include "vpio.h"
+#include "vpio_test.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RATE 16000 // corpus sessions are 16 kHz mono
+#define MAX_PATTERN 16
+
+static uint32_t gPattern[MAX_PATTERN];
+static size_t gPatternLen = 0;
+
+// SNR of ref over (out - ref) in dB; 999 for bit-exact, -1 on length mismatch
+static double compare(const int16_t* out, size_t n_out, const int16_t* ref, size_t n_ref) {
+  if (n_out != n_ref) return -1.0;
+  double se = 0.0, sd = 0.0;
+  for (size_t i = 0; i < n_ref; i++) {
+    double d = (double)out[i] - ref[i];
+    se += (double)ref[i] * ref[i];
+    sd += d * d;
+  }
+  if (sd == 0.0) return 999.0;
+  return 10.0 * log10((se + 1.0) / sd);
+}
+
+// Processed capture of one session into out_cap; playback sink to out_play
+static int replay_session(const char* mic, const char* far, const char* out_cap, const char* out_play) {
+  size_t n_mic = 0, n_far = 0;
+  int16_t* m = test_read_pcm(mic, &n_mic);
+  int16_t* f = far ? test_read_pcm(far, &n_far) : NULL;
+  if (!m) {
+    free(f);
+    return -1;
+  }
+  free(m);
+  size_t cap = (size_t)RATE * 2;
+  if (n_far * sizeof(int16_t) > cap) cap = n_far * sizeof(int16_t);
+  int rc = -1;
+  int16_t* out = (int16_t*)malloc((n_mic ? n_mic : 1) * sizeof(int16_t));
+  if (vpio_set_replay(mic, out_play, 0, gPatternLen ? gPattern : NULL, gPatternLen) != 0 ||
+      vpio_start_stream(RATE, 1, cap) != 0)
+    goto done;
+  // Everything is set before the first read, which is what starts the replay
+  vpio_set_aec(1, 128, -1);
+  vpio_set_delay_estimator(1, 500);
+  vpio_set_noise_suppressor(1, 20.0, 0);
+  vpio_set_agc(VPIO_DIR_CAPTURE, 1, -20.0, 24.0, -1.0);
+  if (f && vpio_write_playback(f, n_far * sizeof(int16_t)) != n_far * sizeof(int16_t)) goto stop;
+  size_t got = 0;
+  while (got < n_mic * sizeof(int16_t)) {
+    size_t r = vpio_read_capture((char*)out + got, n_mic * sizeof(int16_t) - got);
+    if (!r) usleep(500);
+    got += r;
+  }
+  rc = test_write_wav(out_cap, out, n_mic, RATE, 1);
+stop:
+  vpio_stop_stream();
+done:
+  free(out);
+  free(f);
+  return rc;
+}
+
+static int file_exists(const char* p) {
+  struct stat st;
+  return stat(p, &st) == 0;
+}
+
+static int copy_file(const char* from, const char* to) {
+  size_t n = 0;
+  int16_t* pcm = test_read_pcm(from, &n);
+  if (!pcm) return -1;
+  int rc = test_write_wav(to, pcm, n, RATE, 1);
+  free(pcm);
+  return rc;
+}
+
+// Bit-exact, or within min_snr_db; prints the verdict column
+static int check_output(const char* out_path, const char* ref_path, size_t limit, double min_snr_db) {
+  size_t n_out = 0, n_ref = 0;
+  int16_t* out = test_read_pcm(out_path, &n_out);
+  int16_t* ref = test_read_pcm(ref_path, &n_ref);
+  if (limit && n_out > limit) n_out = limit; // the playback sink runs on past the mic file
+  if (limit && n_ref > limit) n_ref = limit;
+  double snr = (out && ref) ? compare(out, n_out, ref, n_ref) : -1.0;
+  free(out);
+  free(ref);
+  if (!ref) printf(" %12s", "no-ref");
+  else if (snr >= 999.0) printf(" %12s", "exact");
+  else if (snr < 0.0) printf(" %12s", "length");
+  else printf(" %9.1f dB", snr);
+  return snr >= min_snr_db;
+}
+
+static int run_session(const char* dir, const char* name, int update, double min_snr_db) {
+  char mic[1024], far[1024], oc[1024], op[1024], rc_[1024], rp[1024];
+  snprintf(mic, sizeof(mic), "%s/%s/mic.wav", dir, name);
+  if (!file_exists(mic)) return -1;
+  snprintf(far, sizeof(far), "%s/%s/far.wav", dir, name);
+  snprintf(oc, sizeof(oc), "%s/%s/out-capture.wav", dir, name);
+  snprintf(op, sizeof(op), "%s/%s/out-playback.wav", dir, name);
+  snprintf(rc_, sizeof(rc_), "%s/%s/ref-capture.wav", dir, name);
+  snprintf(rp, sizeof(rp), "%s/%s/ref-playback.wav", dir, name);
+  printf("%-24s", name);
+  if (replay_session(mic, file_exists(far) ? far : NULL, oc, op) != 0) {
+    printf(" replay failed\n");
+    return 0;
+  }
+  size_t n_mic = 0;
+  free(test_read_pcm(mic, &n_mic));
+  if (update) {
+    // The playback sink runs on past the mic file
+    size_t n_play = 0;
+    int16_t* play = test_read_pcm(op, &n_play);
+    int ok = play && n_play >= n_mic && test_write_wav(rp, play, n_mic, RATE, 1) == 0 && copy_file(oc, rc_) == 0;
+    free(play);
+    printf(" %s\n", ok ? "reference written" : "reference write failed");
+    return ok;
+  }
+  int ok = check_output(oc, rc_, 0, min_snr_db);
+  ok &= check_output(op, rp, n_mic, min_snr_db);
+  printf(" %s\n", ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Echo of a far-end talker over near-end speech in noise, and noise alone
+static int synth(const char* dir) {
+  size_t n = (size_t)RATE * 6;
+  int16_t* far = (int16_t*)malloc(n * sizeof(int16_t));
+  int16_t* mic = (int16_t*)malloc(n * sizeof(int16_t));
+  uint32_t seed = 21;
+  double ph = 0.0, phn = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double t = (double)i / RATE;
+    ph += 2.0 * M_PI * (140.0 + 40.0 * sin(2.0 * M_PI * 0.5 * t)) / RATE;
+    double env = fmax(0.0, sin(2.0 * M_PI * 2.5 * t));
+    double v = 0.0;
+    for (int h = 1; h < 12; h++) v += sin(h * ph) / h;
+    far[i] = test_clip16(5000.0 * env * v);
+  }
+  char path[1024];
+  mkdir(dir, 0755);
+  for (int s = 0; s < 2; s++) {
+    static const char* names[] = {"echo-doubletalk", "noise-only"};
+    snprintf(path, sizeof(path), "%s/%s", dir, names[s]);
+    mkdir(path, 0755);
+    for (size_t i = 0; i < n; i++) {
+      double t = (double)i / RATE;
+      phn += 2.0 * M_PI * 210.0 / RATE;
+      double near = (t > 3.0) ? 3000.0 * fmax(0.0, sin(2.0 * M_PI * 1.7 * t)) * sin(phn) : 0.0;
+      double echo = (s == 0 && i >= 480) ? 0.4 * far[i - 480] : 0.0;
+      mic[i] = test_clip16((s == 0 ? near + echo : 0.0) + 300.0 * test_randf(&seed));
+    }
+    snprintf(path, sizeof(path), "%s/%s/mic.wav", dir, names[s]);
+    if (test_write_wav(path, mic, n, RATE, 1) != 0) return 1;
+    if (s == 0) {
+      snprintf(path, sizeof(path), "%s/%s/far.wav", dir, names[s]);
+      if (test_write_wav(path, far, n, RATE, 1) != 0) return 1;
+    }
+  }
+  free(far);
+  free(mic);
+  printf("synthetic corpus in %s\n", dir);
+  return 0;
+}
+
+static int by_name(const struct dirent** a, const struct dirent** b) {
+  return strcmp((*a)->d_name, (*b)->d_name);
+}
+
+int main(int argc, char** argv) {
+  int update = 0, opt;
+  double min_snr_db = 50.0;
+  const char* synth_dir = NULL;
+  while ((opt = getopt(argc, argv, "ut:p:s:")) != -1) {
+    if (opt == 'u') update = 1;
+    else if (opt == 't') min_snr_db = atof(optarg);
+    else if (opt == 's') synth_dir = optarg;
+    else if (opt == 'p') {
+      for (char* tok = strtok(optarg, ","); tok && gPatternLen < MAX_PATTERN; tok = strtok(NULL, ","))
+        gPattern[gPatternLen++] = (uint32_t)atoi(tok);
+    } else {
+      fprintf(stderr, "usage: %s [-u] [-t min_snr_db] [-p blocks,...] corpus_dir | -s corpus_dir\n", argv[0]);
+      return 2;
+    }
+  }
+  if (synth_dir) return synth(synth_dir);
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-u] [-t min_snr_db] [-p blocks,...] corpus_dir | -s corpus_dir\n", argv[0]);
+    return 2;
+  }
+  const char* dir = argv[optind];
+  struct dirent** ents;
+  int n = scandir(dir, &ents, NULL, by_name);
+  if (n < 0) {
+    perror(dir);
+    return 2;
+  }
+  if (!update) printf("%-24s %12s %12s\n", "session", "capture", "playback");
+  int sessions = 0, failed = 0;
+  for (int i = 0; i < n; i++) {
+    if (ents[i]->d_name[0] != '.') {
+      int ok = run_session(dir, ents[i]->d_name, update, min_snr_db);
+      if (ok >= 0) {
+        sessions++;
+        failed += !ok;
+      }
+    }
+    free(ents[i]);
+  }
+  free(ents);
+  vpio_shutdown();
+  printf("%d sessions, %d failed\n", sessions, failed);
+  return (failed || !sessions) ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+// Every producer/consumer pair on the engine rings at once, for make tsan:
+//
+//   writer thread -> staging ring  (what the Python binding's write does)
+//   pacing thread: staging -> playback ring -> render callback
+//   input callback -> capture ring -> primary reader and an extra reader
+//   control thread: stats, levels and headroom polled from the side, and in
+//   the second phase flushes, capture mute, budget and watermark changes
+//
+// on the realtime replay device with irregular callback sizes. Chunk sizes
+// and pauses are random. Every sample carries its own sequence number (the
+// mic file and the playback writes are ramps), so whatever a consumer gets
+// is checked sample by sample for corruption and order. In the first phase
+// nothing is flushed and loss is accounted for exactly: playback comes out
+// whole, and each capture reader skipped exactly the bytes its dropped
+// counter says. Trace logging is on, since it reads ring state from the
+// pacing and callback threads too; while the streams run, stderr (trace, and
+// any sanitizer report) goes to stress_trace.log.
+//
+// A last phase races the clip bank: two threads trigger and stop voices on a
+// few clip ids while a third unregisters and re-registers them, and render
+// mixes whatever is playing. A clip must never be freed under a voice, and
+// once the stream stops every slot has to come back.
+//
+//   stress_rings [seconds per phase]
+#include "vpio.h"
+#include "vpio_test.h"
+#include <pthread.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define RATE 16000
+#define RING_BYTES 32000
+#define STAGED_MAX 32000 // writer keeps at most this much staged
+
+static atomic_int gRun;
+static int gChaos;
+static int gExtra;
+static int gStderr, gTraceLog; // fds
+
+// Nonzero, period 65535. A playback gap (one flush) stays under half of that
+// since the writer never has much more than STAGED_MAX queued.
+static int16_t seq(uint64_t i) { return (int16_t)(uint16_t)(i % 65535 + 1); }
+
+typedef struct {
+  uint64_t read, gap, bad; // bytes, bytes, broken chunks
+} ReaderLog;
+
+static uint64_t gWritten; // samples accepted, writer thread
+static ReaderLog gMain, gSide;
+
+static void* writer(void* arg) {
+  static int16_t buf[4000];
+  uint32_t seed = 7;
+  gWritten = 0;
+  while (atomic_load(&gRun)) {
+    if (vpio_get_staging_level() > STAGED_MAX) {
+      usleep(1000);
+      continue;
+    }
+    size_t n = 1 + test_rand(&seed) % 4000;
+    for (size_t i = 0; i < n; i++) buf[i] = seq(gWritten + i);
+    // Refused whole when the staging budget is full; the next try resends
+    if (vpio_write_frame_10ms(buf, n * sizeof(int16_t)) == n * sizeof(int16_t)) gWritten += n;
+    if (test_rand(&seed) % 8 == 0) usleep(test_rand(&seed) % 3000);
+  }
+  return NULL;
+}
+
+// One chunk at capture position pos (bytes): in order, and every sample the
+// mic file's at that position. Muted capture comes through as zeros.
+static void check_chunk(ReaderLog* lg, const int16_t* buf, size_t n, size_t pos, size_t* next) {
+  if (*next == (size_t)-1) *next = pos; // opened mid-stream
+  if (pos < *next || pos % 2) lg->bad++;
+  else lg->gap += pos - *next;
+  for (size_t i = 0; i < n / 2; i++) {
+    if (buf[i] && buf[i] != seq(pos / 2 + i)) {
+      lg->bad++;
+      break;
+    }
+  }
+  lg->read += n;
+  *next = pos + n;
+}
+
+// Readers stall past a ring's worth once at stall_at, then now and then
+static void reader_stall(uint32_t* seed, double t0, double stall_at, int* stalled) {
+  if (!*stalled && test_now() - t0 >= stall_at) {
+    *stalled = 1;
+    usleep(1200000);
+  } else if (test_rand(seed) % 300 == 0) {
+    usleep(test_rand(seed) % 1200000);
+  }
+}
+
+static void* main_reader(void* arg) {
+  static int16_t buf[8000];
+  uint32_t seed = 11;
+  size_t next = 0;
+  int stalled = 0;
+  double t0 = test_now();
+  memset(&gMain, 0, sizeof(gMain));
+  for (int last = 0; !last;) {
+    last = !atomic_load(&gRun); // one more read to see the end of a stall
+    size_t pos = 0, n = vpio_read_capture_pos(buf, sizeof(int16_t) * (1 + test_rand(&seed) % 8000), &pos);
+    if (!n) {
+      usleep(200);
+      continue;
+    }
+    check_chunk(&gMain, buf, n, pos, &next);
+    if (!last) reader_stall(&seed, t0, 1.0, &stalled);
+  }
+  return NULL;
+}
+
+static void* side_reader(void* arg) {
+  static int16_t buf[4000];
+  uint32_t seed = 13;
+  size_t next = (size_t)-1;
+  int stalled = 0;
+  double t0 = test_now();
+  memset(&gSide, 0, sizeof(gSide));
+  for (int last = 0; !last;) {
+    last = !atomic_load(&gRun);
+    size_t pos = 0, n = vpio_capture_reader_read(gExtra, buf, sizeof(int16_t) * (1 + test_rand(&seed) % 4000), &pos);
+    if (!n) {
+      usleep(100);
+      continue;
+    }
+    check_chunk(&gSide, buf, n, pos, &next);
+    if (!last) reader_stall(&seed, t0, 0.5, &stalled);
+  }
+  return NULL;
+}
+
+static void* control(void* arg) {
+  uint32_t seed = 17;
+  uint64_t flushed_to = 0; // written position at the last flush
+  vpio_playout_clock c;
+  while (atomic_load(&gRun)) {
+    vpio_stats st;
+    vpio_ring_memory m;
+    size_t q, cap_level, play_level;
+    vpio_get_stats(&st, sizeof(st));
+    vpio_get_ring_memory((int)(test_rand(&seed) % 3), &m, sizeof(m));
+    vpio_get_playback_space(&q);
+    vpio_get_ring_levels(&cap_level, &play_level);
+    vpio_get_staging_capacity();
+    vpio_set_target_headroom_ms((int)(test_rand(&seed) % 40));
+    if (gChaos) {
+      switch (test_rand(&seed) % 6) {
+        case 0:
+        case 1:
+          // Not again before something written after the last one played:
+          // keeps each gap in the played sequence down to one flush's worth
+          if (vpio_get_playout_clock(0, &c, sizeof(c)) && c.position > flushed_to) {
+            if (test_rand(&seed) % 2) vpio_flush_playback();
+            else vpio_flush_input();
+            vpio_get_playout_clock(0, &c, sizeof(c));
+            flushed_to = c.written;
+          }
+          break;
+        case 2: vpio_set_capture_gate((int)(test_rand(&seed) % 2) ? VPIO_GATE_MUTE : VPIO_GATE_OPEN, 1); break;
+        case 3: vpio_set_ring_budget(VPIO_RING_STAGING, (test_rand(&seed) % 4) * 32000, 100); break;
+        case 4: vpio_set_playback_watermarks((test_rand(&seed) % 3) * 16000, 0); break;
+        default: break;
+      }
+    }
+    usleep(test_rand(&seed) % 3000);
+  }
+  return NULL;
+}
+
+// Gaps between what render played, in samples; out-of-order samples in bad
+static uint64_t played_gaps(const char* path, uint64_t* played, uint64_t* bad) {
+  size_t n = 0;
+  int16_t* out = test_read_pcm(path, &n);
+  uint64_t gap = 0;
+  int prev = -1;
+  *played = *bad = 0;
+  for (size_t i = 0; out && i < n; i++) {
+    if (!out[i]) continue; // underrun
+    int v = (uint16_t)out[i] - 1;
+    if (prev < 0) {
+      gap += (uint64_t)v;
+    } else {
+      int d = ((v - prev) % 65535 + 65535) % 65535;
+      if (d == 0 || d > 32767) (*bad)++;
+      else gap += (uint64_t)(d - 1);
+    }
+    prev = v;
+    (*played)++;
+  }
+  free(out);
+  return gap;
+}
+
+static void phase(int secs, int chaos) {
+  static const uint32_t blocks[] = {16, 48, 7, 160, 33, 512};
+  CHECK(vpio_set_replay("stress_mic.wav", "stress_play.raw", 1, blocks, 6) == 0);
+  fflush(stderr);
+  dup2(gTraceLog, 2);
+  if (vpio_start_stream(RATE, 1, RING_BYTES) != 0) {
+    dup2(gStderr, 2);
+    fprintf(stderr, "stream did not start\n");
+    exit(1);
+  }
+  gExtra = vpio_capture_reader_open();
+  CHECK(gExtra > 0);
+  CHECK(vpio_start_playback_thread(5, 20) == 0);
+  vpio_stats st0; // the primary reader's counters run on across streams
+  memset(&st0, 0, sizeof(st0));
+  vpio_get_stats(&st0, sizeof(st0));
+  gChaos = chaos;
+  atomic_store(&gRun, 1);
+  pthread_t t[4];
+  pthread_create(&t[0], NULL, writer, NULL);
+  pthread_create(&t[1], NULL, main_reader, NULL);
+  pthread_create(&t[2], NULL, side_reader, NULL);
+  pthread_create(&t[3], NULL, control, NULL);
+  sleep((unsigned)secs);
+  atomic_store(&gRun, 0);
+  for (int i = 0; i < 4; i++) pthread_join(t[i], NULL);
+  vpio_set_capture_gate(VPIO_GATE_OPEN, 1);
+  // Let the pacer and render play out what was staged before stopping
+  size_t cap_level, play_level = 1;
+  for (int i = 0; i < 500 && (play_level || vpio_get_staging_level()); i++) {
+    vpio_get_ring_levels(&cap_level, &play_level);
+    usleep(10000);
+  }
+  vpio_stop_playback_thread();
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  vpio_get_stats(&st, sizeof(st));
+  st.cap_overruns -= st0.cap_overruns;
+  st.cap_overrun_bytes -= st0.cap_overrun_bytes;
+  vpio_playout_clock clk;
+  memset(&clk, 0, sizeof(clk));
+  vpio_get_playout_clock(0, &clk, sizeof(clk));
+  uint64_t side_overruns = 0, side_dropped = 0;
+  vpio_capture_reader_stats(gExtra, &side_overruns, &side_dropped, NULL);
+  vpio_capture_reader_close(gExtra);
+  vpio_stop_stream();
+  fflush(stderr);
+  dup2(gStderr, 2);
+
+  uint64_t played = 0, play_bad = 0, play_gap = played_gaps("stress_play.raw", &played, &play_bad);
+  printf("%-6s capture: read %llu gap %llu dropped %llu bad %llu | reader: read %llu gap %llu dropped %llu bad %llu\n"
+         "       playback: written %llu played %llu gap %llu dropped %llu bad %llu (samples)\n",
+         chaos ? "chaos" : "exact", (unsigned long long)gMain.read, (unsigned long long)gMain.gap,
+         (unsigned long long)st.cap_overrun_bytes, (unsigned long long)gMain.bad, (unsigned long long)gSide.read,
+         (unsigned long long)gSide.gap, (unsigned long long)side_dropped, (unsigned long long)gSide.bad,
+         (unsigned long long)gWritten, (unsigned long long)played, (unsigned long long)play_gap,
+         (unsigned long long)clk.dropped, (unsigned long long)play_bad);
+  CHECK(gMain.read > 0 && gSide.read > 0 && played > 0);
+  CHECK(gMain.bad == 0 && gSide.bad == 0 && play_bad == 0);
+  // Whatever did not play was flushed, and the playout clock knows exactly
+  CHECK(clk.written == gWritten && clk.rendered == played && clk.dropped == play_gap);
+  CHECK(played + play_gap == gWritten);
+  if (!chaos) {
+    CHECK(gMain.gap == st.cap_overrun_bytes && st.cap_overruns > 0);
+    CHECK(gSide.gap == side_dropped && side_overruns > 0);
+    CHECK(play_gap == 0 && st.play_overrun_bytes == 0);
+  }
+}
+
+#define CLIP_IDS 4
+#define CLIP_BANK 32 // CLIP_SLOTS in the helper
+
+static _Atomic int gClipIds[CLIP_IDS];
+
+static void* clip_trigger(void* arg) {
+  uint32_t seed = (uint32_t)(uintptr_t)arg;
+  while (atomic_load(&gRun)) {
+    int v = vpio_clip_trigger(atomic_load(&gClipIds[test_rand(&seed) % CLIP_IDS]), -6.0);
+    if (v > 0 && test_rand(&seed) % 2) vpio_clip_stop(v);
+    if (test_rand(&seed) % 16 == 0) usleep(test_rand(&seed) % 500);
+  }
+  return NULL;
+}
+
+static void* clip_churn(void* arg) {
+  static int16_t pcm[RATE / 50];
+  uint32_t seed = 19;
+  for (size_t i = 0; i < RATE / 50; i++) pcm[i] = (int16_t)(i * 37);
+  while (atomic_load(&gRun)) {
+    int k = (int)(test_rand(&seed) % CLIP_IDS);
+    vpio_clip_unregister(atomic_load(&gClipIds[k]));
+    atomic_store(&gClipIds[k], vpio_clip_register(pcm, sizeof(pcm)));
+    usleep(test_rand(&seed) % 300);
+  }
+  for (int k = 0; k < CLIP_IDS; k++) vpio_clip_unregister(atomic_load(&gClipIds[k]));
+  return NULL;
+}
+
+static void clip_phase(int secs) {
+  static const uint32_t blocks[] = {16, 48, 7, 160};
+  CHECK(vpio_set_replay("stress_mic.wav", "stress_clips.raw", 1, blocks, 4) == 0);
+  if (vpio_start_stream(RATE, 1, RING_BYTES) != 0) {
+    fprintf(stderr, "stream did not start\n");
+    exit(1);
+  }
+  for (int k = 0; k < CLIP_IDS; k++) atomic_store(&gClipIds[k], -1);
+  atomic_store(&gRun, 1);
+  pthread_t t[3];
+  pthread_create(&t[0], NULL, clip_churn, NULL);
+  pthread_create(&t[1], NULL, clip_trigger, (void*)(uintptr_t)23);
+  pthread_create(&t[2], NULL, clip_trigger, (void*)(uintptr_t)29);
+  sleep((unsigned)secs);
+  atomic_store(&gRun, 0);
+  for (int i = 0; i < 3; i++) pthread_join(t[i], NULL);
+  vpio_stop_stream();
+  // Stopping ended every voice, so the whole bank registers again
+  static const int16_t one[1] = {1};
+  int ids[CLIP_BANK + 1], got = 0;
+  while (got <= CLIP_BANK && (ids[got] = vpio_clip_register(one, sizeof(one))) >= 0) got++;
+  printf("clips  bank slots back after the race: %d of %d\n", got, CLIP_BANK);
+  CHECK(got == CLIP_BANK);
+  for (int i = 0; i < got; i++) vpio_clip_unregister(ids[i]);
+}
+
+int main(int argc, char** argv) {
+  int secs = argc > 1 ? atoi(argv[1]) : 5;
+  if (secs < 2) secs = 2;
+  size_t n = (size_t)RATE * (2 * secs + 30);
+  int16_t* mic = (int16_t*)malloc(n * sizeof(int16_t));
+  for (size_t i = 0; i < n; i++) mic[i] = seq(i);
+  CHECK(test_write_wav("stress_mic.wav", mic, n, RATE, 1) == 0);
+  free(mic);
+  gStderr = dup(2);
+  gTraceLog = open("stress_trace.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (gStderr < 0 || gTraceLog < 0) return 1;
+  setenv("VPIO_TRACE", "1", 1);
+  phase(secs, 0);
+  phase(secs, 1);
+  clip_phase(secs);
+  vpio_shutdown();
+  return test_result("stress_rings");
+}
@@ -0,0 +1,90 @@
+// AGC and limiter (vpio_agc.h) step response: a tone steps from -40 to -10
+// dBFS, pauses, and ends in a full-scale burst. The output has to settle on
+// the target at the configured slew rates, hold its gain through the pause
+// and never peak above the ceiling. Prints the settle times and CPU per
+// stream-second at the engine's rates.
+#include "vpio_test.h"
+#include "vpio_agc.h"
+
+#define TARGET_DB -20.0
+#define CEILING_DB -1.0
+#define BLOCK_MS 10
+
+typedef struct {
+  double ph;
+  float peak; // max output peak so far
+} Tone;
+
+// One 10ms block of a 300 Hz tone at level_db (RMS dBFS); returns output RMS dBFS
+static double step(vpio_agc* a, Tone* t, int rate, double level_db) {
+  float buf[480];
+  size_t n = (size_t)rate * BLOCK_MS / 1000;
+  float amp = (float)(pow(10.0, level_db / 20.0) * sqrt(2.0));
+  for (size_t i = 0; i < n; i++) {
+    t->ph += 2.0 * M_PI * 300.0 / rate;
+    buf[i] = amp * (float)sin(t->ph);
+  }
+  vpio_agc_process(a, buf, n);
+  double e = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    e += (double)buf[i] * buf[i];
+    if (fabsf(buf[i]) > t->peak) t->peak = fabsf(buf[i]);
+  }
+  return 10.0 * log10(e / (double)n + 1e-12);
+}
+
+// Blocks at level_db until the output is within 1 dB of the target; seconds, or -1
+static double settle(vpio_agc* a, Tone* t, int rate, double level_db, double max_s) {
+  for (int b = 0; b < max_s * 1000 / BLOCK_MS; b++)
+    if (fabs(step(a, t, rate, level_db) - TARGET_DB) <= 1.0) return (b + 1) * BLOCK_MS / 1000.0;
+  return -1.0;
+}
+
+static void step_response(int rate) {
+  vpio_agc a;
+  vpio_agc_configure(&a, rate, 1, TARGET_DB, 30.0, CEILING_DB);
+  Tone t = {0.0, 0.0f};
+  // Up 20 dB at 10 dB/s, down 30 dB at 50 dB/s
+  double rise = settle(&a, &t, rate, -40.0, 4.0);
+  for (int b = 0; b < 50; b++) step(&a, &t, rate, -40.0);
+  float gain_before = a.gain_db;
+  double fall = settle(&a, &t, rate, -10.0, 2.0);
+  for (int b = 0; b < 50; b++) step(&a, &t, rate, -10.0);
+  float gain_loud = a.gain_db;
+  float peak_steps = t.peak;
+  // A pause below the gate leaves the gain alone
+  for (int b = 0; b < 200; b++) step(&a, &t, rate, -80.0);
+  float gain_pause = a.gain_db;
+  // Full-scale burst straight after: the limiter catches it
+  for (int b = 0; b < 100; b++) step(&a, &t, rate, -3.0);
+  printf("%6d %8.2f %8.2f %10.1f %10.1f %10.3f %10.3f\n", rate, rise, fall, gain_before, gain_pause, peak_steps,
+         t.peak);
+  CHECK(rise > 1.5 && rise < 2.5);
+  CHECK(fall > 0.4 && fall < 1.0);
+  CHECK(fabs(gain_before - 20.0f) <= 1.0f);
+  CHECK(fabsf(gain_pause - gain_loud) <= 0.01f);
+  CHECK(t.peak <= a.ceiling * 1.001f);
+}
+
+int main(void) {
+  static const int rates[] = {16000, 24000, 48000};
+  printf("%6s %8s %8s %10s %10s %10s %10s\n", "rate", "rise_s", "fall_s", "gain_dB", "pause_dB", "peak", "burst_pk");
+  for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) step_response(rates[r]);
+
+  printf("\n%6s %18s %14s\n", "rate", "CPU_ms/stream-s", "Msamples/s");
+  for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+    int rate = rates[r], secs = 60;
+    size_t n = (size_t)rate * secs;
+    float* x = (float*)malloc(n * sizeof(float));
+    uint32_t seed = 9;
+    for (size_t i = 0; i < n; i++) x[i] = 0.1f * (float)sin((double)i * 0.1) + 0.01f * test_randf(&seed);
+    vpio_agc a;
+    vpio_agc_configure(&a, rate, 1, TARGET_DB, 30.0, CEILING_DB);
+    double c0 = test_thread_cpu();
+    for (size_t i = 0; i < n; i += (size_t)rate / 100) vpio_agc_process(&a, x + i, (size_t)rate / 100);
+    double cpu = test_thread_cpu() - c0;
+    printf("%6d %18.3f %14.1f\n", rate, cpu / secs * 1000.0, (double)n / cpu / 1e6);
+    free(x);
+  }
+  return test_result("test_agc");
+}
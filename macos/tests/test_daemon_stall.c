@@ -0,0 +1,140 @@
+// Out-of-process engine under a stalled client: vpiod runs the engine on the
+// realtime replay device while this process, its client, stops servicing
+// the shared-memory rings for 1.5 s mid-stream (what a GC pause or a stuck
+// log sink does to the bot). The daemon's audio must not notice: capture
+// arrives contiguous with no overrun or IPC drop, and playback queued ahead
+// plays out without an underflow during the stall and without a gap.
+#include "vpio.h"
+#include "vpio_shm.h"
+#include "vpio_test.h"
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define RATE 16000
+#define SECS 6
+#define RING_BYTES (RATE * 2 * 4) // 4 s
+#define FRAME_MS 20
+#define STALL_AT 2.0
+#define STALL_S 1.5
+
+// Keeps the ring calls going while the main thread detaches: they have to
+// see the mapping or nothing, never a freed one
+static _Atomic int gHammer = 1;
+static void* hammer(void* fb) {
+  static unsigned char buf[4 * RATE * 2 * FRAME_MS / 1000];
+  static int16_t pcm[RATE / 100];
+  vpio_frame_info info[4];
+  vpio_stats st;
+  while (gHammer) {
+    vpio_remote_read_frames(buf, 4, (size_t)fb, info);
+    vpio_remote_write_playback(pcm, sizeof(pcm));
+    vpio_remote_get_stats(&st, sizeof(st));
+  }
+  return NULL;
+}
+
+// Nonzero ramps that never repeat within a run
+static int16_t mic_sample(size_t i) { return (int16_t)((int)(i % 32749) - 16000); }
+static int16_t play_sample(size_t i) { return (int16_t)(i % 30000 + 1); }
+
+int main(void) {
+  size_t n = (size_t)RATE * SECS;
+  int16_t* mic = (int16_t*)malloc(n * sizeof(int16_t));
+  for (size_t i = 0; i < n; i++) mic[i] = mic_sample(i);
+  CHECK(test_write_wav("stall_mic.wav", mic, n, RATE, 1) == 0);
+  free(mic);
+  remove("stall_play.wav");
+
+  char name[64], rate[16], ring[32];
+  snprintf(name, sizeof(name), "/vpio-stall-%d", (int)getpid());
+  snprintf(rate, sizeof(rate), "%d", RATE);
+  snprintf(ring, sizeof(ring), "%d", RING_BYTES);
+  pid_t pid = fork();
+  if (pid == 0) {
+    execl("./vpiod", "vpiod", name, rate, "1", ring, "--replay", "stall_mic.wav", "--replay-out", "stall_play.wav",
+          "--replay-pattern", "16,48,160", (char*)NULL);
+    _exit(127);
+  }
+  if (pid < 0 || vpio_remote_attach(name, 3000) != 0) {
+    fprintf(stderr, "vpiod did not come up\n");
+    if (pid > 0) kill(pid, SIGTERM);
+    return 1;
+  }
+  int32_t args[4] = {FRAME_MS, 0, 0, 0};
+  size_t fb = (size_t)vpio_remote_call(VPIO_SHM_OP_FRAME_MS, args, NULL, NULL, NULL);
+  CHECK(fb == (size_t)RATE * 2 * FRAME_MS / 1000);
+
+  static int16_t play[RATE];
+  size_t played = 0; // samples queued for playback
+  int16_t* got = (int16_t*)malloc(n * sizeof(int16_t));
+  size_t got_n = 0, overrun_frames = 0;
+  unsigned char frames[16 * RATE * 2 * FRAME_MS / 1000];
+  vpio_frame_info info[16];
+  vpio_stats before, after;
+  int stalled = 0;
+  double t0 = test_now(), stall_gap = 0.0;
+  while (got_n + fb / 2 * 25 < n && test_now() - t0 < SECS + 4.0) {
+    // Keep as much playback queued as the rings take
+    for (;;) {
+      for (size_t i = 0; i < RATE; i++) play[i] = play_sample(played + i);
+      size_t w = vpio_remote_write_playback(play, sizeof(play));
+      played += w / 2;
+      if (w < sizeof(play)) break;
+    }
+    size_t k = vpio_remote_read_frames(frames, 16, fb, info);
+    for (size_t i = 0; i < k && got_n + fb / 2 <= n; i++) {
+      if (info[i].flags & VPIO_FRAME_OVERRUN) overrun_frames++;
+      memcpy(got + got_n, frames + i * fb, fb);
+      got_n += fb / 2;
+    }
+    if (!stalled && test_now() - t0 >= STALL_AT) {
+      // The whole client goes quiet: no reads, no writes, no commands
+      usleep(200000); // let the last writes reach the engine's ring
+      vpio_remote_get_stats(&before, sizeof(before));
+      double s0 = test_now();
+      usleep((useconds_t)(STALL_S * 1e6));
+      stall_gap = test_now() - s0;
+      vpio_remote_get_stats(&after, sizeof(after));
+      stalled = 1;
+    }
+    usleep(5000);
+  }
+  vpio_stats end;
+  vpio_remote_get_stats(&end, sizeof(end));
+  pthread_t th;
+  pthread_create(&th, NULL, hammer, (void*)fb);
+  vpio_remote_call(VPIO_SHM_OP_STOP, NULL, NULL, NULL, NULL);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  vpio_remote_detach();
+  gHammer = 0;
+  pthread_join(th, NULL);
+
+  // Capture: contiguous from wherever the first frame started
+  size_t start = got_n ? (size_t)((got[0] + 16000 + 32749) % 32749) : 0, breaks = 0;
+  for (size_t i = 0; i < got_n; i++) breaks += got[i] != mic_sample(start + i);
+  // Playback: everything up to where the replay ended came out in order
+  size_t out_n = 0;
+  int16_t* out = test_read_pcm("stall_play.wav", &out_n);
+  size_t first = 0, gaps = 0, checked = 0;
+  while (out && first < out_n && out[first] == 0) first++;
+  for (size_t i = first; out && i < out_n && i - first < played; i++, checked++) gaps += out[i] != play_sample(i - first);
+  printf("stalled %.2f s; capture %zu samples, %zu breaks, %zu overrun frames, ipc_dropped %llu; "
+         "playback %zu samples checked, %zu gaps, underflows %llu during the stall\n",
+         stall_gap, got_n, breaks, overrun_frames, (unsigned long long)end.ipc_dropped, checked, gaps,
+         (unsigned long long)(after.underflows - before.underflows));
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  CHECK(stalled && stall_gap >= STALL_S);
+  CHECK(got_n >= (size_t)RATE * (SECS - 1));
+  CHECK(breaks == 0);
+  CHECK(overrun_frames == 0);
+  CHECK(end.ipc_dropped == 0 && end.cap_overruns == 0);
+  CHECK(after.underflows == before.underflows);
+  CHECK(checked >= (size_t)RATE * (SECS - 1));
+  CHECK(gaps == 0);
+  free(got);
+  free(out);
+  return test_result("test_daemon_stall");
+}
@@ -0,0 +1,77 @@
+// Render/capture delay estimator on synthetic echo: a speech-like far end is
+// played through the engine while the replayed capture holds the same
+// signal delayed, low-passed, attenuated and noisy. The estimate is the lag
+// past what the reference ring already holds: replay runs capture before
+// render, so one 10ms callback of reference is queued ahead and comes off the
+// true delay. It has to land within one estimator block of that, with
+// confidence.
+#include "vpio.h"
+#include "vpio_test.h"
+#include <unistd.h>
+
+#define RATE 16000
+#define SECS 8
+#define BLOCK_MS 8.0 // estimator block at 16 kHz
+#define QUEUED_MS 10 // default replay callback
+
+// Syllable-like bursts of voiced harmonics and noise with a wandering pitch
+static void make_far(int16_t* far, size_t n, uint32_t seed) {
+  double phase = 0.0, f0 = 140.0;
+  size_t left = 0;
+  int on = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (left == 0) {
+      on = !on;
+      left = (size_t)(RATE * (on ? 0.1 + 0.2 * (test_rand(&seed) % 100) / 100.0 : 0.05 + 0.1 * (test_rand(&seed) % 100) / 100.0));
+      f0 = 100.0 + (double)(test_rand(&seed) % 150);
+    }
+    left--;
+    phase += 2.0 * M_PI * f0 / RATE;
+    double v = 0.0;
+    for (int h = 1; h <= 12; h++) v += sin(phase * h) / h;
+    v = on ? 3000.0 * v + 1500.0 * test_randf(&seed) : 30.0 * test_randf(&seed);
+    far[i] = test_clip16(v);
+  }
+}
+
+static void run(const int16_t* far, size_t n, int delay_ms) {
+  size_t d = (size_t)delay_ms * RATE / 1000;
+  int16_t* cap = (int16_t*)calloc(n, sizeof(int16_t));
+  uint32_t seed = 7;
+  for (size_t i = d + 2; i < n; i++) {
+    // echo path: delay, gentle low-pass, -6 dB, noise ~50 dB down
+    double e = 0.25 * far[i - d] + 0.5 * far[i - d - 1] + 0.25 * far[i - d - 2];
+    cap[i] = test_clip16(0.5 * e + 10.0 * test_randf(&seed));
+  }
+  CHECK(test_write_wav("delay_cap.wav", cap, n, RATE, 1) == 0);
+  CHECK(vpio_set_replay("delay_cap.wav", NULL, 0, NULL, 0) == 0);
+  CHECK(vpio_start_stream(RATE, 1, n * sizeof(int16_t)) == 0);
+  CHECK(vpio_set_delay_estimator(1, 500) == 0);
+  CHECK(vpio_write_playback(far, n * sizeof(int16_t)) == n * sizeof(int16_t));
+  static int16_t buf[RATE];
+  size_t got = 0;
+  while (got < n * sizeof(int16_t)) {
+    size_t r = vpio_read_capture(buf, sizeof(buf));
+    if (!r) usleep(1000);
+    got += r;
+  }
+  double est = -1.0, conf = 0.0;
+  int ok = vpio_get_delay_estimate(&est, &conf);
+  printf("delay %3d ms: estimate %6.1f ms confidence %.2f\n", delay_ms, est, conf);
+  CHECK(ok);
+  CHECK(fabs(est - (delay_ms - QUEUED_MS)) <= BLOCK_MS);
+  CHECK(conf >= 0.5);
+  vpio_stop_stream();
+  free(cap);
+}
+
+int main(void) {
+  size_t n = RATE * SECS;
+  int16_t* far = (int16_t*)malloc(n * sizeof(int16_t));
+  make_far(far, n, 3);
+  static const int delays[] = {24, 90, 180, 320, 480};
+  for (size_t k = 0; k < sizeof(delays) / sizeof(delays[0]); k++) run(far, n, delays[k]);
+  vpio_shutdown();
+  free(far);
+  return test_result("test_delay_est");
+}
@@ -0,0 +1,133 @@
+// Drop-oldest playback under contention: a writer thread pushes a numbered
+// sample sequence through vpio_write_playback in random chunks and bursts
+// (some larger than the ring) faster than the realtime replay device plays
+// it, while another thread polls the stats and levels. Every sample written
+// has to be either played, in order, or counted in play_overrun_bytes:
+// the gaps in what came out add up to that counter exactly. Writes larger
+// than the ring while render is not running overflow the playout clock's
+// breakpoint queue, which has to show up in the stats.
+#include "vpio.h"
+#include "vpio_test.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define RATE 16000
+#define RING_BYTES 32000 // 16384 samples once rounded up
+
+static atomic_int gRun = 1;
+static uint64_t gWritten = 0; // samples, writer thread
+
+// Nonzero, period 65535; gaps stay well under half of that
+static int16_t seq(uint64_t i) { return (int16_t)(uint16_t)(i % 65535 + 1); }
+
+static void* writer(void* arg) {
+  static int16_t buf[RATE * 2];
+  uint32_t seed = 7;
+  while (atomic_load(&gRun)) {
+    size_t n = 1 + test_rand(&seed) % 4000;
+    if (test_rand(&seed) % 40 == 0) n = 8000 + test_rand(&seed) % 16000; // up to 1.5 rings at once
+    for (size_t i = 0; i < n; i++) buf[i] = seq(gWritten + i);
+    CHECK(vpio_write_playback(buf, n * sizeof(int16_t)) == n * sizeof(int16_t));
+    gWritten += n;
+    usleep(test_rand(&seed) % 150000);
+  }
+  return NULL;
+}
+
+static void* poller(void* arg) {
+  uint32_t seed = 9;
+  while (atomic_load(&gRun)) {
+    vpio_stats st;
+    vpio_get_stats(&st, sizeof(st));
+    size_t cap_level, play_level, queued;
+    vpio_get_ring_levels(&cap_level, &play_level);
+    vpio_get_playback_space(&queued);
+    usleep(test_rand(&seed) % 2000);
+  }
+  return NULL;
+}
+
+// Fast replay never runs a callback before the first capture read, so each
+// oversized write posts a breakpoint that render never takes
+static void lost_breakpoints(void) {
+  static const int16_t big[RING_BYTES];
+  CHECK(vpio_set_replay("drop_in.wav", NULL, 0, NULL, 0) == 0);
+  if (vpio_start_stream(RATE, 1, RING_BYTES) != 0) {
+    fprintf(stderr, "stream did not start\n");
+    return;
+  }
+  vpio_stats st;
+  for (int i = 0; i < 70; i++) {
+    vpio_write_playback(big, sizeof(big));
+    memset(&st, 0, sizeof(st));
+    vpio_get_stats(&st, sizeof(st));
+    if (i < 64) CHECK(st.playout_breaks_lost == 0);
+  }
+  printf("70 breakpoints posted to a 64-entry queue: playout_breaks_lost %llu\n",
+         (unsigned long long)st.playout_breaks_lost);
+  CHECK(st.playout_breaks_lost == 6);
+  vpio_stop_stream();
+}
+
+int main(int argc, char** argv) {
+  int secs = argc > 1 ? atoi(argv[1]) : 4;
+  size_t n = (size_t)RATE * (secs + 4);
+  int16_t* silence = (int16_t*)calloc(n, sizeof(int16_t));
+  CHECK(test_write_wav("drop_in.wav", silence, n, RATE, 1) == 0);
+  free(silence);
+  static const uint32_t blocks[] = {16, 48, 7, 160, 33, 512};
+  CHECK(vpio_set_replay("drop_in.wav", "drop_out.raw", 1, blocks, 6) == 0);
+  if (vpio_start_stream(RATE, 1, RING_BYTES) != 0) {
+    fprintf(stderr, "stream did not start\n");
+    return 1;
+  }
+  pthread_t t[2];
+  pthread_create(&t[0], NULL, writer, NULL);
+  pthread_create(&t[1], NULL, poller, NULL);
+  sleep((unsigned)secs);
+  atomic_store(&gRun, 0);
+  for (int i = 0; i < 2; i++) pthread_join(t[i], NULL);
+  // Render counts a loss when it reaches the overwritten range: let it play
+  // out the ring before stopping, then read the counters (they outlive stop)
+  size_t cap_level, play_level = 1;
+  for (int i = 0; i < 300 && play_level; i++) {
+    vpio_get_ring_levels(&cap_level, &play_level);
+    usleep(10000);
+  }
+  CHECK(play_level == 0);
+  vpio_stop_stream();
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  vpio_get_stats(&st, sizeof(st));
+
+  size_t out_n = 0;
+  int16_t* out = test_read_pcm("drop_out.raw", &out_n);
+  uint64_t played = 0, gap = 0, bad = 0;
+  int prev = -1;
+  for (size_t i = 0; out && i < out_n; i++) {
+    if (!out[i]) continue; // render underran
+    int v = (uint16_t)out[i] - 1;
+    if (prev < 0) {
+      gap += (uint64_t)v;
+    } else {
+      int d = ((v - prev) % 65535 + 65535) % 65535;
+      if (d == 0 || d > 32767) bad++;
+      else gap += (uint64_t)(d - 1);
+    }
+    prev = v;
+    played++;
+  }
+  printf("written %llu samples, played %llu, gaps %llu samples; play_overruns %llu, play_overrun_bytes %llu\n",
+         (unsigned long long)gWritten, (unsigned long long)played, (unsigned long long)gap,
+         (unsigned long long)st.play_overruns, (unsigned long long)st.play_overrun_bytes);
+  CHECK(bad == 0);
+  CHECK(st.play_overruns > 0); // the test has to have overrun to mean anything
+  CHECK(gap * sizeof(int16_t) == st.play_overrun_bytes);
+  CHECK(played + gap == gWritten);
+  CHECK(st.playout_breaks_lost == 0);
+  lost_breakpoints();
+  vpio_shutdown();
+  free(out);
+  return test_result("test_drop_oldest");
+}
@@ -0,0 +1,189 @@
+// Sample kernels: every vpio_mix table this CPU can run against the scalar
+// reference, bit for bit. Blocks are the callback sizes (10ms at 48 kHz and
+// twice that) plus 1..31 extra samples for the vector tails, starting at
+// every offset up to 16 samples so loads and stores are unaligned, plus
+// random short blocks. Inputs lean on the edges: full scale, ties for the
+// rounding, NaN, infinities and denormals. Samples just past the block have
+// to come back untouched. Then long level sums, where clip counters and
+// 64-bit sums fold, and long crossing counts, and whole FFTs through each
+// table's butterflies.
+#include "vpio_fft.h"
+#include "vpio_mix.h"
+#include "vpio_test.h"
+
+#define MAXN (960 + 32 + 16)
+#define GUARD 8
+
+static uint32_t gSeed = 88172645;
+
+static int16_t edge_s16(void) {
+  uint32_t r = test_rand(&gSeed);
+  switch (r % 8) {
+    case 0: return 32767;
+    case 1: return -32768;
+    case 2: return (int16_t)(32766 - (int)(r >> 8) % 3);
+    case 3: return (int16_t)(-32766 + (int)(r >> 8) % 3);
+    case 4: return (int16_t)((int)(r >> 8) % 64 - 32);
+    default: return (int16_t)(r >> 8);
+  }
+}
+
+static float edge_f32(void) {
+  uint32_t r = test_rand(&gSeed);
+  float u = (float)(test_rand(&gSeed) / 4294967296.0);
+  switch (r % 10) {
+    case 0: return NAN;
+    case 1: return (r & 256) ? INFINITY : -INFINITY;
+    case 2: return ((float)(int)((r >> 8) % 65536) - 32768.0f + 0.5f) / 32768.0f; // ties
+    case 3: return (r & 256) ? 32767.5f / 32768.0f : -32768.5f / 32768.0f;
+    case 4: return 1e-40f;
+    case 5: return (u - 0.5f) * 8.0f;
+    default: return (u - 0.5f) * 2.0f;
+  }
+}
+
+static float gain(void) {
+  return (test_rand(&gSeed) % 5 == 0) ? 1.0f : (float)(test_rand(&gSeed) / 4294967296.0) * 9.0f - 0.5f;
+}
+
+// One butterfly run of n pairs at off through both tables
+static int butterfly_differs(const vpio_mix_kernels* k, const vpio_mix_kernels* ref, size_t n, size_t off) {
+  static float v[2][4][MAXN + GUARD], tw[2][MAXN + GUARD];
+  float sign = (test_rand(&gSeed) & 1) ? 1.0f : -1.0f;
+  size_t all = off + n + GUARD;
+  for (size_t i = 0; i < all; i++) {
+    for (int a = 0; a < 4; a++) v[0][a][i] = v[1][a][i] = test_randf(&gSeed) * 4.0f;
+    tw[0][i] = test_randf(&gSeed);
+    tw[1][i] = test_randf(&gSeed);
+  }
+  for (int t = 0; t < 2; t++) {
+    float** p = (float*[]){v[t][0] + off, v[t][1] + off, v[t][2] + off, v[t][3] + off};
+    (t ? ref : k)->butterfly_f32(p[0], p[1], p[2], p[3], tw[0] + off, tw[1] + off, n, sign);
+  }
+  return memcmp(v[0], v[1], sizeof(v[0])) != 0;
+}
+
+// One block of n at off through both tables; the name of what differed, or NULL
+static const char* block(const vpio_mix_kernels* k, const vpio_mix_kernels* ref, size_t n, size_t off) {
+  static int16_t a[MAXN + GUARD], b[MAXN + GUARD], src[MAXN + GUARD];
+  static float fa[MAXN + GUARD], fb[MAXN + GUARD], fs[MAXN + GUARD];
+  size_t all = off + n + GUARD;
+  for (size_t i = 0; i < all; i++) {
+    a[i] = b[i] = edge_s16();
+    src[i] = edge_s16();
+    fs[i] = edge_f32();
+    fa[i] = fb[i] = (float)i;
+  }
+  float g0 = gain(), g1 = (test_rand(&gSeed) % 3 == 0) ? g0 : gain();
+  k->scale_s16(a + off, n, g0, g1);
+  ref->scale_s16(b + off, n, g0, g1);
+  if (memcmp(a, b, all * sizeof(int16_t))) return "scale_s16";
+  k->adds_s16(a + off, src + off, n);
+  ref->adds_s16(b + off, src + off, n);
+  if (memcmp(a, b, all * sizeof(int16_t))) return "adds_s16";
+  k->s16_to_f32(fa + off, src + off, n);
+  ref->s16_to_f32(fb + off, src + off, n);
+  if (memcmp(fa, fb, all * sizeof(float))) return "s16_to_f32";
+  k->f32_to_s16(a + off, fs + off, n);
+  ref->f32_to_s16(b + off, fs + off, n);
+  if (memcmp(a, b, all * sizeof(int16_t))) return "f32_to_s16";
+  vpio_mix_level la, lb;
+  memset(&la, 0, sizeof(la));
+  memset(&lb, 0, sizeof(lb));
+  k->level_s16(src + off, n, &la);
+  ref->level_s16(src + off, n, &lb);
+  if (memcmp(&la, &lb, sizeof(la))) return "level_s16";
+  if (k->crossings_s16(src + off, n) != ref->crossings_s16(src + off, n)) return "crossings_s16";
+  if (butterfly_differs(k, ref, n, off)) return "butterfly_f32";
+  return NULL;
+}
+
+static int check_table(const vpio_mix_kernels* k, const vpio_mix_kernels* ref) {
+  static const size_t bases[] = {480, 960};
+  size_t blocks = 0;
+  for (size_t b = 0; b < sizeof(bases) / sizeof(bases[0]); b++) {
+    for (size_t tail = 0; tail < 32; tail++) {
+      for (size_t off = 0; off <= 16; off++) {
+        for (int rep = 0; rep < 4; rep++, blocks++) {
+          const char* what = block(k, ref, bases[b] + tail, off);
+          if (what) {
+            printf("  %s: %s differs at n=%zu offset %zu\n", k->isa, what, bases[b] + tail, off);
+            return 0;
+          }
+        }
+      }
+    }
+  }
+  for (int it = 0; it < 20000; it++, blocks++) {
+    size_t n = test_rand(&gSeed) % 100, off = test_rand(&gSeed) % 16;
+    const char* what = block(k, ref, n, off);
+    if (what) {
+      printf("  %s: %s differs at n=%zu offset %zu\n", k->isa, what, n, off);
+      return 0;
+    }
+  }
+  // Long runs at full scale
+  size_t nb = ((size_t)8 << 16) + 37;
+  int16_t* big = (int16_t*)malloc(nb * sizeof(int16_t));
+  int ok = 1;
+  for (int pat = 0; pat < 3 && ok; pat++) {
+    for (size_t i = 0; i < nb; i++) big[i] = pat == 0 ? -32768 : pat == 1 ? 32767 : edge_s16();
+    vpio_mix_level la, lb;
+    memset(&la, 0, sizeof(la));
+    memset(&lb, 0, sizeof(lb));
+    k->level_s16(big, nb, &la);
+    ref->level_s16(big, nb, &lb);
+    if (memcmp(&la, &lb, sizeof(la))) {
+      printf("  %s: level_s16 differs over %zu samples, pattern %d\n", k->isa, nb, pat);
+      ok = 0;
+    }
+    if (k->crossings_s16(big, nb) != ref->crossings_s16(big, nb)) {
+      printf("  %s: crossings_s16 differs over %zu samples, pattern %d\n", k->isa, nb, pat);
+      ok = 0;
+    }
+  }
+  free(big);
+  // Forward and inverse transforms at the DSP stages' sizes
+  static float re[2][1024], im[2][1024];
+  for (int n = 16; n <= 1024 && ok; n *= 2) {
+    vpio_fft f;
+    CHECK(vpio_fft_init(&f, n) == 0);
+    for (int i = 0; i < n; i++) {
+      re[0][i] = re[1][i] = test_randf(&gSeed);
+      im[0][i] = im[1][i] = test_randf(&gSeed);
+    }
+    for (int t = 0; t < 2; t++) {
+      f.mix = t ? ref : k;
+      vpio_fft_forward(&f, re[t], im[t]);
+      vpio_fft_inverse(&f, re[t], im[t]);
+    }
+    if (memcmp(re[0], re[1], sizeof(float) * (size_t)n) || memcmp(im[0], im[1], sizeof(float) * (size_t)n)) {
+      printf("  %s: %d-point FFT differs\n", k->isa, n);
+      ok = 0;
+    }
+    vpio_fft_free(&f);
+  }
+  if (ok) printf("%-6s %zu blocks and FFTs bit-exact with scalar\n", k->isa, blocks);
+  return ok;
+}
+
+int main(void) {
+  static const char* const isas[] = {"sse2", "avx2", "neon"};
+  const vpio_mix_kernels* ref = vpio_mix_kernels_for("scalar");
+  const vpio_mix_kernels* sel = vpio_mix_select(NULL);
+  CHECK(ref && sel);
+  printf("selected: %s\n", sel->isa);
+  int tested = 0;
+  for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+    const vpio_mix_kernels* k = vpio_mix_kernels_for(isas[i]);
+    if (!k) continue;
+    CHECK(check_table(k, ref));
+    tested += k == sel;
+  }
+  // The table the engine would pick is among those checked (or is scalar)
+  CHECK(tested || sel == ref);
+  // An ISA asked for by name is honoured when it runs here, ignored when not
+  CHECK(vpio_mix_select("scalar") == ref);
+  CHECK(vpio_mix_select("no-such-isa") == sel);
+  return test_result("test_kernels");
+}
@@ -0,0 +1,96 @@
+// Noise suppressor (vpio_ns.h) on synthetic mixes: syllable-gated harmonic
+// "speech" plus stationary white or low-passed noise at several input SNRs.
+// Output SNR counts both leftover noise and speech distortion against the
+// clean signal (output lags by one block). Noisy mixes have to come out
+// cleaner and clean speech must survive; CPU per stream-second is printed for
+// the engine's block sizes, full tracking and hold mode.
+#include "vpio_test.h"
+#include "vpio_ns.h"
+
+#define SECS 20
+#define SKIP 5 // seconds of noise tracking before measuring
+
+static void make_speech(float* c, size_t n, int rate) {
+  double ph = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double t = (double)i / rate;
+    double f0 = 120.0 + 30.0 * sin(2.0 * M_PI * 0.7 * t);
+    ph += 2.0 * M_PI * f0 / rate;
+    double env = fmax(0.0, sin(2.0 * M_PI * 3.0 * t)) * (((int)(t / 1.3)) % 3 != 0);
+    double v = 0.0;
+    for (int h = 1; h < 20 && h * f0 < rate / 2; h++) v += sin(h * ph) / h;
+    c[i] = (float)(0.1 * env * v);
+  }
+}
+
+static double power(const float* x, size_t n) {
+  double acc = 0.0;
+  for (size_t i = 0; i < n; i++) acc += (double)x[i] * x[i];
+  return acc / (double)n;
+}
+
+// Output SNR in dB for clean c under noise scaled to in_snr_db; cpu in seconds
+static double run(const float* c, size_t n, int rate, int block, int pink, double in_snr_db, int hold, double* cpu) {
+  float* x = (float*)malloc(n * sizeof(float));
+  float* y = (float*)malloc(n * sizeof(float));
+  uint32_t seed = 5;
+  float lp = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    lp = 0.9f * lp + 0.1f * test_randf(&seed);
+    x[i] = pink ? lp : test_randf(&seed);
+  }
+  double g = sqrt(power(c, n) / power(x, n) / pow(10.0, in_snr_db / 10.0));
+  for (size_t i = 0; i < n; i++) x[i] = c[i] + (float)g * x[i];
+  vpio_ns* s = vpio_ns_create(block, rate, 20.0);
+  double c0 = test_thread_cpu();
+  for (size_t i = 0; i + (size_t)block <= n; i += (size_t)block)
+    vpio_ns_process(s, x + i, y + i, hold && s->frames > 0);
+  *cpu = test_thread_cpu() - c0;
+  vpio_ns_destroy(s);
+  double ce = 0.0, ee = 0.0;
+  for (size_t i = (size_t)SKIP * rate; i + 2 * (size_t)block < n; i++) {
+    double d = y[i + (size_t)block] - c[i];
+    ce += (double)c[i] * c[i];
+    ee += d * d;
+  }
+  free(x);
+  free(y);
+  return 10.0 * log10(ce / (ee + 1e-20));
+}
+
+int main(void) {
+  static const double snrs[] = {0.0, 5.0, 10.0, 20.0, 40.0};
+  static const char* kinds[] = {"white", "pink"};
+  printf("%6s %5s %6s %9s %9s\n", "rate", "noise", "in_dB", "out_dB", "gain_dB");
+  size_t n = 16000 * SECS;
+  float* c = (float*)malloc(n * sizeof(float));
+  make_speech(c, n, 16000);
+  for (int pink = 0; pink < 2; pink++) {
+    for (size_t k = 0; k < sizeof(snrs) / sizeof(snrs[0]); k++) {
+      double cpu;
+      double out = run(c, n, 16000, 128, pink, snrs[k], 0, &cpu);
+      printf("%6d %5s %6.1f %9.1f %9.1f\n", 16000, kinds[pink], snrs[k], out, out - snrs[k]);
+      // Noisy speech comes out cleaner; speech that was already clean
+      // loses at most 1 dB to distortion
+      if (snrs[k] <= 10.0) CHECK(out >= snrs[k] + 2.0);
+      if (snrs[k] >= 20.0) CHECK(out >= snrs[k] - 1.0);
+    }
+  }
+  free(c);
+
+  printf("\n%6s %6s %22s %22s\n", "rate", "block", "CPU_ms/stream-s", "hold_CPU_ms/stream-s");
+  static const int rates[] = {16000, 24000, 48000};
+  for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+    int rate = rates[r], block = 16;
+    while (block < rate / 125) block <<= 1; // dsp_block_size()
+    n = (size_t)rate * SECS;
+    c = (float*)malloc(n * sizeof(float));
+    make_speech(c, n, rate);
+    double cpu, cpu_hold;
+    run(c, n, rate, block, 1, 10.0, 0, &cpu);
+    run(c, n, rate, block, 1, 10.0, 1, &cpu_hold);
+    printf("%6d %6d %22.3f %22.3f\n", rate, block, cpu / SECS * 1000.0, cpu_hold / SECS * 1000.0);
+    free(c);
+  }
+  return test_result("test_ns");
+}
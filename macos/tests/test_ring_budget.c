@@ -0,0 +1,90 @@
+// Staging ring memory under bursty TTS: answers arrive much faster than real
+// time in bursts, the pacing thread plays them out over the realtime replay
+// device. The staging ring may grow with a burst but never past its budget
+// (writes beyond it are refused), and once playback has caught up it has to
+// shrink back to its start size.
+#include "vpio.h"
+#include "vpio_test.h"
+#include <unistd.h>
+
+#define RATE 16000
+#define FRAME (RATE / 100) // 10ms
+#define BUDGET (128 * 1024)
+#define SHRINK_MS 300
+
+static void mem(vpio_ring_memory* m) {
+  memset(m, 0, sizeof(*m));
+  vpio_get_ring_memory(VPIO_RING_STAGING, m, sizeof(*m));
+}
+
+// One answer of secs written as fast as the engine takes it; bytes accepted
+static size_t burst(double secs, size_t* refused) {
+  static int16_t frame[FRAME];
+  size_t frames = (size_t)(secs * 100.0), accepted = 0;
+  for (size_t f = 0; f < frames; f++) {
+    for (size_t i = 0; i < FRAME; i++) frame[i] = (int16_t)(((f * FRAME + i) % 200) * 50 - 5000);
+    size_t n = vpio_write_frame_10ms(frame, sizeof(frame));
+    accepted += n;
+    if (!n) (*refused)++;
+  }
+  return accepted;
+}
+
+// Until the staging ring is back at base bytes, or timeout_s; seconds taken or -1
+static double wait_shrunk(size_t base, double timeout_s) {
+  double t0 = test_now();
+  vpio_ring_memory m;
+  for (mem(&m); m.committed > base; mem(&m)) {
+    if (test_now() - t0 > timeout_s) return -1.0;
+    usleep(10000);
+  }
+  return test_now() - t0;
+}
+
+int main(void) {
+  size_t n = (size_t)RATE * 30;
+  int16_t* silence = (int16_t*)calloc(n, sizeof(int16_t));
+  CHECK(test_write_wav("budget_in.wav", silence, n, RATE, 1) == 0);
+  free(silence);
+  static const uint32_t blocks[] = {160};
+  CHECK(vpio_set_replay("budget_in.wav", NULL, 1, blocks, 1) == 0);
+  CHECK(vpio_set_ring_budget(VPIO_RING_STAGING, BUDGET, SHRINK_MS) == 0);
+  if (vpio_start_stream(RATE, 1, RATE * 2) != 0) {
+    fprintf(stderr, "stream did not start\n");
+    return 1;
+  }
+  CHECK(vpio_start_playback_thread(10, 40) == 0);
+  vpio_ring_memory m;
+  mem(&m);
+  size_t base = (size_t)m.committed;
+  printf("staging starts at %zu bytes, budget %d\n", base, BUDGET);
+
+  // Bursts of 6, 2 and 9 s of speech with pauses long enough to drain
+  static const double answers[] = {6.0, 2.0, 9.0};
+  uint64_t shrinks = 0;
+  for (size_t a = 0; a < sizeof(answers) / sizeof(answers[0]); a++) {
+    size_t refused = 0;
+    size_t accepted = burst(answers[a], &refused);
+    mem(&m);
+    printf("answer %.0f s: accepted %zu bytes, %zu frames refused, committed %llu (high %llu), grows %llu\n",
+           answers[a], accepted, refused, (unsigned long long)m.committed, (unsigned long long)m.committed_high,
+           (unsigned long long)m.grows);
+    CHECK(m.committed_high <= BUDGET);
+    // What the budget leaves room for is taken, the rest refused
+    if (answers[a] * RATE * 2 > BUDGET) CHECK(refused > 0 && m.rejected_bytes > 0);
+    else CHECK(refused == 0);
+    double t = wait_shrunk(base, accepted / (RATE * 2.0) + 3.0);
+    mem(&m);
+    printf("  back to %llu bytes after %.2f s, shrinks %llu\n", (unsigned long long)m.committed, t,
+           (unsigned long long)m.shrinks);
+    CHECK(t >= 0.0);
+    CHECK(m.shrinks > shrinks);
+    shrinks = m.shrinks;
+  }
+  mem(&m);
+  CHECK(m.committed_high <= BUDGET);
+  vpio_stop_playback_thread();
+  vpio_stop_stream();
+  vpio_shutdown();
+  return test_result("test_ring_budget");
+}
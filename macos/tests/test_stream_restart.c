@@ -0,0 +1,84 @@
+// Stream restarts under a running device. On macOS the audio unit outlives
+// vpio_stop_stream, so its callbacks keep firing while stream state is freed
+// and set up again. Here the replay thread stands in for the unit and the
+// stream is torn down and rebuilt underneath it (stream_release and
+// stream_alloc, the parts of stop/start that do not touch the device) with
+// the capture stages, the recorder, playback, an extra mixer stream and a
+// clip voice all active. Built against the helper source to reach those two; make tsan runs
+// it under ThreadSanitizer.
+#include "../vpio_helper.c"
+#include "vpio_test.h"
+
+#define RATE 16000
+
+static int gClip = -1;
+
+static void configure(const int16_t* tone, size_t n) {
+  CHECK(vpio_set_aec(1, 64, -1) == 0);
+  CHECK(vpio_set_noise_suppressor(1, 20.0, 30) == 0);
+  CHECK(vpio_set_agc(VPIO_DIR_CAPTURE, 1, -20.0, 24.0, -1.0) == 0);
+  CHECK(vpio_set_agc(VPIO_DIR_PLAYBACK, 1, 0.0, 0.0, -1.0) == 0);
+  CHECK(vpio_start_recording("restart", VPIO_REC_WAV, 7) == 0);
+  CHECK(vpio_write_playback(tone, n * sizeof(int16_t)) == n * sizeof(int16_t));
+  int ps = vpio_play_stream_open(1, -6.0, 6.0);
+  CHECK(ps > 0);
+  CHECK(vpio_play_stream_write(ps, tone, n * sizeof(int16_t)) == n * sizeof(int16_t));
+  CHECK(vpio_clip_trigger(gClip, -6.0) > 0);
+}
+
+static int voices_playing(void) {
+  int n = 0;
+  for (int i = 0; i < CLIP_VOICES; i++) n += atomic_load(&gVoices[i].state) == VOICE_PLAYING;
+  return n;
+}
+
+int main(int argc, char** argv) {
+  int cycles = argc > 1 ? atoi(argv[1]) : 100;
+  size_t in_n = RATE * 10;
+  int16_t* in = (int16_t*)malloc(in_n * sizeof(int16_t));
+  uint32_t seed = 1;
+  for (size_t i = 0; i < in_n; i++)
+    in[i] = test_clip16(6000.0 * sin(2.0 * M_PI * 440.0 * (double)i / RATE) + 800.0 * test_randf(&seed));
+  CHECK(test_write_wav("restart_in.wav", in, in_n, RATE, 1) == 0);
+  int16_t tone[RATE / 50];
+  for (size_t i = 0; i < RATE / 50; i++) tone[i] = in[i];
+
+  static const uint32_t blocks[] = {16, 48, 160};
+  CHECK(vpio_set_replay("restart_in.wav", NULL, 1, blocks, 3) == 0);
+  if (vpio_start_stream(RATE, 1, 32000) != 0) {
+    fprintf(stderr, "stream did not start\n");
+    return 1;
+  }
+  // Long enough to still be playing at every release
+  gClip = vpio_clip_register(in, RATE * sizeof(int16_t));
+  CHECK(gClip >= 0);
+  uint64_t f0 = atomic_load(&gReplayFrames);
+  for (int c = 0; c < cycles; c++) {
+    configure(tone, RATE / 50);
+    usleep(5000);
+    stream_release();
+    CHECK(voices_playing() == 0);
+    CHECK(stream_alloc(RATE, 1, 32000) == 0);
+  }
+  configure(tone, RATE / 50);
+  usleep(100000);
+  vpio_stats st;
+  vpio_get_stats(&st, sizeof(st));
+  uint64_t frames = atomic_load(&gReplayFrames) - f0;
+  printf("%d restarts, %llu frames through the callbacks, aec_blocks %llu ns_blocks %llu rec_bytes %llu\n", cycles,
+         (unsigned long long)frames, (unsigned long long)st.aec_blocks, (unsigned long long)st.ns_blocks,
+         (unsigned long long)st.rec_bytes);
+  // The device ran throughout, and the last stream got its stages going again
+  CHECK(frames > (uint64_t)cycles * 16);
+  CHECK(st.aec_blocks > 0);
+  CHECK(st.ns_blocks > 0);
+  // Unregistered while its voice plays; stopping the stream ends the voice
+  // and frees the clip
+  CHECK(vpio_clip_unregister(gClip) == 0);
+  vpio_stop_stream();
+  CHECK(voices_playing() == 0);
+  CHECK(atomic_load(&gClips[gClip].state) == CLIP_FREE);
+  vpio_shutdown();
+  free(in);
+  return test_result("test_stream_restart");
+}
@@ -0,0 +1,143 @@
+// Shared helpers for the Linux tests and benchmarks: checks, clocks, a
+// deterministic PRNG and 16-bit PCM files for the replay backend.
+#ifndef VPIO_TEST_H
+#define VPIO_TEST_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int gTestFailures = 0;
+
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      gTestFailures++;                                                       \
+    }                                                                        \
+  } while (0)
+
+// Print the verdict; the exit status for main
+static inline int test_result(const char* name) {
+  printf("%s: %s\n", name, gTestFailures ? "FAIL" : "ok");
+  return gTestFailures != 0;
+}
+
+static inline double test_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static inline double test_thread_cpu(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static inline double test_process_cpu(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// xorshift32; never seed with 0
+static inline uint32_t test_rand(uint32_t* s) {
+  uint32_t x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *s = x;
+}
+
+// Uniform in [-1, 1)
+static inline float test_randf(uint32_t* s) {
+  return (float)((double)test_rand(s) / 2147483648.0 - 1.0);
+}
+
+static inline int16_t test_clip16(double v) {
+  if (v > 32767.0) return 32767;
+  if (v < -32768.0) return -32768;
+  return (int16_t)lrint(v);
+}
+
+static inline double test_rms(const int16_t* x, size_t n) {
+  double acc = 0.0;
+  for (size_t i = 0; i < n; i++) acc += (double)x[i] * x[i];
+  return n ? sqrt(acc / (double)n) : 0.0;
+}
+
+static inline double test_dbfs(double rms) {
+  return 20.0 * log10(rms / 32768.0 + 1e-12);
+}
+
+static inline void test_put16(FILE* f, uint16_t v) {
+  fputc(v & 0xff, f);
+  fputc(v >> 8, f);
+}
+
+static inline void test_put32(FILE* f, uint32_t v) {
+  test_put16(f, (uint16_t)(v & 0xffff));
+  test_put16(f, (uint16_t)(v >> 16));
+}
+
+// 16-bit PCM WAV
+static inline int test_write_wav(const char* path, const int16_t* pcm, size_t frames, int rate, int channels) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return -1;
+  uint32_t data = (uint32_t)(frames * (size_t)channels * 2);
+  fwrite("RIFF", 1, 4, f);
+  test_put32(f, 36 + data);
+  fwrite("WAVEfmt ", 1, 8, f);
+  test_put32(f, 16);
+  test_put16(f, 1);
+  test_put16(f, (uint16_t)channels);
+  test_put32(f, (uint32_t)rate);
+  test_put32(f, (uint32_t)(rate * channels * 2));
+  test_put16(f, (uint16_t)(channels * 2));
+  test_put16(f, 16);
+  fwrite("data", 1, 4, f);
+  test_put32(f, data);
+  size_t n = fwrite(pcm, 2, frames * (size_t)channels, f);
+  return (fclose(f) == 0 && n == frames * (size_t)channels) ? 0 : -1;
+}
+
+// Samples of a 16-bit WAV (data chunk) or a raw PCM file; malloc'd, NULL on error
+static inline int16_t* test_read_pcm(const char* path, size_t* samples) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  rewind(f);
+  unsigned char* raw = (unsigned char*)malloc(size > 0 ? (size_t)size : 1);
+  if (!raw || fread(raw, 1, (size_t)size, f) != (size_t)size) {
+    fclose(f);
+    free(raw);
+    return NULL;
+  }
+  fclose(f);
+  size_t off = 0, len = (size_t)size;
+  if (len >= 12 && memcmp(raw, "RIFF", 4) == 0 && memcmp(raw + 8, "WAVE", 4) == 0) {
+    size_t p = 12;
+    len = 0;
+    while (p + 8 <= (size_t)size) {
+      size_t n = raw[p + 4] | (raw[p + 5] << 8) | (raw[p + 6] << 16) | ((size_t)raw[p + 7] << 24);
+      if (memcmp(raw + p, "data", 4) == 0) {
+        off = p + 8;
+        len = n <= (size_t)size - off ? n : (size_t)size - off;
+        break;
+      }
+      p += 8 + n + (n & 1);
+    }
+  }
+  int16_t* pcm = (int16_t*)malloc(len ? len : 2);
+  if (pcm) memcpy(pcm, raw + off, len);
+  free(raw);
+  *samples = len / 2;
+  return pcm;
+}
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef VPIO_H
+#define VPIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Public C API of the VPIO helper (macos/vpio_helper.c). Python reaches it
+// either through ctypes (libvpio.dylib) or the _vpio extension module
+// (macos/vpio_module.c), which compiles the helper in directly.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capability bits returned by vpio_get_capabilities()
+enum {
+  VPIO_CAP_STREAM = 1u << 0,       // vpio_start_stream / read_capture / write_playback
+  VPIO_CAP_PLAY_THREAD = 1u << 1,  // C-paced playback thread + vpio_write_frame_10ms
+  VPIO_CAP_FLUSH = 1u << 2,        // vpio_flush_playback / vpio_flush_input
+  VPIO_CAP_DEBUG = 1u << 3,        // bypass / sample rate / ring level getters
+  VPIO_CAP_VAD_GATE = 1u << 4,     // capture VAD pre-gate
+  VPIO_CAP_FRAMES = 1u << 5,       // engine-side framing, vpio_read_frame(s)
+  VPIO_CAP_DTX = 1u << 6,          // discontinuous transmission on framed reads
+  VPIO_CAP_STATS = 1u << 7,        // vpio_get_stats
+  VPIO_CAP_AEC = 1u << 8,          // software echo canceller, vpio_set_aec
+  VPIO_CAP_DELAY_EST = 1u << 9,    // render/capture delay estimator
+  VPIO_CAP_NS = 1u << 10,          // capture noise suppressor
+  VPIO_CAP_AGC = 1u << 11,         // AGC + limiter per direction
+  VPIO_CAP_LEVELS = 1u << 12,      // per-direction level meters, vpio_get_levels
+  VPIO_CAP_RECORDER = 1u << 13,    // background session recorder
+  VPIO_CAP_REPLAY = 1u << 14,      // file replay backend, vpio_set_replay
+  VPIO_CAP_REMOTE = 1u << 15,      // client for an out-of-process engine, vpio_remote_*
+  VPIO_CAP_READERS = 1u << 16,     // extra capture readers, vpio_capture_reader_*
+  VPIO_CAP_MIXER = 1u << 17,       // extra playback streams, vpio_play_stream_*
+  VPIO_CAP_CLIPS = 1u << 18,       // preloaded clip bank, vpio_clip_*
+  VPIO_CAP_EVENTS = 1u << 19,      // engine event queue + notifier fd
+  VPIO_CAP_ASYNC_START = 1u << 20, // vpio_start_stream_async, vpio_get_start_timings
+  VPIO_CAP_CAPTURE_GATE = 1u << 21, // vpio_set_capture_gate
+  VPIO_CAP_RING_BUDGET = 1u << 22, // vpio_set_ring_budget, vpio_get_ring_memory
+  VPIO_CAP_BACKPRESSURE = 1u << 23, // vpio_set_playback_watermarks, PLAYBACK_WRITABLE events
+  VPIO_CAP_PLAYOUT = 1u << 24,      // playout clock and utterance marks, vpio_playout_mark
+};
+
+// Audio directions for per-direction stages
+enum { VPIO_DIR_CAPTURE = 0, VPIO_DIR_PLAYBACK = 1 };
+
+// Per-frame metadata for framed capture reads
+typedef struct {
+  uint64_t seq;            // frame number on the grid (capture offset / frame bytes)
+  uint64_t sample_index;   // capture sample index of the first sample
+  uint64_t host_time_ns;   // host clock time of the first sample; 0 if unknown
+  uint32_t flags;          // VPIO_FRAME_* bits
+  uint32_t silence_before; // samples suppressed by DTX right before this frame
+} vpio_frame_info;
+
+enum {
+  VPIO_FRAME_OVERRUN = 1,   // frames were lost (ring overrun) before this one
+  VPIO_FRAME_VAD_KNOWN = 2, // VAD_OPEN is meaningful
+  VPIO_FRAME_VAD_OPEN = 4,  // VAD gate open on any block of the frame
+  VPIO_FRAME_KEEPALIVE = 8, // gated-off frame passed through as DTX keepalive
+};
+
+// Engine notification (vpio_poll_events). Posted from any thread, including
+// the audio callbacks; the notifier fd turns readable when some are queued.
+typedef struct {
+  uint32_t type;          // VPIO_EVENT_*
+  uint32_t id;            // subject, e.g. the clip id
+  uint64_t arg;           // e.g. the voice handle
+  uint64_t host_time_ns;  // when it was posted
+} vpio_event;
+
+enum {
+  VPIO_EVENT_CLIP_DONE = 1,    // a clip voice played to the end
+  VPIO_EVENT_CLIP_STOPPED = 2, // a clip voice was stopped early
+  VPIO_EVENT_STREAM_STARTED = 3, // async start finished; arg = its result (int64)
+  VPIO_EVENT_PLAYBACK_WRITABLE = 4, // refused playback can resume; arg = free bytes
+};
+
+// Startup milestones of the last vpio_start_stream, in ms since start_ns;
+// -1 until reached (the replay backend skips the audio unit phases).
+// Size-versioned like vpio_stats: fields are only ever appended.
+typedef struct {
+  uint64_t start_ns;        // host time the start began, 0 if never started
+  double component_ms;      // VPIO component found and instantiated
+  double configure_ms;      // formats and callbacks set
+  double initialize_ms;     // AudioUnitInitialize returned
+  double unit_start_ms;     // AudioOutputUnitStart returned
+  double ready_ms;          // rings allocated, vpio_start_stream returning
+  double first_render_ms;   // first render callback
+  double first_capture_ms;  // first captured frame published to the capture ring
+  double first_played_ms;   // first queued playback sample rendered
+} vpio_start_timings;
+
+// Rings for vpio_set_ring_budget / vpio_get_ring_memory
+enum { VPIO_RING_CAPTURE = 0, VPIO_RING_PLAYBACK = 1, VPIO_RING_STAGING = 2 };
+
+// Memory of one ring; high-water marks restart with each stream.
+// Size-versioned like vpio_stats.
+typedef struct {
+  uint64_t committed;       // bytes allocated now
+  uint64_t committed_high;  // most bytes allocated at once
+  uint64_t level;           // bytes queued now
+  uint64_t level_high;      // deepest backlog
+  uint64_t budget;          // ceiling on committed, 0 = none
+  uint64_t grows;           // times the ring was enlarged
+  uint64_t shrinks;         // times it was shrunk back
+  uint64_t rejected_bytes;  // writes refused because of the budget
+} vpio_ring_memory;
+
+// Playout clock of one playback stream (0 = main). Positions count samples
+// in the order they were written since the stream started (extra streams:
+// since they were opened), so they stay comparable across flushes.
+// Size-versioned like vpio_stats.
+typedef struct {
+  uint64_t written;   // samples accepted by the write calls
+  uint64_t rendered;  // samples handed to the device
+  uint64_t position;  // written position of the next sample to play; all before it were rendered or dropped
+  uint64_t dropped;   // samples flushed or overwritten before they played
+} vpio_playout_clock;
+
+// One mark (vpio_playout_mark): the samples written from it up to the next
+// mark. Size-versioned like vpio_stats.
+typedef struct {
+  uint64_t tag;
+  uint64_t start;     // written position of its first sample
+  uint64_t written;   // samples written under it so far
+  uint64_t heard;     // of those, samples handed to the device
+  uint64_t pending;   // still queued; the rest of written was dropped
+} vpio_playout_mark_info;
+
+// One 10ms level meter block (vpio_get_levels). Levels are linear, full
+// scale = 1.0, measured on what was delivered (capture) or played (render).
+typedef struct {
+  uint64_t seq;      // block number since the stream started
+  float rms;
+  float peak;
+  uint32_t clipped;  // samples at or beyond full scale
+  uint32_t samples;
+} vpio_level;
+
+// Session recorder taps (bitmask) and output formats
+enum {
+  VPIO_REC_TAP_MIC_RAW = 1,   // capture as delivered by the device, before any helper processing
+  VPIO_REC_TAP_CAPTURE = 2,   // capture as handed to the reader
+  VPIO_REC_TAP_PLAYBACK = 4,  // what render_cb played
+};
+enum { VPIO_REC_WAV = 0, VPIO_REC_FRAMED = 1 };
+
+// VPIO_REC_FRAMED files (<prefix>.vprec): one vpio_rec_file_header, then
+// records of one vpio_rec_chunk followed by frames * channels int16 samples.
+// Records of different taps are interleaved in arrival order.
+typedef struct {
+  char magic[4];          // "VPRC"
+  uint32_t version;       // 1
+  uint32_t sample_rate;
+  uint16_t channels;
+  uint16_t taps;          // VPIO_REC_TAP_* bits recorded
+} vpio_rec_file_header;
+
+typedef struct {
+  uint32_t tap;           // one VPIO_REC_TAP_* bit
+  uint32_t frames;
+  uint64_t sample_index;  // position on this tap's sample clock
+  uint64_t host_time_ns;  // host time of the callback; 0 if unknown
+} vpio_rec_chunk;
+
+// All debug counters in one call. Fields are only ever appended; callers pass
+// sizeof their struct to vpio_get_stats and get back the bytes filled.
+typedef struct {
+  uint64_t cap_level, cap_capacity;
+  uint64_t play_level, play_capacity;
+  uint64_t staging_level, staging_capacity;
+  uint64_t underflows;
+  uint64_t render_last_bytes, render_max_bytes;
+  uint64_t vad_blocks, vad_open_blocks;
+  uint64_t dtx_frames_sent, dtx_frames_suppressed;
+  uint64_t aec_blocks;   // software AEC blocks processed
+  double aec_erle_db;    // smoothed echo return loss enhancement
+  uint64_t delay_blocks; // delay estimator blocks analyzed
+  double delay_ms;       // render -> capture delay estimate; -1 if none yet
+  double delay_confidence; // 0..1
+  double aec_delay_ms;   // bulk delay the software AEC currently applies
+  uint64_t ns_blocks;    // noise suppressor blocks processed
+  uint64_t ns_over_budget; // blocks that exceeded the CPU budget
+  double ns_max_block_us;  // slowest block since enabling
+  double ns_noise_dbfs;    // tracked noise floor
+  double agc_capture_gain_db, agc_capture_limit_db;   // AGC gain, limiter reduction (<= 0)
+  double agc_playback_gain_db, agc_playback_limit_db;
+  uint64_t rec_bytes;      // recorder bytes handed to the files
+  uint64_t rec_dropped;    // tap blocks dropped because the writer fell behind
+  uint64_t replay_frames;  // frames the replay backend drove through the callbacks
+  uint64_t replay_eof;     // 1 once the replay capture file is exhausted
+  uint64_t ipc_dropped;    // out-of-process engine: capture frames dropped, client fell behind
+  uint64_t cap_overruns;   // default capture reader lapped by the writer
+  uint64_t cap_overrun_bytes; // capture bytes it lost that way
+  uint64_t clip_voices;    // clip voices playing
+  uint64_t events_dropped; // events lost because the queue was full
+  uint64_t play_overruns;  // render found unplayed audio overwritten (drop-oldest writes)
+  uint64_t play_overrun_bytes; // playback bytes lost that way, exact
+  uint64_t playout_breaks_lost; // main playout clock breakpoints not queued (render stalled
+                                // through 64 flushes or jumps); positions after one are off
+} vpio_stats;
+
+uint32_t vpio_get_capabilities(void);
+
+// Engine lifecycle
+int vpio_set_replay(const char* capture_path, const char* playback_path, int realtime,
+                    const uint32_t* pattern, size_t pattern_len);
+int vpio_init(double sample_rate, int channels);
+int vpio_start_stream(double sample_rate, int channels, size_t ring_capacity_bytes);
+void vpio_stop_stream(void);
+// vpio_start_stream on a worker thread; posts VPIO_EVENT_STREAM_STARTED when
+// done. Returns 0 if the worker started, -1 if a start is already pending.
+int vpio_start_stream_async(double sample_rate, int channels, size_t ring_capacity_bytes);
+// 1 once the last async start finished (its vpio_start_stream result in
+// *rc), 0 while pending, -1 if there was none
+int vpio_start_stream_result(int* rc);
+size_t vpio_get_start_timings(void* out, size_t out_size);
+void vpio_shutdown(void);
+
+// Capture gate (vpio_set_capture_gate)
+enum {
+  VPIO_GATE_OPEN = 0,  // normal capture
+  VPIO_GATE_MUTE = 1,  // frames keep coming on the capture grid, all silence
+  VPIO_GATE_PAUSE = 2, // nothing is captured; the grid resumes where it stopped
+};
+
+// Streaming capture
+size_t vpio_read_capture(void* dst, size_t maxlen);
+size_t vpio_read_capture_pos(void* dst, size_t maxlen, size_t* pos_out);
+size_t vpio_set_capture_frame_ms(int ms);
+// Mute, pause or resume capture from the next input callback on; rings,
+// readers and the stream stay up. keep_echo keeps the echo canceller and
+// delay estimator running on the real mic signal meanwhile, so they are
+// still converged on resume. Returns 0, or -1 for an unknown gate.
+int vpio_set_capture_gate(int gate, int keep_echo);
+int vpio_get_capture_gate(void);
+size_t vpio_read_frame(void* dst, size_t maxlen, vpio_frame_info* info);
+size_t vpio_read_frames(void* dst, size_t max_frames, size_t frame_bytes, vpio_frame_info* meta_out);
+uint64_t vpio_host_time_now_ns(void);
+
+// Extra capture readers, each with its own cursor (reader 0 is the default
+// one above). The writer never waits for a reader; one that falls a whole
+// ring behind skips ahead and only it loses data. peek hands out the ring
+// itself (up to two spans); consume returns -1 if the writer overwrote the
+// peeked bytes in the meantime, in which case they must be discarded.
+int vpio_capture_reader_open(void);
+void vpio_capture_reader_close(int reader);
+size_t vpio_capture_reader_read(int reader, void* dst, size_t maxlen, size_t* pos_out);
+size_t vpio_capture_reader_read_frames(int reader, void* dst, size_t max_frames, size_t frame_bytes,
+                                       vpio_frame_info* meta_out);
+size_t vpio_capture_reader_peek(int reader, size_t maxlen, const void** p1, size_t* n1, const void** p2,
+                                size_t* n2, size_t* pos_out);
+int vpio_capture_reader_consume(int reader, size_t n);
+int vpio_capture_reader_stats(int reader, uint64_t* overruns, uint64_t* dropped_bytes, size_t* level);
+
+// Capture VAD pre-gate and DTX
+void vpio_set_vad_gate(int enabled, double margin_db, int hangover_ms, int onset_blocks);
+int vpio_vad_gate_query(size_t byte_pos, size_t len);
+void vpio_get_vad_stats(size_t* blocks_total, size_t* blocks_open);
+void vpio_set_dtx(int enabled, int keepalive_ms);
+void vpio_get_dtx_stats(size_t* frames_sent, size_t* frames_suppressed);
+
+// Software echo canceller
+int vpio_set_aec(int enabled, int tail_ms, int delay_ms);
+int vpio_set_delay_estimator(int enabled, int max_delay_ms);
+int vpio_get_delay_estimate(double* delay_ms, double* confidence);
+
+// Capture noise suppressor
+int vpio_set_noise_suppressor(int enabled, double max_atten_db, int budget_pct);
+
+// Automatic gain control / limiter
+int vpio_set_agc(int direction, int enabled, double target_dbfs, double max_gain_db, double ceiling_dbfs);
+
+// Level meters
+size_t vpio_get_levels(int direction, vpio_level* out, size_t max_entries);
+
+// Session recorder
+int vpio_start_recording(const char* path_prefix, int format, unsigned int taps);
+void vpio_stop_recording(void);
+
+// Streaming playback
+size_t vpio_write_playback(const void* src, size_t len);
+size_t vpio_write_frame_10ms(const void* data, size_t len);
+// Bounded playback: vpio_write_frame_10ms refuses (returns 0) while the
+// queued backlog (staging + play ring) plus the write would pass high_bytes;
+// once the pacer has drained it to low_bytes (0 = half of high) it posts
+// VPIO_EVENT_PLAYBACK_WRITABLE. high_bytes 0 = unbounded (the default).
+int vpio_set_playback_watermarks(size_t high_bytes, size_t low_bytes);
+// Bytes that can be written now (before the high watermark, or before the
+// staging ring grows when unbounded); *queued_out = the backlog
+size_t vpio_get_playback_space(size_t* queued_out);
+void vpio_flush_playback(void);
+void vpio_flush_input(void);
+void vpio_set_target_headroom_ms(int ms);
+int vpio_start_playback_thread(int slice_ms, int preroll_ms);
+void vpio_stop_playback_thread(void);
+
+// Extra playback streams mixed over the main one (stream 0) with their own
+// gain and flush. A stream with audio queued ducks lower-priority streams by
+// its duck_db.
+int vpio_play_stream_open(int priority, double gain_db, double duck_db);
+int vpio_play_stream_set(int stream, int priority, double gain_db, double duck_db);
+size_t vpio_play_stream_write(int stream, const void* src, size_t len);
+void vpio_play_stream_flush(int stream);
+void vpio_play_stream_close(int stream);
+int vpio_play_stream_stats(int stream, size_t* queued, uint64_t* played, double* duck_db);
+// Playout clock: tag the next sample written to a stream (e.g. an
+// utterance's first) from the thread that writes it, then ask how much of
+// it reached the device. Marks fail once 64 are still unplayed; each
+// stays queryable until 64 newer ones replace it. Getters return the bytes
+// filled, 0 if the stream is not open or the tag is unknown.
+int vpio_playout_mark(int stream, uint64_t tag);
+size_t vpio_get_playout_clock(int stream, void* out, size_t out_size);
+size_t vpio_get_playout_mark(int stream, uint64_t tag, void* out, size_t out_size);
+
+// Clip bank: PCM registered once, then triggered by id from any thread
+// without copying or blocking. Voices mix over playback; each ends with a
+// CLIP_DONE or CLIP_STOPPED event carrying its handle.
+int vpio_clip_register(const void* pcm, size_t len);
+int vpio_clip_unregister(int clip);
+int vpio_clip_trigger(int clip, double gain_db);
+int vpio_clip_stop(int voice);
+
+// Engine events
+int vpio_event_fd(void);
+size_t vpio_poll_events(vpio_event* out, size_t max_events);
+
+// Legacy single-shot API
+int vpio_record(double seconds);
+size_t vpio_get_capture_size(void);
+size_t vpio_copy_capture(void* dst, size_t maxlen);
+size_t vpio_reset_capture(void);
+int vpio_play(const void* data, size_t len);
+
+// Debug
+int vpio_get_bypass(unsigned int* bypass);
+double vpio_get_in_sample_rate(void);
+double vpio_get_out_sample_rate(void);
+size_t vpio_get_ring_levels(size_t* cap_level, size_t* play_level);
+
+// Ring memory budgets. Capture and playback rings are sized by
+// vpio_start_stream, so theirs apply from the next start (never below one
+// second of audio). The staging ring grows with TTS bursts up to its budget
+// and refuses writes beyond it. Once its backlog has stayed under a quarter
+// of the ring for shrink_after_ms (staging only; 0 = never, default 2000),
+// the pacing thread halves it back toward its start size. max_bytes 0 = no
+// budget. Returns 0, or -1 for an unknown ring.
+int vpio_set_ring_budget(int ring, size_t max_bytes, int shrink_after_ms);
+size_t vpio_get_ring_memory(int ring, void* out, size_t out_size);
+size_t vpio_get_staging_level(void);
+size_t vpio_get_staging_capacity(void);
+size_t vpio_get_underflow_count(void);
+void vpio_reset_underflow_count(void);
+size_t vpio_get_stats(void* out, size_t out_size);
+void vpio_debug_dump(void);
+
+// Out-of-process engine client. The engine runs in vpiod (vpio_daemon.c);
+// these map its shared-memory segment (vpio_shm.h). Ops are VPIO_SHM_OP_*.
+int vpio_remote_attach(const char* shm_name, int timeout_ms);
+void vpio_remote_detach(void);
+uint32_t vpio_remote_capabilities(void);
+int64_t vpio_remote_call(int op, const int32_t* iargs, const double* dargs, const char* path, double* out);
+size_t vpio_remote_get_levels(int direction, vpio_level* out, size_t max_entries);
+size_t vpio_remote_read_frames(void* dst, size_t max_frames, size_t frame_bytes, vpio_frame_info* meta_out);
+size_t vpio_remote_write_playback(const void* src, size_t len);
+size_t vpio_remote_get_stats(void* out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VPIO_H
@@ -0,0 +1,165 @@
+#ifndef VPIO_AEC_H
+#define VPIO_AEC_H
+
+#include "vpio_fft.h"
+
+// Partitioned-block frequency-domain adaptive filter (overlap-save, MDF
+// style) for software echo cancellation. Works on mono float blocks of
+// `block` samples; the echo tail is covered by `parts` partitions of one
+// block each. The gradient constraint is applied to one partition per block
+// in turn, which keeps the cost at roughly 3 + 2/parts FFTs per block.
+// Create/destroy allocate; vpio_aec_process does not and is RT-safe.
+
+typedef struct {
+  int block;          // B samples per block
+  int nfft;           // 2B
+  int nbins;          // B+1 (real spectrum)
+  int parts;          // number of filter partitions
+  vpio_fft fft;
+  float* xtime;       // nfft: previous + current far-end block
+  float* Xre; float* Xim; // parts*nbins far-end spectra, newest at xhead
+  float* Wre; float* Wim; // parts*nbins filter taps
+  float* xpow;        // nbins smoothed far-end power
+  float* sre; float* sim; // nfft scratch
+  float* tbuf;        // nfft time-domain scratch
+  int xhead;
+  int cpart;          // next partition to constrain
+  float mu;
+  double near_pow, err_pow; // smoothed energies over far-active blocks
+  float erle_db;
+  uint64_t blocks;
+} vpio_aec;
+
+static void vpio_aec_destroy(vpio_aec* a) {
+  if (!a) return;
+  vpio_fft_free(&a->fft);
+  free(a->xtime); free(a->Xre); free(a->Xim); free(a->Wre); free(a->Wim);
+  free(a->xpow); free(a->sre); free(a->sim); free(a->tbuf);
+  free(a);
+}
+
+// block must be a power of two; mu is the normalized step size (0.1..1)
+static vpio_aec* vpio_aec_create(int block, int parts, float mu) {
+  if (block < 16 || (block & (block - 1)) || parts < 1) return NULL;
+  vpio_aec* a = (vpio_aec*)calloc(1, sizeof(*a));
+  if (!a) return NULL;
+  a->block = block;
+  a->nfft = block * 2;
+  a->nbins = block + 1;
+  a->parts = parts;
+  a->mu = mu;
+  size_t spec = (size_t)parts * (size_t)a->nbins;
+  a->xtime = (float*)calloc((size_t)a->nfft, sizeof(float));
+  a->Xre = (float*)calloc(spec, sizeof(float));
+  a->Xim = (float*)calloc(spec, sizeof(float));
+  a->Wre = (float*)calloc(spec, sizeof(float));
+  a->Wim = (float*)calloc(spec, sizeof(float));
+  a->xpow = (float*)calloc((size_t)a->nbins, sizeof(float));
+  a->sre = (float*)calloc((size_t)a->nfft, sizeof(float));
+  a->sim = (float*)calloc((size_t)a->nfft, sizeof(float));
+  a->tbuf = (float*)calloc((size_t)a->nfft, sizeof(float));
+  if (vpio_fft_init(&a->fft, a->nfft) != 0 || !a->xtime || !a->Xre || !a->Xim || !a->Wre ||
+      !a->Wim || !a->xpow || !a->sre || !a->sim || !a->tbuf) {
+    vpio_aec_destroy(a);
+    return NULL;
+  }
+  return a;
+}
+
+// Cancel the echo of `far` (what was played) from `near` (what was
+// captured); writes block samples of residual to `out` (may alias near).
+static void vpio_aec_process(vpio_aec* a, const float* far, const float* near, float* out) {
+  const int B = a->block, N = a->nfft, K = a->nbins, P = a->parts;
+  float* sre = a->sre; float* sim = a->sim;
+
+  // Newest far-end spectrum over the last two blocks
+  memmove(a->xtime, a->xtime + B, sizeof(float) * (size_t)B);
+  memcpy(a->xtime + B, far, sizeof(float) * (size_t)B);
+  a->xhead = (a->xhead + P - 1) % P;
+  float* xr0 = a->Xre + (size_t)a->xhead * (size_t)K;
+  float* xi0 = a->Xim + (size_t)a->xhead * (size_t)K;
+  vpio_fft_real_forward(&a->fft, a->xtime, sre, sim);
+  memcpy(xr0, sre, sizeof(float) * (size_t)K);
+  memcpy(xi0, sim, sizeof(float) * (size_t)K);
+
+  float far_e = 0.0f;
+  for (int i = 0; i < B; i++) far_e += far[i] * far[i];
+  for (int k = 0; k < K; k++) {
+    float p = xr0[k] * xr0[k] + xi0[k] * xi0[k];
+    a->xpow[k] = 0.9f * a->xpow[k] + 0.1f * p;
+  }
+
+  // Echo estimate: Y = sum_p W_p * X_{n-p}
+  memset(sre, 0, sizeof(float) * (size_t)N);
+  memset(sim, 0, sizeof(float) * (size_t)N);
+  for (int p = 0; p < P; p++) {
+    int xp = (a->xhead + p) % P;
+    const float* xr = a->Xre + (size_t)xp * (size_t)K;
+    const float* xi = a->Xim + (size_t)xp * (size_t)K;
+    const float* wr = a->Wre + (size_t)p * (size_t)K;
+    const float* wi = a->Wim + (size_t)p * (size_t)K;
+    for (int k = 0; k < K; k++) {
+      sre[k] += wr[k] * xr[k] - wi[k] * xi[k];
+      sim[k] += wr[k] * xi[k] + wi[k] * xr[k];
+    }
+  }
+  vpio_fft_real_inverse(&a->fft, sre, sim, a->tbuf);
+
+  float near_e = 0.0f, err_e = 0.0f;
+  for (int i = 0; i < B; i++) {
+    float d = near[i];
+    float e = d - a->tbuf[B + i];
+    near_e += d * d;
+    err_e += e * e;
+    a->tbuf[i] = 0.0f;
+    a->tbuf[B + i] = e;
+    out[i] = e;
+  }
+  // A diverged filter must never make the capture louder than the mic
+  if (err_e > 2.0f * near_e + 1e-6f) {
+    for (int i = 0; i < B; i++) out[i] = near[i];
+    for (size_t i = 0; i < (size_t)P * (size_t)K; i++) { a->Wre[i] *= 0.5f; a->Wim[i] *= 0.5f; }
+  }
+
+  // Adapt only while the far end is active; there is nothing to learn otherwise
+  const float far_floor = (float)B * 1e-7f; // ~-70 dBFS
+  if (far_e > far_floor) {
+    vpio_fft_real_forward(&a->fft, a->tbuf, sre, sim);
+    const float eps = (far_floor / (float)B) * (float)N;
+    for (int k = 0; k < K; k++) {
+      float g = a->mu / ((float)P * a->xpow[k] + eps);
+      sre[k] *= g;
+      sim[k] *= g;
+    }
+    for (int p = 0; p < P; p++) {
+      int xp = (a->xhead + p) % P;
+      const float* xr = a->Xre + (size_t)xp * (size_t)K;
+      const float* xi = a->Xim + (size_t)xp * (size_t)K;
+      float* wr = a->Wre + (size_t)p * (size_t)K;
+      float* wi = a->Wim + (size_t)p * (size_t)K;
+      for (int k = 0; k < K; k++) {
+        // W += conj(X) * E
+        wr[k] += xr[k] * sre[k] + xi[k] * sim[k];
+        wi[k] += xr[k] * sim[k] - xi[k] * sre[k];
+      }
+    }
+    // Gradient constraint on one partition: keep only the first B taps
+    float* wr = a->Wre + (size_t)a->cpart * (size_t)K;
+    float* wi = a->Wim + (size_t)a->cpart * (size_t)K;
+    memcpy(sre, wr, sizeof(float) * (size_t)K);
+    memcpy(sim, wi, sizeof(float) * (size_t)K);
+    vpio_fft_real_inverse(&a->fft, sre, sim, a->tbuf);
+    memset(a->tbuf + B, 0, sizeof(float) * (size_t)B);
+    vpio_fft_real_forward(&a->fft, a->tbuf, sre, sim);
+    memcpy(wr, sre, sizeof(float) * (size_t)K);
+    memcpy(wi, sim, sizeof(float) * (size_t)K);
+    a->cpart = (a->cpart + 1) % P;
+
+    a->near_pow = 0.98 * a->near_pow + 0.02 * (double)near_e;
+    a->err_pow = 0.98 * a->err_pow + 0.02 * (double)err_e;
+    a->erle_db = (float)(10.0 * log10((a->near_pow + 1e-10) / (a->err_pow + 1e-10)));
+  }
+  a->blocks++;
+}
+
+#endif // VPIO_AEC_H
@@ -0,0 +1,131 @@
+#ifndef VPIO_AGC_H
+#define VPIO_AGC_H
+
+#include <math.h>
+#include <string.h>
+
+// Automatic gain control with a lookahead peak limiter. Works in ~1ms chunks:
+// the AGC gain follows the 10ms speech level (gated, rate-limited), and the
+// limiter looks one chunk ahead so its gain has already ramped down when a
+// peak reaches the output. Output lags input by two chunks. Fixed-size state,
+// no allocation; vpio_agc_process is RT-safe.
+
+#define VPIO_AGC_MAX_CHUNK 64  // 1ms at 48k
+
+typedef struct {
+  // configuration (vpio_agc_configure)
+  int agc_on;              // 0 = limiter only
+  float target_db;         // speech level the AGC steers to (dBFS RMS)
+  float max_gain_db, min_gain_db;
+  float gate_db;           // blocks below this level don't move the gain
+  float ceiling;           // limiter ceiling (linear peak)
+  float up_db, down_db;    // max gain change per 10ms level block
+  float release;           // limiter recovery per chunk (0..1)
+  size_t chunk;            // samples per chunk
+  size_t level_chunks;     // chunks per level block (~10ms)
+  // state
+  float in[VPIO_AGC_MAX_CHUNK];
+  size_t fill;
+  float held[VPIO_AGC_MAX_CHUNK];   // AGC-scaled chunk waiting for lookahead
+  float held_need;                   // limiter gain the held chunk needs
+  float out[VPIO_AGC_MAX_CHUNK];    // limited chunk being played out
+  float gain_db;                     // current AGC gain
+  float applied;                     // linear AGC gain at the end of the last chunk
+  float lim;                         // limiter gain at the end of the last chunk
+  double level_acc;
+  size_t level_n, level_count;
+} vpio_agc;
+
+static void vpio_agc_configure(vpio_agc* a, double sample_rate, int agc_on, double target_db,
+                               double max_gain_db, double ceiling_db) {
+  memset(a, 0, sizeof(*a));
+  a->chunk = (size_t)(sample_rate / 1000.0);
+  if (a->chunk < 8) a->chunk = 8;
+  if (a->chunk > VPIO_AGC_MAX_CHUNK) a->chunk = VPIO_AGC_MAX_CHUNK;
+  a->level_chunks = 10;
+  a->agc_on = agc_on;
+  a->target_db = (float)target_db;
+  a->max_gain_db = (float)max_gain_db;
+  a->min_gain_db = -20.0f;
+  a->gate_db = -55.0f;
+  a->ceiling = (float)pow(10.0, ceiling_db / 20.0);
+  a->up_db = 0.1f;    // 10 dB/s: slow rise, no pumping on pauses
+  a->down_db = 0.5f;  // 50 dB/s: back off quickly from sudden loud input
+  double chunk_ms = (double)a->chunk * 1000.0 / sample_rate;
+  a->release = (float)(1.0 - exp(-chunk_ms / 60.0)); // ~60ms limiter release
+  a->held_need = 1.0f;
+  a->applied = 1.0f;
+  a->lim = 1.0f;
+}
+
+static void vpio_agc_update_level(vpio_agc* a) {
+  if (!a->agc_on || a->level_n == 0) return;
+  float level_db = (float)(10.0 * log10(a->level_acc / (double)a->level_n + 1e-12));
+  a->level_acc = 0.0;
+  a->level_n = 0;
+  if (level_db < a->gate_db) return;
+  float want = a->target_db - level_db;
+  if (want > a->max_gain_db) want = a->max_gain_db;
+  if (want < a->min_gain_db) want = a->min_gain_db;
+  float d = want - a->gain_db;
+  if (d > a->up_db) d = a->up_db;
+  if (d < -a->down_db) d = -a->down_db;
+  a->gain_db += d;
+}
+
+// A full input chunk arrived: scale it, look at its peak, and finish the
+// held chunk with a limiter ramp that is already low enough for both.
+static void vpio_agc_chunk(vpio_agc* a) {
+  const size_t n = a->chunk;
+  float g1 = a->agc_on ? (float)pow(10.0, a->gain_db / 20.0) : 1.0f;
+  float g0 = a->applied;
+  float step = (g1 - g0) / (float)n;
+  float peak = 0.0f;
+  double e = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    float x = a->in[i];
+    e += (double)x * x;
+    float y = x * (g0 + step * (float)(i + 1));
+    a->in[i] = y;
+    float m = fabsf(y);
+    peak = (m > peak) ? m : peak;
+  }
+  a->applied = g1;
+  a->level_acc += e;
+  a->level_n += n;
+  if (++a->level_count >= a->level_chunks) { a->level_count = 0; vpio_agc_update_level(a); }
+  float need = (peak > a->ceiling) ? a->ceiling / peak : 1.0f;
+
+  float target = a->lim + (1.0f - a->lim) * a->release;
+  if (target > a->held_need) target = a->held_need;
+  if (target > need) target = need;
+  float l0 = a->lim;
+  float lstep = (target - l0) / (float)n;
+  for (size_t i = 0; i < n; i++) a->out[i] = a->held[i] * (l0 + lstep * (float)(i + 1));
+  a->lim = target;
+  memcpy(a->held, a->in, sizeof(float) * n);
+  a->held_need = need;
+}
+
+// In place over n samples (any n)
+static void vpio_agc_process(vpio_agc* a, float* x, size_t n) {
+  for (size_t i = 0; i < n; ) {
+    size_t take = a->chunk - a->fill;
+    if (take > n - i) take = n - i;
+    for (size_t k = 0; k < take; k++) {
+      float v = x[i + k];
+      x[i + k] = a->out[a->fill + k];
+      a->in[a->fill + k] = v;
+    }
+    a->fill += take;
+    i += take;
+    if (a->fill == a->chunk) { vpio_agc_chunk(a); a->fill = 0; }
+  }
+}
+
+// Current limiter gain reduction in dB (0 when idle)
+static float vpio_agc_limit_db(const vpio_agc* a) {
+  return (float)(20.0 * log10(a->lim > 1e-6f ? a->lim : 1e-6f));
+}
+
+#endif // VPIO_AGC_H
@@ -0,0 +1,351 @@
+// vpiod: runs the VPIO engine in its own process for a client that maps its
+// shared-memory segment (layout in vpio_shm.h, client in vpio_helper.c), so
+// stalls in the client process (GC pauses, log sinks, slow handlers) never
+// reach the audio callbacks; the rings absorb them.
+//
+//   vpiod <shm-name> <sample-rate> <channels> <ring-bytes>
+//         [--replay <capture> [--replay-out <file>] [--replay-fast]
+//          [--replay-pattern n,n,...]]
+//
+// The segment is created exclusively; the client unlinks the name once it
+// has mapped it. The daemon exits on VPIO_SHM_OP_STOP, SIGINT/SIGTERM, or
+// when its parent process goes away.
+//
+// Build: make -C macos vpiod (on Linux, with the replay device only)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "vpio.h"
+#include "vpio_shm.h"
+
+#define CAPTURE_BATCH 16
+
+static vpio_shm_header* gShm = NULL;
+static _Atomic int gRun = 1;
+static _Atomic size_t gFrameBytes = 0; // 0 until the client sets a frame size
+static int gPlayThread = 0;            // playback goes through the paced staging ring
+
+static void on_signal(int sig) {
+  (void)sig;
+  atomic_store_explicit(&gRun, 0, memory_order_release);
+}
+
+// Engine frames -> shared capture ring. Never waits for the client: a full
+// ring drops the frame, counts it, and flags the next one as an overrun.
+static void* capture_pump(void* arg) {
+  (void)arg;
+  vpio_shm_header* h = gShm;
+  unsigned char* buf = NULL;
+  size_t buf_fb = 0;
+  int lost = 0;
+  vpio_frame_info info[CAPTURE_BATCH];
+  while (atomic_load_explicit(&gRun, memory_order_acquire)) {
+    size_t fb = atomic_load_explicit(&gFrameBytes, memory_order_acquire);
+    if (fb != buf_fb) {
+      free(buf);
+      buf = fb ? (unsigned char*)malloc(fb * CAPTURE_BATCH) : NULL;
+      buf_fb = buf ? fb : 0;
+    }
+    size_t n = buf_fb ? vpio_read_frames(buf, CAPTURE_BATCH, buf_fb, info) : 0;
+    uint64_t w = atomic_load_explicit(&h->cap.w, memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+      size_t need = sizeof(vpio_shm_frame) + buf_fb;
+      if (vpio_shm_ring_space(&h->cap, w, need) < need) {
+        atomic_fetch_add_explicit(&h->cap_dropped, 1, memory_order_relaxed);
+        lost = 1;
+        continue;
+      }
+      vpio_shm_frame fr;
+      memset(&fr, 0, sizeof(fr));
+      fr.bytes = (uint32_t)buf_fb;
+      fr.info = info[i];
+      if (lost) { fr.info.flags |= VPIO_FRAME_OVERRUN; lost = 0; }
+      w = vpio_shm_ring_copy_in(h, &h->cap, w, &fr, sizeof(fr));
+      w = vpio_shm_ring_copy_in(h, &h->cap, w, buf + i * buf_fb, buf_fb);
+    }
+    if (n) atomic_store_explicit(&h->cap.w, w, memory_order_release);
+    if (n < CAPTURE_BATCH) usleep(2000);
+  }
+  free(buf);
+  return NULL;
+}
+
+// Room the engine has for more playback. vpio_write_playback drops the
+// oldest unplayed audio when its ring is full, so whatever does not fit
+// stays in the shared ring and the client sees that one fill up instead.
+static size_t engine_play_space(void) {
+  if (gPlayThread) return vpio_get_playback_space(NULL);
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  vpio_get_stats(&st, sizeof(st));
+  return st.play_capacity > st.play_level ? (size_t)(st.play_capacity - st.play_level) : 0;
+}
+
+// Shared playback ring -> engine. Only the main loop consumes the ring.
+static void drain_playback(vpio_shm_header* h) {
+  static unsigned char buf[16384];
+  const size_t frame = (size_t)2 * (size_t)h->channels;
+  uint64_t r = atomic_load_explicit(&h->play.r, memory_order_relaxed);
+  size_t room = engine_play_space();
+  room -= room % frame;
+  while (room) {
+    size_t avail = vpio_shm_ring_avail(&h->play, r, sizeof(buf));
+    if (avail == 0) break;
+    size_t n = avail < sizeof(buf) ? avail : sizeof(buf);
+    if (n > room) n = room;
+    uint64_t next = vpio_shm_ring_copy_out(h, &h->play, r, buf, n);
+    // A bounded engine refuses the whole write past its high watermark:
+    // leave those bytes in the shared ring for the next pass
+    size_t took = gPlayThread ? vpio_write_frame_10ms(buf, n) : vpio_write_playback(buf, n);
+    if (took < n) break;
+    r = next;
+    atomic_store_explicit(&h->play.r, r, memory_order_release);
+    room -= n;
+  }
+}
+
+static void drop_playback(vpio_shm_header* h) {
+  atomic_store_explicit(&h->play.r, atomic_load_explicit(&h->play.w, memory_order_acquire), memory_order_release);
+}
+
+static void publish_stats(vpio_shm_header* h) {
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  vpio_get_stats(&st, sizeof(st));
+  st.ipc_dropped = atomic_load_explicit(&h->cap_dropped, memory_order_relaxed);
+  uint64_t words[VPIO_SHM_STATS_WORDS];
+  memcpy(words, &st, sizeof(words));
+  uint32_t seq = atomic_load_explicit(&h->stats_seq, memory_order_relaxed);
+  atomic_store_explicit(&h->stats_seq, seq + 1, VPIO_SEQ_ORDER(memory_order_relaxed));
+  VPIO_SEQ_FENCE(memory_order_release);
+  for (size_t i = 0; i < VPIO_SHM_STATS_WORDS; i++)
+    atomic_store_explicit(&h->stats[i], words[i], memory_order_relaxed);
+  atomic_store_explicit(&h->stats_seq, seq + 2, memory_order_release);
+}
+
+static int64_t run_command(vpio_shm_header* h, int* stop) {
+  const int32_t* i = h->cmd_i;
+  const double* d = h->cmd_d;
+  switch (h->cmd_op) {
+    case VPIO_SHM_OP_STOP:
+      *stop = 1;
+      return 0;
+    case VPIO_SHM_OP_FRAME_MS: {
+      size_t fb = vpio_set_capture_frame_ms(i[0]);
+      atomic_store_explicit(&gFrameBytes, fb, memory_order_release);
+      return (int64_t)fb;
+    }
+    case VPIO_SHM_OP_VAD_GATE:
+      vpio_set_vad_gate(i[0], d[0], i[1], i[2]);
+      return 0;
+    case VPIO_SHM_OP_DTX:
+      vpio_set_dtx(i[0], i[1]);
+      return 0;
+    case VPIO_SHM_OP_AEC:
+      return vpio_set_aec(i[0], i[1], i[2]);
+    case VPIO_SHM_OP_DELAY_EST:
+      return vpio_set_delay_estimator(i[0], i[1]);
+    case VPIO_SHM_OP_DELAY_ESTIMATE:
+      return vpio_get_delay_estimate(&h->cmd_out[0], &h->cmd_out[1]);
+    case VPIO_SHM_OP_NS:
+      return vpio_set_noise_suppressor(i[0], d[0], i[1]);
+    case VPIO_SHM_OP_AGC:
+      return vpio_set_agc(i[0], i[1], d[0], d[1], d[2]);
+    case VPIO_SHM_OP_START_REC:
+      h->cmd_data[VPIO_SHM_CMD_DATA - 1] = 0;
+      return vpio_start_recording((const char*)h->cmd_data, i[0], (unsigned int)i[1]);
+    case VPIO_SHM_OP_STOP_REC:
+      vpio_stop_recording();
+      return 0;
+    case VPIO_SHM_OP_LEVELS: {
+      vpio_level lv[VPIO_SHM_CMD_DATA / sizeof(vpio_level)];
+      size_t max = sizeof(lv) / sizeof(lv[0]);
+      if (i[1] >= 0 && (size_t)i[1] < max) max = (size_t)i[1];
+      size_t n = vpio_get_levels(i[0], lv, max);
+      memcpy(h->cmd_data, lv, n * sizeof(vpio_level));
+      return (int64_t)n;
+    }
+    case VPIO_SHM_OP_FLUSH_PLAYBACK:
+      drop_playback(h);
+      vpio_flush_playback();
+      return 0;
+    case VPIO_SHM_OP_FLUSH_INPUT:
+      drop_playback(h);
+      vpio_flush_input();
+      return 0;
+    case VPIO_SHM_OP_HEADROOM:
+      vpio_set_target_headroom_ms(i[0]);
+      return 0;
+    case VPIO_SHM_OP_START_PLAY_THREAD: {
+      int rc = vpio_start_playback_thread(i[0], i[1]);
+      if (rc == 0) gPlayThread = 1;
+      return rc;
+    }
+    case VPIO_SHM_OP_STOP_PLAY_THREAD:
+      vpio_stop_playback_thread();
+      gPlayThread = 0;
+      return 0;
+    case VPIO_SHM_OP_CAPTURE_GATE:
+      return vpio_set_capture_gate(i[0], i[1]);
+    default:
+      return -1;
+  }
+}
+
+static void finish_command(vpio_shm_header* h, uint32_t req, int64_t result) {
+  h->cmd_result = result;
+  atomic_store_explicit(&h->cmd_done, req, memory_order_release);
+  vpio_shm_wake(&h->cmd_done);
+}
+
+static int parse_pattern(const char* s, uint32_t* out, size_t max) {
+  size_t n = 0;
+  while (*s && n < max) {
+    char* end = NULL;
+    unsigned long v = strtoul(s, &end, 10);
+    if (end == s) return -1;
+    out[n++] = (uint32_t)v;
+    s = (*end == ',') ? end + 1 : end;
+  }
+  return *s ? -1 : (int)n;
+}
+
+static int usage(void) {
+  fprintf(stderr,
+          "usage: vpiod <shm-name> <sample-rate> <channels> <ring-bytes>\n"
+          "             [--replay <capture> [--replay-out <file>] [--replay-fast] [--replay-pattern n,n,...]]\n");
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 5) return usage();
+  const char* name = argv[1];
+  double sample_rate = atof(argv[2]);
+  int channels = atoi(argv[3]);
+  size_t ring_bytes = (size_t)strtoull(argv[4], NULL, 10);
+  const char* replay_in = NULL;
+  const char* replay_out = NULL;
+  int replay_realtime = 1;
+  uint32_t pattern[32];
+  int pattern_len = 0;
+  for (int a = 5; a < argc; a++) {
+    if (!strcmp(argv[a], "--replay") && a + 1 < argc) replay_in = argv[++a];
+    else if (!strcmp(argv[a], "--replay-out") && a + 1 < argc) replay_out = argv[++a];
+    else if (!strcmp(argv[a], "--replay-fast")) replay_realtime = 0;
+    else if (!strcmp(argv[a], "--replay-pattern") && a + 1 < argc) {
+      pattern_len = parse_pattern(argv[++a], pattern, sizeof(pattern) / sizeof(pattern[0]));
+      if (pattern_len < 0) return usage();
+    } else return usage();
+  }
+  if (sample_rate <= 0.0 || channels <= 0 || ring_bytes == 0) return usage();
+
+  // Capture records carry a small header per frame; leave room for it
+  size_t hdr = (sizeof(vpio_shm_header) + 63) & ~(size_t)63;
+  size_t cap_size = vpio_ring_pow2(ring_bytes + ring_bytes / 8 + 4096);
+  size_t play_size = vpio_ring_pow2(ring_bytes);
+  size_t total = hdr + cap_size + play_size;
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    fprintf(stderr, "vpiod: shm_open %s: %s\n", name, strerror(errno));
+    return 1;
+  }
+  if (ftruncate(fd, (off_t)total) != 0) {
+    fprintf(stderr, "vpiod: ftruncate: %s\n", strerror(errno));
+    close(fd);
+    shm_unlink(name);
+    return 1;
+  }
+  void* p = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    fprintf(stderr, "vpiod: mmap: %s\n", strerror(errno));
+    shm_unlink(name);
+    return 1;
+  }
+  vpio_shm_header* h = (vpio_shm_header*)p; // zero-filled by ftruncate
+  gShm = h;
+  h->version = VPIO_SHM_VERSION;
+  h->capabilities = vpio_get_capabilities();
+  h->sample_rate = sample_rate;
+  h->channels = channels;
+  h->daemon_pid = (int32_t)getpid();
+  h->cap.size = cap_size;
+  h->cap.offset = hdr;
+  h->play.size = play_size;
+  h->play.offset = hdr + cap_size;
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+  pid_t parent = getppid();
+
+  int status = 0;
+  if (replay_in &&
+      vpio_set_replay(replay_in, replay_out, replay_realtime, pattern_len ? pattern : NULL, (size_t)pattern_len) != 0)
+    status = -1;
+  if (status == 0 && vpio_start_stream(sample_rate, channels, ring_bytes) != 0) status = -1;
+  h->status = status;
+  publish_stats(h);
+  atomic_store_explicit(&h->magic, VPIO_SHM_MAGIC, memory_order_release);
+  if (status != 0) {
+    fprintf(stderr, "vpiod: engine failed to start\n");
+    // Give the client a moment to read the status before the name goes
+    for (int i = 0; i < 300 && getppid() == parent; i++) {
+      int probe = shm_open(name, O_RDONLY, 0);
+      if (probe < 0) break;
+      close(probe);
+      usleep(10000);
+    }
+    shm_unlink(name);
+    munmap(p, total);
+    return 1;
+  }
+
+  pthread_t pump;
+  int pump_ok = (pthread_create(&pump, NULL, capture_pump, NULL) == 0);
+  if (!pump_ok) {
+    fprintf(stderr, "vpiod: capture thread failed\n");
+    atomic_store_explicit(&gRun, 0, memory_order_release);
+  }
+
+  int stop = 0;
+  uint32_t stop_req = 0;
+  uint64_t last_stats = vpio_host_time_now_ns();
+  while (atomic_load_explicit(&gRun, memory_order_acquire) && !stop) {
+    uint32_t bell = atomic_load_explicit(&h->bell, memory_order_acquire);
+    drain_playback(h);
+    uint32_t req = atomic_load_explicit(&h->cmd_req, memory_order_acquire);
+    if (req != atomic_load_explicit(&h->cmd_done, memory_order_relaxed)) {
+      int64_t rc = run_command(h, &stop);
+      if (stop) stop_req = req;
+      else finish_command(h, req, rc);
+    }
+    uint64_t now = vpio_host_time_now_ns();
+    if (now - last_stats >= 20000000ull) {
+      publish_stats(h);
+      last_stats = now;
+    }
+    if (getppid() != parent) break;
+    if (!stop) vpio_shm_wait(&h->bell, bell, 10);
+  }
+
+  atomic_store_explicit(&gRun, 0, memory_order_release);
+  if (pump_ok) pthread_join(pump, NULL);
+  vpio_stop_playback_thread();
+  vpio_stop_stream();
+  vpio_shutdown();
+  publish_stats(h);
+  // Reply to STOP only once the engine (and any recording) is finalized
+  if (stop) finish_command(h, stop_req, 0);
+  shm_unlink(name);
+  munmap(p, total);
+  return 0;
+}
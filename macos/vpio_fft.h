@@ -0,0 +1,110 @@
+#ifndef VPIO_FFT_H
+#define VPIO_FFT_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vpio_mix.h"
+
+// Small in-place radix-2 complex FFT on split (re[], im[]) arrays, shared by
+// the helper's DSP stages. Included into vpio_helper.c as a single TU so the
+// build stays a single clang invocation. Each stage's twiddles are stored
+// contiguously, so a stage is runs of butterflies over contiguous slices of
+// the split arrays; runs of 4 and more go through butterfly_f32 in the
+// vpio_mix kernel table (SSE2 / AVX2 / NEON), the first two stages stay
+// scalar.
+
+typedef struct {
+  int n;
+  int log2n;
+  float* tw_re;   // n-1 twiddles: the stage of half-size h at [h-1, 2h-1)
+  float* tw_im;
+  int* bitrev;    // n entries
+  const vpio_mix_kernels* mix;
+} vpio_fft;
+
+static void vpio_fft_free(vpio_fft* f) {
+  if (!f) return;
+  free(f->tw_re); free(f->tw_im); free(f->bitrev);
+  memset(f, 0, sizeof(*f));
+}
+
+// Not RT-safe (allocates). n must be a power of two >= 2. The kernels are
+// the ones the helper runs (VPIO_KERNELS names an ISA to force).
+static int vpio_fft_init(vpio_fft* f, int n) {
+  memset(f, 0, sizeof(*f));
+  if (n < 2 || (n & (n - 1))) return -1;
+  int lg = 0;
+  while ((1 << lg) < n) lg++;
+  f->n = n;
+  f->log2n = lg;
+  f->tw_re = (float*)malloc(sizeof(float) * (size_t)(n - 1));
+  f->tw_im = (float*)malloc(sizeof(float) * (size_t)(n - 1));
+  f->bitrev = (int*)malloc(sizeof(int) * (size_t)n);
+  if (!f->tw_re || !f->tw_im || !f->bitrev) { vpio_fft_free(f); return -1; }
+  for (int half = 1; half < n; half <<= 1) {
+    const int stride = n / (half * 2);
+    for (int k = 0; k < half; k++) {
+      double a = -2.0 * M_PI * (double)(k * stride) / (double)n;
+      f->tw_re[half - 1 + k] = (float)cos(a);
+      f->tw_im[half - 1 + k] = (float)sin(a);
+    }
+  }
+  f->mix = vpio_mix_select(getenv("VPIO_KERNELS"));
+  for (int i = 0; i < n; i++) {
+    int r = 0;
+    for (int b = 0; b < lg; b++) r |= ((i >> b) & 1) << (lg - 1 - b);
+    f->bitrev[i] = r;
+  }
+  return 0;
+}
+
+static void vpio_fft_core(const vpio_fft* f, float* re, float* im, float sign) {
+  const int n = f->n;
+  for (int i = 0; i < n; i++) {
+    int j = f->bitrev[i];
+    if (j > i) {
+      float tr = re[i]; re[i] = re[j]; re[j] = tr;
+      float ti = im[i]; im[i] = im[j]; im[j] = ti;
+    }
+  }
+  for (int half = 1; half < n; half <<= 1) {
+    const float* wr = f->tw_re + half - 1;
+    const float* wi = f->tw_im + half - 1;
+    for (int base = 0; base < n; base += half * 2) {
+      float* ar = re + base; float* ai = im + base;
+      if (half < 4) vpio_mix_butterfly_f32_scalar(ar, ai, ar + half, ai + half, wr, wi, (size_t)half, sign);
+      else f->mix->butterfly_f32(ar, ai, ar + half, ai + half, wr, wi, (size_t)half, sign);
+    }
+  }
+}
+
+static void vpio_fft_forward(const vpio_fft* f, float* re, float* im) {
+  vpio_fft_core(f, re, im, 1.0f);
+}
+
+// Inverse transform, scaled by 1/n
+static void vpio_fft_inverse(const vpio_fft* f, float* re, float* im) {
+  vpio_fft_core(f, re, im, -1.0f);
+  const float s = 1.0f / (float)f->n;
+  for (int i = 0; i < f->n; i++) { re[i] *= s; im[i] *= s; }
+}
+
+// Forward transform of a real signal; only bins 0..n/2 are meaningful after.
+static void vpio_fft_real_forward(const vpio_fft* f, const float* x, float* re, float* im) {
+  memcpy(re, x, sizeof(float) * (size_t)f->n);
+  memset(im, 0, sizeof(float) * (size_t)f->n);
+  vpio_fft_forward(f, re, im);
+}
+
+// Inverse of a Hermitian spectrum given as bins 0..n/2; writes n real samples.
+// re/im are scratch of length n (bins 0..n/2 are read from them).
+static void vpio_fft_real_inverse(const vpio_fft* f, float* re, float* im, float* x) {
+  const int n = f->n;
+  im[0] = 0.0f; im[n / 2] = 0.0f;
+  for (int k = 1; k < n / 2; k++) { re[n - k] = re[k]; im[n - k] = -im[k]; }
+  vpio_fft_inverse(f, re, im);
+  if (x != re) memcpy(x, re, sizeof(float) * (size_t)n);
+}
+
+#endif // VPIO_FFT_H
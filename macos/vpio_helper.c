@@ -1,108 +1,498 @@
+#if defined(__APPLE__)
 #include <AudioToolbox/AudioToolbox.h>
 #include <AudioUnit/AudioUnit.h>
 #include <CoreAudio/CoreAudioTypes.h>
 #include <CoreFoundation/CoreFoundation.h>
+#else
+// Non-Apple builds only have the file replay backend (vpio_set_replay), e.g.
+// for Linux CI; these are the few Core Audio types the callbacks use.
+#include <stdint.h>
+typedef uint32_t UInt32;
+typedef int16_t SInt16;
+typedef uint64_t UInt64;
+typedef double Float64;
+typedef int32_t OSStatus;
+typedef UInt32 AudioUnitRenderActionFlags;
+typedef void* AudioUnit;
+enum { noErr = 0 };
+enum { kAudioTimeStampSampleTimeValid = 1, kAudioTimeStampHostTimeValid = 2 };
+typedef struct {
+  Float64 mSampleTime; UInt64 mHostTime; Float64 mRateScalar; UInt64 mWordClockTime;
+  UInt32 mFlags; UInt32 mReserved;
+} AudioTimeStamp;
+typedef struct { UInt32 mNumberChannels; UInt32 mDataByteSize; void* mData; } AudioBuffer;
+typedef struct { UInt32 mNumberBuffers; AudioBuffer mBuffers[1]; } AudioBufferList;
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vpio.h"
+#include "vpio_shm.h"
+#include "vpio_aec.h"
+#include "vpio_ns.h"
+#include "vpio_agc.h"
+#include "vpio_mix.h"
+#include "vpio_ring.h"
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
 
 // Simple C helper that wraps VoiceProcessingIO (AEC) and exposes a tiny C API
 // for Python to call via ctypes without RT callbacks crossing the boundary.
 
-// Forward declarations for functions used before their definitions
-int vpio_start_stream(double sample_rate, int channels, size_t ring_capacity_bytes);
-void vpio_stop_stream(void);
-int vpio_start_playback_thread(int slice_ms, int preroll_ms);
-void vpio_stop_playback_thread(void);
+// Public prototypes live in vpio.h.
 
 static AudioUnit gAudioUnit = NULL;
 static double gSampleRate = 16000.0;
 static int gChannels = 1;
 static const int kBytesPerSample = 2; // SInt16
 
-typedef enum { MODE_IDLE = 0, MODE_RECORD = 1, MODE_PLAY = 2 } Mode;
+typedef enum { MODE_IDLE = 0, MODE_RECORD = 1 } Mode;
 static _Atomic Mode gMode = MODE_IDLE;
+// Audio callbacks in flight. The audio unit keeps running across stream
+// stop/start, so anything a callback may touch is freed or rewritten only
+// between callbacks_hold and callbacks_release: a callback counts itself in
+// before it looks at anything else and skips all work while a hold is up,
+// and callbacks_hold returns once every callback that may have missed the
+// hold has left. Control threads only; never from a callback.
+static _Atomic int gCbHold = 0;
+static _Atomic int gCbInFlight = 0;
+
+// RT: 0 means held, do nothing (and don't call callback_exit)
+static inline int callback_enter(void) {
+  atomic_fetch_add(&gCbInFlight, 1);
+  if (!atomic_load(&gCbHold)) return 1;
+  atomic_fetch_sub_explicit(&gCbInFlight, 1, memory_order_release);
+  return 0;
+}
+
+static inline void callback_exit(void) {
+  atomic_fetch_sub_explicit(&gCbInFlight, 1, memory_order_release);
+}
+
+static void callbacks_hold(void) {
+  atomic_fetch_add(&gCbHold, 1);
+  while (atomic_load(&gCbInFlight) != 0) usleep(200);
+}
+
+static void callbacks_release(void) {
+  atomic_fetch_sub_explicit(&gCbHold, 1, memory_order_release);
+}
+// Capture gate (VPIO_GATE_*), read once per input callback. Kept across
+// stream restarts so a mute outlives them.
+static _Atomic int gCapGate = VPIO_GATE_OPEN;
+static _Atomic int gCapGateEcho = 1;
 static int gTrace = 0; // enable verbose logs if VPIO_TRACE is set
+// Sample kernels (vpio_mix.h), picked from the CPU at the first vpio_init;
+// VPIO_KERNELS=scalar|sse2|avx2|neon forces one where it is available
+static const vpio_mix_kernels* gMix = &vpio_mix_scalar;
+static int gMixChosen = 0;
 
 // Capture buffer
 static unsigned char *gCapture = NULL;
 static size_t gCaptureSize = 0;
 static size_t gCaptureCap = 0;
-// Streaming capture ring
-static unsigned char *gCapRing = NULL;
-static size_t gCapCap = 0;
-static _Atomic size_t gCapW = 0; // write counter (bytes)
-static _Atomic size_t gCapR = 0; // read counter (bytes)
-
-// Playback buffer
-static unsigned char *gPlay = NULL;
-static size_t gPlayLen = 0;
-static volatile size_t gPlayOff = 0;
-// Streaming playback ring
-static unsigned char *gPlayRing = NULL;
-static size_t gPlayCap = 0;
-static _Atomic size_t gPlayW = 0;
-static _Atomic size_t gPlayR = 0;
+// Streaming capture ring. input_cb overwrites the oldest bytes without
+// waiting for anyone (vpio_ring_overwrite); the readers below keep their own
+// cursors instead of the ring's r.
+static vpio_ring gCap;
+
+// Capture readers. The writer never waits for or moves them; a reader the
+// writer lapped notices on its own and skips to the oldest intact byte.
+// Reader 0 is the default one behind vpio_read_capture / vpio_read_frame(s).
+#define CAP_READERS 8
+typedef struct {
+  _Alignas(VPIO_CACHE_LINE) _Atomic int open; // one line per reader
+  _Atomic size_t r;           // read counter (bytes)
+  int lost;                   // framed reads: flag the next frame as OVERRUN
+  size_t pending_silent;      // framed reads: DTX bytes not yet reported
+  size_t dtx_since_sent;      // framed reads: bytes since the last returned frame
+  _Atomic uint64_t overruns;  // times the writer lapped this reader
+  _Atomic uint64_t dropped;   // bytes lost to those overruns
+} CapReader;
+static CapReader gCapReaders[CAP_READERS];
+
+// Streaming playback ring. The pacer writes without dropping; a direct
+// vpio_write_playback drops the oldest (vpio_ring_overwrite). Only render_cb
+// reads it: it applies flushes and skips what a lap overwrote, counting what
+// it lost.
+static vpio_ring gPlay;
+static _Atomic uint64_t gPlayOverruns = 0;    // times render_cb found itself lapped
+static _Atomic uint64_t gPlayOverrunBytes = 0; // bytes overwritten before they were played
 static _Atomic size_t gUnderflowEvents = 0; // count render underflow events
 // Track render pull sizes to size headroom
 static _Atomic size_t gRenderLastBytes = 0;
 static _Atomic size_t gRenderMaxBytes = 0;
 
+// Extra playback streams (earcons, notifications) mixed over the main one in
+// render_cb. Slot 0 stands for the main ring above; it only has mix settings.
+// Each extra stream is an SPSC ring (one writer thread, render_cb reads) with
+// its own gain and flush. While a stream has audio queued, streams of lower
+// priority are ducked by its duck_db.
+#define PLAY_STREAMS 8
+#define MIX_CHUNK 1024
+
+// Playout clock of one stream. Positions are bytes in the stream's written
+// order, counted from the stream start (extra streams: from their open), so
+// they survive flushes. Writers advance written and place marks; render_cb
+// moves position over everything it plays or skips and credits what it
+// plays to the mark covering it. A writer may only lap a mark slot once
+// render_cb has moved past that mark.
+#define PLAYOUT_MARKS 64
+typedef struct {
+  _Atomic uint64_t seq;       // mark number + 1; 0 while it is rewritten
+  _Atomic uint64_t tag;
+  _Atomic uint64_t start;     // written position of its first byte
+  _Atomic uint64_t heard;     // bytes render_cb played from it
+} PlayoutMark;
+typedef struct {
+  _Atomic uint64_t written;   // bytes accepted by the write calls
+  _Atomic uint64_t position;  // written position of the next byte to play
+  _Atomic uint64_t marks;     // marks placed
+  _Atomic uint64_t passed;    // marks whose start render_cb has reached
+  size_t base;                // extra streams: ring position of written 0
+  PlayoutMark mark[PLAYOUT_MARKS];
+} Playout;
+
+typedef struct {
+  _Atomic int open;
+  vpio_ring q;                // allocated on first open, freed at stream stop
+  _Atomic uint64_t played;    // bytes mixed out
+  Playout po;
+  _Atomic float gain;         // linear
+  _Atomic float duck_db;      // attenuation applied to lower priorities
+  _Atomic int priority;
+  // render_cb only
+  float duck;                 // current ducking gain
+  float applied;              // gain applied at the end of the last block
+  // published by render_cb
+  _Atomic float duck_now_db;
+} PlayStream;
+static PlayStream gPlayStreams[PLAY_STREAMS];
+static int16_t gMixScratch[MIX_CHUNK];
+
+// The main stream reaches the play ring through staging or directly, and a
+// staging flush drops bytes that never get there, so play ring positions
+// map to written positions piecewise. Whoever writes the play ring (under
+// gInLock) posts a breakpoint where the written order jumps; render_cb
+// applies them as it reads past.
+#define PLAYOUT_BREAKS 64
+typedef struct { size_t pos; uint64_t w; } PlayoutBreak;
+static PlayoutBreak gPoBreak[PLAYOUT_BREAKS];
+static _Atomic uint64_t gPoBreakW = 0;  // posted
+static _Atomic uint64_t gPoBreakR = 0;  // applied by render_cb
+static _Atomic uint64_t gPoBreaksLost = 0; // posted to a full queue
+static uint64_t gPoPlayW = 0;           // under gInLock: written position at the play ring's write end
+static uint64_t gPoInR = 0;             // under gInLock: written position at staging's read end
+static size_t gPoBasePos = 0;           // render_cb: play ring position of the last breakpoint applied
+static uint64_t gPoBaseW = 0;           // ... and its written position
+
+static void playout_reset(Playout* po, uint64_t base) {
+  atomic_store_explicit(&po->written, 0, memory_order_relaxed);
+  atomic_store_explicit(&po->position, 0, memory_order_relaxed);
+  atomic_store_explicit(&po->marks, 0, memory_order_relaxed);
+  atomic_store_explicit(&po->passed, 0, memory_order_relaxed);
+  po->base = base;
+  for (int i = 0; i < PLAYOUT_MARKS; i++) atomic_store_explicit(&po->mark[i].seq, 0, memory_order_relaxed);
+}
+
+// RT: render_cb has played or skipped everything before written position w
+static void playout_advance(Playout* po, uint64_t w) {
+  uint64_t marks = atomic_load_explicit(&po->marks, memory_order_acquire);
+  uint64_t passed = atomic_load_explicit(&po->passed, memory_order_relaxed);
+  while (passed < marks &&
+         atomic_load_explicit(&po->mark[passed % PLAYOUT_MARKS].start, memory_order_relaxed) <= w)
+    passed++;
+  atomic_store_explicit(&po->passed, passed, memory_order_release);
+  atomic_store_explicit(&po->position, w, memory_order_release);
+}
+
+// RT: render_cb played written bytes [a, b)
+static void playout_played(Playout* po, uint64_t a, uint64_t b) {
+  uint64_t marks = atomic_load_explicit(&po->marks, memory_order_acquire);
+  uint64_t passed = atomic_load_explicit(&po->passed, memory_order_relaxed);
+  while (a < b) {
+    while (passed < marks &&
+           atomic_load_explicit(&po->mark[passed % PLAYOUT_MARKS].start, memory_order_relaxed) <= a)
+      passed++;
+    uint64_t end = b;
+    if (passed < marks) {
+      uint64_t next = atomic_load_explicit(&po->mark[passed % PLAYOUT_MARKS].start, memory_order_relaxed);
+      if (next < end) end = next;
+    }
+    // Bytes ahead of the first mark belong to no utterance
+    if (passed > 0)
+      atomic_fetch_add_explicit(&po->mark[(passed - 1) % PLAYOUT_MARKS].heard, end - a, memory_order_relaxed);
+    a = end;
+  }
+  atomic_store_explicit(&po->passed, passed, memory_order_release);
+}
+
+// Under gInLock: the play ring's next bytes are written from w on
+static void playout_main_break(uint64_t w) {
+  if (w == gPoPlayW) return;
+  gPoPlayW = w;
+  uint64_t k = atomic_load_explicit(&gPoBreakW, memory_order_relaxed);
+  if (k - atomic_load_explicit(&gPoBreakR, memory_order_acquire) >= PLAYOUT_BREAKS) {
+    // render_cb is not running; positions after this point come out shifted
+    atomic_fetch_add_explicit(&gPoBreaksLost, 1, memory_order_relaxed);
+    if (gTrace) fprintf(stderr, "[VPIO-PLAYOUT] breakpoint queue full\n");
+    return;
+  }
+  gPoBreak[k % PLAYOUT_BREAKS] = (PlayoutBreak){vpio_ring_wpos(&gPlay), w};
+  atomic_store_explicit(&gPoBreakW, k + 1, memory_order_release);
+}
+
+// RT: written position of play ring position pos (non-decreasing across calls)
+static uint64_t playout_main_map(size_t pos) {
+  uint64_t k = atomic_load_explicit(&gPoBreakW, memory_order_acquire);
+  uint64_t r = atomic_load_explicit(&gPoBreakR, memory_order_relaxed);
+  while (r < k && (ptrdiff_t)(pos - gPoBreak[r % PLAYOUT_BREAKS].pos) >= 0) {
+    gPoBasePos = gPoBreak[r % PLAYOUT_BREAKS].pos;
+    gPoBaseW = gPoBreak[r % PLAYOUT_BREAKS].w;
+    r++;
+  }
+  atomic_store_explicit(&gPoBreakR, r, memory_order_release);
+  return gPoBaseW + (uint64_t)(pos - gPoBasePos);
+}
+
+// RT: render_cb played main play ring bytes [p0, p1) and its read position is p1
+static void playout_main_played(size_t p0, size_t p1) {
+  Playout* po = &gPlayStreams[0].po;
+  while (p0 != p1) {
+    uint64_t w = playout_main_map(p0);
+    size_t end = p1;
+    uint64_t r = atomic_load_explicit(&gPoBreakR, memory_order_relaxed);
+    if (r < atomic_load_explicit(&gPoBreakW, memory_order_acquire)) {
+      size_t bp = gPoBreak[r % PLAYOUT_BREAKS].pos;
+      if ((ptrdiff_t)(bp - p0) > 0 && (ptrdiff_t)(bp - p1) < 0) end = bp;
+    }
+    playout_played(po, w, w + (uint64_t)(end - p0));
+    p0 = end;
+  }
+  playout_advance(po, playout_main_map(p1));
+}
+
+// Clip bank: PCM registered once and played by reference. A clip is only
+// freed once it is DYING (unregistered) and no voice holds it; the frees
+// happen on the register / unregister / stream-start paths, never in
+// render_cb. A voice is one triggered playback; its handle is
+// (generation << 4) | slot so a stale handle can't stop a later voice.
+#define CLIP_SLOTS 32
+#define CLIP_VOICES 16
+enum { CLIP_FREE = 0, CLIP_LOADING, CLIP_READY, CLIP_DYING };
+typedef struct {
+  _Atomic int state;
+  _Atomic int users;          // voices (and triggers in flight) holding it
+  int16_t* pcm;
+  size_t samples;
+} Clip;
+enum { VOICE_FREE = 0, VOICE_SETUP, VOICE_PLAYING };
+typedef struct {
+  _Atomic int state;
+  _Atomic int stop;           // fade out over the next block and end
+  _Atomic int handle;
+  _Atomic int clip;           // unregister peeks at it on any voice
+  float gain;                 // linear
+  size_t pos;                 // render_cb only: samples played
+} Voice;
+static Clip gClips[CLIP_SLOTS];
+static Voice gVoices[CLIP_VOICES];
+static _Atomic int gVoiceGen = 0;
+
+// Engine event queue: bounded MPSC, posted from any thread including the
+// audio callbacks. Each slot's seq is 2*lap while free and 2*lap+1 once
+// filled for that lap, so the zeroed array starts out empty. The notifier
+// pipe gets one byte per wakeup: posting disarms it, vpio_poll_events
+// re-arms it, so a burst costs a single write.
+#define EVENT_SLOTS 256
+typedef struct {
+  _Atomic size_t seq;
+  vpio_event ev;
+} EventSlot;
+static EventSlot gEvents[EVENT_SLOTS];
+static _Atomic size_t gEventHead = 0;   // producers claim positions here
+static size_t gEventTail = 0;           // consumer, under gEventLock
+static pthread_mutex_t gEventLock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic int gEventArmed = 1;
+static _Atomic int gEventWfd = -1;      // notifier pipe, created on first vpio_event_fd
+static int gEventRfd = -1;
+static _Atomic uint64_t gEventsDropped = 0;
+
+// Startup milestones (vpio_start_timings) as host times, 0 until reached.
+// The first_* ones are stored once by the callback thread that gets there.
+enum {
+  START_COMPONENT = 0, START_CONFIGURE, START_INITIALIZE, START_UNIT_START, START_READY,
+  START_FIRST_RENDER, START_FIRST_CAPTURE, START_FIRST_PLAYED, START_MARKS
+};
+static _Atomic uint64_t gStartT0 = 0;
+static _Atomic uint64_t gStartMarks[START_MARKS];
+// Async start worker: 0 idle, 1 running, 2 finished but not joined
+static pthread_t gStartThread;
+static _Atomic int gStartState = 0;
+static int gStartRc = 0;
+static int gStartDone = 0; // an async start has finished since the last join
+static _Thread_local int tStartWorker = 0;
+static double gStartRate = 16000.0;
+static int gStartChannels = 1;
+static size_t gStartRing = 0;
+
 // Staging ring for incoming 10ms frames; helper thread slices to ~5ms
-static unsigned char *gInRing = NULL; // staging ring for 10ms frames
-static size_t gInCap = 0;
-static _Atomic size_t gInW = 0;
-static _Atomic size_t gInR = 0;
-static pthread_mutex_t gInLock;      // protects resizing and read/write to gInRing
+static vpio_ring gIn;
+static pthread_mutex_t gInLock;      // protects resizing and read/write to gIn
 static int gInLockInit = 0;
+static size_t gInBase = 0;           // capacity at stream start; shrinking stops here
+static uint64_t gInCalmSince = 0;    // under gInLock: backlog small since (host ns)
+static uint64_t gInShrinkCheck = 0;  // pacing thread: last shrink check (host ns)
+static _Atomic int gInShrinkMs = 2000;
+// Bounded playback: writes past gPlayHigh queued bytes (staging + play ring)
+// are refused and arm gPlayBlocked; the pacer posts PLAYBACK_WRITABLE once
+// the backlog drains to gPlayLow. 0 = unbounded.
+static _Atomic size_t gPlayHigh = 0;
+static _Atomic size_t gPlayLow = 0;
+static _Atomic int gPlayBlocked = 0;
+
+// Ring budgets and memory accounting, indexed by VPIO_RING_*
+#define RING_KINDS 3
+typedef struct {
+  _Atomic size_t budget;      // 0 = none
+  _Atomic size_t committed_high;
+  _Atomic size_t level_high;
+  _Atomic uint64_t grows, shrinks, rejected;
+} RingMem;
+static RingMem gRingMem[RING_KINDS];
+
+static inline void ring_high(_Atomic size_t* hw, size_t v) {
+  size_t cur = atomic_load_explicit(hw, memory_order_relaxed);
+  while (v > cur && !atomic_compare_exchange_weak_explicit(hw, &cur, v, memory_order_relaxed,
+                                                           memory_order_relaxed)) {}
+}
+
+// Capacity for a ring sized at stream start: want rounded up to a power of
+// two, within its budget (rounded down) but never below floor (rounded up)
+static size_t ring_budgeted(int ring, size_t want, size_t floor) {
+  size_t budget = atomic_load_explicit(&gRingMem[ring].budget, memory_order_relaxed);
+  size_t cap = vpio_ring_pow2(want);
+  if (budget && cap > budget) cap = vpio_ring_pow2_floor(budget);
+  size_t min = vpio_ring_pow2(floor);
+  return cap < min ? min : cap;
+}
 
 // Playback thread control
 static pthread_t gPlayThread;
 static _Atomic int gPlayThreadRun = 0;
-static int gSliceMs = 5;        // pacing slice in ms
-static int gPrerollMs = 40;     // preroll before steady pacing
-static int gHeadroomMs = 10;    // target minimum headroom during steady state
-static int gDidPreroll = 0;
+// Set from the API thread while the pacer runs: read once per iteration
+static _Atomic int gSliceMs = 5;        // pacing slice in ms
+static _Atomic int gPrerollMs = 40;     // preroll before steady pacing
+static _Atomic int gHeadroomMs = 10;    // target minimum headroom during steady state
 // Render guard multiplier for sizing target against max observed pull
-static double gRenderGuardMult = 1.5; // tighter than previous 2.0 for lower latency
+static _Atomic double gRenderGuardMult = 1.5; // tighter than previous 2.0 for lower latency
 
 // Note: we no longer implement any burst logic or drop policy.
 
 // Ensure staging ring has at least `add` free bytes; if not, grow it.
 static int ensure_inring_space(size_t add) {
   // Lock is held by caller
-  size_t inW = atomic_load_explicit(&gInW, memory_order_acquire);
-  size_t inR = atomic_load_explicit(&gInR, memory_order_acquire);
-  size_t used = inW - inR;
-  size_t freeBytes = (gInCap > used) ? (gInCap - used) : 0;
-  if (add <= freeBytes) return 1;
-  // Grow: new capacity at least used+add, plus slack (double or +50%).
+  size_t used = vpio_ring_level(&gIn);
+  if (add <= gIn.cap - used) return 1;
+  // Grow: at least double, with room for used+add plus half again, within
+  // the budget
+  RingMem* rm = &gRingMem[VPIO_RING_STAGING];
   size_t need = used + add;
-  size_t newCap = gInCap ? (gInCap * 2) : need;
-  if (newCap < need) newCap = need;
-  if (newCap < (size_t)(need + need / 2)) newCap = need + need / 2;
-  unsigned char* p = (unsigned char*)malloc(newCap);
-  if (!p) return 0;
-  // Copy existing data in order into new buffer at offset 0
-  if (used > 0 && gInRing && gInCap) {
-    size_t ridx = inR % gInCap;
-    size_t first = gInCap - ridx; if (first > used) first = used;
-    memcpy(p, gInRing + ridx, first);
-    if (used > first) memcpy(p + first, gInRing, used - first);
-  }
-  // Swap and reset indices
-  if (gInRing) free(gInRing);
-  gInRing = p;
-  gInCap = newCap;
-  atomic_store_explicit(&gInR, 0, memory_order_release);
-  atomic_store_explicit(&gInW, used, memory_order_release);
-  if (gTrace) fprintf(stderr, "[VPIO-PLAY] inRing grown to %zu bytes (used=%zu)\n", gInCap, used);
+  size_t newCap = vpio_ring_pow2(need + need / 2);
+  if (newCap < gIn.cap * 2) newCap = gIn.cap * 2;
+  size_t budget = atomic_load_explicit(&rm->budget, memory_order_relaxed);
+  if (budget && newCap > budget) newCap = vpio_ring_pow2_floor(budget);
+  if (newCap < need || newCap <= gIn.cap) {
+    atomic_fetch_add_explicit(&rm->rejected, add, memory_order_relaxed);
+    if (gTrace) fprintf(stderr, "[VPIO-PLAY] staging budget %zu reached; refused %zu bytes\n", budget, add);
+    return 0;
+  }
+  if (vpio_ring_resize(&gIn, newCap) != 0) return 0;
+  atomic_fetch_add_explicit(&rm->grows, 1, memory_order_relaxed);
+  ring_high(&rm->committed_high, newCap);
+  gInCalmSince = 0;
+  if (gTrace) fprintf(stderr, "[VPIO-PLAY] inRing grown to %zu bytes (used=%zu)\n", gIn.cap, used);
   return 1;
 }
 
+static void event_post(uint32_t type, uint32_t id, uint64_t arg);
+
+// Bytes waiting to be played: staging backlog plus the play ring. Caller
+// holds gInLock (resizing rewrites the staging counters).
+static size_t playback_queued(void) {
+  return vpio_ring_level(&gIn) + vpio_ring_level(&gPlay);
+}
+
+// Staging backlog and capacity, consistent with each other (a resize
+// rewrites both); 0/0 before the stream starts
+static size_t staging_level(size_t* cap_out) {
+  size_t level = 0, cap = 0;
+  if (gInLockInit) {
+    pthread_mutex_lock(&gInLock);
+    level = vpio_ring_level(&gIn);
+    cap = gIn.cap;
+    pthread_mutex_unlock(&gInLock);
+  }
+  if (cap_out) *cap_out = cap;
+  return level;
+}
+
+// Pacing thread: wake a writer refused at the high watermark once the
+// backlog is down to the low one (a flush gets there at once)
+static void playback_maybe_writable(void) {
+  if (!atomic_load_explicit(&gPlayBlocked, memory_order_acquire)) return;
+  size_t high = atomic_load_explicit(&gPlayHigh, memory_order_relaxed);
+  pthread_mutex_lock(&gInLock);
+  size_t queued = playback_queued();
+  pthread_mutex_unlock(&gInLock);
+  if (high && queued > atomic_load_explicit(&gPlayLow, memory_order_relaxed)) return;
+  int expected = 1;
+  if (atomic_compare_exchange_strong(&gPlayBlocked, &expected, 0))
+    event_post(VPIO_EVENT_PLAYBACK_WRITABLE, 0, high > queued ? high - queued : 0);
+}
+
+// Pacing thread, every 100ms: once the staging backlog has stayed under a
+// quarter of the ring for gInShrinkMs, halve the ring (not below its start
+// size or twice the backlog). The writer waits on gInLock meanwhile; the
+// audio callbacks never touch this ring.
+static void staging_maybe_shrink(void) {
+  int after_ms = atomic_load_explicit(&gInShrinkMs, memory_order_relaxed);
+  uint64_t now = vpio_host_time_now_ns();
+  if (after_ms <= 0 || now - gInShrinkCheck < 100000000ull) return;
+  gInShrinkCheck = now;
+  pthread_mutex_lock(&gInLock);
+  size_t used = vpio_ring_level(&gIn);
+  if (!gIn.buf || gIn.cap <= gInBase || used > gIn.cap / 4) {
+    gInCalmSince = 0;
+    pthread_mutex_unlock(&gInLock);
+    return;
+  }
+  if (!gInCalmSince) gInCalmSince = now;
+  if (now - gInCalmSince < (uint64_t)after_ms * 1000000ull) {
+    pthread_mutex_unlock(&gInLock);
+    return;
+  }
+  size_t newCap = gIn.cap / 2;
+  if (newCap < gInBase) newCap = gInBase;
+  if (newCap < used * 2) newCap = vpio_ring_pow2(used * 2);
+  if (newCap < gIn.cap && vpio_ring_resize(&gIn, newCap) == 0) {
+    atomic_fetch_add_explicit(&gRingMem[VPIO_RING_STAGING].shrinks, 1, memory_order_relaxed);
+    if (gTrace) fprintf(stderr, "[VPIO-PLAY] inRing shrunk to %zu bytes (used=%zu)\n", gIn.cap, used);
+  }
+  gInCalmSince = now; // the next halving waits another full period
+  pthread_mutex_unlock(&gInLock);
+}
+
 static size_t bytes_per_ms(void) {
   size_t bps = (size_t)(gSampleRate * (kBytesPerSample * gChannels));
   // Divide by 1000 safely (integer math; for 16k this is exact: 32 bytes/ms)
@@ -110,40 +500,32 @@ static size_t bytes_per_ms(void) {
 }
 
 static size_t write_play_ring(const unsigned char* src, size_t len) {
-  if (!gPlayRing || gPlayCap == 0 || len == 0) return 0;
-  size_t playW = atomic_load_explicit(&gPlayW, memory_order_acquire);
-  size_t playR = atomic_load_explicit(&gPlayR, memory_order_acquire);
-  size_t freeBytes = (gPlayCap > (playW - playR)) ? (gPlayCap - (playW - playR)) : 0;
-  size_t n = (len < freeBytes) ? len : freeBytes;
-  if (n == 0) return 0;
-  size_t widx = playW % gPlayCap;
-  size_t first = gPlayCap - widx; if (first > n) first = n;
-  memcpy(gPlayRing + widx, src, first);
-  if (n > first) memcpy(gPlayRing, src + first, n - first);
-  atomic_store_explicit(&gPlayW, playW + n, memory_order_release);
+  if (!gPlay.buf || len == 0) return 0;
+  size_t n = vpio_ring_write(&gPlay, src, len);
+  if (n) ring_high(&gRingMem[VPIO_RING_PLAYBACK].level_high, vpio_ring_level(&gPlay));
   return n;
 }
 
 static size_t copy_from_staging_to_play(size_t nbytes) {
-  if (!gInRing || gInCap == 0 || nbytes == 0) return 0;
+  if (!gInLockInit || nbytes == 0) return 0;
   pthread_mutex_lock(&gInLock);
-  size_t inW = atomic_load_explicit(&gInW, memory_order_acquire);
-  size_t inR = atomic_load_explicit(&gInR, memory_order_acquire);
-  size_t avail_in = inW - inR;
-  size_t playW = atomic_load_explicit(&gPlayW, memory_order_acquire);
-  size_t playR = atomic_load_explicit(&gPlayR, memory_order_acquire);
-  size_t free_play = (gPlayCap > (playW - playR)) ? (gPlayCap - (playW - playR)) : 0;
+  if (!gIn.buf || !gPlay.buf) { pthread_mutex_unlock(&gInLock); return 0; }
+  size_t avail_in = vpio_ring_readable(&gIn, nbytes);
+  size_t free_play = vpio_ring_writable(&gPlay, nbytes);
   size_t n = nbytes;
   if (n > avail_in) n = avail_in;
   if (n > free_play) n = free_play;
   if (n == 0) { pthread_mutex_unlock(&gInLock); return 0; }
-  size_t ridx = inR % gInCap;
-  size_t first = gInCap - ridx; if (first > n) first = n;
-  size_t wrote = 0;
-  wrote += write_play_ring(gInRing + ridx, first);
-  if (n > first) wrote += write_play_ring(gInRing, n - first);
+  size_t inR = vpio_ring_rpos(&gIn);
+  size_t first;
+  const unsigned char* p = vpio_ring_span(&gIn, inR, n, &first);
+  playout_main_break(gPoInR);
+  size_t wrote = write_play_ring(p, first);
+  if (n > first) wrote += write_play_ring(gIn.buf, n - first);
+  gPoInR += wrote;
+  gPoPlayW += wrote;
   // Advance read by the amount we actually committed to play
-  atomic_store_explicit(&gInR, inR + wrote, memory_order_release);
+  vpio_ring_consume(&gIn, inR + wrote);
   pthread_mutex_unlock(&gInLock);
   return wrote;
 }
@@ -153,44 +535,47 @@ static void* playback_thread_fn(void* arg) {
   pthread_setname_np("vpio-play");
 #endif
   const size_t b_per_ms = bytes_per_ms();
-  const size_t slice_bytes = b_per_ms * (size_t)gSliceMs;
-  gDidPreroll = 0;
+  int did_preroll = 0;
   unsigned long _vpio_iter = 0; // for periodic logs
   while (atomic_load_explicit(&gPlayThreadRun, memory_order_acquire)) {
+    const int slice_ms = atomic_load_explicit(&gSliceMs, memory_order_relaxed);
+    const size_t slice_bytes = b_per_ms * (size_t)slice_ms;
+    staging_maybe_shrink();
+    playback_maybe_writable();
     // If nothing in play ring, consider this a new segment: re-preroll
-    size_t _pw = atomic_load_explicit(&gPlayW, memory_order_acquire);
-    size_t _pr = atomic_load_explicit(&gPlayR, memory_order_acquire);
-    if ((_pw - _pr) == 0) {
-      if (gDidPreroll && gTrace) fprintf(stderr, "[VPIO-PLAY] drained; re-preroll\n");
-      gDidPreroll = 0;
+    if (vpio_ring_level(&gPlay) == 0) {
+      if (did_preroll && gTrace) fprintf(stderr, "[VPIO-PLAY] drained; re-preroll\n");
+      did_preroll = 0;
     }
 
-    if (!gDidPreroll) {
-      size_t need = (size_t)gPrerollMs * b_per_ms;
-      size_t have = (atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire));
+    if (!did_preroll) {
+      const int preroll_ms = atomic_load_explicit(&gPrerollMs, memory_order_relaxed);
+      size_t need = (size_t)preroll_ms * b_per_ms;
+      size_t have = vpio_ring_level(&gPlay);
       if (have < need) {
         size_t to_pull = need - have;
         size_t got = copy_from_staging_to_play(to_pull);
         if (gTrace) {
-          size_t inLevel = (gInW - gInR);
-          size_t playLevel = (gPlayW - gPlayR);
+          size_t inLevel = staging_level(NULL);
+          size_t playLevel = vpio_ring_level(&gPlay);
           fprintf(stderr, "[VPIO-PLAY] preroll need=%zu wrote=%zu in=%zu play=%zu\n", to_pull, got, inLevel, playLevel);
         }
         if (got == 0) {
           // Wait for more input
-          usleep((useconds_t)(gSliceMs * 1000));
+          usleep((useconds_t)(slice_ms * 1000));
         }
         continue; // loop until preroll satisfied
       }
-      gDidPreroll = 1;
-      if (gTrace) fprintf(stderr, "[VPIO-PLAY] preroll satisfied at %d ms\n", gPrerollMs);
+      did_preroll = 1;
+      if (gTrace) fprintf(stderr, "[VPIO-PLAY] preroll satisfied at %d ms\n", preroll_ms);
       continue;
     }
 
     // Maintain continuous headroom; top up to a target level
-    size_t level = (atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire));
-    size_t head_bytes = (size_t)gHeadroomMs * b_per_ms;
-    size_t render_guard = (size_t)((double)gRenderMaxBytes * gRenderGuardMult); // cushion for occasional larger pulls
+    size_t level = vpio_ring_level(&gPlay);
+    size_t head_bytes = (size_t)atomic_load_explicit(&gHeadroomMs, memory_order_relaxed) * b_per_ms;
+    size_t render_guard = (size_t)((double)atomic_load_explicit(&gRenderMaxBytes, memory_order_relaxed) *
+                                   atomic_load_explicit(&gRenderGuardMult, memory_order_relaxed)); // cushion for occasional larger pulls
     size_t target = head_bytes;
     if (render_guard > target) target = render_guard;
     // keep at least one extra slice beyond the target
@@ -199,13 +584,13 @@ static void* playback_thread_fn(void* arg) {
       size_t need = desired - level;
       size_t got = copy_from_staging_to_play(need);
       if (gTrace) {
-        size_t inLevel = (atomic_load_explicit(&gInW, memory_order_acquire) - atomic_load_explicit(&gInR, memory_order_acquire));
-        size_t playLevel = (atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire));
+        size_t inLevel = staging_level(NULL);
+        size_t playLevel = vpio_ring_level(&gPlay);
         fprintf(stderr, "[VPIO-PLAY] topup need=%zu wrote=%zu in=%zu play=%zu\n", need, got, inLevel, playLevel);
       }
       if (got == 0) {
         // No input yet; small wait
-        usleep((useconds_t)(gSliceMs * 1000));
+        usleep((useconds_t)(slice_ms * 1000));
       }
     }
 
@@ -213,25 +598,901 @@ static void* playback_thread_fn(void* arg) {
     size_t _w = copy_from_staging_to_play(slice_bytes);
     if (gTrace) {
       _vpio_iter++;
-      unsigned long period = (unsigned long)(200 / (gSliceMs > 0 ? gSliceMs : 5));
+      unsigned long period = (unsigned long)(200 / (slice_ms > 0 ? slice_ms : 5));
       if (period == 0) period = 40;
       if ((_vpio_iter % period) == 0) {
-        size_t inLevel = (atomic_load_explicit(&gInW, memory_order_acquire) - atomic_load_explicit(&gInR, memory_order_acquire));
-        size_t _wcur = atomic_load_explicit(&gPlayW, memory_order_acquire);
-        size_t _rcur = atomic_load_explicit(&gPlayR, memory_order_acquire);
-        size_t playLevel = (_wcur - _rcur);
-        size_t freePlay = (gPlayCap > playLevel) ? (gPlayCap - playLevel) : 0;
+        size_t inLevel = staging_level(NULL);
+        size_t playLevel = vpio_ring_level(&gPlay);
+        size_t freePlay = (gPlay.cap > playLevel) ? (gPlay.cap - playLevel) : 0;
         size_t rlast = atomic_load_explicit(&gRenderLastBytes, memory_order_acquire);
         size_t rmax = atomic_load_explicit(&gRenderMaxBytes, memory_order_acquire);
         fprintf(stderr, "[VPIO-PLAY] steady wrote=%zu in=%zu play=%zu free=%zu rlast=%zu rmax=%zu\n", _w, inLevel, playLevel, freePlay, rlast, rmax);
       }
     }
     // Normal pace sleep
-    usleep((useconds_t)(gSliceMs * 1000));
+    usleep((useconds_t)(slice_ms * 1000));
+  }
+  return NULL;
+}
+
+// DSP stages that own heap state (AEC, NS, AGC) are built off the RT thread
+// and handed over through a StageSlot: the setter publishes into `pending`,
+// the callback running the stage adopts it on its next call and hands the
+// previous one back through `retired` for the next setter (or stream stop)
+// to free.
+typedef struct {
+  _Atomic(void*) pending;
+  _Atomic(void*) retired;
+  void* active;             // owned by input_cb
+  void (*destroy)(void*);
+} StageSlot;
+
+static void stage_slot_publish(StageSlot* slot, void* st) {
+  slot->destroy(atomic_exchange_explicit(&slot->retired, NULL, memory_order_acq_rel));
+  slot->destroy(atomic_exchange_explicit(&slot->pending, st, memory_order_acq_rel));
+}
+
+// RT
+static void* stage_slot_acquire(StageSlot* slot) {
+  void* fresh = atomic_exchange_explicit(&slot->pending, NULL, memory_order_acq_rel);
+  if (fresh) {
+    if (slot->active) atomic_store_explicit(&slot->retired, slot->active, memory_order_release);
+    slot->active = fresh;
+  }
+  return slot->active;
+}
+
+// Only under callbacks_hold (stream stop, shutdown)
+static void stage_slot_clear(StageSlot* slot) {
+  slot->destroy(atomic_exchange_explicit(&slot->pending, NULL, memory_order_acq_rel));
+  slot->destroy(atomic_exchange_explicit(&slot->retired, NULL, memory_order_acq_rel));
+  slot->destroy(slot->active);
+  slot->active = NULL;
+}
+
+// Fixed-latency block adapter for capture stages: push at most one block's
+// worth of samples, process when the block is complete, then pop as many
+// samples as were pushed. Output runs exactly one block behind the input.
+typedef struct {
+  size_t block;
+  float* in;         // block: samples awaiting a full block
+  size_t fill;
+  float* out;        // 2*block ring of processed samples
+  size_t out_r, out_w;
+} BlockFifo;
+
+static int block_fifo_init(BlockFifo* f, size_t block) {
+  f->block = block;
+  f->fill = 0;
+  f->in = (float*)calloc(block, sizeof(float));
+  f->out = (float*)calloc(block * 2, sizeof(float));
+  f->out_r = 0;
+  f->out_w = block; // one block of zeros primes the output
+  return (f->in && f->out) ? 0 : -1;
+}
+
+static void block_fifo_free(BlockFifo* f) {
+  free(f->in); free(f->out);
+  f->in = f->out = NULL;
+}
+
+static void block_fifo_push(BlockFifo* f, const SInt16* s, size_t c) {
+  gMix->s16_to_f32(f->in + f->fill, s, c);
+  f->fill += c;
+}
+
+// Queue one processed block (normally f->in, processed in place)
+static void block_fifo_emit(BlockFifo* f, const float* y) {
+  size_t cap = f->block * 2;
+  for (size_t k = 0; k < f->block; k++) f->out[(f->out_w + k) % cap] = y[k];
+  f->out_w += f->block;
+  f->fill = 0;
+}
+
+static void block_fifo_pop(BlockFifo* f, SInt16* s, size_t c) {
+  size_t cap = f->block * 2;
+  for (size_t k = 0; k < c; ) {
+    size_t idx = (f->out_r + k) % cap;
+    size_t m = (c - k < cap - idx) ? c - k : cap - idx;
+    gMix->f32_to_s16(s + k, f->out + idx, m);
+    k += m;
+  }
+  f->out_r += c;
+}
+
+// Power-of-two processing block of ~8ms for the FFT-based stages
+static size_t dsp_block_size(void) {
+  size_t block = 16;
+  while ((double)block < gSampleRate / 125.0) block <<= 1;
+  return block;
+}
+
+// Echo reference: render_cb appends what it actually played to gRef while a
+// consumer (software AEC, delay estimator) is enabled; input_cb pulls the
+// reference samples lined up with each capture callback.
+static vpio_ring gRef;                    // reference ring (int16 samples), stream lifetime
+#define REF_CHUNK 1024
+static float gRefChunk[REF_CHUNK];        // input_cb scratch
+
+// Optional software echo canceller (vpio_aec.h). Filters the capture before
+// the VAD gate and the capture ring see it. Adds one AEC block (~8ms) of capture
+// latency while enabled.
+#define AEC_MAX_DELAY_MS 500
+typedef struct {
+  vpio_aec* aec;
+  BlockFifo fifo;    // near end
+  float* far;        // block: reference samples matching fifo.in
+  float* dline;      // bulk delay line on the reference
+  size_t dcap, dpos;
+} AecRuntime;
+static void aec_runtime_free(void* p);
+static _Atomic int gAecEnabled = 0;
+static _Atomic int gAecAutoDelay = 0;           // follow the delay estimator
+static _Atomic size_t gAecDelaySamples = 0;     // bulk delay on the reference
+static StageSlot gAecSlot = { NULL, NULL, NULL, aec_runtime_free };
+static _Atomic size_t gAecBlocks = 0;
+static _Atomic int gAecErleCdb = 0;             // ERLE in 0.01 dB
+
+// Render/capture delay estimator: binary-spectrum correlator. Every ~8ms block
+// of reference and capture is reduced to a 32-bit word (band energy above its
+// running mean), and the Hamming distance between the capture word and each
+// delayed reference word is smoothed per lag; the lag with the lowest distance
+// is the echo delay. Cheap enough to run continuously in input_cb.
+#define DE_MAX_FFT 1024
+#define DE_LAGS 128
+#define DE_BANDS 32
+static _Atomic int gDelayEnabled = 0;
+static _Atomic int gDelayResetReq = 0;
+static _Atomic int gDelayMaxLags = DE_LAGS;
+static vpio_fft gDeFft;                         // 2*block, set up at stream start
+static size_t gDeBlock = 0;
+static size_t gDeBandLo[DE_BANDS + 1];          // band edges in bins
+static float gDeWin[DE_MAX_FFT];
+static float gDeFarBuf[DE_MAX_FFT], gDeNearBuf[DE_MAX_FFT]; // previous + current block
+static size_t gDeFill = 0;
+static float gDeRe[DE_MAX_FFT], gDeIm[DE_MAX_FFT];
+static float gDeFarMean[DE_BANDS], gDeNearMean[DE_BANDS];
+static uint32_t gDeFarHist[DE_LAGS];            // newest at gDeHead
+static size_t gDeHead = 0, gDeHistFill = 0;
+static float gDeFarEnergy[DE_LAGS];
+static float gDeCost[DE_LAGS];                  // smoothed bit errors per lag
+static size_t gDeUpdates = 0;
+static _Atomic int gDelayEstSamples = -1;       // -1 = no estimate yet
+static _Atomic int gDelayConfPermille = 0;
+static _Atomic size_t gDelayBlocks = 0;
+
+static void delay_est_setup(void) {
+  size_t block = dsp_block_size();
+  while (block * 2 > DE_MAX_FFT) block >>= 1;
+  vpio_fft_free(&gDeFft);
+  if (vpio_fft_init(&gDeFft, (int)(block * 2)) != 0) { gDeBlock = 0; return; }
+  gDeBlock = block;
+  size_t n = block * 2;
+  for (size_t i = 0; i < n; i++) gDeWin[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)n));
+  // 32 bands linearly spaced over ~250..3750 Hz, where speech and echo energy sit
+  double hz_per_bin = gSampleRate / (double)n;
+  size_t lo = (size_t)(250.0 / hz_per_bin);
+  double top = gSampleRate / 2.0 < 3750.0 ? gSampleRate / 2.0 : 3750.0;
+  size_t hi = (size_t)(top / hz_per_bin);
+  if (hi < lo + DE_BANDS) hi = lo + DE_BANDS;
+  if (hi > n / 2) hi = n / 2;
+  for (int b = 0; b <= DE_BANDS; b++) gDeBandLo[b] = lo + (hi - lo) * (size_t)b / DE_BANDS;
+}
+
+// Band energies of the windowed 2-block buffer -> bit per band above the mean
+static uint32_t delay_est_binarize(const float* buf, float* mean, float* energy_out) {
+  size_t n = gDeBlock * 2;
+  float e = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    gDeRe[i] = buf[i] * gDeWin[i];
+    gDeIm[i] = 0.0f;
+    e += buf[i] * buf[i];
+  }
+  *energy_out = e / (float)n;
+  vpio_fft_forward(&gDeFft, gDeRe, gDeIm);
+  uint32_t bits = 0;
+  for (int b = 0; b < DE_BANDS; b++) {
+    float be = 0.0f;
+    for (size_t k = gDeBandLo[b]; k < gDeBandLo[b + 1]; k++) be += gDeRe[k] * gDeRe[k] + gDeIm[k] * gDeIm[k];
+    if (be > mean[b]) bits |= 1u << b;
+    mean[b] += (be - mean[b]) * (1.0f / 64.0f);
+  }
+  return bits;
+}
+
+static void delay_est_block(void) {
+  const float floor = 1e-7f; // ~-70 dBFS mean power
+  float far_e = 0.0f, near_e = 0.0f;
+  uint32_t fw = delay_est_binarize(gDeFarBuf, gDeFarMean, &far_e);
+  uint32_t nw = delay_est_binarize(gDeNearBuf, gDeNearMean, &near_e);
+  gDeHead = (gDeHead + 1) % DE_LAGS;
+  gDeFarHist[gDeHead] = fw;
+  gDeFarEnergy[gDeHead] = far_e;
+  if (gDeHistFill < DE_LAGS) gDeHistFill++;
+  atomic_fetch_add_explicit(&gDelayBlocks, 1, memory_order_relaxed);
+  if (near_e < floor) return;
+
+  size_t lags = (size_t)atomic_load_explicit(&gDelayMaxLags, memory_order_relaxed);
+  if (lags > gDeHistFill) lags = gDeHistFill;
+  // Only learn from blocks where the reference carried signal at that lag
+  for (size_t l = 0; l < lags; l++) {
+    size_t idx = (gDeHead + DE_LAGS - l) % DE_LAGS;
+    if (gDeFarEnergy[idx] < floor) continue;
+    float cost = (float)__builtin_popcount(nw ^ gDeFarHist[idx]);
+    gDeCost[l] += (cost - gDeCost[l]) * (1.0f / 32.0f);
+  }
+  gDeUpdates++;
+  if (gDeUpdates < 32 || lags == 0) return;
+  size_t best = 0;
+  float sum = 0.0f;
+  for (size_t l = 0; l < lags; l++) {
+    sum += gDeCost[l];
+    if (gDeCost[l] < gDeCost[best]) best = l;
+  }
+  float mean = sum / (float)lags;
+  float conf = (mean > 0.0f) ? (mean - gDeCost[best]) / mean : 0.0f;
+  if (conf < 0.0f) conf = 0.0f;
+  if (conf > 1.0f) conf = 1.0f;
+  atomic_store_explicit(&gDelayEstSamples, (int)(best * gDeBlock), memory_order_relaxed);
+  atomic_store_explicit(&gDelayConfPermille, (int)(conf * 1000.0f), memory_order_release);
+}
+
+// RT: feed reference and raw capture (before any AEC) to the estimator
+static void delay_est_process(const float* ref, const SInt16* s, size_t n) {
+  if (!atomic_load_explicit(&gDelayEnabled, memory_order_acquire) || gDeBlock == 0) return;
+  const size_t B = gDeBlock;
+  if (atomic_exchange_explicit(&gDelayResetReq, 0, memory_order_acq_rel)) {
+    memset(gDeFarBuf, 0, sizeof(gDeFarBuf));
+    memset(gDeNearBuf, 0, sizeof(gDeNearBuf));
+    memset(gDeFarMean, 0, sizeof(gDeFarMean));
+    memset(gDeNearMean, 0, sizeof(gDeNearMean));
+    memset(gDeFarHist, 0, sizeof(gDeFarHist));
+    memset(gDeFarEnergy, 0, sizeof(gDeFarEnergy));
+    for (int l = 0; l < DE_LAGS; l++) gDeCost[l] = DE_BANDS / 2.0f;
+    gDeFill = 0; gDeHead = 0; gDeHistFill = 0; gDeUpdates = 0;
+    atomic_store_explicit(&gDelayEstSamples, -1, memory_order_relaxed);
+    atomic_store_explicit(&gDelayConfPermille, 0, memory_order_relaxed);
+  }
+  size_t i = 0;
+  while (i < n) {
+    size_t take = B - gDeFill;
+    if (take > n - i) take = n - i;
+    memcpy(gDeFarBuf + B + gDeFill, ref + i, sizeof(float) * take);
+    gMix->s16_to_f32(gDeNearBuf + B + gDeFill, s + i, take);
+    gDeFill += take;
+    i += take;
+    if (gDeFill == B) {
+      delay_est_block();
+      memmove(gDeFarBuf, gDeFarBuf + B, sizeof(float) * B);
+      memmove(gDeNearBuf, gDeNearBuf + B, sizeof(float) * B);
+      gDeFill = 0;
+    }
+  }
+}
+
+static void aec_runtime_free(void* p) {
+  AecRuntime* rt = (AecRuntime*)p;
+  if (!rt) return;
+  vpio_aec_destroy(rt->aec);
+  block_fifo_free(&rt->fifo);
+  free(rt->far); free(rt->dline);
+  free(rt);
+}
+
+static AecRuntime* aec_runtime_create(size_t block, int parts) {
+  AecRuntime* rt = (AecRuntime*)calloc(1, sizeof(*rt));
+  if (!rt) return NULL;
+  rt->aec = vpio_aec_create((int)block, parts, 0.5f);
+  rt->far = (float*)calloc(block, sizeof(float));
+  rt->dcap = (size_t)(gSampleRate * AEC_MAX_DELAY_MS / 1000.0) + 1;
+  rt->dline = (float*)calloc(rt->dcap, sizeof(float));
+  if (block_fifo_init(&rt->fifo, block) != 0 || !rt->aec || !rt->far || !rt->dline) {
+    aec_runtime_free(rt);
+    return NULL;
+  }
+  return rt;
+}
+
+static int ref_consumers(void) {
+  return atomic_load_explicit(&gAecEnabled, memory_order_acquire) ||
+         atomic_load_explicit(&gDelayEnabled, memory_order_acquire);
+}
+
+// RT: render side of the reference ring; drops on overflow (reader resyncs)
+static void ref_write(const SInt16* s, size_t n) {
+  if (!gRef.buf || !n || !ref_consumers()) return;
+  size_t bytes = n * sizeof(SInt16);
+  if (vpio_ring_writable(&gRef, bytes) < bytes) return;
+  vpio_ring_write(&gRef, s, bytes);
+}
+
+// RT: reference samples lined up with the next n captured samples. Keeps the
+// ring level at n (render and capture run off the same clock); short reads
+// are front-padded with silence.
+static void ref_read(float* dst, size_t n) {
+  size_t tol = (size_t)(gSampleRate / 100.0); // 10ms of render/capture jitter
+  size_t level = vpio_ring_readable(&gRef, (n + tol + 1) * sizeof(SInt16)) / sizeof(SInt16);
+  size_t r = vpio_ring_rpos(&gRef);
+  if (level > n + tol) {
+    r += (level - n) * sizeof(SInt16);
+    level = n;
+  }
+  size_t pad = (level < n) ? n - level : 0;
+  for (size_t i = 0; i < pad; i++) dst[i] = 0.0f;
+  for (size_t i = pad; i < n; ) {
+    size_t len;
+    const SInt16* p = (const SInt16*)vpio_ring_span(&gRef, r, (n - i) * sizeof(SInt16), &len);
+    gMix->s16_to_f32(dst + i, p, len / sizeof(SInt16));
+    i += len / sizeof(SInt16);
+    r += len;
+  }
+  vpio_ring_consume(&gRef, r);
+}
+
+// RT: run the canceller over captured samples in place
+static void aec_process_capture(SInt16* s, const float* ref, size_t n) {
+  if (!atomic_load_explicit(&gAecEnabled, memory_order_acquire)) return;
+  AecRuntime* rt = (AecRuntime*)stage_slot_acquire(&gAecSlot);
+  if (!rt) return;
+  const size_t B = rt->fifo.block;
+  if (atomic_load_explicit(&gAecAutoDelay, memory_order_relaxed) &&
+      atomic_load_explicit(&gDelayConfPermille, memory_order_acquire) >= 300) {
+    // Keep one block of the estimate inside the filter so it stays causal
+    int est = atomic_load_explicit(&gDelayEstSamples, memory_order_relaxed);
+    size_t want = (est > (int)B) ? (size_t)est - B : 0;
+    size_t cur = atomic_load_explicit(&gAecDelaySamples, memory_order_relaxed);
+    if (want + B < cur || cur + B < want) atomic_store_explicit(&gAecDelaySamples, want, memory_order_relaxed);
+  }
+  size_t delay = atomic_load_explicit(&gAecDelaySamples, memory_order_relaxed);
+  if (delay >= rt->dcap) delay = rt->dcap - 1;
+  size_t i = 0;
+  while (i < n) {
+    size_t c = B - rt->fifo.fill;
+    if (c > n - i) c = n - i;
+    for (size_t k = 0; k < c; k++) {
+      rt->dline[rt->dpos % rt->dcap] = ref[i + k];
+      rt->far[rt->fifo.fill + k] = rt->dline[(rt->dpos + rt->dcap - delay) % rt->dcap];
+      rt->dpos++;
+    }
+    block_fifo_push(&rt->fifo, s + i, c);
+    if (rt->fifo.fill == B) {
+      vpio_aec_process(rt->aec, rt->far, rt->fifo.in, rt->fifo.in);
+      block_fifo_emit(&rt->fifo, rt->fifo.in);
+      atomic_store_explicit(&gAecBlocks, (size_t)rt->aec->blocks, memory_order_relaxed);
+      atomic_store_explicit(&gAecErleCdb, (int)(rt->aec->erle_db * 100.0f), memory_order_relaxed);
+    }
+    block_fifo_pop(&rt->fifo, s + i, c);
+    i += c;
+  }
+}
+
+// RT: echo-path stages on captured samples, in place
+static void echo_process_capture(SInt16* s, size_t n) {
+  if (!gRef.buf || !ref_consumers()) return;
+  for (size_t i = 0; i < n; ) {
+    size_t c = (n - i < REF_CHUNK) ? n - i : REF_CHUNK;
+    ref_read(gRefChunk, c);
+    delay_est_process(gRefChunk, s + i, c);
+    aec_process_capture(s + i, gRefChunk, c);
+    i += c;
   }
+}
+
+// Optional capture noise suppressor (vpio_ns.h), after the echo stages and
+// before the VAD gate; adds one block (~8ms) of latency while enabled. Each
+// block is timed against a CPU budget; a block over budget puts the stage in
+// hold (previous gains, no noise tracking) for NS_HOLD_BLOCKS blocks.
+#define NS_HOLD_BLOCKS 16
+typedef struct {
+  vpio_ns* ns;
+  BlockFifo fifo;
+  int hold_left;
+} NsRuntime;
+static void ns_runtime_free(void* p);
+static _Atomic int gNsEnabled = 0;
+static _Atomic uint64_t gNsBudgetNs = 0;      // 0 = unbounded
+static StageSlot gNsSlot = { NULL, NULL, NULL, ns_runtime_free };
+static _Atomic size_t gNsBlocks = 0;
+static _Atomic size_t gNsOverBudget = 0;
+static _Atomic uint64_t gNsMaxBlockNs = 0;
+static _Atomic int gNsNoiseCdb = -10000;      // noise floor, 0.01 dBFS
+
+static void ns_runtime_free(void* p) {
+  NsRuntime* rt = (NsRuntime*)p;
+  if (!rt) return;
+  vpio_ns_destroy(rt->ns);
+  block_fifo_free(&rt->fifo);
+  free(rt);
+}
+
+// RT: suppress noise in captured samples, in place
+static void ns_process_capture(SInt16* s, size_t n) {
+  if (!atomic_load_explicit(&gNsEnabled, memory_order_acquire)) return;
+  NsRuntime* rt = (NsRuntime*)stage_slot_acquire(&gNsSlot);
+  if (!rt) return;
+  const size_t B = rt->fifo.block;
+  uint64_t budget = atomic_load_explicit(&gNsBudgetNs, memory_order_relaxed);
+  size_t i = 0;
+  while (i < n) {
+    size_t c = B - rt->fifo.fill;
+    if (c > n - i) c = n - i;
+    block_fifo_push(&rt->fifo, s + i, c);
+    if (rt->fifo.fill == B) {
+      int hold = rt->hold_left > 0;
+      uint64_t t0 = vpio_host_time_now_ns();
+      vpio_ns_process(rt->ns, rt->fifo.in, rt->fifo.in, hold);
+      uint64_t dt = vpio_host_time_now_ns() - t0;
+      if (hold) {
+        rt->hold_left--;
+      } else if (budget && dt > budget) {
+        rt->hold_left = NS_HOLD_BLOCKS;
+        atomic_fetch_add_explicit(&gNsOverBudget, 1, memory_order_relaxed);
+      }
+      if (dt > atomic_load_explicit(&gNsMaxBlockNs, memory_order_relaxed))
+        atomic_store_explicit(&gNsMaxBlockNs, dt, memory_order_relaxed);
+      block_fifo_emit(&rt->fifo, rt->fifo.in);
+      size_t blocks = atomic_fetch_add_explicit(&gNsBlocks, 1, memory_order_relaxed) + 1;
+      if ((blocks % 16) == 0) {
+        // sqrt-Hann analysis: white noise of power p shows up as p * nfft/2 per bin
+        double acc = 0.0;
+        for (int k = 0; k < rt->ns->nbins; k++) acc += rt->ns->noise[k];
+        double p = acc / (double)rt->ns->nbins / ((double)rt->ns->nfft / 2.0);
+        atomic_store_explicit(&gNsNoiseCdb, (int)(1000.0 * log10(p + 1e-12)), memory_order_relaxed);
+      }
+    }
+    block_fifo_pop(&rt->fifo, s + i, c);
+    i += c;
+  }
+}
+
+// Automatic gain control + lookahead limiter (vpio_agc.h) per direction
+// (VPIO_DIR_*): capture after the NS and before the VAD gate, playback in
+// render_cb before the echo reference is taken so the AEC sees what was
+// really played. Adds ~2ms of latency in each enabled direction.
+// Each vpio_set_agc publishes a freshly configured state through the
+// direction's StageSlot; its callback (input_cb or render_cb) adopts it.
+static StageSlot gAgcSlot[2] = { { NULL, NULL, NULL, free }, { NULL, NULL, NULL, free } };
+static _Atomic int gAgcEnabled[2];
+static _Atomic int gAgcGainCdb[2];       // current AGC gain, 0.01 dB
+static _Atomic int gAgcLimitCdb[2];      // current limiter reduction, 0.01 dB
+static float gAgcScratch[2][REF_CHUNK];
+
+// RT: gain stage for one direction, in place
+static void agc_process(int dir, SInt16* s, size_t n) {
+  if (!atomic_load_explicit(&gAgcEnabled[dir], memory_order_acquire)) return;
+  vpio_agc* a = (vpio_agc*)stage_slot_acquire(&gAgcSlot[dir]);
+  if (!a) return;
+  float* f = gAgcScratch[dir];
+  for (size_t i = 0; i < n; ) {
+    size_t c = (n - i < REF_CHUNK) ? n - i : REF_CHUNK;
+    gMix->s16_to_f32(f, s + i, c);
+    vpio_agc_process(a, f, c);
+    gMix->f32_to_s16(s + i, f, c);
+    i += c;
+  }
+  atomic_store_explicit(&gAgcGainCdb[dir], (int)(a->gain_db * 100.0f), memory_order_relaxed);
+  atomic_store_explicit(&gAgcLimitCdb[dir], (int)(vpio_agc_limit_db(a) * 100.0f), memory_order_relaxed);
+}
+
+// Level meters: RMS, peak and clip count per 10ms block for each direction
+// (VPIO_DIR_*), taken on the capture samples as delivered (end of input_cb)
+// and on what render_cb hands to the device. Blocks land in a short history
+// ring per direction that vpio_get_levels copies out, so a UI can poll at
+// 30Hz without touching audio data. Slots are seqlocked: a reader that races
+// the writer on a slot drops that entry instead of returning a torn one.
+#define LEVEL_HIST 128           // ~1.3s of 10ms blocks
+typedef struct {
+  _Atomic uint64_t seq;          // block number + 1; 0 while being rewritten
+  _Atomic float rms, peak;
+  _Atomic uint32_t clipped, samples;
+} LevelSlot;
+typedef struct { int64_t sumsq; int32_t peak; uint32_t clipped; size_t n, block; } LevelAcc;
+static LevelSlot gLevelHist[2][LEVEL_HIST];
+static _Atomic uint64_t gLevelBlocks[2]; // published blocks, monotonic across streams
+static _Atomic int gLevelResetReq[2];
+static LevelAcc gLevelAcc[2];            // owned by the RT callback of each direction
+
+static void level_publish(int dir, LevelAcc* a) {
+  uint64_t b = atomic_load_explicit(&gLevelBlocks[dir], memory_order_relaxed);
+  LevelSlot* slot = &gLevelHist[dir][b % LEVEL_HIST];
+  atomic_store_explicit(&slot->seq, 0, VPIO_SEQ_ORDER(memory_order_relaxed));
+  VPIO_SEQ_FENCE(memory_order_release);
+  atomic_store_explicit(&slot->rms, (float)(sqrt((double)a->sumsq / (double)a->n) / 32768.0), memory_order_relaxed);
+  atomic_store_explicit(&slot->peak, (float)a->peak / 32768.0f, memory_order_relaxed);
+  atomic_store_explicit(&slot->clipped, a->clipped, memory_order_relaxed);
+  atomic_store_explicit(&slot->samples, (uint32_t)a->n, memory_order_relaxed);
+  atomic_store_explicit(&slot->seq, b + 1, memory_order_release);
+  atomic_store_explicit(&gLevelBlocks[dir], b + 1, memory_order_release);
+  a->sumsq = 0; a->peak = 0; a->clipped = 0; a->n = 0;
+}
+
+// RT: meter n samples of one direction
+static void level_process(int dir, const SInt16* s, size_t n) {
+  LevelAcc* a = &gLevelAcc[dir];
+  if (atomic_exchange_explicit(&gLevelResetReq[dir], 0, memory_order_acq_rel)) {
+    memset(a, 0, sizeof(*a));
+    a->block = (size_t)(gSampleRate / 100.0);
+  }
+  if (!a->block) return;
+  for (size_t i = 0; i < n; ) {
+    size_t take = a->block - a->n;
+    if (take > n - i) take = n - i;
+    vpio_mix_level lv;
+    gMix->level_s16(s + i, take, &lv);
+    a->sumsq += lv.sumsq;
+    if (lv.peak > a->peak) a->peak = lv.peak;
+    a->clipped += lv.clipped;
+    a->n += take;
+    i += take;
+    if (a->n == a->block) level_publish(dir, a);
+  }
+}
+
+// Echo canceller, noise suppressor and delay estimator state; under
+// callbacks_hold
+static void echo_release_all(void) {
+  atomic_store_explicit(&gAecEnabled, 0, memory_order_release);
+  atomic_store_explicit(&gDelayEnabled, 0, memory_order_release);
+  stage_slot_clear(&gAecSlot);
+  atomic_store_explicit(&gNsEnabled, 0, memory_order_release);
+  stage_slot_clear(&gNsSlot);
+  vpio_fft_free(&gDeFft);
+  gDeBlock = 0;
+  vpio_ring_free(&gRef);
+}
+
+// Session recorder. input_cb and render_cb copy each callback's samples into
+// a per-tap SPSC ring (VPIO_REC_TAP_*) and move on; a low-priority writer
+// thread drains the rings every 20ms into large buffered sequential writes.
+// A tap whose ring is full drops the block and counts it; WAV output fills
+// the gap with silence so positions stay true, framed output carries the
+// sample index and host time of every block.
+#define REC_TAPS 3             // tap k records VPIO_REC_TAP_* bit (1 << k)
+enum { REC_MIC_RAW = 0, REC_CAPTURE = 1, REC_PLAYBACK = 2 };
+#define REC_RING_SECS 2
+#define REC_IO_BUF (256 * 1024)
+typedef struct { uint64_t index; uint64_t host_ticks; uint32_t frames; uint32_t pad; } RecBlock;
+typedef struct {
+  vpio_ring q;                   // allocated by the first recording of a stream
+  _Atomic int on;
+  uint64_t index;                // RT: frames seen while on
+  // writer side
+  FILE* f;                       // WAV file (framed output shares gRecFile)
+  uint64_t next_index;           // UINT64_MAX until the first block
+  uint64_t frames_written;
+} RecTap;
+static RecTap gRecTaps[REC_TAPS];
+static FILE* gRecFile = NULL;    // framed output
+static int gRecFormat = VPIO_REC_WAV;
+static pthread_t gRecThread;
+static _Atomic int gRecRun = 0;
+static _Atomic uint64_t gRecBytes = 0;
+static _Atomic uint64_t gRecDropped = 0;
+static SInt16 gRecZeros[1024];
+static uint64_t host_ticks_to_ns(uint64_t t);
+
+// RT: queue one callback's worth of samples for the writer
+static void rec_tap(int tap, const SInt16* s, size_t frames, const AudioTimeStamp* ts) {
+  RecTap* t = &gRecTaps[tap];
+  if (!atomic_load_explicit(&t->on, memory_order_acquire) || !frames) return;
+  RecBlock b = { t->index, (ts && (ts->mFlags & kAudioTimeStampHostTimeValid)) ? ts->mHostTime : 0,
+                 (uint32_t)frames, 0 };
+  t->index += frames;
+  size_t bytes = frames * (size_t)kBytesPerSample * (size_t)gChannels;
+  if (vpio_ring_writable(&t->q, sizeof(b) + bytes) < sizeof(b) + bytes) {
+    atomic_fetch_add_explicit(&gRecDropped, 1, memory_order_relaxed);
+    return;
+  }
+  size_t w = vpio_ring_wpos(&t->q);
+  vpio_ring_put(&t->q, w, &b, sizeof(b));
+  vpio_ring_put(&t->q, w + sizeof(b), s, bytes);
+  vpio_ring_commit(&t->q, w + sizeof(b) + bytes);
+}
+
+static void rec_write(FILE* f, const void* p, size_t n) {
+  if (n && fwrite(p, 1, n, f) == n) atomic_fetch_add_explicit(&gRecBytes, n, memory_order_relaxed);
+}
+
+static void rec_ring_write(RecTap* t, FILE* f, size_t pos, size_t n) {
+  size_t first;
+  const unsigned char* p = vpio_ring_span(&t->q, pos, n, &first);
+  rec_write(f, p, first);
+  if (n > first) rec_write(f, t->q.buf, n - first);
+}
+
+// Writer: move everything queued on one tap into its file
+static void rec_drain_tap(int tap) {
+  RecTap* t = &gRecTaps[tap];
+  if (!t->q.buf) return;
+  const size_t frame_bytes = (size_t)kBytesPerSample * (size_t)gChannels;
+  size_t r = vpio_ring_rpos(&t->q);
+  size_t w = r + vpio_ring_readable(&t->q, SIZE_MAX);
+  while (w - r >= sizeof(RecBlock)) {
+    RecBlock b;
+    vpio_ring_get(&t->q, r, &b, sizeof(b));
+    size_t bytes = (size_t)b.frames * frame_bytes;
+    if (gRecFormat == VPIO_REC_FRAMED) {
+      vpio_rec_chunk c = { 1u << tap, b.frames, b.index, b.host_ticks ? host_ticks_to_ns(b.host_ticks) : 0 };
+      rec_write(gRecFile, &c, sizeof(c));
+      rec_ring_write(t, gRecFile, r + sizeof(b), bytes);
+    } else {
+      if (t->next_index == UINT64_MAX) t->next_index = b.index;
+      // Dropped blocks become silence so the file keeps its timeline
+      size_t gap = (b.index > t->next_index) ? (size_t)((b.index - t->next_index) * frame_bytes) : 0;
+      t->frames_written += gap / frame_bytes;
+      while (gap) {
+        size_t c = (gap < sizeof(gRecZeros)) ? gap : sizeof(gRecZeros);
+        rec_write(t->f, gRecZeros, c);
+        gap -= c;
+      }
+      rec_ring_write(t, t->f, r + sizeof(b), bytes);
+      t->frames_written += b.frames;
+      t->next_index = b.index + b.frames;
+    }
+    r += sizeof(b) + bytes;
+    vpio_ring_consume(&t->q, r);
+  }
+}
+
+static void* rec_thread_fn(void* arg) {
+#if defined(__APPLE__)
+  pthread_setname_np("vpio-rec");
+  pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+  while (atomic_load_explicit(&gRecRun, memory_order_acquire)) {
+    for (int k = 0; k < REC_TAPS; k++) rec_drain_tap(k);
+    usleep(20000);
+  }
+  for (int k = 0; k < REC_TAPS; k++) rec_drain_tap(k);
   return NULL;
 }
 
+static void rec_wav_header(FILE* f, uint64_t frames) {
+  uint32_t data = (uint32_t)(frames * (uint64_t)kBytesPerSample * (uint64_t)gChannels);
+  uint32_t riff = 36 + data, fmt_len = 16, rate = (uint32_t)gSampleRate;
+  uint16_t pcm = 1, ch = (uint16_t)gChannels, bits = 16, align = (uint16_t)(kBytesPerSample * gChannels);
+  uint32_t byte_rate = rate * align;
+  fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+  fwrite(&fmt_len, 4, 1, f); fwrite(&pcm, 2, 1, f); fwrite(&ch, 2, 1, f);
+  fwrite(&rate, 4, 1, f); fwrite(&byte_rate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+  fwrite("data", 1, 4, f); fwrite(&data, 4, 1, f);
+}
+
+static FILE* rec_open(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (f) setvbuf(f, NULL, _IOFBF, REC_IO_BUF);
+  return f;
+}
+
+static void rec_close_files(void) {
+  for (int k = 0; k < REC_TAPS; k++) {
+    RecTap* t = &gRecTaps[k];
+    if (!t->f) continue;
+    // WAV sizes are only known now
+    if (fseek(t->f, 0, SEEK_SET) == 0) rec_wav_header(t->f, t->frames_written);
+    fclose(t->f);
+    t->f = NULL;
+  }
+  if (gRecFile) { fclose(gRecFile); gRecFile = NULL; }
+}
+
+// Under callbacks_hold: the taps write into these rings
+static void rec_release(void) {
+  vpio_stop_recording();
+  for (int k = 0; k < REC_TAPS; k++) {
+    RecTap* t = &gRecTaps[k];
+    vpio_ring_free(&t->q);
+  }
+}
+
+// Defaults for every slot; extra streams start closed. Under callbacks_hold:
+// render keeps per-stream gain and duck state.
+static void play_streams_reset(void) {
+  for (int i = 0; i < PLAY_STREAMS; i++) {
+    PlayStream* ps = &gPlayStreams[i];
+    atomic_store_explicit(&ps->open, i == 0, memory_order_release);
+    vpio_ring_reset(&ps->q, 0);
+    atomic_store_explicit(&ps->played, 0, memory_order_relaxed);
+    playout_reset(&ps->po, 0);
+    atomic_store_explicit(&ps->gain, 1.0f, memory_order_relaxed);
+    atomic_store_explicit(&ps->duck_db, 0.0f, memory_order_relaxed);
+    atomic_store_explicit(&ps->priority, 0, memory_order_relaxed);
+    atomic_store_explicit(&ps->duck_now_db, 0.0f, memory_order_relaxed);
+    ps->duck = 1.0f;
+    ps->applied = 1.0f;
+  }
+  atomic_store_explicit(&gPoBreakW, 0, memory_order_relaxed);
+  atomic_store_explicit(&gPoBreakR, 0, memory_order_relaxed);
+  atomic_store_explicit(&gPoBreaksLost, 0, memory_order_relaxed);
+  gPoPlayW = gPoInR = 0;
+  gPoBasePos = 0;
+  gPoBaseW = 0;
+}
+
+// Under callbacks_hold (stream stop, shutdown): render mixes from these rings
+static void play_streams_release(void) {
+  for (int i = 1; i < PLAY_STREAMS; i++) {
+    PlayStream* ps = &gPlayStreams[i];
+    atomic_store_explicit(&ps->open, 0, memory_order_release);
+    vpio_ring_free(&ps->q);
+  }
+}
+
+static void event_ring(void) {
+  int fd = atomic_load_explicit(&gEventWfd, memory_order_acquire);
+  if (fd < 0) return;
+  char b = 1;
+  ssize_t rc = write(fd, &b, 1); // non-blocking; a full pipe is already readable
+  (void)rc;
+}
+
+// RT-safe apart from the one pipe write per wakeup. Drops the event and
+// counts it if the queue is full.
+static void event_post(uint32_t type, uint32_t id, uint64_t arg) {
+  size_t pos = atomic_load_explicit(&gEventHead, memory_order_relaxed);
+  for (;;) {
+    EventSlot* sl = &gEvents[pos % EVENT_SLOTS];
+    size_t lap = pos / EVENT_SLOTS * 2;
+    size_t seq = atomic_load_explicit(&sl->seq, memory_order_acquire);
+    if (seq == lap) {
+      if (atomic_compare_exchange_weak_explicit(&gEventHead, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        sl->ev.type = type;
+        sl->ev.id = id;
+        sl->ev.arg = arg;
+        sl->ev.host_time_ns = vpio_host_time_now_ns();
+        // seq_cst with the armed flag below: either the consumer sees this
+        // slot after re-arming, or this post sees it armed and rings
+        atomic_store(&sl->seq, lap + 1);
+        break;
+      }
+    } else if ((ptrdiff_t)(seq - lap) < 0) {
+      atomic_fetch_add_explicit(&gEventsDropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&gEventHead, memory_order_relaxed);
+    }
+  }
+  if (atomic_exchange(&gEventArmed, 0)) event_ring();
+}
+
+static inline void start_mark(int m) {
+  if (!atomic_load_explicit(&gStartMarks[m], memory_order_relaxed))
+    atomic_store_explicit(&gStartMarks[m], vpio_host_time_now_ns(), memory_order_relaxed);
+}
+
+// End a voice: notify, release its clip, free the slot
+static void voice_end(Voice* v, int stopped) {
+  int clip = atomic_load_explicit(&v->clip, memory_order_relaxed);
+  event_post(stopped ? VPIO_EVENT_CLIP_STOPPED : VPIO_EVENT_CLIP_DONE, (uint32_t)clip,
+             (uint64_t)atomic_load_explicit(&v->handle, memory_order_relaxed));
+  atomic_fetch_sub_explicit(&gClips[clip].users, 1, memory_order_release);
+  atomic_store_explicit(&v->state, VOICE_FREE, memory_order_release);
+}
+
+// Only under callbacks_hold (stream stop, shutdown)
+static void clip_voices_reset(void) {
+  for (int i = 0; i < CLIP_VOICES; i++)
+    if (atomic_load_explicit(&gVoices[i].state, memory_order_acquire) == VOICE_PLAYING)
+      voice_end(&gVoices[i], 1);
+}
+
+// Free unregistered clips no voice holds any more
+static void clips_reap(void) {
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    Clip* c = &gClips[i];
+    // seq_cst against vpio_clip_trigger's users bump and state check: either
+    // it sees DYING and backs out, or this sees its count and keeps the PCM
+    if (atomic_load(&c->users) != 0) continue;
+    int expected = CLIP_DYING;
+    if (!atomic_compare_exchange_strong(&c->state, &expected, CLIP_LOADING)) continue;
+    free(c->pcm);
+    c->pcm = NULL;
+    c->samples = 0;
+    atomic_store_explicit(&c->state, CLIP_FREE, memory_order_release);
+  }
+}
+
+// RT: mix the playing clip voices over out. Unity gain adds straight from
+// the clip's PCM; other gains and stop fades go through the scratch buffer.
+static void mix_clips(SInt16* out, size_t n) {
+  for (int i = 0; i < CLIP_VOICES; i++) {
+    Voice* v = &gVoices[i];
+    if (atomic_load_explicit(&v->state, memory_order_acquire) != VOICE_PLAYING) continue;
+    const Clip* c = &gClips[atomic_load_explicit(&v->clip, memory_order_relaxed)];
+    int stop = atomic_load_explicit(&v->stop, memory_order_relaxed);
+    size_t m = c->samples - v->pos < n ? c->samples - v->pos : n;
+    const int16_t* src = c->pcm + v->pos;
+    if (!stop && v->gain == 1.0f) {
+      gMix->adds_s16((int16_t*)out, src, m);
+    } else {
+      float g1 = stop ? 0.0f : v->gain;
+      for (size_t k = 0; k < m; k += MIX_CHUNK) {
+        size_t mm = m - k < MIX_CHUNK ? m - k : MIX_CHUNK;
+        memcpy(gMixScratch, src + k, mm * sizeof(int16_t));
+        float ga = v->gain + (g1 - v->gain) * (float)k / (float)m;
+        float gb = v->gain + (g1 - v->gain) * (float)(k + mm) / (float)m;
+        gMix->scale_s16(gMixScratch, mm, ga, gb);
+        gMix->adds_s16((int16_t*)out + k, gMixScratch, mm);
+      }
+    }
+    v->pos += m;
+    if (stop || v->pos >= c->samples) voice_end(v, stop);
+  }
+}
+
+// RT: scale the main stream already in out and mix the extra streams over
+// it. main_bytes is how much the main ring delivered this callback.
+static void mix_streams(SInt16* out, size_t n, size_t main_bytes) {
+  int open[PLAY_STREAMS], prio[PLAY_STREAMS] = {0};
+  size_t avail[PLAY_STREAMS];
+  float duck_db[PLAY_STREAMS] = {0};
+  int any = 0;
+  for (int i = 0; i < PLAY_STREAMS; i++) {
+    PlayStream* ps = &gPlayStreams[i];
+    // -1 while vpio_play_stream_open is still setting the slot up
+    open[i] = atomic_load_explicit(&ps->open, memory_order_acquire) == 1;
+    avail[i] = 0;
+    if (!open[i]) continue;
+    prio[i] = atomic_load_explicit(&ps->priority, memory_order_relaxed);
+    duck_db[i] = atomic_load_explicit(&ps->duck_db, memory_order_relaxed);
+    if (i == 0) {
+      avail[0] = main_bytes;
+      continue;
+    }
+    any = 1;
+    avail[i] = vpio_ring_readable(&ps->q, n * kBytesPerSample);
+  }
+  PlayStream* main = &gPlayStreams[0];
+  if (main_bytes) atomic_fetch_add_explicit(&main->played, main_bytes, memory_order_relaxed);
+  if (!any && main->applied == 1.0f && main->duck == 1.0f &&
+      atomic_load_explicit(&main->gain, memory_order_relaxed) == 1.0f)
+    return;
+  float block_s = (float)n / (float)gChannels / (float)gSampleRate;
+  for (int i = 0; i < PLAY_STREAMS; i++) {
+    if (!open[i]) continue;
+    PlayStream* ps = &gPlayStreams[i];
+    // Deepest duck requested by an audible stream of higher priority
+    float d = 0.0f;
+    for (int j = 0; j < PLAY_STREAMS; j++)
+      if (j != i && open[j] && avail[j] && prio[j] > prio[i] && duck_db[j] > d) d = duck_db[j];
+    float target = powf(10.0f, -d / 20.0f);
+    float tau = (target < ps->duck) ? 0.01f : 0.25f; // 10ms attack, 250ms release
+    ps->duck = target + (ps->duck - target) * expf(-block_s / tau);
+    atomic_store_explicit(&ps->duck_now_db, 20.0f * log10f(ps->duck > 1e-5f ? ps->duck : 1e-5f),
+                          memory_order_relaxed);
+    float g0 = ps->applied;
+    float g1 = atomic_load_explicit(&ps->gain, memory_order_relaxed) * ps->duck;
+    ps->applied = g1;
+    if (i == 0) {
+      if (g0 != 1.0f || g1 != 1.0f) gMix->scale_s16(out, n, g0, g1);
+      continue;
+    }
+    size_t bytes = avail[i] < n * kBytesPerSample ? avail[i] : n * kBytesPerSample;
+    bytes -= bytes % kBytesPerSample;
+    size_t r = vpio_ring_rpos(&ps->q);
+    if (!bytes) {
+      if (open[i] == 1) playout_advance(&ps->po, r - ps->po.base);
+      continue;
+    }
+    size_t samples = bytes / kBytesPerSample;
+    for (size_t k = 0; k < samples; k += MIX_CHUNK) {
+      size_t m = samples - k < MIX_CHUNK ? samples - k : MIX_CHUNK;
+      vpio_ring_get(&ps->q, r + k * kBytesPerSample, gMixScratch, m * kBytesPerSample);
+      float ga = g0 + (g1 - g0) * (float)k / (float)n;
+      float gb = g0 + (g1 - g0) * (float)(k + m) / (float)n;
+      if (ga != 1.0f || gb != 1.0f) gMix->scale_s16(gMixScratch, m, ga, gb);
+      gMix->adds_s16((int16_t*)out + k, gMixScratch, m);
+    }
+    vpio_ring_consume(&ps->q, r + bytes);
+    atomic_fetch_add_explicit(&ps->played, bytes, memory_order_relaxed);
+    if (open[i] == 1) {
+      playout_played(&ps->po, r - ps->po.base, r + bytes - ps->po.base);
+      playout_advance(&ps->po, r + bytes - ps->po.base);
+    }
+  }
+}
+
 static OSStatus render_cb(void *inRefCon,
                           AudioUnitRenderActionFlags *ioActionFlags,
                           const AudioTimeStamp *inTimeStamp,
@@ -242,6 +1503,13 @@ static OSStatus render_cb(void *inRefCon,
   AudioBuffer *buf = &ioData->mBuffers[0];
   UInt32 bytesNeeded = inNumberFrames * (UInt32)(kBytesPerSample * gChannels);
   if (!buf->mData) return noErr;
+  if (!callback_enter()) {
+    memset(buf->mData, 0, bytesNeeded);
+    buf->mDataByteSize = bytesNeeded;
+    return noErr;
+  }
+  // Stream state (rings, mixer, echo reference, recorder) only while streaming
+  int live = atomic_load_explicit(&gMode, memory_order_acquire) == MODE_RECORD;
   atomic_store_explicit(&gRenderLastBytes, bytesNeeded, memory_order_release);
   size_t _rmax = atomic_load_explicit(&gRenderMaxBytes, memory_order_acquire);
   if (bytesNeeded > _rmax) atomic_store_explicit(&gRenderMaxBytes, bytesNeeded, memory_order_release);
@@ -258,34 +1526,40 @@ static OSStatus render_cb(void *inRefCon,
     }
   }
 
-  if (atomic_load_explicit(&gMode, memory_order_acquire) == MODE_PLAY && gPlay && gPlayOff < gPlayLen) {
-    size_t remaining = gPlayLen - gPlayOff;
-    size_t toCopy = bytesNeeded < remaining ? bytesNeeded : remaining;
-    memcpy(buf->mData, gPlay + gPlayOff, toCopy);
-    gPlayOff += toCopy;
-    if (toCopy < bytesNeeded) {
-      memset((unsigned char *)buf->mData + toCopy, 0, bytesNeeded - toCopy);
-    }
-    buf->mDataByteSize = bytesNeeded;
-  } else {
-    // Streaming playback ring
-    size_t avail = atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire);
-    size_t toCopy = (avail < bytesNeeded) ? avail : bytesNeeded;
-    if (toCopy > 0 && gPlayRing && gPlayCap) {
-      size_t playR = atomic_load_explicit(&gPlayR, memory_order_acquire);
-      size_t ridx = playR % gPlayCap;
-      size_t first = gPlayCap - ridx;
-      if (first > toCopy) first = toCopy;
-      memcpy(buf->mData, gPlayRing + ridx, first);
-      if (toCopy > first) memcpy((unsigned char*)buf->mData + first, gPlayRing, toCopy - first);
-      atomic_store_explicit(&gPlayR, playR + toCopy, memory_order_release);
+  {
+    // Streaming playback ring. Only this callback reads it: it applies
+    // flushes, skips what a drop-oldest write overwrote, and re-copies if
+    // the writer lapped it mid-copy
+    size_t toCopy = 0, playEnd = 0;
+    if (live && gPlay.buf) {
+      uint64_t laps = 0, lost = 0;
+      toCopy = vpio_ring_read_lapped(&gPlay, buf->mData, bytesNeeded, &laps, &lost);
+      playEnd = atomic_load_explicit(&gPlay.r, memory_order_relaxed);
+      if (laps) {
+        atomic_fetch_add_explicit(&gPlayOverruns, laps, memory_order_relaxed);
+        atomic_fetch_add_explicit(&gPlayOverrunBytes, lost, memory_order_relaxed);
+      }
     }
     if (toCopy < bytesNeeded) memset((unsigned char*)buf->mData + toCopy, 0, bytesNeeded - toCopy);
     buf->mDataByteSize = bytesNeeded;
     if (toCopy < bytesNeeded) {
       atomic_fetch_add_explicit(&gUnderflowEvents, 1, memory_order_relaxed);
     }
+    start_mark(START_FIRST_RENDER);
+    if (toCopy) start_mark(START_FIRST_PLAYED);
+    if (live) {
+      mix_streams((SInt16*)buf->mData, bytesNeeded / kBytesPerSample, toCopy);
+      if (gPlay.buf) playout_main_played(playEnd - toCopy, playEnd);
+    }
+    mix_clips((SInt16*)buf->mData, bytesNeeded / kBytesPerSample);
   }
+  agc_process(VPIO_DIR_PLAYBACK, (SInt16*)buf->mData, bytesNeeded / kBytesPerSample);
+  level_process(VPIO_DIR_PLAYBACK, (const SInt16*)buf->mData, bytesNeeded / kBytesPerSample);
+  if (live) {
+    rec_tap(REC_PLAYBACK, (const SInt16*)buf->mData, inNumberFrames, inTimeStamp);
+    ref_write((const SInt16*)buf->mData, bytesNeeded / kBytesPerSample);
+  }
+  callback_exit();
   return noErr;
 }
 
@@ -308,59 +1582,479 @@ static int append_capture(const void *src, size_t len) {
 static unsigned char* gInputScratch = NULL;
 static size_t gInputScratchCap = 0;
 
-static OSStatus input_cb(void *inRefCon,
-                         AudioUnitRenderActionFlags *ioActionFlags,
-                         const AudioTimeStamp *inTimeStamp,
-                         UInt32 inBusNumber,
-                         UInt32 inNumberFrames,
-                         AudioBufferList *ioData) {
-  if (atomic_load_explicit(&gMode, memory_order_acquire) != MODE_RECORD) return noErr;
+// Capture VAD pre-gate: cheap energy / zero-crossing / spectral-flatness
+// classifier run on 10ms blocks inside input_cb. It only marks blocks; Python
+// queries the marks by capture byte position and skips the neural VAD on
+// blocks that are clearly silence.
+#define VAD_HIST_BLOCKS 1024   // ~10s of 10ms block flags
+#define VAD_MAX_BLOCK 480      // 10ms at 48k
+#define VAD_LPC_ORDER 8
+enum { VAD_FLAG_OPEN = 1 };
+static _Atomic int gVadEnabled = 0;
+static _Atomic int gVadResetReq = 0;
+static double gVadMarginDb = 9.0;   // required rise above the noise floor
+static int gVadHangoverMs = 1000;   // keep gate open after last speech-like block
+static int gVadOnsetBlocks = 1;     // consecutive speech-like blocks to open
+static const double kVadAbsFloorDb = -60.0; // never open below this level (dBFS)
+static float gVadBlock[VAD_MAX_BLOCK];
+static SInt16 gVadBlockS16[VAD_MAX_BLOCK];
+static size_t gVadBlockLen = 160;   // samples per block (set from sample rate)
+static size_t gVadFill = 0;
+static size_t gVadSkip = 0;         // samples to skip to reach the block grid
+static size_t gVadOrigin = 0;       // capture byte offset of block 0 (grid aligned)
+static double gVadNoiseDb = 0.0;
+static int gVadNoiseInit = 0;
+static int gVadHangLeft = 0;
+static int gVadOnsetRun = 0;
+static _Atomic unsigned char gVadFlags[VAD_HIST_BLOCKS];
+static _Atomic size_t gVadBlocks = 0;     // analyzed blocks (published)
+static _Atomic size_t gVadOpenBlocks = 0; // blocks marked open
+static _Atomic size_t gVadOrigin_pub = 0; // gVadOrigin as seen by readers
 
-  UInt32 byteCount = inNumberFrames * (UInt32)(kBytesPerSample * gChannels);
-  AudioBuffer buffer;
-  buffer.mNumberChannels = (UInt32)gChannels;
-  buffer.mDataByteSize = byteCount;
-  if (gInputScratchCap < byteCount) {
-    unsigned char* p = (unsigned char*)realloc(gInputScratch, byteCount);
-    if (!p) return noErr; // drop frame on allocation failure
-    gInputScratch = p;
-    gInputScratchCap = byteCount;
+// Spectral flatness estimate from the LPC prediction gain: the ratio of the
+// order-P forward prediction error to the signal power converges to the
+// geometric/arithmetic mean ratio of the spectrum (~1 for noise, << 1 for
+// voiced speech) without needing an FFT.
+static double vad_lpc_flatness(const float* x, size_t n) {
+  double r[VAD_LPC_ORDER + 1];
+  for (int k = 0; k <= VAD_LPC_ORDER; k++) {
+    float acc = 0.0f;
+    for (size_t i = (size_t)k; i < n; i++) acc += x[i] * x[i - (size_t)k];
+    r[k] = acc;
   }
-  buffer.mData = gInputScratch;
-  AudioBufferList bl;
-  bl.mNumberBuffers = 1;
-  bl.mBuffers[0] = buffer;
-
-  OSStatus st = AudioUnitRender(gAudioUnit, ioActionFlags, inTimeStamp, 1,
-                                inNumberFrames, &bl);
-  if (st == noErr) {
-    // Append to streaming capture ring
-    if (gCapRing && gCapCap) {
-      size_t capW = atomic_load_explicit(&gCapW, memory_order_acquire);
-      size_t capR = atomic_load_explicit(&gCapR, memory_order_acquire);
-      size_t freeBytes = (gCapCap > (capW - capR)) ? (gCapCap - (capW - capR)) : 0;
-      if (byteCount > freeBytes) {
-        size_t need = byteCount - freeBytes;
-        atomic_store_explicit(&gCapR, capR + need, memory_order_release); // drop oldest
-        capR += need;
-      }
-      size_t widx = capW % gCapCap;
-      size_t first = gCapCap - widx;
-      if (first > byteCount) first = byteCount;
-      memcpy(gCapRing + widx, buffer.mData, first);
-      if (byteCount > first) memcpy(gCapRing, (unsigned char*)buffer.mData + first, byteCount - first);
-      atomic_store_explicit(&gCapW, capW + byteCount, memory_order_release);
-    }
-    // Also keep simple capture for legacy API
-    append_capture(buffer.mData, byteCount);
+  if (r[0] <= 1e-9) return 1.0;
+  double a[VAD_LPC_ORDER + 1] = {1.0};
+  double err = r[0];
+  for (int i = 1; i <= VAD_LPC_ORDER; i++) {
+    double acc = r[i];
+    for (int j = 1; j < i; j++) acc += a[j] * r[i - j];
+    double k = -acc / err;
+    double tmp[VAD_LPC_ORDER + 1];
+    for (int j = 1; j < i; j++) tmp[j] = a[j] + k * a[i - j];
+    for (int j = 1; j < i; j++) a[j] = tmp[j];
+    a[i] = k;
+    err *= (1.0 - k * k);
+    if (err <= 0.0) return 0.0;
   }
-  return st;
+  return err / r[0];
 }
 
-static UInt32 fourcc(const char s[4]) {
+// Energy and zero crossings come from the int16 block through the sample
+// kernel table; the LPC part works on the float copy.
+static void vad_classify_block(const SInt16* s, const float* x, size_t n) {
+  vpio_mix_level lv;
+  gMix->level_s16(s, n, &lv);
+  double energy = (double)lv.sumsq / (32768.0 * 32768.0);
+  uint32_t zc = gMix->crossings_s16(s, n);
+  double e_db = 10.0 * log10(energy / (double)n + 1e-10);
+  double zcr = (double)zc / (double)n;
+  double flat = vad_lpc_flatness(x, n);
+  if (!gVadNoiseInit) { gVadNoiseDb = e_db; gVadNoiseInit = 1; }
+
+  int loud = (e_db > gVadNoiseDb + gVadMarginDb) && (e_db > kVadAbsFloorDb);
+  // Loud but noise-like (flat spectrum, high ZCR) only counts when well clear of the floor
+  int speechish = loud && ((flat < 0.35 && zcr < 0.45) || e_db > gVadNoiseDb + 2.0 * gVadMarginDb);
+
+  // Asymmetric noise floor tracker: fast fall, slow rise; creeps up under speech
+  if (!speechish) {
+    double a = (e_db < gVadNoiseDb) ? 0.2 : 0.02;
+    gVadNoiseDb += (e_db - gVadNoiseDb) * a;
+  } else {
+    gVadNoiseDb += 0.001 * (e_db - gVadNoiseDb);
+  }
+
+  gVadOnsetRun = speechish ? gVadOnsetRun + 1 : 0;
+  int block_ms = (int)((double)n * 1000.0 / gSampleRate);
+  if (gVadOnsetRun >= gVadOnsetBlocks) {
+    gVadHangLeft = gVadHangoverMs;
+  } else if (gVadHangLeft > 0) {
+    gVadHangLeft -= block_ms;
+  }
+  int open = (gVadOnsetRun >= gVadOnsetBlocks) || gVadHangLeft > 0;
+  size_t b = atomic_load_explicit(&gVadBlocks, memory_order_relaxed);
+  atomic_store_explicit(&gVadFlags[b % VAD_HIST_BLOCKS], (unsigned char)(open ? VAD_FLAG_OPEN : 0), memory_order_relaxed);
+  if (open) atomic_fetch_add_explicit(&gVadOpenBlocks, 1, memory_order_relaxed);
+  atomic_store_explicit(&gVadBlocks, b + 1, memory_order_release);
+}
+
+// RT: feed captured samples (starting at capture byte offset `pos`) to the gate
+static void vad_gate_process(const SInt16* s, size_t nsamples, size_t pos) {
+  if (!atomic_load_explicit(&gVadEnabled, memory_order_acquire)) return;
+  if (atomic_exchange_explicit(&gVadResetReq, 0, memory_order_acq_rel)) {
+    gVadBlockLen = (size_t)(gSampleRate / 100.0);
+    if (gVadBlockLen > VAD_MAX_BLOCK) gVadBlockLen = VAD_MAX_BLOCK;
+    gVadFill = 0;
+    // Blocks sit on an absolute grid of capture offsets so capture frames that
+    // are a multiple of 10ms always cover whole blocks.
+    size_t block_bytes = gVadBlockLen * (size_t)kBytesPerSample * (size_t)gChannels;
+    gVadOrigin = (pos + block_bytes - 1) / block_bytes * block_bytes;
+    gVadSkip = (gVadOrigin - pos) / ((size_t)kBytesPerSample * (size_t)gChannels);
+    gVadNoiseInit = 0;
+    gVadHangLeft = 0;
+    gVadOnsetRun = 0;
+    atomic_store_explicit(&gVadBlocks, 0, memory_order_relaxed);
+    atomic_store_explicit(&gVadOpenBlocks, 0, memory_order_relaxed);
+    atomic_store_explicit(&gVadOrigin_pub, gVadOrigin, memory_order_release);
+  }
+  size_t i = 0;
+  if (gVadSkip) {
+    i = (gVadSkip < nsamples) ? gVadSkip : nsamples;
+    gVadSkip -= i;
+  }
+  while (i < nsamples) {
+    size_t take = gVadBlockLen - gVadFill;
+    if (take > nsamples - i) take = nsamples - i;
+    float* dst = gVadBlock + gVadFill;
+    const SInt16* src = s + i;
+    gMix->s16_to_f32(dst, src, take);
+    memcpy(gVadBlockS16 + gVadFill, src, take * sizeof(SInt16));
+    gVadFill += take;
+    i += take;
+    if (gVadFill == gVadBlockLen) {
+      vad_classify_block(gVadBlockS16, gVadBlock, gVadBlockLen);
+      gVadFill = 0;
+    }
+  }
+}
+
+// Engine-side capture framing. Frames of gCapFrameBytes sit on an absolute
+// grid of capture byte offsets (frame k starts at k * frame_bytes); input_cb
+// stamps each frame's first sample with the device host time so readers get
+// whole frames with exact positions instead of re-chunking a byte stream
+// (vpio_frame_info in vpio.h).
+#define CAP_META_SLOTS 1024
+// Slots are reused every CAP_META_SLOTS frames while a slow reader may still
+// be looking at one, so both fields are atomic and a stamp only counts when
+// seq reads as the frame's number before and after host_time_ns
+// (cap_frame_host_time).
+typedef struct { _Atomic uint64_t seq; _Atomic uint64_t host_time_ns; } CapFrameStamp;
+static CapFrameStamp gCapStamps[CAP_META_SLOTS]; // written by input_cb before the capture ring publishes them
+static _Atomic size_t gCapFrameBytes = 0;        // 0 = framing not configured
+#if defined(__APPLE__)
+static mach_timebase_info_data_t gTimebase;
+#endif
+
+static uint64_t host_ticks_to_ns(uint64_t t) {
+#if defined(__APPLE__)
+  if (gTimebase.denom == 0) return 0;
+  return t * gTimebase.numer / gTimebase.denom;
+#else
+  return t;
+#endif
+}
+
+// RT: record host times for frames starting within [pos, pos+len)
+static void cap_stamp_frames(size_t pos, size_t len, const AudioTimeStamp* ts) {
+  size_t fb = atomic_load_explicit(&gCapFrameBytes, memory_order_acquire);
+  if (!fb || !len) return;
+  uint64_t host0 = (ts && (ts->mFlags & kAudioTimeStampHostTimeValid)) ? host_ticks_to_ns(ts->mHostTime) : 0;
+  size_t bytes_per_frame_sample = (size_t)kBytesPerSample * (size_t)gChannels;
+  size_t k = (pos + fb - 1) / fb;
+  for (size_t start = k * fb; start < pos + len; start += fb, k++) {
+    CapFrameStamp* slot = &gCapStamps[k % CAP_META_SLOTS];
+    uint64_t t = host0 ? host0 + (uint64_t)((double)((start - pos) / bytes_per_frame_sample) * 1e9 / gSampleRate) : 0;
+    // Invalidate, then time, then number: a reader that sees the new time
+    // also sees seq moved off the old frame's number
+    atomic_store_explicit(&slot->seq, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&slot->host_time_ns, t, memory_order_release);
+    atomic_store_explicit(&slot->seq, (uint64_t)k, memory_order_release);
+  }
+}
+
+// Host time of capture frame k, or 0 when its slot was unset or has been
+// reused for a later frame
+static uint64_t cap_frame_host_time(size_t k) {
+  const CapFrameStamp* slot = &gCapStamps[k % CAP_META_SLOTS];
+  if (atomic_load_explicit(&slot->seq, memory_order_acquire) != (uint64_t)k) return 0;
+  uint64_t t = atomic_load_explicit(&slot->host_time_ns, memory_order_acquire);
+  return atomic_load_explicit(&slot->seq, memory_order_relaxed) == (uint64_t)k ? t : 0;
+}
+
+// Rewind every reader to a fresh ring; open extra readers stay open
+static void cap_readers_reset(void) {
+  for (int i = 0; i < CAP_READERS; i++) {
+    CapReader* rd = &gCapReaders[i];
+    atomic_store_explicit(&rd->r, 0, memory_order_release);
+    rd->lost = 0;
+    rd->pending_silent = 0;
+    rd->dtx_since_sent = 0;
+  }
+  atomic_store_explicit(&gCapReaders[0].open, 1, memory_order_release);
+}
+
+static CapReader* cap_reader(int reader) {
+  if (reader < 0 || reader >= CAP_READERS) return NULL;
+  CapReader* rd = &gCapReaders[reader];
+  return atomic_load_explicit(&rd->open, memory_order_acquire) == 1 ? rd : NULL;
+}
+
+// Bytes waiting for a reader, capped at what the ring still holds
+static size_t cap_backlog(int reader) {
+  size_t n = vpio_ring_published(&gCap) - atomic_load_explicit(&gCapReaders[reader].r, memory_order_acquire);
+  return n < gCap.cap ? n : gCap.cap;
+}
+
+// Reader side: move a reader the writer lapped up to the oldest intact byte
+static size_t cap_catch_up(CapReader* rd, size_t r) {
+  size_t oldest = vpio_ring_oldest(&gCap, r);
+  if (oldest == r) return r;
+  atomic_fetch_add_explicit(&rd->overruns, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&rd->dropped, (uint64_t)(oldest - r), memory_order_relaxed);
+  rd->lost = 1;
+  return oldest;
+}
+
+// File replay backend (vpio_set_replay): stands in for the VoiceProcessingIO
+// unit so the whole engine runs without an audio device, e.g. deterministic
+// regression runs in Linux CI. A thread drives input_cb and render_cb with
+// callback sizes cycled from a pattern; capture is read from a WAV or raw
+// PCM file, playback is written to one. Pacing follows the wall clock, or in
+// fast mode only waits for the capture reader to keep up.
+#define REPLAY_MAX_PATTERN 32
+#define REPLAY_MAX_FRAMES 4096
+static int gReplay = 0;                        // set before vpio_start_stream
+static char gReplayInPath[1024];
+static char gReplayOutPath[1024];
+static int gReplayRealtime = 1;
+static UInt32 gReplayPattern[REPLAY_MAX_PATTERN];
+static size_t gReplayPatternLen = 0;
+static FILE* gReplayIn = NULL;
+static FILE* gReplayOut = NULL;
+static int gReplayOutWav = 0;
+static uint64_t gReplayOutFrames = 0;
+static pthread_t gReplayThread;
+static _Atomic int gReplayRun = 0;
+static _Atomic uint64_t gReplayFrames = 0;     // frames driven through the callbacks
+static _Atomic int gReplayEof = 0;             // capture file exhausted (silence since)
+static _Atomic int gReplayArmed = 0;           // fast mode: reader has polled once
+
+// Replay thread: next capture block from the file, zero-padded at the end
+static OSStatus replay_read_capture(AudioBufferList* bl, UInt32 frames) {
+  size_t want = (size_t)frames * (size_t)gChannels;
+  SInt16* dst = (SInt16*)bl->mBuffers[0].mData;
+  size_t got = gReplayIn ? fread(dst, sizeof(SInt16), want, gReplayIn) : 0;
+  if (got < want) {
+    memset(dst + got, 0, (want - got) * sizeof(SInt16));
+    atomic_store_explicit(&gReplayEof, 1, memory_order_release);
+  }
+  return noErr;
+}
+
+static OSStatus capture_pull(AudioUnitRenderActionFlags* ioActionFlags, const AudioTimeStamp* inTimeStamp,
+                             UInt32 inNumberFrames, AudioBufferList* bl) {
+  if (gReplay) return replay_read_capture(bl, inNumberFrames);
+#if defined(__APPLE__)
+  return AudioUnitRender(gAudioUnit, ioActionFlags, inTimeStamp, 1, inNumberFrames, bl);
+#else
+  return -1;
+#endif
+}
+
+// RT: input_cb between callback_enter and callback_exit
+static OSStatus input_process(AudioUnitRenderActionFlags *ioActionFlags,
+                              const AudioTimeStamp *inTimeStamp,
+                              UInt32 inNumberFrames) {
+  if (atomic_load_explicit(&gMode, memory_order_acquire) != MODE_RECORD) return noErr;
+  int gate = atomic_load_explicit(&gCapGate, memory_order_acquire);
+  int gate_echo = gate != VPIO_GATE_OPEN && atomic_load_explicit(&gCapGateEcho, memory_order_relaxed);
+  if (gate == VPIO_GATE_PAUSE && !gate_echo) return noErr;
+
+  UInt32 byteCount = inNumberFrames * (UInt32)(kBytesPerSample * gChannels);
+  AudioBuffer buffer;
+  buffer.mNumberChannels = (UInt32)gChannels;
+  buffer.mDataByteSize = byteCount;
+  if (gInputScratchCap < byteCount) {
+    unsigned char* p = (unsigned char*)realloc(gInputScratch, byteCount);
+    if (!p) return noErr; // drop frame on allocation failure
+    gInputScratch = p;
+    gInputScratchCap = byteCount;
+  }
+  buffer.mData = gInputScratch;
+  AudioBufferList bl;
+  bl.mNumberBuffers = 1;
+  bl.mBuffers[0] = buffer;
+
+  OSStatus st = capture_pull(ioActionFlags, inTimeStamp, inNumberFrames, &bl);
+  if (st == noErr) {
+    if (gate != VPIO_GATE_OPEN) {
+      // The echo path adapts on the real signal; nothing of it is published
+      if (gate_echo) echo_process_capture((SInt16*)buffer.mData, byteCount / kBytesPerSample);
+      if (gate == VPIO_GATE_PAUSE) return st;
+      memset(buffer.mData, 0, byteCount);
+    }
+    // Append to streaming capture ring
+    if (gCap.buf) {
+      size_t capW = vpio_ring_wpos(&gCap);
+      rec_tap(REC_MIC_RAW, (const SInt16*)buffer.mData, inNumberFrames, inTimeStamp);
+      if (gate == VPIO_GATE_OPEN) {
+        echo_process_capture((SInt16*)buffer.mData, byteCount / kBytesPerSample);
+        ns_process_capture((SInt16*)buffer.mData, byteCount / kBytesPerSample);
+        agc_process(VPIO_DIR_CAPTURE, (SInt16*)buffer.mData, byteCount / kBytesPerSample);
+      }
+      level_process(VPIO_DIR_CAPTURE, (const SInt16*)buffer.mData, byteCount / kBytesPerSample);
+      rec_tap(REC_CAPTURE, (const SInt16*)buffer.mData, inNumberFrames, inTimeStamp);
+      // Classify before publishing so a reader never sees bytes without marks
+      vad_gate_process((const SInt16*)buffer.mData, byteCount / kBytesPerSample, capW);
+      cap_stamp_frames(capW, byteCount, inTimeStamp);
+      // Overwrite oldest without touching any reader; a reader copying
+      // from the range can tell its copy went stale
+      vpio_ring_overwrite(&gCap, buffer.mData, byteCount);
+      start_mark(START_FIRST_CAPTURE);
+      size_t backlog = capW + byteCount - atomic_load_explicit(&gCapReaders[0].r, memory_order_relaxed);
+      ring_high(&gRingMem[VPIO_RING_CAPTURE].level_high, backlog < gCap.cap ? backlog : gCap.cap);
+    }
+    // Also keep simple capture for legacy API
+    append_capture(buffer.mData, byteCount);
+  }
+  return st;
+}
+
+static OSStatus input_cb(void *inRefCon,
+                         AudioUnitRenderActionFlags *ioActionFlags,
+                         const AudioTimeStamp *inTimeStamp,
+                         UInt32 inBusNumber,
+                         UInt32 inNumberFrames,
+                         AudioBufferList *ioData) {
+  if (!callback_enter()) return noErr;
+  OSStatus st = input_process(ioActionFlags, inTimeStamp, inNumberFrames);
+  callback_exit();
+  return st;
+}
+
+static void* replay_thread_fn(void* arg) {
+#if defined(__APPLE__)
+  pthread_setname_np("vpio-replay");
+#endif
+  static SInt16 out[REPLAY_MAX_FRAMES];
+  const size_t frame_bytes = (size_t)kBytesPerSample * (size_t)gChannels;
+  uint64_t t0 = vpio_host_time_now_ns();
+  uint64_t frames = 0;
+  size_t k = 0;
+  while (atomic_load_explicit(&gReplayRun, memory_order_acquire)) {
+    UInt32 n = gReplayPattern[k++ % gReplayPatternLen];
+    if (gReplayRealtime) {
+      uint64_t due = t0 + (uint64_t)((double)frames * 1e9 / gSampleRate);
+      uint64_t now = vpio_host_time_now_ns();
+      if (due > now) usleep((useconds_t)((due - now) / 1000));
+    } else {
+      // As fast as the reader drains capture, without ever overrunning it.
+      // Nothing runs before the first read, so stages configured right after
+      // vpio_start_stream see the whole file.
+      size_t room = gCap.cap / 2;
+      while (atomic_load_explicit(&gReplayRun, memory_order_acquire) &&
+             (!atomic_load_explicit(&gReplayArmed, memory_order_acquire) ||
+              cap_backlog(0) +
+                  (size_t)n * frame_bytes > room))
+        usleep(1000);
+    }
+    AudioTimeStamp ts;
+    memset(&ts, 0, sizeof(ts));
+    ts.mSampleTime = (Float64)frames;
+    ts.mFlags = kAudioTimeStampSampleTimeValid;
+    // Fast mode leaves host time out so runs are reproducible
+    if (gReplayRealtime) {
+#if defined(__APPLE__)
+      ts.mHostTime = mach_absolute_time();
+#else
+      ts.mHostTime = vpio_host_time_now_ns(); // host ticks are nanoseconds here
+#endif
+      ts.mFlags |= kAudioTimeStampHostTimeValid;
+    }
+    AudioUnitRenderActionFlags flags = 0;
+    input_cb(NULL, &flags, &ts, 1, n, NULL);
+    AudioBufferList bl;
+    bl.mNumberBuffers = 1;
+    bl.mBuffers[0].mNumberChannels = (UInt32)gChannels;
+    bl.mBuffers[0].mDataByteSize = n * (UInt32)frame_bytes;
+    bl.mBuffers[0].mData = out;
+    render_cb(NULL, &flags, &ts, 0, n, &bl);
+    if (gReplayOut) gReplayOutFrames += fwrite(out, frame_bytes, n, gReplayOut);
+    frames += n;
+    atomic_store_explicit(&gReplayFrames, frames, memory_order_release);
+  }
+  return NULL;
+}
+
+// Open the capture source; WAV must match the stream format, anything else is raw PCM
+static FILE* replay_open_capture(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  unsigned char hdr[12];
+  if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+    rewind(f);
+    return f;
+  }
+  int fmt_ok = 0;
+  for (;;) {
+    unsigned char ch[8];
+    if (fread(ch, 1, 8, f) != 8) break;
+    uint32_t len = (uint32_t)ch[4] | ((uint32_t)ch[5] << 8) | ((uint32_t)ch[6] << 16) | ((uint32_t)ch[7] << 24);
+    if (memcmp(ch, "fmt ", 4) == 0 && len >= 16) {
+      unsigned char fm[16];
+      if (fread(fm, 1, 16, f) != 16) break;
+      unsigned tag = fm[0] | (fm[1] << 8), chans = fm[2] | (fm[3] << 8), bits = fm[14] | (fm[15] << 8);
+      uint32_t rate = (uint32_t)fm[4] | ((uint32_t)fm[5] << 8) | ((uint32_t)fm[6] << 16) | ((uint32_t)fm[7] << 24);
+      fmt_ok = (tag == 1 && bits == 16 && (int)chans == gChannels && rate == (uint32_t)gSampleRate);
+      if (!fmt_ok && gTrace)
+        fprintf(stderr, "[VPIO-REPLAY] %s: need 16-bit PCM, %d ch, %.0f Hz (got tag=%u bits=%u ch=%u rate=%u)\n",
+                path, gChannels, gSampleRate, tag, bits, chans, rate);
+      if (fseek(f, (long)(len - 16 + (len & 1)), SEEK_CUR) != 0) break;
+    } else if (memcmp(ch, "data", 4) == 0) {
+      if (fmt_ok) return f;
+      break;
+    } else if (fseek(f, (long)(len + (len & 1)), SEEK_CUR) != 0) {
+      break;
+    }
+  }
+  fclose(f);
+  return NULL;
+}
+
+static int replay_start(void) {
+  if (gReplayPatternLen == 0) {
+    gReplayPattern[0] = (UInt32)(gSampleRate / 100.0);
+    gReplayPatternLen = 1;
+  }
+  gReplayIn = replay_open_capture(gReplayInPath);
+  if (!gReplayIn) return -1;
+  if (gReplayOutPath[0]) {
+    size_t len = strlen(gReplayOutPath);
+    gReplayOut = fopen(gReplayOutPath, "wb");
+    if (!gReplayOut) { fclose(gReplayIn); gReplayIn = NULL; return -1; }
+    gReplayOutWav = (len > 4 && strcmp(gReplayOutPath + len - 4, ".wav") == 0);
+    if (gReplayOutWav) rec_wav_header(gReplayOut, 0);
+  }
+  gReplayOutFrames = 0;
+  atomic_store_explicit(&gReplayFrames, 0, memory_order_relaxed);
+  atomic_store_explicit(&gReplayEof, 0, memory_order_relaxed);
+  atomic_store_explicit(&gReplayArmed, 0, memory_order_relaxed);
+  atomic_store_explicit(&gReplayRun, 1, memory_order_release);
+  if (pthread_create(&gReplayThread, NULL, replay_thread_fn, NULL) != 0) {
+    atomic_store_explicit(&gReplayRun, 0, memory_order_release);
+    return -1;
+  }
+  if (gTrace) fprintf(stderr, "[VPIO-REPLAY] %s -> %s (%s)\n", gReplayInPath,
+                      gReplayOutPath[0] ? gReplayOutPath : "(discarded)", gReplayRealtime ? "realtime" : "fast");
+  return 0;
+}
+
+// Stop driving the callbacks and close the files; must run before the rings go away
+static void replay_stop(void) {
+  if (atomic_exchange_explicit(&gReplayRun, 0, memory_order_acq_rel)) pthread_join(gReplayThread, NULL);
+  if (gReplayIn) { fclose(gReplayIn); gReplayIn = NULL; }
+  if (gReplayOut) {
+    if (gReplayOutWav && fseek(gReplayOut, 0, SEEK_SET) == 0) rec_wav_header(gReplayOut, gReplayOutFrames);
+    fclose(gReplayOut);
+    gReplayOut = NULL;
+  }
+}
+
+#if defined(__APPLE__)
+static UInt32 fourcc(const char s[4]) {
   return ((UInt32)s[0] << 24) | ((UInt32)s[1] << 16) | ((UInt32)s[2] << 8) |
          (UInt32)s[3];
 }
+#endif
 
 int vpio_init(double sample_rate, int channels) {
   if (gAudioUnit) return 0;
@@ -370,6 +2064,11 @@ int vpio_init(double sample_rate, int channels) {
   // Check env for tracing
   const char* tr = getenv("VPIO_TRACE");
   if (tr && tr[0] != '\0' && tr[0] != '0') gTrace = 1;
+  if (!gMixChosen) {
+    gMix = vpio_mix_select(getenv("VPIO_KERNELS"));
+    gMixChosen = 1;
+    if (gTrace) fprintf(stderr, "[VPIO-KERNELS] %s\n", gMix->isa);
+  }
   // Optional render guard multiplier (e.g., 1.25..2.0)
   {
     const char* rg = getenv("VPIO_RENDER_GUARD_MULT");
@@ -377,12 +2076,21 @@ int vpio_init(double sample_rate, int channels) {
       double v = atof(rg);
       if (v < 1.0) v = 1.0;
       if (v > 4.0) v = 4.0;
-      gRenderGuardMult = v;
+      atomic_store_explicit(&gRenderGuardMult, v, memory_order_relaxed);
     }
   }
+#if defined(__APPLE__)
+  if (gTimebase.denom == 0) mach_timebase_info(&gTimebase);
+#endif
   // Optional tunables for burst top-up behavior
   // No burst or overflow policy configuration: staging grows dynamically.
+  if (gReplay) {
+    // No audio unit: replay_start drives the callbacks once the stream is set up
+    atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
+    return 0;
+  }
 
+#if defined(__APPLE__)
   AudioComponentDescription desc;
   desc.componentType = fourcc("auou");
   desc.componentSubType = fourcc("vpio");
@@ -394,6 +2102,7 @@ int vpio_init(double sample_rate, int channels) {
   if (!comp) return -1;
   OSStatus st = AudioComponentInstanceNew(comp, &gAudioUnit);
   if (st != noErr) return (int)st;
+  start_mark(START_COMPONENT);
 
   UInt32 one = 1;
   st = AudioUnitSetProperty(gAudioUnit, kAudioOutputUnitProperty_EnableIO,
@@ -406,6 +2115,9 @@ int vpio_init(double sample_rate, int channels) {
   // Ensure voice processing (AEC/NS/HPF) is enabled (i.e., bypass disabled)
   {
     UInt32 bypass = 0; // 0 = enable processing, 1 = bypass
+    // VPIO_BYPASS_VP=1 turns Apple's processing off, e.g. to measure the software AEC alone
+    const char* bp = getenv("VPIO_BYPASS_VP");
+    if (bp && bp[0] != '\0' && bp[0] != '0') bypass = 1;
     OSStatus st2 = AudioUnitSetProperty(gAudioUnit,
                                         kAUVoiceIOProperty_BypassVoiceProcessing,
                                         kAudioUnitScope_Global,
@@ -463,6 +2175,7 @@ int vpio_init(double sample_rate, int channels) {
                          sizeof(maxFrames));
     if (pst != noErr && gTrace) fprintf(stderr, "[VPIO] pre-init MaxFramesPerSlice set failed (st=%d)\n", (int)pst);
   }
+  start_mark(START_CONFIGURE);
 
   st = AudioUnitInitialize(gAudioUnit);
   // Tighter maximum frames per slice to reduce large render pulls (target ~10ms)
@@ -478,106 +2191,550 @@ int vpio_init(double sample_rate, int channels) {
     if (pst != noErr && gTrace) fprintf(stderr, "[VPIO] post-init MaxFramesPerSlice set failed (st=%d)\n", (int)pst);
   }
   if (st != noErr) { if (gTrace) fprintf(stderr, "[VPIO] AudioUnitInitialize failed (st=%d)\n", (int)st); return (int)st; }
+  start_mark(START_INITIALIZE);
   st = AudioOutputUnitStart(gAudioUnit);
   if (st != noErr) { if (gTrace) fprintf(stderr, "[VPIO] AudioOutputUnitStart failed (st=%d)\n", (int)st); return (int)st; }
+  start_mark(START_UNIT_START);
   atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
   return 0;
+#else
+  return -1; // only the replay backend exists off Apple platforms
+#endif
 }
 
-int vpio_start_stream(double sample_rate, int channels, size_t ring_capacity_bytes) {
-  int rc = vpio_init(sample_rate, channels);
-  if (rc != 0) return rc;
-  // Allocate rings
-  if (ring_capacity_bytes < (size_t)(sample_rate * channels * kBytesPerSample)) {
-    ring_capacity_bytes = (size_t)(sample_rate * channels * kBytesPerSample);
-  }
-  gCapRing = (unsigned char*)malloc(ring_capacity_bytes);
-  gCapCap = ring_capacity_bytes;
-  if (!gCapRing) { vpio_stop_stream(); return -1; }
-  atomic_store_explicit(&gCapW, 0, memory_order_release);
-  atomic_store_explicit(&gCapR, 0, memory_order_release);
-
-  gPlayRing = (unsigned char*)malloc(ring_capacity_bytes);
-  gPlayCap = ring_capacity_bytes;
-  if (!gPlayRing) { vpio_stop_stream(); return -1; }
-  atomic_store_explicit(&gPlayW, 0, memory_order_release);
-  atomic_store_explicit(&gPlayR, 0, memory_order_release);
+// Stream state: everything the callbacks use while gMode is MODE_RECORD.
+// The audio unit outlives streams, so callbacks may be running around both
+// of these. Returns -1 if a ring could not be allocated (stream_release
+// frees what was).
+static int stream_alloc(double sample_rate, int channels, size_t ring_capacity_bytes) {
+  callbacks_hold();
+  play_streams_reset();
+  callbacks_release();
+  // Allocate rings: at least one second each, within their budgets
+  size_t floor_bytes = (size_t)(sample_rate * channels * kBytesPerSample);
+  if (ring_capacity_bytes < floor_bytes) ring_capacity_bytes = floor_bytes;
+  if (vpio_ring_alloc(&gCap, ring_budgeted(VPIO_RING_CAPTURE, ring_capacity_bytes, floor_bytes)) != 0) return -1;
+  cap_readers_reset();
+
+  if (vpio_ring_alloc(&gPlay, ring_budgeted(VPIO_RING_PLAYBACK, ring_capacity_bytes, floor_bytes)) != 0) return -1;
+  atomic_store_explicit(&gPlayOverruns, 0, memory_order_relaxed);
+  atomic_store_explicit(&gPlayOverrunBytes, 0, memory_order_relaxed);
   // staging ring for input frames (10ms)
-  gInRing = (unsigned char*)malloc(ring_capacity_bytes);
-  gInCap = ring_capacity_bytes;
-  if (!gInRing) { vpio_stop_stream(); return -1; }
-  atomic_store_explicit(&gInW, 0, memory_order_release);
-  atomic_store_explicit(&gInR, 0, memory_order_release);
+  if (vpio_ring_alloc(&gIn, ring_budgeted(VPIO_RING_STAGING, ring_capacity_bytes, floor_bytes)) != 0) return -1;
+  gInBase = gIn.cap;
+  gInCalmSince = 0;
+  const size_t committed[RING_KINDS] = {gCap.cap, gPlay.cap, gIn.cap};
+  for (int k = 0; k < RING_KINDS; k++) {
+    RingMem* rm = &gRingMem[k];
+    atomic_store_explicit(&rm->committed_high, committed[k], memory_order_relaxed);
+    atomic_store_explicit(&rm->level_high, 0, memory_order_relaxed);
+    atomic_store_explicit(&rm->grows, 0, memory_order_relaxed);
+    atomic_store_explicit(&rm->shrinks, 0, memory_order_relaxed);
+    atomic_store_explicit(&rm->rejected, 0, memory_order_relaxed);
+  }
   if (!gInLockInit) { pthread_mutex_init(&gInLock, NULL); gInLockInit = 1; }
+  // echo reference ring (1s of played samples) and delay estimator tables
+  if (vpio_ring_alloc(&gRef, (size_t)sample_rate * sizeof(SInt16)) != 0) return -1;
+  delay_est_setup();
+  // 10ms meter blocks at the new rate
+  atomic_store_explicit(&gLevelResetReq[VPIO_DIR_CAPTURE], 1, memory_order_release);
+  atomic_store_explicit(&gLevelResetReq[VPIO_DIR_PLAYBACK], 1, memory_order_release);
   // Always be in record mode for streaming (AEC engaged)
   atomic_store_explicit(&gMode, MODE_RECORD, memory_order_release);
   return 0;
 }
 
+static void stream_release(void) {
+  atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
+  // Callbacks that still saw MODE_RECORD must be gone before their state is freed
+  callbacks_hold();
+  vpio_ring_free(&gCap);
+  cap_readers_reset();
+  vpio_ring_free(&gPlay);
+  play_streams_release();
+  clip_voices_reset();
+  vpio_ring_free(&gIn);
+  if (gInLockInit) { pthread_mutex_destroy(&gInLock); gInLockInit = 0; }
+  rec_release();
+  echo_release_all();
+  callbacks_release();
+  clips_reap();
+}
+
+int vpio_start_stream(double sample_rate, int channels, size_t ring_capacity_bytes) {
+  for (int m = 0; m < START_MARKS; m++) atomic_store_explicit(&gStartMarks[m], 0, memory_order_relaxed);
+  atomic_store_explicit(&gStartT0, vpio_host_time_now_ns(), memory_order_relaxed);
+  int rc = vpio_init(sample_rate, channels);
+  if (rc != 0) return rc;
+  if (stream_alloc(sample_rate, channels, ring_capacity_bytes) != 0) { vpio_stop_stream(); return -1; }
+  if (gReplay && replay_start() != 0) { vpio_stop_stream(); return -1; }
+  start_mark(START_READY);
+  if (gTrace) {
+    uint64_t t0 = atomic_load_explicit(&gStartT0, memory_order_relaxed);
+    fprintf(stderr, "[VPIO-START] stream ready in %.1f ms\n",
+            (double)(atomic_load_explicit(&gStartMarks[START_READY], memory_order_relaxed) - t0) / 1e6);
+  }
+  return 0;
+}
+
+static void* start_thread_fn(void* arg) {
+  (void)arg;
+#if defined(__APPLE__)
+  pthread_setname_np("vpio-start");
+#endif
+  tStartWorker = 1;
+  gStartRc = vpio_start_stream(gStartRate, gStartChannels, gStartRing);
+  atomic_store_explicit(&gStartState, 2, memory_order_release);
+  event_post(VPIO_EVENT_STREAM_STARTED, 0, (uint64_t)(int64_t)gStartRc);
+  return NULL;
+}
+
+// Wait for the async start worker, unless called from it (a failing start
+// stops the stream itself)
+static void start_join(void) {
+  if (atomic_load_explicit(&gStartState, memory_order_acquire) == 0) return;
+  if (tStartWorker) return;
+  pthread_join(gStartThread, NULL);
+  atomic_store_explicit(&gStartState, 0, memory_order_release);
+  gStartDone = 1;
+}
+
+// Device bring-up (component lookup, AudioUnitInitialize, start) can take
+// hundreds of ms; this keeps it off the caller's thread. Call from one
+// control thread; vpio_stop_stream waits for a pending start.
+int vpio_start_stream_async(double sample_rate, int channels, size_t ring_capacity_bytes) {
+  if (atomic_load_explicit(&gStartState, memory_order_acquire) == 1) return -1;
+  start_join();
+  gStartRate = sample_rate;
+  gStartChannels = channels;
+  gStartRing = ring_capacity_bytes;
+  gStartDone = 0;
+  atomic_store_explicit(&gStartState, 1, memory_order_release);
+  if (pthread_create(&gStartThread, NULL, start_thread_fn, NULL) != 0) {
+    atomic_store_explicit(&gStartState, 0, memory_order_release);
+    return -1;
+  }
+  return 0;
+}
+
+int vpio_start_stream_result(int* rc) {
+  if (atomic_load_explicit(&gStartState, memory_order_acquire) == 1) return 0;
+  start_join();
+  if (!gStartDone) return -1;
+  if (rc) *rc = gStartRc;
+  return 1;
+}
+
+size_t vpio_get_start_timings(void* out, size_t out_size) {
+  if (!out || out_size == 0) return 0;
+  vpio_start_timings t;
+  memset(&t, 0, sizeof(t));
+  uint64_t t0 = atomic_load_explicit(&gStartT0, memory_order_relaxed);
+  double* ms[START_MARKS] = {&t.component_ms, &t.configure_ms, &t.initialize_ms, &t.unit_start_ms,
+                             &t.ready_ms, &t.first_render_ms, &t.first_capture_ms, &t.first_played_ms};
+  t.start_ns = t0;
+  for (int m = 0; m < START_MARKS; m++) {
+    uint64_t at = atomic_load_explicit(&gStartMarks[m], memory_order_relaxed);
+    *ms[m] = (t0 && at >= t0) ? (double)(at - t0) / 1e6 : -1.0;
+  }
+  size_t n = (out_size < sizeof(t)) ? out_size : sizeof(t);
+  memcpy(out, &t, n);
+  return n;
+}
+
 void vpio_stop_stream(void) {
+  start_join();
+  replay_stop();
   // Stop playback thread if running
   if (atomic_load_explicit(&gPlayThreadRun, memory_order_acquire)) {
     vpio_stop_playback_thread();
   }
-  atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
-  if (gCapRing) { free(gCapRing); gCapRing = NULL; }
-  gCapCap = 0; atomic_store_explicit(&gCapW, 0, memory_order_release); atomic_store_explicit(&gCapR, 0, memory_order_release);
-  if (gPlayRing) { free(gPlayRing); gPlayRing = NULL; }
-  gPlayCap = 0; atomic_store_explicit(&gPlayW, 0, memory_order_release); atomic_store_explicit(&gPlayR, 0, memory_order_release);
-  if (gInRing) { free(gInRing); gInRing = NULL; }
-  gInCap = 0; atomic_store_explicit(&gInW, 0, memory_order_release); atomic_store_explicit(&gInR, 0, memory_order_release);
-  if (gInLockInit) { pthread_mutex_destroy(&gInLock); gInLockInit = 0; }
+  // The audio unit keeps running
+  stream_release();
+}
+
+static size_t cap_reader_read(CapReader* rd, void* dst, size_t maxlen, size_t* pos_out) {
+  if (gReplay) atomic_store_explicit(&gReplayArmed, 1, memory_order_release);
+  size_t r = atomic_load_explicit(&rd->r, memory_order_relaxed);
+  if (pos_out) *pos_out = r;
+  if (!gCap.buf || maxlen == 0) return 0;
+  for (;;) {
+    r = cap_catch_up(rd, r);
+    if (pos_out) *pos_out = r;
+    size_t avail = vpio_ring_published(&gCap) - r;
+    size_t n = (avail < maxlen) ? avail : maxlen;
+    if (n == 0) break;
+    if (vpio_ring_get_intact(&gCap, r, dst, n)) {
+      atomic_store_explicit(&rd->r, r + n, memory_order_release);
+      return n;
+    }
+  }
+  atomic_store_explicit(&rd->r, r, memory_order_release);
+  return 0;
 }
 
 size_t vpio_read_capture(void* dst, size_t maxlen) {
-  if (!gCapRing || gCapCap == 0 || maxlen == 0) return 0;
-  size_t avail = atomic_load_explicit(&gCapW, memory_order_acquire) - atomic_load_explicit(&gCapR, memory_order_acquire);
-  size_t n = (avail < maxlen) ? avail : maxlen;
-  if (n == 0) return 0;
-  size_t capR = atomic_load_explicit(&gCapR, memory_order_acquire);
-  size_t ridx = capR % gCapCap;
-  size_t first = gCapCap - ridx; if (first > n) first = n;
-  memcpy(dst, gCapRing + ridx, first);
-  if (n > first) memcpy((unsigned char*)dst + first, gCapRing, n - first);
-  atomic_store_explicit(&gCapR, capR + n, memory_order_release);
-  return n;
+  return cap_reader_read(&gCapReaders[0], dst, maxlen, NULL);
+}
+
+// Like vpio_read_capture, but also reports the capture byte offset of dst[0]
+// so callers can line reads up with per-block marks (e.g. the VAD gate).
+size_t vpio_read_capture_pos(void* dst, size_t maxlen, size_t* pos_out) {
+  return cap_reader_read(&gCapReaders[0], dst, maxlen, pos_out);
 }
 
 size_t vpio_write_playback(const void* src, size_t len) {
-  if (!gPlayRing || gPlayCap == 0 || len == 0) return 0;
-  // Make room if needed
-  size_t playW = atomic_load_explicit(&gPlayW, memory_order_acquire);
-  size_t playR = atomic_load_explicit(&gPlayR, memory_order_acquire);
-  size_t freeBytes = (gPlayCap > (playW - playR)) ? (gPlayCap - (playW - playR)) : 0;
-  if (len > freeBytes) {
-    size_t need = len - freeBytes;
-    // drop oldest
-    atomic_store_explicit(&gPlayR, playR + need, memory_order_release);
-    playR += need;
-  }
-  playW = atomic_load_explicit(&gPlayW, memory_order_acquire);
-  size_t widx = playW % gPlayCap;
-  size_t first = gPlayCap - widx; if (first > len) first = len;
-  memcpy(gPlayRing + widx, src, first);
-  if (len > first) memcpy(gPlayRing, (const unsigned char*)src + first, len - first);
-  atomic_store_explicit(&gPlayW, playW + len, memory_order_release);
+  if (!gPlay.buf || !src || len == 0) return 0;
+  // Drop oldest: overwrite what render_cb has not played yet, announcing the
+  // range first; it counts what it lost when it gets there. Of a write
+  // larger than the ring only the newest gPlay.cap bytes can survive.
+  const unsigned char* p = (const unsigned char*)src;
+  size_t n = len;
+  if (n > gPlay.cap) {
+    atomic_fetch_add_explicit(&gPlayOverrunBytes, (uint64_t)(n - gPlay.cap), memory_order_relaxed);
+    p += n - gPlay.cap;
+    n = gPlay.cap;
+  }
+  // gInLock orders this against the pacer's playout breakpoints
+  if (gInLockInit) pthread_mutex_lock(&gInLock);
+  Playout* po = &gPlayStreams[0].po;
+  uint64_t w = atomic_load_explicit(&po->written, memory_order_relaxed);
+  playout_main_break(w + (len - n));
+  vpio_ring_overwrite(&gPlay, p, n);
+  gPoPlayW += n;
+  atomic_store_explicit(&po->written, w + len, memory_order_release);
+  if (gInLockInit) pthread_mutex_unlock(&gInLock);
+  ring_high(&gRingMem[VPIO_RING_PLAYBACK].level_high, vpio_ring_level(&gPlay));
   return len;
 }
 
 void vpio_flush_playback(void) {
-  // Drop all pending playback in streaming ring immediately
-  size_t playW = atomic_load_explicit(&gPlayW, memory_order_acquire);
-  atomic_store_explicit(&gPlayR, playW, memory_order_release);
+  // Drop all pending playback in streaming ring from the next render
+  // callback on; only bytes written before the call are dropped
+  vpio_ring_flush(&gPlay);
 }
 
 void vpio_flush_input(void) {
   // Drop all pending data in staging ring immediately
+  // (under gInLock the pacer is held off, so this can move its cursor)
   pthread_mutex_lock(&gInLock);
-  size_t inW = atomic_load_explicit(&gInW, memory_order_acquire);
-  atomic_store_explicit(&gInR, inW, memory_order_release);
+  size_t dropped = vpio_ring_level(&gIn);
+  vpio_ring_consume(&gIn, vpio_ring_wpos(&gIn));
+  // Once render_cb is past what the play ring holds, it is past these too
+  if (dropped) {
+    gPoInR += dropped;
+    playout_main_break(gPoInR);
+  }
   pthread_mutex_unlock(&gInLock);
 }
 
+// Open an extra playback stream mixed over the main one. Call after
+// vpio_start_stream. Returns its id (1..PLAY_STREAMS-1), or -1 if none is
+// free or its ring could not be allocated.
+int vpio_play_stream_open(int priority, double gain_db, double duck_db) {
+  if (!gPlay.cap) return -1;
+  for (int i = 1; i < PLAY_STREAMS; i++) {
+    PlayStream* ps = &gPlayStreams[i];
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&ps->open, &expected, -1)) continue;
+    // Closed slots keep their ring until stream stop: render_cb may still be
+    // reading it, so it is only ever reused, never freed here
+    if (!ps->q.buf && vpio_ring_alloc(&ps->q, gPlay.cap) != 0) {
+      atomic_store_explicit(&ps->open, 0, memory_order_release);
+      return -1;
+    }
+    vpio_ring_flush(&ps->q);
+    atomic_store_explicit(&ps->played, 0, memory_order_relaxed);
+    playout_reset(&ps->po, vpio_ring_wpos(&ps->q));
+    atomic_store_explicit(&ps->gain, powf(10.0f, (float)gain_db / 20.0f), memory_order_relaxed);
+    atomic_store_explicit(&ps->duck_db, duck_db > 0 ? (float)duck_db : 0.0f, memory_order_relaxed);
+    atomic_store_explicit(&ps->priority, priority, memory_order_relaxed);
+    ps->duck = 1.0f;
+    ps->applied = atomic_load_explicit(&ps->gain, memory_order_relaxed);
+    atomic_store_explicit(&ps->open, 1, memory_order_release);
+    return i;
+  }
+  return -1;
+}
+
+// Change a stream's mix settings; stream 0 is the main playback ring.
+// Returns 0, or -1 if the stream is not open.
+int vpio_play_stream_set(int stream, int priority, double gain_db, double duck_db) {
+  if (stream < 0 || stream >= PLAY_STREAMS) return -1;
+  PlayStream* ps = &gPlayStreams[stream];
+  if (atomic_load_explicit(&ps->open, memory_order_acquire) != 1) return -1;
+  atomic_store_explicit(&ps->gain, powf(10.0f, (float)gain_db / 20.0f), memory_order_relaxed);
+  atomic_store_explicit(&ps->duck_db, duck_db > 0 ? (float)duck_db : 0.0f, memory_order_relaxed);
+  atomic_store_explicit(&ps->priority, priority, memory_order_relaxed);
+  return 0;
+}
+
+static PlayStream* play_stream(int stream) {
+  if (stream <= 0 || stream >= PLAY_STREAMS) return NULL;
+  PlayStream* ps = &gPlayStreams[stream];
+  return atomic_load_explicit(&ps->open, memory_order_acquire) == 1 ? ps : NULL;
+}
+
+// Queue PCM on an extra stream (one writer thread per stream). Never drops
+// queued audio: returns how many bytes fit.
+size_t vpio_play_stream_write(int stream, const void* src, size_t len) {
+  PlayStream* ps = play_stream(stream);
+  if (!ps || !src) return 0;
+  size_t room = vpio_ring_writable(&ps->q, len);
+  size_t n = len < room ? len : room;
+  n -= n % kBytesPerSample;
+  if (!n) return 0;
+  vpio_ring_write(&ps->q, src, n);
+  atomic_fetch_add_explicit(&ps->po.written, n, memory_order_release);
+  return n;
+}
+
+// Drop what is queued on one extra stream; the others keep playing. Safe
+// against the writer: only bytes written before the call are dropped.
+void vpio_play_stream_flush(int stream) {
+  PlayStream* ps = play_stream(stream);
+  if (!ps) return;
+  vpio_ring_flush(&ps->q);
+}
+
+void vpio_play_stream_close(int stream) {
+  PlayStream* ps = play_stream(stream);
+  if (!ps) return;
+  atomic_store_explicit(&ps->open, 0, memory_order_release);
+}
+
+// Queued bytes, bytes mixed out so far and the current ducking (dB, <= 0).
+// Returns 0, or -1 if the stream is not open.
+int vpio_play_stream_stats(int stream, size_t* queued, uint64_t* played, double* duck_db) {
+  if (stream < 0 || stream >= PLAY_STREAMS) return -1;
+  PlayStream* ps = &gPlayStreams[stream];
+  if (atomic_load_explicit(&ps->open, memory_order_acquire) != 1) return -1;
+  if (queued) {
+    *queued = vpio_ring_level(stream == 0 ? &gPlay : &ps->q);
+  }
+  if (played) *played = atomic_load_explicit(&ps->played, memory_order_relaxed);
+  if (duck_db) *duck_db = atomic_load_explicit(&ps->duck_now_db, memory_order_relaxed);
+  return 0;
+}
+
+static Playout* playout_stream(int stream) {
+  if (stream < 0 || stream >= PLAY_STREAMS || !gPlay.buf) return NULL;
+  PlayStream* ps = &gPlayStreams[stream];
+  return atomic_load_explicit(&ps->open, memory_order_acquire) == 1 ? &ps->po : NULL;
+}
+
+// Tag the next byte written to a stream. Call from the thread that writes
+// it. Returns 0, or -1 if the stream is not open or PLAYOUT_MARKS marks are
+// still ahead of render_cb.
+int vpio_playout_mark(int stream, uint64_t tag) {
+  Playout* po = playout_stream(stream);
+  if (!po) return -1;
+  uint64_t m = atomic_load_explicit(&po->marks, memory_order_relaxed);
+  if (m + 1 >= atomic_load_explicit(&po->passed, memory_order_acquire) + PLAYOUT_MARKS) return -1;
+  PlayoutMark* mk = &po->mark[m % PLAYOUT_MARKS];
+  atomic_store_explicit(&mk->seq, 0, VPIO_SEQ_ORDER(memory_order_relaxed));
+  VPIO_SEQ_FENCE(memory_order_release);
+  atomic_store_explicit(&mk->tag, tag, memory_order_relaxed);
+  atomic_store_explicit(&mk->start, atomic_load_explicit(&po->written, memory_order_relaxed), memory_order_relaxed);
+  atomic_store_explicit(&mk->heard, 0, memory_order_relaxed);
+  atomic_store_explicit(&mk->seq, m + 1, memory_order_release);
+  atomic_store_explicit(&po->marks, m + 1, memory_order_release);
+  return 0;
+}
+
+size_t vpio_get_playout_clock(int stream, void* out, size_t out_size) {
+  Playout* po = playout_stream(stream);
+  if (!po || !out || out_size == 0) return 0;
+  vpio_playout_clock c;
+  memset(&c, 0, sizeof(c));
+  uint64_t position = atomic_load_explicit(&po->position, memory_order_acquire);
+  uint64_t played = atomic_load_explicit(&gPlayStreams[stream].played, memory_order_relaxed);
+  c.written = atomic_load_explicit(&po->written, memory_order_acquire) / kBytesPerSample;
+  c.rendered = played / kBytesPerSample;
+  c.position = position / kBytesPerSample;
+  c.dropped = position > played ? (position - played) / kBytesPerSample : 0;
+  size_t n = out_size < sizeof(c) ? out_size : sizeof(c);
+  memcpy(out, &c, n);
+  return n;
+}
+
+// Newest mark with this tag still in the stream's mark ring
+size_t vpio_get_playout_mark(int stream, uint64_t tag, void* out, size_t out_size) {
+  Playout* po = playout_stream(stream);
+  if (!po || !out || out_size == 0) return 0;
+  uint64_t marks = atomic_load_explicit(&po->marks, memory_order_acquire);
+  for (uint64_t m = marks; m-- > 0 && marks - m <= PLAYOUT_MARKS; ) {
+    PlayoutMark* mk = &po->mark[m % PLAYOUT_MARKS];
+    if (atomic_load_explicit(&mk->seq, memory_order_acquire) != m + 1) break; // lapped
+    if (atomic_load_explicit(&mk->tag, memory_order_relaxed) != tag) continue;
+    // position before heard: heard never trails what position says was played
+    uint64_t position = atomic_load_explicit(&po->position, memory_order_acquire);
+    uint64_t start = atomic_load_explicit(&mk->start, memory_order_relaxed);
+    uint64_t heard = atomic_load_explicit(&mk->heard, memory_order_relaxed);
+    uint64_t end = atomic_load_explicit(&po->written, memory_order_acquire);
+    if (m + 1 < marks) end = atomic_load_explicit(&po->mark[(m + 1) % PLAYOUT_MARKS].start, memory_order_relaxed);
+    VPIO_SEQ_FENCE(memory_order_acquire);
+    if (atomic_load_explicit(&mk->seq, VPIO_SEQ_ORDER(memory_order_relaxed)) != m + 1) break;
+    uint64_t from = position > start ? position : start;
+    vpio_playout_mark_info info;
+    memset(&info, 0, sizeof(info));
+    info.tag = tag;
+    info.start = start / kBytesPerSample;
+    info.written = (end - start) / kBytesPerSample;
+    info.heard = heard / kBytesPerSample;
+    info.pending = end > from ? (end - from) / kBytesPerSample : 0;
+    size_t n = out_size < sizeof(info) ? out_size : sizeof(info);
+    memcpy(out, &info, n);
+    return n;
+  }
+  return 0;
+}
+
+// Copy PCM into the clip bank once. Returns the clip id, or -1 if the bank
+// is full or the copy could not be allocated.
+int vpio_clip_register(const void* pcm, size_t len) {
+  clips_reap();
+  size_t samples = len / sizeof(int16_t);
+  if (!pcm || !samples) return -1;
+  int16_t* copy = (int16_t*)malloc(samples * sizeof(int16_t));
+  if (!copy) return -1;
+  memcpy(copy, pcm, samples * sizeof(int16_t));
+  for (int i = 0; i < CLIP_SLOTS; i++) {
+    Clip* c = &gClips[i];
+    int expected = CLIP_FREE;
+    if (!atomic_compare_exchange_strong(&c->state, &expected, CLIP_LOADING)) continue;
+    c->pcm = copy;
+    c->samples = samples;
+    atomic_store_explicit(&c->state, CLIP_READY, memory_order_release);
+    return i;
+  }
+  free(copy);
+  return -1;
+}
+
+// Stop the clip's voices and free it once they have ended. Returns 0, or -1
+// if it is not registered.
+int vpio_clip_unregister(int clip) {
+  if (clip < 0 || clip >= CLIP_SLOTS) return -1;
+  int expected = CLIP_READY;
+  if (!atomic_compare_exchange_strong(&gClips[clip].state, &expected, CLIP_DYING)) return -1;
+  for (int i = 0; i < CLIP_VOICES; i++) {
+    Voice* v = &gVoices[i];
+    if (atomic_load_explicit(&v->state, memory_order_acquire) == VOICE_PLAYING &&
+        atomic_load_explicit(&v->clip, memory_order_relaxed) == clip)
+      atomic_store_explicit(&v->stop, 1, memory_order_relaxed);
+  }
+  clips_reap();
+  return 0;
+}
+
+// Start a voice on a registered clip; any thread, no copy, no lock. Returns
+// the voice handle (> 0) for vpio_clip_stop and the CLIP_* events, or -1 if
+// the clip is not registered or all voices are busy.
+int vpio_clip_trigger(int clip, double gain_db) {
+  if (clip < 0 || clip >= CLIP_SLOTS) return -1;
+  Clip* c = &gClips[clip];
+  // seq_cst, paired with clips_reap
+  atomic_fetch_add(&c->users, 1);
+  if (atomic_load(&c->state) != CLIP_READY) {
+    atomic_fetch_sub_explicit(&c->users, 1, memory_order_release);
+    return -1;
+  }
+  for (int i = 0; i < CLIP_VOICES; i++) {
+    Voice* v = &gVoices[i];
+    int expected = VOICE_FREE;
+    if (!atomic_compare_exchange_strong(&v->state, &expected, VOICE_SETUP)) continue;
+    int gen = (atomic_fetch_add_explicit(&gVoiceGen, 1, memory_order_relaxed) & 0x3ffffff) + 1;
+    int handle = (gen << 4) | i;
+    atomic_store_explicit(&v->clip, clip, memory_order_relaxed);
+    v->gain = powf(10.0f, (float)gain_db / 20.0f);
+    v->pos = 0;
+    atomic_store_explicit(&v->stop, 0, memory_order_relaxed);
+    atomic_store_explicit(&v->handle, handle, memory_order_relaxed);
+    atomic_store(&v->state, VOICE_PLAYING);
+    // An unregister that slipped in since the check may have scanned the
+    // voices before this one was playing: stop it here instead
+    if (atomic_load(&c->state) != CLIP_READY) atomic_store_explicit(&v->stop, 1, memory_order_relaxed);
+    return handle;
+  }
+  atomic_fetch_sub_explicit(&c->users, 1, memory_order_release);
+  return -1;
+}
+
+// Fade a voice out over the next render block. Returns 0, or -1 if it has
+// already ended.
+int vpio_clip_stop(int voice) {
+  if (voice <= 0) return -1;
+  Voice* v = &gVoices[voice & (CLIP_VOICES - 1)];
+  if (atomic_load_explicit(&v->state, memory_order_acquire) != VOICE_PLAYING ||
+      atomic_load_explicit(&v->handle, memory_order_relaxed) != voice)
+    return -1;
+  atomic_store_explicit(&v->stop, 1, memory_order_relaxed);
+  return 0;
+}
+
+// Notifier fd for the event queue: readable while events are pending. Made
+// on first use and kept for the life of the process; read it only through
+// vpio_poll_events. Returns -1 if the pipe could not be created.
+int vpio_event_fd(void) {
+  pthread_mutex_lock(&gEventLock);
+  if (gEventRfd < 0) {
+    int fds[2];
+    if (pipe(fds) == 0) {
+      for (int k = 0; k < 2; k++) {
+        fcntl(fds[k], F_SETFL, fcntl(fds[k], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[k], F_SETFD, FD_CLOEXEC);
+      }
+      gEventRfd = fds[0];
+      atomic_store_explicit(&gEventWfd, fds[1], memory_order_release);
+      // Posts before the pipe existed disarmed it without ringing
+      if (!atomic_load(&gEventArmed)) event_ring();
+    }
+  }
+  int fd = gEventRfd;
+  pthread_mutex_unlock(&gEventLock);
+  return fd;
+}
+
+// Take up to max_events queued events, oldest first. If more remain, the fd
+// stays readable.
+size_t vpio_poll_events(vpio_event* out, size_t max_events) {
+  if (!out) return 0;
+  pthread_mutex_lock(&gEventLock);
+  if (gEventRfd >= 0) {
+    char buf[64];
+    while (read(gEventRfd, buf, sizeof(buf)) > 0) {}
+  }
+  atomic_store(&gEventArmed, 1);
+  size_t n = 0;
+  for (;;) {
+    EventSlot* sl = &gEvents[gEventTail % EVENT_SLOTS];
+    size_t lap = gEventTail / EVENT_SLOTS * 2;
+    if (atomic_load(&sl->seq) != lap + 1) break;
+    if (n == max_events) {
+      if (atomic_exchange(&gEventArmed, 0)) event_ring();
+      break;
+    }
+    out[n++] = sl->ev;
+    atomic_store_explicit(&sl->seq, lap + 2, memory_order_release);
+    gEventTail++;
+  }
+  pthread_mutex_unlock(&gEventLock);
+  return n;
+}
+
+int vpio_set_capture_gate(int gate, int keep_echo) {
+  if (gate < VPIO_GATE_OPEN || gate > VPIO_GATE_PAUSE) return -1;
+  atomic_store_explicit(&gCapGateEcho, keep_echo ? 1 : 0, memory_order_relaxed);
+  atomic_store_explicit(&gCapGate, gate, memory_order_release);
+  if (gTrace) fprintf(stderr, "[VPIO-GATE] capture gate %d (echo %d)\n", gate, keep_echo ? 1 : 0);
+  return 0;
+}
+
+int vpio_get_capture_gate(void) {
+  return atomic_load_explicit(&gCapGate, memory_order_acquire);
+}
+
 size_t vpio_get_underflow_count(void) {
   return atomic_load_explicit(&gUnderflowEvents, memory_order_acquire);
 }
@@ -612,64 +2769,74 @@ size_t vpio_reset_capture(void) {
   return 0;
 }
 
+// Blocking one-shot playback: a temporary clip mixed over the stream, so
+// capture keeps running while it plays
 int vpio_play(const void *data, size_t len) {
-  if (!gAudioUnit) return -1;
-  if (gPlay) {
-    free(gPlay);
-    gPlay = NULL;
-    gPlayLen = 0;
-    gPlayOff = 0;
-  }
-  gPlay = (unsigned char *)malloc(len);
-  if (!gPlay) return -1;
-  memcpy(gPlay, data, len);
-  gPlayLen = len;
-  gPlayOff = 0;
-  atomic_store_explicit(&gMode, MODE_PLAY, memory_order_release);
-
-  // Wait until played (approx)
+  if (!gAudioUnit && !gPlay.cap) return -1;
+  int clip = vpio_clip_register(data, len);
+  if (clip < 0) return -1;
+  int voice = vpio_clip_trigger(clip, 0.0);
+  if (voice < 0) { vpio_clip_unregister(clip); return -1; }
+  // Wait until played, with a second of slack in case rendering stalls
   size_t bytesPerSec = (size_t)(gSampleRate * (kBytesPerSample * gChannels));
-  double secs = (double)len / (double)bytesPerSec;
+  double secs = (double)len / (double)bytesPerSec + 1.0;
   double elapsed = 0.0;
-  while (elapsed < secs && gPlayOff < gPlayLen) {
-    usleep(10 * 1000);
-    elapsed += 0.01;
+  Voice* v = &gVoices[voice & (CLIP_VOICES - 1)];
+  while (elapsed < secs && atomic_load_explicit(&v->state, memory_order_acquire) != VOICE_FREE &&
+         atomic_load_explicit(&v->handle, memory_order_relaxed) == voice) {
+    usleep(5 * 1000);
+    elapsed += 0.005;
   }
-  atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
+  // Rendering stalled: end the voice here so the clip is freed below
+  if (atomic_load_explicit(&v->state, memory_order_acquire) == VOICE_PLAYING) {
+    callbacks_hold();
+    if (atomic_load_explicit(&v->state, memory_order_acquire) == VOICE_PLAYING &&
+        atomic_load_explicit(&v->handle, memory_order_relaxed) == voice)
+      voice_end(v, 1);
+    callbacks_release();
+  }
+  vpio_clip_unregister(clip);
   return 0;
 }
 
 void vpio_shutdown(void) {
+  start_join();
+  replay_stop();
+#if defined(__APPLE__)
   if (gAudioUnit) {
     AudioOutputUnitStop(gAudioUnit);
     AudioUnitUninitialize(gAudioUnit);
     AudioComponentInstanceDispose(gAudioUnit);
     gAudioUnit = NULL;
   }
+#endif
+  atomic_store_explicit(&gMode, MODE_IDLE, memory_order_release);
   // Free streaming rings
-  if (gCapRing) { free(gCapRing); gCapRing = NULL; }
-  gCapCap = 0; gCapW = gCapR = 0;
-  if (gPlayRing) { free(gPlayRing); gPlayRing = NULL; }
-  gPlayCap = 0; gPlayW = gPlayR = 0;
-  if (gInRing) { free(gInRing); gInRing = NULL; }
-  gInCap = 0; gInW = gInR = 0;
+  callbacks_hold();
+  vpio_ring_free(&gCap);
+  cap_readers_reset();
+  vpio_ring_free(&gPlay);
+  play_streams_release();
+  vpio_ring_free(&gIn);
   if (gInLockInit) { pthread_mutex_destroy(&gInLock); gInLockInit = 0; }
+  rec_release();
+  echo_release_all();
   if (gInputScratch) { free(gInputScratch); gInputScratch = NULL; gInputScratchCap = 0; }
   if (gCapture) {
     free(gCapture);
     gCapture = NULL;
     gCaptureSize = gCaptureCap = 0;
   }
-  if (gPlay) {
-    free(gPlay);
-    gPlay = NULL;
-    gPlayLen = 0;
-    gPlayOff = 0;
-  }
+  clip_voices_reset();
+  stage_slot_clear(&gAgcSlot[VPIO_DIR_CAPTURE]);
+  stage_slot_clear(&gAgcSlot[VPIO_DIR_PLAYBACK]);
+  callbacks_release();
+  clips_reap();
 }
 
 // Debug helpers
 int vpio_get_bypass(unsigned int* bypass) {
+#if defined(__APPLE__)
   if (!gAudioUnit || !bypass) return -1;
   UInt32 val = 0, sz = sizeof(val);
   OSStatus st = AudioUnitGetProperty(gAudioUnit,
@@ -681,9 +2848,14 @@ int vpio_get_bypass(unsigned int* bypass) {
   if (st != noErr) return (int)st;
   *bypass = (unsigned int)val;
   return 0;
+#else
+  return -1;
+#endif
 }
 
 double vpio_get_in_sample_rate(void) {
+  if (gReplay) return gSampleRate;
+#if defined(__APPLE__)
   if (!gAudioUnit) return 0.0;
   AudioStreamBasicDescription asbd; UInt32 sz = sizeof(asbd);
   OSStatus st = AudioUnitGetProperty(gAudioUnit,
@@ -694,9 +2866,14 @@ double vpio_get_in_sample_rate(void) {
                                      &sz);
   if (st != noErr) return 0.0;
   return asbd.mSampleRate;
+#else
+  return 0.0;
+#endif
 }
 
 double vpio_get_out_sample_rate(void) {
+  if (gReplay) return gSampleRate;
+#if defined(__APPLE__)
   if (!gAudioUnit) return 0.0;
   AudioStreamBasicDescription asbd; UInt32 sz = sizeof(asbd);
   OSStatus st = AudioUnitGetProperty(gAudioUnit,
@@ -707,11 +2884,14 @@ double vpio_get_out_sample_rate(void) {
                                      &sz);
   if (st != noErr) return 0.0;
   return asbd.mSampleRate;
+#else
+  return 0.0;
+#endif
 }
 
 size_t vpio_get_ring_levels(size_t* cap_level, size_t* play_level) {
-  size_t cap = (atomic_load_explicit(&gCapW, memory_order_acquire) - atomic_load_explicit(&gCapR, memory_order_acquire));
-  size_t play = (atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire));
+  size_t cap = cap_backlog(0);
+  size_t play = vpio_ring_level(&gPlay);
   if (cap_level) *cap_level = cap;
   if (play_level) *play_level = play;
   return cap + play;
@@ -719,53 +2899,677 @@ size_t vpio_get_ring_levels(size_t* cap_level, size_t* play_level) {
 
 // Debug: expose staging (input) ring level and capacity
 size_t vpio_get_staging_level(void) {
-  size_t inW = atomic_load_explicit(&gInW, memory_order_acquire);
-  size_t inR = atomic_load_explicit(&gInR, memory_order_acquire);
-  return inW - inR;
+  return staging_level(NULL);
 }
 
 size_t vpio_get_staging_capacity(void) {
-  return gInCap;
+  size_t cap = 0;
+  staging_level(&cap);
+  return cap;
 }
 
 void vpio_debug_dump(void) {
   unsigned int bypass = 0xFFFFFFFF; int r = vpio_get_bypass(&bypass);
   double inSR = vpio_get_in_sample_rate();
   double outSR = vpio_get_out_sample_rate();
-  size_t cap = (atomic_load_explicit(&gCapW, memory_order_acquire) - atomic_load_explicit(&gCapR, memory_order_acquire));
-  size_t play = (atomic_load_explicit(&gPlayW, memory_order_acquire) - atomic_load_explicit(&gPlayR, memory_order_acquire));
+  size_t cap = cap_backlog(0);
+  size_t play = vpio_ring_level(&gPlay);
   fprintf(stderr,
           "[VPIO] mode=%d bypass=%u (rc=%d) inSR=%.2f outSR=%.2f capRing=%zu/%zu playRing=%zu/%zu\n",
-          (int)gMode, bypass, r, inSR, outSR, cap, gCapCap, play, gPlayCap);
+          (int)gMode, bypass, r, inSR, outSR, cap, gCap.cap, play, gPlay.cap);
 }
 
 // New APIs for 10ms input and C-paced 5ms playback
 size_t vpio_write_frame_10ms(const void* data, size_t len) {
-  if (!gInRing || gInCap == 0 || !data || len == 0) return 0;
+  if (!gInLockInit || !data || len == 0) return 0;
   pthread_mutex_lock(&gInLock);
+  if (!gIn.buf) { pthread_mutex_unlock(&gInLock); return 0; }
+  // Bounded mode: refuse past the high watermark (an empty backlog always
+  // takes one write, however large)
+  size_t high = atomic_load_explicit(&gPlayHigh, memory_order_relaxed);
+  if (high) {
+    size_t queued = playback_queued();
+    if (queued && queued + len > high) {
+      atomic_store_explicit(&gPlayBlocked, 1, memory_order_release);
+      pthread_mutex_unlock(&gInLock);
+      return 0;
+    }
+  }
   // Ensure capacity; grow if needed
   if (!ensure_inring_space(len)) { pthread_mutex_unlock(&gInLock); return 0; }
-  size_t inW = atomic_load_explicit(&gInW, memory_order_acquire);
-  size_t widx = inW % gInCap;
-  size_t first = gInCap - widx; if (first > len) first = len;
-  memcpy(gInRing + widx, data, first);
-  if (len > first) memcpy(gInRing, (const unsigned char*)data + first, len - first);
-  atomic_store_explicit(&gInW, inW + len, memory_order_release);
+  Playout* po = &gPlayStreams[0].po;
+  uint64_t w = atomic_load_explicit(&po->written, memory_order_relaxed);
+  if (vpio_ring_level(&gIn) == 0) gPoInR = w;
+  vpio_ring_write(&gIn, data, len);
+  atomic_store_explicit(&po->written, w + len, memory_order_release);
+  ring_high(&gRingMem[VPIO_RING_STAGING].level_high, vpio_ring_level(&gIn));
   pthread_mutex_unlock(&gInLock);
   return len;
 }
 
+int vpio_set_playback_watermarks(size_t high_bytes, size_t low_bytes) {
+  if (high_bytes && low_bytes >= high_bytes) return -1;
+  atomic_store_explicit(&gPlayLow, high_bytes && !low_bytes ? high_bytes / 2 : low_bytes, memory_order_relaxed);
+  atomic_store_explicit(&gPlayHigh, high_bytes, memory_order_relaxed);
+  // Leaving bounded mode releases a waiting writer (the pacer would too)
+  if (!high_bytes && gInLockInit) playback_maybe_writable();
+  return 0;
+}
+
+size_t vpio_get_playback_space(size_t* queued_out) {
+  if (queued_out) *queued_out = 0;
+  if (!gInLockInit) return 0;
+  pthread_mutex_lock(&gInLock);
+  size_t queued = playback_queued();
+  size_t in = vpio_ring_level(&gIn);
+  size_t cap = gIn.cap;
+  pthread_mutex_unlock(&gInLock);
+  if (queued_out) *queued_out = queued;
+  size_t high = atomic_load_explicit(&gPlayHigh, memory_order_relaxed);
+  if (high) return high > queued ? high - queued : 0;
+  // Unbounded: what fits before the staging ring has to grow
+  return cap > in ? cap - in : 0;
+}
+
+int vpio_set_ring_budget(int ring, size_t max_bytes, int shrink_after_ms) {
+  if (ring < 0 || ring >= RING_KINDS) return -1;
+  atomic_store_explicit(&gRingMem[ring].budget, max_bytes, memory_order_relaxed);
+  if (ring == VPIO_RING_STAGING)
+    atomic_store_explicit(&gInShrinkMs, shrink_after_ms > 0 ? shrink_after_ms : 0, memory_order_relaxed);
+  return 0;
+}
+
+size_t vpio_get_ring_memory(int ring, void* out, size_t out_size) {
+  if (ring < 0 || ring >= RING_KINDS || !out || out_size == 0) return 0;
+  RingMem* rm = &gRingMem[ring];
+  vpio_ring_memory m;
+  memset(&m, 0, sizeof(m));
+  if (ring == VPIO_RING_CAPTURE) {
+    m.committed = gCap.cap;
+    m.level = gCap.buf ? cap_backlog(0) : 0;
+  } else if (ring == VPIO_RING_PLAYBACK) {
+    m.committed = gPlay.cap;
+    m.level = vpio_ring_level(&gPlay);
+  } else {
+    size_t cap = 0;
+    m.level = staging_level(&cap);
+    m.committed = cap;
+  }
+  m.committed_high = atomic_load_explicit(&rm->committed_high, memory_order_relaxed);
+  m.level_high = atomic_load_explicit(&rm->level_high, memory_order_relaxed);
+  m.budget = atomic_load_explicit(&rm->budget, memory_order_relaxed);
+  m.grows = atomic_load_explicit(&rm->grows, memory_order_relaxed);
+  m.shrinks = atomic_load_explicit(&rm->shrinks, memory_order_relaxed);
+  m.rejected_bytes = atomic_load_explicit(&rm->rejected, memory_order_relaxed);
+  size_t n = (out_size < sizeof(m)) ? out_size : sizeof(m);
+  memcpy(out, &m, n);
+  return n;
+}
+
+// Configure the capture VAD pre-gate. margin_db is the rise over the adaptive
+// noise floor needed to open, hangover_ms how long it stays open afterwards.
+void vpio_set_vad_gate(int enabled, double margin_db, int hangover_ms, int onset_blocks) {
+  if (margin_db < 1.0) margin_db = 1.0;
+  if (hangover_ms < 0) hangover_ms = 0;
+  if (onset_blocks < 1) onset_blocks = 1;
+  gVadMarginDb = margin_db;
+  gVadHangoverMs = hangover_ms;
+  gVadOnsetBlocks = onset_blocks;
+  if (enabled) atomic_store_explicit(&gVadResetReq, 1, memory_order_release);
+  atomic_store_explicit(&gVadEnabled, enabled ? 1 : 0, memory_order_release);
+}
+
+enum { GATE_CLOSED = 0, GATE_OPEN = 1, GATE_UNKNOWN = -1, GATE_PENDING = -2 };
+
+static int vad_gate_state(size_t byte_pos, size_t len) {
+  if (!atomic_load_explicit(&gVadEnabled, memory_order_acquire) || len == 0) return GATE_UNKNOWN;
+  size_t blocks = atomic_load_explicit(&gVadBlocks, memory_order_acquire);
+  size_t origin = atomic_load_explicit(&gVadOrigin_pub, memory_order_acquire);
+  size_t block_bytes = gVadBlockLen * (size_t)kBytesPerSample * (size_t)gChannels;
+  if (byte_pos < origin || block_bytes == 0) return GATE_UNKNOWN;
+  size_t first = (byte_pos - origin) / block_bytes;
+  size_t last = (byte_pos - origin + len - 1) / block_bytes;
+  if (last >= blocks) return GATE_PENDING; // tail block still filling
+  if (blocks - first > VAD_HIST_BLOCKS) return GATE_UNKNOWN;
+  for (size_t b = first; b <= last; b++) {
+    if (atomic_load_explicit(&gVadFlags[b % VAD_HIST_BLOCKS], memory_order_relaxed) & VAD_FLAG_OPEN) return GATE_OPEN;
+  }
+  return GATE_CLOSED;
+}
+
+// Query the gate for capture bytes [byte_pos, byte_pos+len): 1 if any block
+// overlapping the range is open, 0 if all are closed, -1 if unknown (gate
+// disabled, not yet analyzed, or too old).
+int vpio_vad_gate_query(size_t byte_pos, size_t len) {
+  int st = vad_gate_state(byte_pos, len);
+  return st == GATE_PENDING ? GATE_UNKNOWN : st;
+}
+
+// Discontinuous transmission: whole capture frames the gate marks closed are
+// consumed but not returned; the caller gets their length as a silence count
+// instead, plus one real frame every keepalive interval.
+static _Atomic int gDtxEnabled = 0;
+static int gDtxKeepaliveMs = 1000;            // under gCapFrameLock
+static _Atomic size_t gDtxFramesSent = 0;
+static _Atomic size_t gDtxFramesSuppressed = 0;
+// Held around framed reads, so the setters below can reset the readers' DTX
+// state while a poll thread is cutting frames
+static pthread_mutex_t gCapFrameLock = PTHREAD_MUTEX_INITIALIZER;
+
+void vpio_set_dtx(int enabled, int keepalive_ms) {
+  if (keepalive_ms < 0) keepalive_ms = 0;
+  pthread_mutex_lock(&gCapFrameLock);
+  gDtxKeepaliveMs = keepalive_ms;
+  for (int i = 0; i < CAP_READERS; i++) gCapReaders[i].dtx_since_sent = 0;
+  atomic_store_explicit(&gDtxEnabled, enabled ? 1 : 0, memory_order_release);
+  pthread_mutex_unlock(&gCapFrameLock);
+}
+
+// Configure engine-side capture framing (frame duration in ms, 0 = off).
+// Returns the frame size in bytes.
+size_t vpio_set_capture_frame_ms(int ms) {
+  size_t fb = (ms > 0) ? (size_t)ms * bytes_per_ms() : 0;
+  pthread_mutex_lock(&gCapFrameLock);
+  for (int i = 0; i < CAP_READERS; i++) gCapReaders[i].pending_silent = 0;
+  atomic_store_explicit(&gCapFrameBytes, fb, memory_order_release);
+  pthread_mutex_unlock(&gCapFrameLock);
+  return fb;
+}
+
+// Read the next whole capture frame into dst and describe it in *info.
+// Returns the frame size in bytes, or 0 if no complete frame is available.
+// With DTX enabled, gated-off frames are consumed here and reported through
+// info->silence_before on the next returned frame. Only reader 0 counts
+// towards the DTX stats. Caller holds gCapFrameLock.
+static size_t cap_reader_read_frame(CapReader* rd, void* dst, size_t maxlen, vpio_frame_info* info) {
+  size_t fb = atomic_load_explicit(&gCapFrameBytes, memory_order_acquire);
+  if (gReplay) atomic_store_explicit(&gReplayArmed, 1, memory_order_release);
+  if (!gCap.buf || !dst || fb == 0 || maxlen < fb) return 0;
+  int primary = (rd == &gCapReaders[0]);
+  int dtx = atomic_load_explicit(&gDtxEnabled, memory_order_acquire);
+  size_t keepalive_bytes = (size_t)gDtxKeepaliveMs * bytes_per_ms();
+  size_t bps = (size_t)kBytesPerSample * (size_t)gChannels;
+  size_t capR = atomic_load_explicit(&rd->r, memory_order_relaxed);
+  size_t got = 0;
+  for (;;) {
+    capR = cap_catch_up(rd, capR);
+    // Realign to the frame grid after an overrun moved the read index; the
+    // partial frame skipped is lost with the rest
+    if (capR % fb) {
+      size_t skip = fb - (capR % fb);
+      atomic_fetch_add_explicit(&rd->dropped, (uint64_t)skip, memory_order_relaxed);
+      rd->lost = 1;
+      capR += skip;
+    }
+    size_t capW = vpio_ring_published(&gCap);
+    if (capW < capR || capW - capR < fb) break;
+    uint32_t flags = 0;
+    int st = vad_gate_state(capR, fb);
+    if (st == GATE_PENDING && dtx) break; // wait until the frame's last block is classified
+    if (dtx && st == GATE_CLOSED) {
+      if (keepalive_bytes == 0 || rd->dtx_since_sent + fb < keepalive_bytes) {
+        capR += fb;
+        rd->pending_silent += fb;
+        rd->dtx_since_sent += fb;
+        if (primary) atomic_fetch_add_explicit(&gDtxFramesSuppressed, 1, memory_order_relaxed);
+        continue;
+      }
+      flags |= VPIO_FRAME_KEEPALIVE;
+    }
+    if (!vpio_ring_get_intact(&gCap, capR, dst, fb)) continue; // lapped mid-copy: catch up and retry
+    if (st == GATE_OPEN || st == GATE_CLOSED) flags |= VPIO_FRAME_VAD_KNOWN;
+    if (st == GATE_OPEN) flags |= VPIO_FRAME_VAD_OPEN;
+    if (rd->lost) flags |= VPIO_FRAME_OVERRUN;
+    if (info) {
+      size_t seq = capR / fb;
+      info->seq = seq;
+      info->sample_index = capR / bps;
+      info->host_time_ns = cap_frame_host_time(seq);
+      info->flags = flags;
+      info->silence_before = (uint32_t)(rd->pending_silent / bps);
+    }
+    rd->lost = 0;
+    rd->pending_silent = 0;
+    rd->dtx_since_sent = 0;
+    if (primary) atomic_fetch_add_explicit(&gDtxFramesSent, 1, memory_order_relaxed);
+    capR += fb;
+    got = fb;
+    break;
+  }
+  atomic_store_explicit(&rd->r, capR, memory_order_release);
+  return got;
+}
+
+size_t vpio_read_frame(void* dst, size_t maxlen, vpio_frame_info* info) {
+  pthread_mutex_lock(&gCapFrameLock);
+  size_t got = cap_reader_read_frame(&gCapReaders[0], dst, maxlen, info);
+  pthread_mutex_unlock(&gCapFrameLock);
+  return got;
+}
+
+// Batched read: up to max_frames whole frames into dst (frame_bytes each,
+// which must match the configured frame size) with one vpio_frame_info per
+// frame in meta_out. Returns the number of frames read. One FFI crossing per
+// poll instead of one per frame.
+static size_t cap_reader_read_frames(CapReader* rd, void* dst, size_t max_frames, size_t frame_bytes,
+                                     vpio_frame_info* meta_out) {
+  size_t fb = atomic_load_explicit(&gCapFrameBytes, memory_order_acquire);
+  if (!rd || !dst || !meta_out || fb == 0 || frame_bytes != fb) return 0;
+  size_t n = 0;
+  pthread_mutex_lock(&gCapFrameLock);
+  while (n < max_frames) {
+    if (!cap_reader_read_frame(rd, (unsigned char*)dst + n * fb, fb, &meta_out[n])) break;
+    n++;
+  }
+  pthread_mutex_unlock(&gCapFrameLock);
+  return n;
+}
+
+size_t vpio_read_frames(void* dst, size_t max_frames, size_t frame_bytes, vpio_frame_info* meta_out) {
+  return cap_reader_read_frames(&gCapReaders[0], dst, max_frames, frame_bytes, meta_out);
+}
+
+// Open an extra capture reader positioned at the newest capture byte.
+// Returns its id (1..CAP_READERS-1), or -1 if all are taken.
+int vpio_capture_reader_open(void) {
+  for (int i = 1; i < CAP_READERS; i++) {
+    CapReader* rd = &gCapReaders[i];
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&rd->open, &expected, -1)) continue;
+    atomic_store_explicit(&rd->r, vpio_ring_published(&gCap), memory_order_relaxed);
+    rd->lost = 0;
+    rd->pending_silent = 0;
+    rd->dtx_since_sent = 0;
+    atomic_store_explicit(&rd->overruns, 0, memory_order_relaxed);
+    atomic_store_explicit(&rd->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&rd->open, 1, memory_order_release);
+    return i;
+  }
+  return -1;
+}
+
+void vpio_capture_reader_close(int reader) {
+  if (reader <= 0 || reader >= CAP_READERS) return;
+  atomic_store_explicit(&gCapReaders[reader].open, 0, memory_order_release);
+}
+
+size_t vpio_capture_reader_read(int reader, void* dst, size_t maxlen, size_t* pos_out) {
+  CapReader* rd = cap_reader(reader);
+  if (!rd || !dst) return 0;
+  return cap_reader_read(rd, dst, maxlen, pos_out);
+}
+
+size_t vpio_capture_reader_read_frames(int reader, void* dst, size_t max_frames, size_t frame_bytes,
+                                       vpio_frame_info* meta_out) {
+  return cap_reader_read_frames(cap_reader(reader), dst, max_frames, frame_bytes, meta_out);
+}
+
+// Zero-copy read: point at up to maxlen unread bytes in the ring (split in
+// two spans at the wrap) without consuming them. Returns the total length.
+size_t vpio_capture_reader_peek(int reader, size_t maxlen, const void** p1, size_t* n1, const void** p2,
+                                size_t* n2, size_t* pos_out) {
+  CapReader* rd = cap_reader(reader);
+  if (p1) *p1 = NULL;
+  if (n1) *n1 = 0;
+  if (p2) *p2 = NULL;
+  if (n2) *n2 = 0;
+  if (!rd || !gCap.buf || !p1 || !n1 || !p2 || !n2) return 0;
+  if (gReplay) atomic_store_explicit(&gReplayArmed, 1, memory_order_release);
+  size_t r = cap_catch_up(rd, atomic_load_explicit(&rd->r, memory_order_relaxed));
+  atomic_store_explicit(&rd->r, r, memory_order_release);
+  if (pos_out) *pos_out = r;
+  size_t avail = vpio_ring_published(&gCap) - r;
+  size_t n = (avail < maxlen) ? avail : maxlen;
+  if (n == 0) return 0;
+  size_t first;
+  *p1 = vpio_ring_span(&gCap, r, n, &first); *n1 = first;
+  if (n > first) { *p2 = gCap.buf; *n2 = n - first; }
+  return n;
+}
+
+// Finish a peek: consume n bytes. Returns 0, or -1 if the writer lapped the
+// reader since the peek (the reader is moved past the lost bytes).
+int vpio_capture_reader_consume(int reader, size_t n) {
+  CapReader* rd = cap_reader(reader);
+  if (!rd || gCap.cap == 0) return -1;
+  size_t r = atomic_load_explicit(&rd->r, memory_order_relaxed);
+  if (!vpio_ring_intact(&gCap, r)) {
+    atomic_store_explicit(&rd->r, cap_catch_up(rd, r), memory_order_release);
+    return -1;
+  }
+  size_t avail = vpio_ring_published(&gCap) - r;
+  if (n > avail) n = avail;
+  atomic_store_explicit(&rd->r, r + n, memory_order_release);
+  return 0;
+}
+
+// Overrun counters and backlog of a reader (0 = the default one).
+// Returns 0, or -1 if the reader is not open.
+int vpio_capture_reader_stats(int reader, uint64_t* overruns, uint64_t* dropped_bytes, size_t* level) {
+  CapReader* rd = cap_reader(reader);
+  if (!rd) return -1;
+  if (overruns) *overruns = atomic_load_explicit(&rd->overruns, memory_order_relaxed);
+  if (dropped_bytes) *dropped_bytes = atomic_load_explicit(&rd->dropped, memory_order_relaxed);
+  if (level) *level = gCap.buf ? cap_backlog(reader) : 0;
+  return 0;
+}
+
+// Host clock "now" in the same units as vpio_frame_info.host_time_ns
+uint64_t vpio_host_time_now_ns(void) {
+#if defined(__APPLE__)
+  if (gTimebase.denom == 0) mach_timebase_info(&gTimebase);
+  return host_ticks_to_ns(mach_absolute_time());
+#else
+  struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void vpio_get_dtx_stats(size_t* frames_sent, size_t* frames_suppressed) {
+  if (frames_sent) *frames_sent = atomic_load_explicit(&gDtxFramesSent, memory_order_acquire);
+  if (frames_suppressed) *frames_suppressed = atomic_load_explicit(&gDtxFramesSuppressed, memory_order_acquire);
+}
+
+void vpio_get_vad_stats(size_t* blocks_total, size_t* blocks_open) {
+  if (blocks_total) *blocks_total = atomic_load_explicit(&gVadBlocks, memory_order_acquire);
+  if (blocks_open) *blocks_open = atomic_load_explicit(&gVadOpenBlocks, memory_order_acquire);
+}
+
+// All debug counters in one call (vpio_stats in vpio.h)
+size_t vpio_get_stats(void* out, size_t out_size) {
+  if (!out || out_size == 0) return 0;
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  size_t cap = 0, play = 0;
+  vpio_get_ring_levels(&cap, &play);
+  st.cap_level = cap; st.cap_capacity = gCap.cap;
+  st.play_level = play; st.play_capacity = gPlay.cap;
+  size_t stage_cap = 0;
+  st.staging_level = staging_level(&stage_cap); st.staging_capacity = stage_cap;
+  st.underflows = atomic_load_explicit(&gUnderflowEvents, memory_order_acquire);
+  st.render_last_bytes = atomic_load_explicit(&gRenderLastBytes, memory_order_acquire);
+  st.render_max_bytes = atomic_load_explicit(&gRenderMaxBytes, memory_order_acquire);
+  st.vad_blocks = atomic_load_explicit(&gVadBlocks, memory_order_acquire);
+  st.vad_open_blocks = atomic_load_explicit(&gVadOpenBlocks, memory_order_acquire);
+  st.dtx_frames_sent = atomic_load_explicit(&gDtxFramesSent, memory_order_acquire);
+  st.dtx_frames_suppressed = atomic_load_explicit(&gDtxFramesSuppressed, memory_order_acquire);
+  st.aec_blocks = atomic_load_explicit(&gAecBlocks, memory_order_acquire);
+  st.aec_erle_db = (double)atomic_load_explicit(&gAecErleCdb, memory_order_acquire) / 100.0;
+  st.delay_blocks = atomic_load_explicit(&gDelayBlocks, memory_order_acquire);
+  vpio_get_delay_estimate(&st.delay_ms, &st.delay_confidence);
+  st.aec_delay_ms = (double)atomic_load_explicit(&gAecDelaySamples, memory_order_relaxed) * 1000.0 / gSampleRate;
+  st.ns_blocks = atomic_load_explicit(&gNsBlocks, memory_order_acquire);
+  st.ns_over_budget = atomic_load_explicit(&gNsOverBudget, memory_order_acquire);
+  st.ns_max_block_us = (double)atomic_load_explicit(&gNsMaxBlockNs, memory_order_relaxed) / 1000.0;
+  st.ns_noise_dbfs = (double)atomic_load_explicit(&gNsNoiseCdb, memory_order_relaxed) / 100.0;
+  st.agc_capture_gain_db = (double)atomic_load_explicit(&gAgcGainCdb[VPIO_DIR_CAPTURE], memory_order_relaxed) / 100.0;
+  st.agc_capture_limit_db = (double)atomic_load_explicit(&gAgcLimitCdb[VPIO_DIR_CAPTURE], memory_order_relaxed) / 100.0;
+  st.agc_playback_gain_db = (double)atomic_load_explicit(&gAgcGainCdb[VPIO_DIR_PLAYBACK], memory_order_relaxed) / 100.0;
+  st.agc_playback_limit_db = (double)atomic_load_explicit(&gAgcLimitCdb[VPIO_DIR_PLAYBACK], memory_order_relaxed) / 100.0;
+  st.rec_bytes = atomic_load_explicit(&gRecBytes, memory_order_relaxed);
+  st.rec_dropped = atomic_load_explicit(&gRecDropped, memory_order_relaxed);
+  st.replay_frames = atomic_load_explicit(&gReplayFrames, memory_order_acquire);
+  st.replay_eof = (uint64_t)atomic_load_explicit(&gReplayEof, memory_order_acquire);
+  st.cap_overruns = atomic_load_explicit(&gCapReaders[0].overruns, memory_order_relaxed);
+  st.cap_overrun_bytes = atomic_load_explicit(&gCapReaders[0].dropped, memory_order_relaxed);
+  for (int i = 0; i < CLIP_VOICES; i++)
+    st.clip_voices += atomic_load_explicit(&gVoices[i].state, memory_order_relaxed) != VOICE_FREE;
+  st.events_dropped = atomic_load_explicit(&gEventsDropped, memory_order_relaxed);
+  st.play_overruns = atomic_load_explicit(&gPlayOverruns, memory_order_relaxed);
+  st.play_overrun_bytes = atomic_load_explicit(&gPlayOverrunBytes, memory_order_relaxed);
+  st.playout_breaks_lost = atomic_load_explicit(&gPoBreaksLost, memory_order_relaxed);
+  size_t n = (out_size < sizeof(st)) ? out_size : sizeof(st);
+  memcpy(out, &st, n);
+  return n;
+}
+
+// Capability bitmask so bindings don't have to probe for symbols
+uint32_t vpio_get_capabilities(void) {
+  return VPIO_CAP_STREAM | VPIO_CAP_PLAY_THREAD | VPIO_CAP_FLUSH | VPIO_CAP_DEBUG |
+         VPIO_CAP_VAD_GATE | VPIO_CAP_FRAMES | VPIO_CAP_DTX | VPIO_CAP_STATS |
+         VPIO_CAP_AEC | VPIO_CAP_DELAY_EST | VPIO_CAP_NS | VPIO_CAP_AGC |
+         VPIO_CAP_LEVELS | VPIO_CAP_RECORDER | VPIO_CAP_REPLAY | VPIO_CAP_REMOTE |
+         VPIO_CAP_READERS | VPIO_CAP_MIXER | VPIO_CAP_CLIPS | VPIO_CAP_EVENTS |
+         VPIO_CAP_ASYNC_START | VPIO_CAP_CAPTURE_GATE | VPIO_CAP_RING_BUDGET |
+         VPIO_CAP_BACKPRESSURE | VPIO_CAP_PLAYOUT;
+}
+
+// Enable the software echo canceller. tail_ms is the echo path length the
+// filter covers, delay_ms bulk delay applied to the reference before the
+// filter; -1 follows the delay estimator (enabling it). Call after
+// vpio_start_stream. Returns 0, or -1 if the filter could not be allocated.
+int vpio_set_aec(int enabled, int tail_ms, int delay_ms) {
+  if (!enabled) {
+    atomic_store_explicit(&gAecEnabled, 0, memory_order_release);
+    return 0;
+  }
+  if (!gRef.buf) return -1;
+  if (tail_ms < 16) tail_ms = 16;
+  if (tail_ms > 500) tail_ms = 500;
+  int auto_delay = delay_ms < 0;
+  if (delay_ms < 0) delay_ms = 0;
+  if (delay_ms > AEC_MAX_DELAY_MS) delay_ms = AEC_MAX_DELAY_MS;
+  if (auto_delay && !atomic_load_explicit(&gDelayEnabled, memory_order_acquire)) vpio_set_delay_estimator(1, 0);
+  size_t block = dsp_block_size();
+  size_t tail = (size_t)((double)tail_ms * gSampleRate / 1000.0);
+  int parts = (int)((tail + block - 1) / block);
+  AecRuntime* rt = aec_runtime_create(block, parts);
+  if (!rt) return -1;
+  stage_slot_publish(&gAecSlot, rt);
+  atomic_store_explicit(&gAecDelaySamples, (size_t)((double)delay_ms * gSampleRate / 1000.0), memory_order_relaxed);
+  atomic_store_explicit(&gAecAutoDelay, auto_delay, memory_order_relaxed);
+  atomic_store_explicit(&gAecEnabled, 1, memory_order_release);
+  if (gTrace) fprintf(stderr, "[VPIO-AEC] enabled block=%zu parts=%d delay=%s%dms\n", block, parts, auto_delay ? "auto/" : "", delay_ms);
+  return 0;
+}
+
+// Enable the capture noise suppressor. max_atten_db bounds how far noise is
+// pulled down; budget_pct is the per-block CPU budget as a percentage of the
+// block duration (0 = unbounded). Call after vpio_start_stream.
+int vpio_set_noise_suppressor(int enabled, double max_atten_db, int budget_pct) {
+  if (!enabled) {
+    atomic_store_explicit(&gNsEnabled, 0, memory_order_release);
+    return 0;
+  }
+  if (!gCap.buf) return -1;
+  if (max_atten_db < 0.0) max_atten_db = 0.0;
+  if (max_atten_db > 40.0) max_atten_db = 40.0;
+  if (budget_pct < 0) budget_pct = 0;
+  size_t block = dsp_block_size();
+  NsRuntime* rt = (NsRuntime*)calloc(1, sizeof(*rt));
+  if (!rt) return -1;
+  rt->ns = vpio_ns_create((int)block, gSampleRate, max_atten_db);
+  if (!rt->ns || block_fifo_init(&rt->fifo, block) != 0) { ns_runtime_free(rt); return -1; }
+  stage_slot_publish(&gNsSlot, rt);
+  double block_ns = (double)block * 1e9 / gSampleRate;
+  atomic_store_explicit(&gNsBudgetNs, (uint64_t)(block_ns * budget_pct / 100.0), memory_order_relaxed);
+  atomic_store_explicit(&gNsMaxBlockNs, 0, memory_order_relaxed);
+  atomic_store_explicit(&gNsEnabled, 1, memory_order_release);
+  if (gTrace) fprintf(stderr, "[VPIO-NS] enabled block=%zu atten=%.1fdB budget=%d%%\n", block, max_atten_db, budget_pct);
+  return 0;
+}
+
+// Configure the gain stage of one direction (VPIO_DIR_*). target_dbfs is the
+// speech RMS level the AGC steers to, max_gain_db how far it may boost;
+// target_dbfs >= 0 leaves only the limiter. ceiling_dbfs is the limiter's
+// peak ceiling.
+int vpio_set_agc(int direction, int enabled, double target_dbfs, double max_gain_db, double ceiling_dbfs) {
+  if (direction != VPIO_DIR_CAPTURE && direction != VPIO_DIR_PLAYBACK) return -1;
+  if (!enabled) {
+    atomic_store_explicit(&gAgcEnabled[direction], 0, memory_order_release);
+    return 0;
+  }
+  if (max_gain_db < 0.0) max_gain_db = 0.0;
+  if (max_gain_db > 40.0) max_gain_db = 40.0;
+  if (ceiling_dbfs > 0.0) ceiling_dbfs = 0.0;
+  if (ceiling_dbfs < -20.0) ceiling_dbfs = -20.0;
+  vpio_agc* a = (vpio_agc*)malloc(sizeof(vpio_agc));
+  if (!a) return -1;
+  vpio_agc_configure(a, gSampleRate, target_dbfs < 0.0, target_dbfs, max_gain_db, ceiling_dbfs);
+  stage_slot_publish(&gAgcSlot[direction], a);
+  atomic_store_explicit(&gAgcEnabled[direction], 1, memory_order_release);
+  return 0;
+}
+
+// Copy up to max_entries of the most recent 10ms level blocks of `direction`
+// into out, oldest first. Never blocks the audio callbacks; entries being
+// rewritten while copied are skipped. Returns the number of entries written.
+size_t vpio_get_levels(int direction, vpio_level* out, size_t max_entries) {
+  if (direction != VPIO_DIR_CAPTURE && direction != VPIO_DIR_PLAYBACK) return 0;
+  if (!out || max_entries == 0) return 0;
+  if (max_entries > LEVEL_HIST) max_entries = LEVEL_HIST;
+  uint64_t w = atomic_load_explicit(&gLevelBlocks[direction], memory_order_acquire);
+  uint64_t b = (w > max_entries) ? w - max_entries : 0;
+  size_t n = 0;
+  for (; b < w; b++) {
+    LevelSlot* slot = &gLevelHist[direction][b % LEVEL_HIST];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != b + 1) continue;
+    vpio_level l;
+    l.seq = b;
+    l.rms = atomic_load_explicit(&slot->rms, memory_order_relaxed);
+    l.peak = atomic_load_explicit(&slot->peak, memory_order_relaxed);
+    l.clipped = atomic_load_explicit(&slot->clipped, memory_order_relaxed);
+    l.samples = atomic_load_explicit(&slot->samples, memory_order_relaxed);
+    VPIO_SEQ_FENCE(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, VPIO_SEQ_ORDER(memory_order_relaxed)) != b + 1) continue;
+    out[n++] = l;
+  }
+  return n;
+}
+
+// Use the file replay backend instead of the audio device from the next
+// vpio_start_stream on. Capture is read from capture_path (a WAV matching
+// the stream format, or raw 16-bit PCM); playback is written to
+// playback_path (WAV if it ends in .wav, else raw; NULL discards it).
+// Callback sizes cycle through pattern[0..pattern_len) frames (NULL = 10ms).
+// realtime=0 runs as fast as the capture reader keeps up. A NULL
+// capture_path switches back to the device. Returns 0, or -1 while a stream
+// is running or on bad arguments.
+int vpio_set_replay(const char* capture_path, const char* playback_path, int realtime,
+                    const uint32_t* pattern, size_t pattern_len) {
+  if (gCap.buf) return -1;
+  if (!capture_path) { gReplay = 0; return 0; }
+  if (strlen(capture_path) >= sizeof(gReplayInPath)) return -1;
+  if (playback_path && strlen(playback_path) >= sizeof(gReplayOutPath)) return -1;
+  if (pattern_len > REPLAY_MAX_PATTERN) return -1;
+  for (size_t i = 0; pattern && i < pattern_len; i++)
+    if (pattern[i] == 0 || pattern[i] > REPLAY_MAX_FRAMES) return -1;
+  snprintf(gReplayInPath, sizeof(gReplayInPath), "%s", capture_path);
+  snprintf(gReplayOutPath, sizeof(gReplayOutPath), "%s", playback_path ? playback_path : "");
+  gReplayRealtime = realtime ? 1 : 0;
+  if (pattern && pattern_len) {
+    memcpy(gReplayPattern, pattern, sizeof(uint32_t) * pattern_len);
+    gReplayPatternLen = pattern_len;
+  } else {
+    gReplayPatternLen = 0; // 10ms at the stream rate, filled in below
+  }
+  gReplay = 1;
+  return 0;
+}
+
+// Record the taps selected by `taps` (VPIO_REC_TAP_* bits) until
+// vpio_stop_recording or the stream stops. VPIO_REC_WAV writes
+// <prefix>-mic-raw.wav, <prefix>-capture.wav and <prefix>-playback.wav;
+// VPIO_REC_FRAMED writes <prefix>.vprec (layout in vpio.h). Call after
+// vpio_start_stream. Returns 0, or -1 if a file or buffer couldn't be set up.
+int vpio_start_recording(const char* path_prefix, int format, unsigned int taps) {
+  static const char* kTapNames[REC_TAPS] = {"mic-raw", "capture", "playback"};
+  taps &= (1u << REC_TAPS) - 1;
+  if (!path_prefix || !taps || !gCap.buf) return -1;
+  if (format != VPIO_REC_WAV && format != VPIO_REC_FRAMED) return -1;
+  vpio_stop_recording();
+  // Two seconds of audio plus room for block headers at small callback sizes
+  size_t ring_bytes = (size_t)(gSampleRate * REC_RING_SECS) * (size_t)kBytesPerSample * (size_t)gChannels * 2;
+  char path[1024];
+  gRecFormat = format;
+  if (format == VPIO_REC_FRAMED) {
+    snprintf(path, sizeof(path), "%s.vprec", path_prefix);
+    gRecFile = rec_open(path);
+    if (!gRecFile) return -1;
+    vpio_rec_file_header h = { {'V', 'P', 'R', 'C'}, 1, (uint32_t)gSampleRate, (uint16_t)gChannels, (uint16_t)taps };
+    rec_write(gRecFile, &h, sizeof(h));
+  }
+  for (int k = 0; k < REC_TAPS; k++) {
+    RecTap* t = &gRecTaps[k];
+    if (!(taps & (1u << k))) continue;
+    if (!t->q.buf && vpio_ring_alloc(&t->q, ring_bytes) != 0) { rec_close_files(); return -1; }
+    vpio_ring_flush(&t->q);
+    t->next_index = UINT64_MAX;
+    t->frames_written = 0;
+    if (format == VPIO_REC_WAV) {
+      snprintf(path, sizeof(path), "%s-%s.wav", path_prefix, kTapNames[k]);
+      t->f = rec_open(path);
+      if (!t->f) { rec_close_files(); return -1; }
+      rec_wav_header(t->f, 0);
+    }
+  }
+  atomic_store_explicit(&gRecBytes, 0, memory_order_relaxed);
+  atomic_store_explicit(&gRecDropped, 0, memory_order_relaxed);
+  atomic_store_explicit(&gRecRun, 1, memory_order_release);
+  if (pthread_create(&gRecThread, NULL, rec_thread_fn, NULL) != 0) {
+    atomic_store_explicit(&gRecRun, 0, memory_order_release);
+    rec_close_files();
+    return -1;
+  }
+  for (int k = 0; k < REC_TAPS; k++)
+    if (taps & (1u << k)) atomic_store_explicit(&gRecTaps[k].on, 1, memory_order_release);
+  if (gTrace) fprintf(stderr, "[VPIO-REC] recording taps=0x%x to %s (%s)\n", taps, path_prefix,
+                      format == VPIO_REC_FRAMED ? "framed" : "wav");
+  return 0;
+}
+
+// Stop recording: the writer drains what was queued, then the files are
+// finalized. Safe to call when not recording.
+void vpio_stop_recording(void) {
+  for (int k = 0; k < REC_TAPS; k++) atomic_store_explicit(&gRecTaps[k].on, 0, memory_order_release);
+  if (!atomic_exchange_explicit(&gRecRun, 0, memory_order_acq_rel)) return;
+  pthread_join(gRecThread, NULL);
+  rec_close_files();
+  if (gTrace) fprintf(stderr, "[VPIO-REC] stopped bytes=%llu dropped=%llu\n",
+                      (unsigned long long)atomic_load_explicit(&gRecBytes, memory_order_relaxed),
+                      (unsigned long long)atomic_load_explicit(&gRecDropped, memory_order_relaxed));
+}
+
+// Run the render/capture delay estimator. max_delay_ms bounds the search
+// (0 = the full ~1s history). Call after vpio_start_stream.
+int vpio_set_delay_estimator(int enabled, int max_delay_ms) {
+  if (!enabled) {
+    atomic_store_explicit(&gDelayEnabled, 0, memory_order_release);
+    return 0;
+  }
+  if (!gRef.buf || gDeBlock == 0) return -1;
+  int lags = DE_LAGS;
+  if (max_delay_ms > 0) {
+    lags = (int)((double)max_delay_ms * gSampleRate / 1000.0 / (double)gDeBlock) + 1;
+    if (lags > DE_LAGS) lags = DE_LAGS;
+  }
+  atomic_store_explicit(&gDelayMaxLags, lags, memory_order_relaxed);
+  atomic_store_explicit(&gDelayResetReq, 1, memory_order_release);
+  atomic_store_explicit(&gDelayEnabled, 1, memory_order_release);
+  return 0;
+}
+
+// Current echo delay estimate (render -> capture) in ms and its confidence
+// (0..1). Returns 1 if an estimate exists, 0 otherwise.
+int vpio_get_delay_estimate(double* delay_ms, double* confidence) {
+  int est = atomic_load_explicit(&gDelayEstSamples, memory_order_acquire);
+  int conf = atomic_load_explicit(&gDelayConfPermille, memory_order_acquire);
+  if (delay_ms) *delay_ms = (est >= 0) ? (double)est * 1000.0 / gSampleRate : -1.0;
+  if (confidence) *confidence = (double)conf / 1000.0;
+  return est >= 0;
+}
+
 void vpio_set_target_headroom_ms(int ms) {
   if (ms < 0) ms = 0;
-  gHeadroomMs = ms;
+  atomic_store_explicit(&gHeadroomMs, ms, memory_order_relaxed);
 }
 
 int vpio_start_playback_thread(int slice_ms, int preroll_ms) {
   if (slice_ms <= 0) slice_ms = 5;
   if (preroll_ms < 0) preroll_ms = 0;
-  gSliceMs = slice_ms;
-  gPrerollMs = preroll_ms;
-  gDidPreroll = 0;
+  // A running pacer picks these up on its next iteration
+  atomic_store_explicit(&gSliceMs, slice_ms, memory_order_relaxed);
+  atomic_store_explicit(&gPrerollMs, preroll_ms, memory_order_relaxed);
   if (atomic_load_explicit(&gPlayThreadRun, memory_order_acquire)) return 0; // already running
   atomic_store_explicit(&gPlayThreadRun, 1, memory_order_release);
   int rc = pthread_create(&gPlayThread, NULL, playback_thread_fn, NULL);
@@ -782,5 +3586,211 @@ void vpio_stop_playback_thread(void) {
   // wake the thread if sleeping
   usleep(1000);
   pthread_join(gPlayThread, NULL);
-  gDidPreroll = 0;
+}
+
+// ---- Out-of-process engine client ----
+// The engine runs in vpiod (vpio_daemon.c). These only touch the mapped
+// segment, never the local engine state above.
+
+static _Atomic(vpio_shm_header*) gRemote = NULL;
+static size_t gRemoteSize = 0;
+static pthread_mutex_t gRemoteLock = PTHREAD_MUTEX_INITIALIZER; // one mailbox user at a time
+// Ring and stats calls run without gRemoteLock (a mailbox call can hold it
+// for seconds) and count themselves in here instead; detach clears gRemote,
+// then waits for the count to drain before unmapping. Both sides store then
+// load, so both are seq_cst.
+static _Atomic int gRemoteUsers = 0;
+
+static vpio_shm_header* remote_enter(void) {
+  atomic_fetch_add_explicit(&gRemoteUsers, 1, memory_order_seq_cst);
+  vpio_shm_header* h = atomic_load_explicit(&gRemote, memory_order_seq_cst);
+  if (!h) atomic_fetch_sub_explicit(&gRemoteUsers, 1, memory_order_release);
+  return h;
+}
+
+static void remote_leave(void) {
+  atomic_fetch_sub_explicit(&gRemoteUsers, 1, memory_order_release);
+}
+
+static vpio_shm_header* remote_map(const char* name, size_t* size_out) {
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void* p = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(vpio_shm_header))
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return NULL;
+  *size_out = (size_t)st.st_size;
+  return (vpio_shm_header*)p;
+}
+
+// Map the segment vpiod created under shm_name, waiting up to timeout_ms for
+// the engine to come up. The name is unlinked once mapped. Returns 0, or -1
+// on timeout, a version mismatch or an engine that failed to start.
+int vpio_remote_attach(const char* shm_name, int timeout_ms) {
+  if (atomic_load_explicit(&gRemote, memory_order_acquire) || !shm_name) return -1;
+  uint64_t deadline = vpio_host_time_now_ns() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) * 1000000ull;
+  for (;;) {
+    size_t size = 0;
+    vpio_shm_header* h = remote_map(shm_name, &size);
+    if (h && atomic_load_explicit(&h->magic, memory_order_acquire) == VPIO_SHM_MAGIC) {
+      shm_unlink(shm_name);
+      if (h->version != VPIO_SHM_VERSION || h->status != 0) {
+        if (gTrace) fprintf(stderr, "[VPIO-REMOTE] %s: version %u status %d\n", shm_name, h->version, h->status);
+        munmap(h, size);
+        return -1;
+      }
+      pthread_mutex_lock(&gRemoteLock);
+      gRemoteSize = size;
+      atomic_store_explicit(&gRemote, h, memory_order_seq_cst);
+      pthread_mutex_unlock(&gRemoteLock);
+      return 0;
+    }
+    if (h) munmap(h, size);
+    if (vpio_host_time_now_ns() >= deadline) return -1;
+    usleep(5000);
+  }
+}
+
+void vpio_remote_detach(void) {
+  pthread_mutex_lock(&gRemoteLock);
+  vpio_shm_header* h = atomic_exchange_explicit(&gRemote, NULL, memory_order_seq_cst);
+  // Calls that saw the mapping finish with it first; new ones see NULL
+  while (atomic_load_explicit(&gRemoteUsers, memory_order_seq_cst) != 0) usleep(100);
+  if (h) munmap(h, gRemoteSize);
+  gRemoteSize = 0;
+  pthread_mutex_unlock(&gRemoteLock);
+}
+
+uint32_t vpio_remote_capabilities(void) {
+  vpio_shm_header* h = remote_enter();
+  if (!h) return 0;
+  uint32_t caps = h->capabilities & VPIO_SHM_CAPS;
+  remote_leave();
+  return caps;
+}
+
+// Post one mailbox request and wait for it; gRemoteLock held
+static int64_t remote_call_locked(vpio_shm_header* h, int op, const int32_t* iargs, const double* dargs,
+                                  const char* path, double* out) {
+  h->cmd_op = op;
+  for (int i = 0; i < 4; i++) {
+    h->cmd_i[i] = iargs ? iargs[i] : 0;
+    h->cmd_d[i] = dargs ? dargs[i] : 0.0;
+  }
+  snprintf((char*)h->cmd_data, VPIO_SHM_CMD_DATA, "%s", path ? path : "");
+  uint32_t req = atomic_load_explicit(&h->cmd_req, memory_order_relaxed) + 1;
+  atomic_store_explicit(&h->cmd_req, req, memory_order_release);
+  atomic_fetch_add_explicit(&h->bell, 1, memory_order_release);
+  vpio_shm_wake(&h->bell);
+  uint64_t deadline = vpio_host_time_now_ns() + 2000000000ull;
+  for (;;) {
+    uint32_t done = atomic_load_explicit(&h->cmd_done, memory_order_acquire);
+    if (done == req) break;
+    if (vpio_host_time_now_ns() >= deadline) {
+      if (gTrace) fprintf(stderr, "[VPIO-REMOTE] op %d timed out\n", op);
+      return -1;
+    }
+    vpio_shm_wait(&h->cmd_done, done, 50);
+  }
+  if (out) { out[0] = h->cmd_out[0]; out[1] = h->cmd_out[1]; }
+  return h->cmd_result;
+}
+
+// Run one engine call in the daemon. iargs/dargs hold 4 values each (NULL =
+// zeros); path goes to ops that take one. Blocks up to 2s; -1 on timeout.
+int64_t vpio_remote_call(int op, const int32_t* iargs, const double* dargs, const char* path, double* out) {
+  pthread_mutex_lock(&gRemoteLock);
+  vpio_shm_header* h = atomic_load_explicit(&gRemote, memory_order_relaxed);
+  int64_t rc = h ? remote_call_locked(h, op, iargs, dargs, path, out) : -1;
+  pthread_mutex_unlock(&gRemoteLock);
+  return rc;
+}
+
+size_t vpio_remote_get_levels(int direction, vpio_level* out, size_t max_entries) {
+  if (!out) return 0;
+  if (max_entries > VPIO_SHM_CMD_DATA / sizeof(vpio_level)) max_entries = VPIO_SHM_CMD_DATA / sizeof(vpio_level);
+  int32_t args[4] = {direction, (int32_t)max_entries, 0, 0};
+  size_t n = 0;
+  pthread_mutex_lock(&gRemoteLock);
+  vpio_shm_header* h = atomic_load_explicit(&gRemote, memory_order_relaxed);
+  if (h) {
+    int64_t rc = remote_call_locked(h, VPIO_SHM_OP_LEVELS, args, NULL, NULL, NULL);
+    if (rc > 0) {
+      n = (size_t)rc < max_entries ? (size_t)rc : max_entries;
+      memcpy(out, h->cmd_data, n * sizeof(vpio_level));
+    }
+  }
+  pthread_mutex_unlock(&gRemoteLock);
+  return n;
+}
+
+// Same contract as vpio_read_frames, from the shared capture ring. Records of
+// another frame size (left over from before a frame_ms change) are skipped.
+size_t vpio_remote_read_frames(void* dst, size_t max_frames, size_t frame_bytes, vpio_frame_info* meta_out) {
+  if (!dst || !meta_out || frame_bytes == 0) return 0;
+  vpio_shm_header* h = remote_enter();
+  if (!h) return 0;
+  vpio_shm_ring* rg = &h->cap;
+  uint64_t r = atomic_load_explicit(&rg->r, memory_order_relaxed);
+  size_t n = 0;
+  // Records are published whole: a visible header means a visible body
+  while (n < max_frames && vpio_shm_ring_avail(rg, r, sizeof(vpio_shm_frame)) >= sizeof(vpio_shm_frame)) {
+    vpio_shm_frame fr;
+    vpio_shm_ring_copy_out(h, rg, r, &fr, sizeof(fr));
+    if (fr.bytes == frame_bytes) {
+      vpio_shm_ring_copy_out(h, rg, r + sizeof(fr), (unsigned char*)dst + n * frame_bytes, frame_bytes);
+      meta_out[n++] = fr.info;
+    }
+    r += sizeof(fr) + fr.bytes;
+  }
+  atomic_store_explicit(&rg->r, r, memory_order_release);
+  remote_leave();
+  return n;
+}
+
+// Queue playback for the daemon; returns bytes accepted (less than len once
+// the shared ring is full: the engine's play ring is full too, or the daemon
+// has stopped draining).
+size_t vpio_remote_write_playback(const void* src, size_t len) {
+  if (!src || len == 0) return 0;
+  vpio_shm_header* h = remote_enter();
+  if (!h) return 0;
+  vpio_shm_ring* rg = &h->play;
+  size_t frame = (size_t)kBytesPerSample * (size_t)(h->channels > 0 ? h->channels : 1);
+  uint64_t w = atomic_load_explicit(&rg->w, memory_order_relaxed);
+  size_t space = vpio_shm_ring_space(rg, w, len);
+  size_t n = len < space ? len : space;
+  n -= n % frame;
+  if (n > 0) {
+    w = vpio_shm_ring_copy_in(h, rg, w, src, n);
+    atomic_store_explicit(&rg->w, w, memory_order_release);
+    atomic_fetch_add_explicit(&h->bell, 1, memory_order_release);
+    vpio_shm_wake(&h->bell);
+  }
+  remote_leave();
+  return n;
+}
+
+// Latest stats snapshot the daemon published (every ~20ms); same contract as
+// vpio_get_stats.
+size_t vpio_remote_get_stats(void* out, size_t out_size) {
+  if (!out || out_size == 0) return 0;
+  vpio_shm_header* h = remote_enter();
+  if (!h) return 0;
+  uint64_t words[VPIO_SHM_STATS_WORDS];
+  size_t got = 0;
+  for (int tries = 0; tries < 100 && !got; tries++) {
+    uint32_t s0 = atomic_load_explicit(&h->stats_seq, memory_order_acquire);
+    if (s0 & 1u) { usleep(50); continue; }
+    for (size_t i = 0; i < VPIO_SHM_STATS_WORDS; i++)
+      words[i] = atomic_load_explicit(&h->stats[i], memory_order_relaxed);
+    VPIO_SEQ_FENCE(memory_order_acquire);
+    if (atomic_load_explicit(&h->stats_seq, VPIO_SEQ_ORDER(memory_order_relaxed)) != s0) continue;
+    got = out_size < sizeof(words) ? out_size : sizeof(words);
+    memcpy(out, words, got);
+  }
+  remote_leave();
+  return got;
 }
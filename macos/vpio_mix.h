@@ -0,0 +1,559 @@
+#ifndef VPIO_MIX_H
+#define VPIO_MIX_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VPIO_MIX_NEON 1
+#elif defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#include <immintrin.h>
+#define VPIO_MIX_X86 1
+#endif
+
+// Sample kernels for the RT callbacks: gain ramps, mixing, int16 <-> float
+// conversion, level sums and sign crossings on mono int16 blocks, plus the
+// FFT butterflies of the DSP stages (vpio_fft.h). Each kernel has a scalar
+// reference and SSE2 / AVX2 / NEON versions that give bit-identical
+// results; vpio_mix_select picks one table per process from the CPU. No
+// state, no allocation; RT-safe.
+
+typedef struct { int64_t sumsq; int32_t peak; uint32_t clipped; } vpio_mix_level;
+
+typedef struct {
+  const char* isa;
+  // buf *= gain ramping g0 -> g1 over the block (gains in [0, 8)), rounded
+  // and clamped. Integer Q12 math so every version agrees to the bit.
+  void (*scale_s16)(int16_t* buf, size_t n, float g0, float g1);
+  // dst += src, saturating at the int16 limits
+  void (*adds_s16)(int16_t* dst, const int16_t* src, size_t n);
+  // s / 32768
+  void (*s16_to_f32)(float* dst, const int16_t* src, size_t n);
+  // f * 32768 clamped to int16, rounded to nearest even; NaN maps to 32767
+  void (*f32_to_s16)(int16_t* dst, const float* src, size_t n);
+  // Sum of squares, peak |s| and samples at full scale (|s| >= 32767)
+  void (*level_s16)(const int16_t* s, size_t n, vpio_mix_level* out);
+  // Neighbours of opposite sign (zero counts as positive): i in [1, n) with
+  // s[i] < 0 != s[i - 1] < 0
+  uint32_t (*crossings_s16)(const int16_t* s, size_t n);
+  // One radix-2 stage on split complex arrays: for each of n pairs,
+  // x = b * w with w = wr + i * sign * wi, then (a, b) = (a + x, a - x)
+  void (*butterfly_f32)(float* ar, float* ai, float* br, float* bi, const float* wr, const float* wi, size_t n,
+                        float sign);
+} vpio_mix_kernels;
+
+// The butterflies round each product and sum on their own, so every version
+// agrees; GCC would fuse them into FMAs on targets that have one
+#if defined(__GNUC__) && !defined(__clang__)
+#define VPIO_MIX_NO_FMA __attribute__((optimize("fp-contract=off")))
+#else
+#define VPIO_MIX_NO_FMA
+#endif
+
+// Q24 start gain and per-sample step shared by every scale_s16 version
+static inline int32_t vpio_mix_ramp(float g0, float g1, size_t n, int32_t* step) {
+  g0 = g0 < 0.0f ? 0.0f : (g0 > 7.99f ? 7.99f : g0);
+  g1 = g1 < 0.0f ? 0.0f : (g1 > 7.99f ? 7.99f : g1);
+  *step = (int32_t)((g1 - g0) * 16777216.0f / (float)n);
+  return (int32_t)(g0 * 16777216.0f);
+}
+
+static inline void vpio_mix_scale_s16_scalar(int16_t* buf, size_t n, float g0, float g1) {
+  if (n == 0) return;
+  int32_t step, g = vpio_mix_ramp(g0, g1, n, &step);
+  for (size_t i = 0; i < n; i++) {
+    int32_t q = (g + step * (int32_t)i) >> 12;
+    int32_t v = ((int32_t)buf[i] * q + 2048) >> 12;
+    buf[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+static inline void vpio_mix_adds_s16_scalar(int16_t* dst, const int16_t* src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    int32_t v = (int32_t)dst[i] + (int32_t)src[i];
+    dst[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+static inline void vpio_mix_s16_to_f32_scalar(float* dst, const int16_t* src, size_t n) {
+  for (size_t i = 0; i < n; i++) dst[i] = (float)src[i] * (1.0f / 32768.0f);
+}
+
+static inline void vpio_mix_f32_to_s16_scalar(int16_t* dst, const float* src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    // Written as selects so NaN lands where minps/maxps put it
+    float v = src[i] * 32768.0f;
+    v = v < 32767.0f ? v : 32767.0f;
+    v = v > -32768.0f ? v : -32768.0f;
+    dst[i] = (int16_t)lrintf(v);
+  }
+}
+
+static inline void vpio_mix_level_s16_scalar(const int16_t* s, size_t n, vpio_mix_level* out) {
+  int64_t sumsq = 0;
+  int32_t peak = 0;
+  uint32_t clipped = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t v = s[i];
+    int32_t m = v < 0 ? -v : v;
+    sumsq += v * v;
+    peak = m > peak ? m : peak;
+    clipped += (uint32_t)(m >= 32767);
+  }
+  out->sumsq = sumsq; out->peak = peak; out->clipped = clipped;
+}
+
+static inline uint32_t vpio_mix_crossings_s16_scalar(const int16_t* s, size_t n) {
+  uint32_t zc = 0;
+  for (size_t i = 1; i < n; i++) zc += (uint32_t)((s[i] ^ s[i - 1]) < 0);
+  return zc;
+}
+
+VPIO_MIX_NO_FMA static inline void vpio_mix_butterfly_f32_scalar(float* ar, float* ai, float* br, float* bi,
+                                                                 const float* wr, const float* wi, size_t n,
+                                                                 float sign) {
+  for (size_t k = 0; k < n; k++) {
+    float c = wr[k], s = sign * wi[k];
+    // Products in their own expressions, which clang never contracts
+    float rc = br[k] * c, is = bi[k] * s, rs = br[k] * s, ic = bi[k] * c;
+    float xr = rc - is, xi = rs + ic;
+    br[k] = ar[k] - xr; bi[k] = ai[k] - xi;
+    ar[k] += xr;        ai[k] += xi;
+  }
+}
+
+#if defined(VPIO_MIX_X86)
+#define VPIO_MIX_SSE2 __attribute__((target("sse2")))
+#define VPIO_MIX_AVX2 __attribute__((target("avx2")))
+
+VPIO_MIX_SSE2 static inline void vpio_mix_scale_s16_sse2(int16_t* buf, size_t n, float g0, float g1) {
+  if (n == 0) return;
+  int32_t step, g = vpio_mix_ramp(g0, g1, n, &step);
+  size_t i = 0, n8 = n & ~(size_t)7;
+  // q fits int16 (gain < 8 in Q12), so 16x16 -> 32 products via mullo/mulhi
+  __m128i ga = _mm_setr_epi32(g, g + step, g + step * 2, g + step * 3);
+  __m128i gb = _mm_add_epi32(ga, _mm_set1_epi32(step * 4));
+  __m128i inc = _mm_set1_epi32(step * 8), rnd = _mm_set1_epi32(2048);
+  for (; i < n8; i += 8) {
+    __m128i q = _mm_packs_epi32(_mm_srai_epi32(ga, 12), _mm_srai_epi32(gb, 12));
+    __m128i x = _mm_loadu_si128((const __m128i*)(buf + i));
+    __m128i lo = _mm_mullo_epi16(x, q), hi = _mm_mulhi_epi16(x, q);
+    __m128i v0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), rnd), 12);
+    __m128i v1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), rnd), 12);
+    _mm_storeu_si128((__m128i*)(buf + i), _mm_packs_epi32(v0, v1));
+    ga = _mm_add_epi32(ga, inc);
+    gb = _mm_add_epi32(gb, inc);
+  }
+  for (; i < n; i++) {
+    int32_t q = (g + step * (int32_t)i) >> 12;
+    int32_t v = ((int32_t)buf[i] * q + 2048) >> 12;
+    buf[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+VPIO_MIX_SSE2 static inline void vpio_mix_adds_s16_sse2(int16_t* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  for (; i < n8; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(a, b));
+  }
+  vpio_mix_adds_s16_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_SSE2 static inline void vpio_mix_s16_to_f32_sse2(float* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  __m128 k = _mm_set1_ps(1.0f / 32768.0f);
+  for (; i < n8; i += 8) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+    _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+  }
+  vpio_mix_s16_to_f32_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_SSE2 static inline void vpio_mix_f32_to_s16_sse2(int16_t* dst, const float* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  __m128 k = _mm_set1_ps(32768.0f), top = _mm_set1_ps(32767.0f), bot = _mm_set1_ps(-32768.0f);
+  for (; i < n8; i += 8) {
+    // minps/maxps return the second operand on NaN, like the scalar selects;
+    // cvtps rounds in the current mode, like lrintf
+    __m128 a = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i), k), top), bot);
+    __m128 b = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), k), top), bot);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+  vpio_mix_f32_to_s16_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_SSE2 static inline void vpio_mix_level_s16_sse2(const int16_t* s, size_t n, vpio_mix_level* out) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  __m128i acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+  __m128i mx = zero, mn = zero;
+  __m128i top = _mm_set1_epi16(32766), bot = _mm_set1_epi16(-32766);
+  uint32_t clipped = 0;
+  while (i < n8) {
+    // 16-bit clip counters, folded every 2^14 vectors
+    size_t end = (n8 - i > ((size_t)8 << 14)) ? i + ((size_t)8 << 14) : n8;
+    __m128i cnt = zero;
+    for (; i < end; i += 8) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+      // Pairs of squares reach 2^31, so treat madd lanes as unsigned
+      __m128i sq = _mm_madd_epi16(x, x);
+      acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+      acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+      mx = _mm_max_epi16(mx, x);
+      mn = _mm_min_epi16(mn, x);
+      cnt = _mm_sub_epi16(cnt, _mm_or_si128(_mm_cmpgt_epi16(x, top), _mm_cmplt_epi16(x, bot)));
+    }
+    uint16_t c[8];
+    _mm_storeu_si128((__m128i*)c, cnt);
+    for (int k = 0; k < 8; k++) clipped += c[k];
+  }
+  uint64_t a[2];
+  int16_t hi[8], lo[8];
+  _mm_storeu_si128((__m128i*)a, acc);
+  _mm_storeu_si128((__m128i*)hi, mx);
+  _mm_storeu_si128((__m128i*)lo, mn);
+  int32_t peak = 0;
+  for (int k = 0; k < 8; k++) {
+    if (hi[k] > peak) peak = hi[k];
+    if (-(int32_t)lo[k] > peak) peak = -(int32_t)lo[k];
+  }
+  vpio_mix_level_s16_scalar(s + i, n - i, out);
+  out->sumsq += (int64_t)(a[0] + a[1]);
+  if (peak > out->peak) out->peak = peak;
+  out->clipped += clipped;
+}
+
+VPIO_MIX_SSE2 static inline uint32_t vpio_mix_crossings_s16_sse2(const int16_t* s, size_t n) {
+  size_t i = 1;
+  __m128i acc = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+  for (; i + 8 <= n; i += 8) {
+    // Sign bit of s[i] ^ s[i - 1], widened into 32-bit counts by madd
+    __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(s + i)),
+                              _mm_loadu_si128((const __m128i*)(s + i - 1)));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_srli_epi16(x, 15), one));
+  }
+  uint32_t c[4];
+  _mm_storeu_si128((__m128i*)c, acc);
+  uint32_t zc = c[0] + c[1] + c[2] + c[3];
+  for (; i < n; i++) zc += (uint32_t)((s[i] ^ s[i - 1]) < 0);
+  return zc;
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_scale_s16_avx2(int16_t* buf, size_t n, float g0, float g1) {
+  if (n == 0) return;
+  int32_t step, g = vpio_mix_ramp(g0, g1, n, &step);
+  size_t i = 0, n16 = n & ~(size_t)15;
+  __m256i ga = _mm256_add_epi32(_mm256_set1_epi32(g), _mm256_mullo_epi32(_mm256_set1_epi32(step),
+                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+  __m256i gb = _mm256_add_epi32(ga, _mm256_set1_epi32(step * 8));
+  __m256i inc = _mm256_set1_epi32(step * 16), rnd = _mm256_set1_epi32(2048);
+  for (; i < n16; i += 16) {
+    // packs works per 128-bit lane; the permute puts q back in sample order
+    __m256i q = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(_mm256_srai_epi32(ga, 12), _mm256_srai_epi32(gb, 12)), 0xD8);
+    __m256i x = _mm256_loadu_si256((const __m256i*)(buf + i));
+    __m256i lo = _mm256_mullo_epi16(x, q), hi = _mm256_mulhi_epi16(x, q);
+    __m256i v0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(lo, hi), rnd), 12);
+    __m256i v1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(lo, hi), rnd), 12);
+    _mm256_storeu_si256((__m256i*)(buf + i), _mm256_packs_epi32(v0, v1));
+    ga = _mm256_add_epi32(ga, inc);
+    gb = _mm256_add_epi32(gb, inc);
+  }
+  for (; i < n; i++) {
+    int32_t q = (g + step * (int32_t)i) >> 12;
+    int32_t v = ((int32_t)buf[i] * q + 2048) >> 12;
+    buf[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_adds_s16_avx2(int16_t* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n16 = n & ~(size_t)15;
+  for (; i < n16; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epi16(a, b));
+  }
+  vpio_mix_adds_s16_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_s16_to_f32_avx2(float* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  __m256 k = _mm256_set1_ps(1.0f / 32768.0f);
+  for (; i < n8; i += 8) {
+    __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+  }
+  vpio_mix_s16_to_f32_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_f32_to_s16_avx2(int16_t* dst, const float* src, size_t n) {
+  size_t i = 0, n16 = n & ~(size_t)15;
+  __m256 k = _mm256_set1_ps(32768.0f), top = _mm256_set1_ps(32767.0f), bot = _mm256_set1_ps(-32768.0f);
+  for (; i < n16; i += 16) {
+    __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), k), top), bot);
+    __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), k), top), bot);
+    __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(v, 0xD8));
+  }
+  vpio_mix_f32_to_s16_scalar(dst + i, src + i, n - i);
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_level_s16_avx2(const int16_t* s, size_t n, vpio_mix_level* out) {
+  size_t i = 0, n16 = n & ~(size_t)15;
+  __m256i zero = _mm256_setzero_si256(), acc = zero, mx = zero, mn = zero;
+  __m256i top = _mm256_set1_epi16(32766), bot = _mm256_set1_epi16(-32766);
+  uint32_t clipped = 0;
+  while (i < n16) {
+    size_t end = (n16 - i > ((size_t)16 << 14)) ? i + ((size_t)16 << 14) : n16;
+    __m256i cnt = zero;
+    for (; i < end; i += 16) {
+      __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+      __m256i sq = _mm256_madd_epi16(x, x);
+      acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sq, zero));
+      acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(sq, zero));
+      mx = _mm256_max_epi16(mx, x);
+      mn = _mm256_min_epi16(mn, x);
+      cnt = _mm256_sub_epi16(cnt, _mm256_or_si256(_mm256_cmpgt_epi16(x, top), _mm256_cmpgt_epi16(bot, x)));
+    }
+    uint16_t c[16];
+    _mm256_storeu_si256((__m256i*)c, cnt);
+    for (int k = 0; k < 16; k++) clipped += c[k];
+  }
+  uint64_t a[4];
+  int16_t hi[16], lo[16];
+  _mm256_storeu_si256((__m256i*)a, acc);
+  _mm256_storeu_si256((__m256i*)hi, mx);
+  _mm256_storeu_si256((__m256i*)lo, mn);
+  int32_t peak = 0;
+  for (int k = 0; k < 16; k++) {
+    if (hi[k] > peak) peak = hi[k];
+    if (-(int32_t)lo[k] > peak) peak = -(int32_t)lo[k];
+  }
+  vpio_mix_level_s16_scalar(s + i, n - i, out);
+  out->sumsq += (int64_t)(a[0] + a[1] + a[2] + a[3]);
+  if (peak > out->peak) out->peak = peak;
+  out->clipped += clipped;
+}
+
+VPIO_MIX_AVX2 static inline uint32_t vpio_mix_crossings_s16_avx2(const int16_t* s, size_t n) {
+  size_t i = 1;
+  __m256i acc = _mm256_setzero_si256(), one = _mm256_set1_epi16(1);
+  for (; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(s + i)),
+                                 _mm256_loadu_si256((const __m256i*)(s + i - 1)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_srli_epi16(x, 15), one));
+  }
+  uint32_t c[8];
+  _mm256_storeu_si256((__m256i*)c, acc);
+  uint32_t zc = 0;
+  for (int k = 0; k < 8; k++) zc += c[k];
+  for (; i < n; i++) zc += (uint32_t)((s[i] ^ s[i - 1]) < 0);
+  return zc;
+}
+
+VPIO_MIX_SSE2 static inline void vpio_mix_butterfly_f32_sse2(float* ar, float* ai, float* br, float* bi,
+                                                             const float* wr, const float* wi, size_t n,
+                                                             float sign) {
+  size_t k = 0, n4 = n & ~(size_t)3;
+  __m128 sg = _mm_set1_ps(sign);
+  for (; k < n4; k += 4) {
+    __m128 c = _mm_loadu_ps(wr + k), s = _mm_mul_ps(sg, _mm_loadu_ps(wi + k));
+    __m128 xr0 = _mm_loadu_ps(br + k), xi0 = _mm_loadu_ps(bi + k);
+    __m128 xr = _mm_sub_ps(_mm_mul_ps(xr0, c), _mm_mul_ps(xi0, s));
+    __m128 xi = _mm_add_ps(_mm_mul_ps(xr0, s), _mm_mul_ps(xi0, c));
+    __m128 yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+    _mm_storeu_ps(br + k, _mm_sub_ps(yr, xr));
+    _mm_storeu_ps(bi + k, _mm_sub_ps(yi, xi));
+    _mm_storeu_ps(ar + k, _mm_add_ps(yr, xr));
+    _mm_storeu_ps(ai + k, _mm_add_ps(yi, xi));
+  }
+  vpio_mix_butterfly_f32_scalar(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, n - k, sign);
+}
+
+VPIO_MIX_AVX2 static inline void vpio_mix_butterfly_f32_avx2(float* ar, float* ai, float* br, float* bi,
+                                                             const float* wr, const float* wi, size_t n,
+                                                             float sign) {
+  size_t k = 0, n8 = n & ~(size_t)7;
+  __m256 sg = _mm256_set1_ps(sign);
+  for (; k < n8; k += 8) {
+    // Plain mul then add/sub: the avx2 target does not enable FMA
+    __m256 c = _mm256_loadu_ps(wr + k), s = _mm256_mul_ps(sg, _mm256_loadu_ps(wi + k));
+    __m256 xr0 = _mm256_loadu_ps(br + k), xi0 = _mm256_loadu_ps(bi + k);
+    __m256 xr = _mm256_sub_ps(_mm256_mul_ps(xr0, c), _mm256_mul_ps(xi0, s));
+    __m256 xi = _mm256_add_ps(_mm256_mul_ps(xr0, s), _mm256_mul_ps(xi0, c));
+    __m256 yr = _mm256_loadu_ps(ar + k), yi = _mm256_loadu_ps(ai + k);
+    _mm256_storeu_ps(br + k, _mm256_sub_ps(yr, xr));
+    _mm256_storeu_ps(bi + k, _mm256_sub_ps(yi, xi));
+    _mm256_storeu_ps(ar + k, _mm256_add_ps(yr, xr));
+    _mm256_storeu_ps(ai + k, _mm256_add_ps(yi, xi));
+  }
+  // The scalar tail may not be inlined here (it is built without FMA
+  // contraction), and legacy SSE code after dirty upper halves is slow
+  _mm256_zeroupper();
+  vpio_mix_butterfly_f32_sse2(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, n - k, sign);
+}
+#endif // VPIO_MIX_X86
+
+#if defined(VPIO_MIX_NEON)
+static inline void vpio_mix_scale_s16_neon(int16_t* buf, size_t n, float g0, float g1) {
+  if (n == 0) return;
+  int32_t step, g = vpio_mix_ramp(g0, g1, n, &step);
+  size_t i = 0, n8 = n & ~(size_t)7;
+  const int32_t ramp[4] = {0, 1, 2, 3};
+  int32x4_t ga = vmlaq_n_s32(vdupq_n_s32(g), vld1q_s32(ramp), step);
+  int32x4_t gb = vaddq_s32(ga, vdupq_n_s32(step * 4));
+  int32x4_t inc = vdupq_n_s32(step * 8);
+  for (; i < n8; i += 8) {
+    int16x8_t x = vld1q_s16(buf + i);
+    // vrshr adds the 2048 before shifting, at full width
+    int32x4_t v0 = vrshrq_n_s32(vmull_s16(vget_low_s16(x), vmovn_s32(vshrq_n_s32(ga, 12))), 12);
+    int32x4_t v1 = vrshrq_n_s32(vmull_s16(vget_high_s16(x), vmovn_s32(vshrq_n_s32(gb, 12))), 12);
+    vst1q_s16(buf + i, vcombine_s16(vqmovn_s32(v0), vqmovn_s32(v1)));
+    ga = vaddq_s32(ga, inc);
+    gb = vaddq_s32(gb, inc);
+  }
+  for (; i < n; i++) {
+    int32_t q = (g + step * (int32_t)i) >> 12;
+    int32_t v = ((int32_t)buf[i] * q + 2048) >> 12;
+    buf[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+static inline void vpio_mix_adds_s16_neon(int16_t* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  for (; i < n8; i += 8) vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+  vpio_mix_adds_s16_scalar(dst + i, src + i, n - i);
+}
+
+static inline void vpio_mix_s16_to_f32_neon(float* dst, const int16_t* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  for (; i < n8; i += 8) {
+    int16x8_t x = vld1q_s16(src + i);
+    vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32768.0f));
+    vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32768.0f));
+  }
+  vpio_mix_s16_to_f32_scalar(dst + i, src + i, n - i);
+}
+
+static inline void vpio_mix_f32_to_s16_neon(int16_t* dst, const float* src, size_t n) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  float32x4_t top = vdupq_n_f32(32767.0f), bot = vdupq_n_f32(-32768.0f);
+  for (; i < n8; i += 8) {
+    // Selects rather than vminq/vmaxq, which propagate NaN
+    float32x4_t a = vmulq_n_f32(vld1q_f32(src + i), 32768.0f);
+    float32x4_t b = vmulq_n_f32(vld1q_f32(src + i + 4), 32768.0f);
+    a = vbslq_f32(vcltq_f32(a, top), a, top);
+    b = vbslq_f32(vcltq_f32(b, top), b, top);
+    a = vbslq_f32(vcgtq_f32(a, bot), a, bot);
+    b = vbslq_f32(vcgtq_f32(b, bot), b, bot);
+    vst1q_s16(dst + i, vcombine_s16(vmovn_s32(vcvtnq_s32_f32(a)), vmovn_s32(vcvtnq_s32_f32(b))));
+  }
+  vpio_mix_f32_to_s16_scalar(dst + i, src + i, n - i);
+}
+
+static inline void vpio_mix_level_s16_neon(const int16_t* s, size_t n, vpio_mix_level* out) {
+  size_t i = 0, n8 = n & ~(size_t)7;
+  int64x2_t acc = vdupq_n_s64(0);
+  int16x8_t mx = vdupq_n_s16(0), mn = vdupq_n_s16(0);
+  uint32x4_t cnt = vdupq_n_u32(0);
+  for (; i < n8; i += 8) {
+    int16x8_t x = vld1q_s16(s + i);
+    int16x4_t lo = vget_low_s16(x), hi = vget_high_s16(x);
+    acc = vpadalq_s32(acc, vmull_s16(lo, lo));
+    acc = vpadalq_s32(acc, vmull_s16(hi, hi));
+    mx = vmaxq_s16(mx, x);
+    mn = vminq_s16(mn, x);
+    uint16x8_t c = vorrq_u16(vcgeq_s16(x, vdupq_n_s16(32767)), vcleq_s16(x, vdupq_n_s16(-32767)));
+    cnt = vpadalq_u16(cnt, vshrq_n_u16(c, 15));
+  }
+  int32_t peak = vmaxvq_s16(mx), neg = -(int32_t)vminvq_s16(mn);
+  if (neg > peak) peak = neg;
+  vpio_mix_level_s16_scalar(s + i, n - i, out);
+  out->sumsq += vaddvq_s64(acc);
+  if (peak > out->peak) out->peak = peak;
+  out->clipped += vaddvq_u32(cnt);
+}
+
+static inline uint32_t vpio_mix_crossings_s16_neon(const int16_t* s, size_t n) {
+  size_t i = 1;
+  uint32x4_t cnt = vdupq_n_u32(0);
+  for (; i + 8 <= n; i += 8) {
+    uint16x8_t x = vreinterpretq_u16_s16(veorq_s16(vld1q_s16(s + i), vld1q_s16(s + i - 1)));
+    cnt = vpadalq_u16(cnt, vshrq_n_u16(x, 15));
+  }
+  uint32_t zc = vaddvq_u32(cnt);
+  for (; i < n; i++) zc += (uint32_t)((s[i] ^ s[i - 1]) < 0);
+  return zc;
+}
+
+VPIO_MIX_NO_FMA static inline void vpio_mix_butterfly_f32_neon(float* ar, float* ai, float* br, float* bi,
+                                                               const float* wr, const float* wi, size_t n,
+                                                               float sign) {
+  size_t k = 0, n4 = n & ~(size_t)3;
+  for (; k < n4; k += 4) {
+    // vmul + vsub/vadd, not vmls/vmla, which fuse
+    float32x4_t c = vld1q_f32(wr + k), s = vmulq_n_f32(vld1q_f32(wi + k), sign);
+    float32x4_t xr0 = vld1q_f32(br + k), xi0 = vld1q_f32(bi + k);
+    float32x4_t xr = vsubq_f32(vmulq_f32(xr0, c), vmulq_f32(xi0, s));
+    float32x4_t xi = vaddq_f32(vmulq_f32(xr0, s), vmulq_f32(xi0, c));
+    float32x4_t yr = vld1q_f32(ar + k), yi = vld1q_f32(ai + k);
+    vst1q_f32(br + k, vsubq_f32(yr, xr));
+    vst1q_f32(bi + k, vsubq_f32(yi, xi));
+    vst1q_f32(ar + k, vaddq_f32(yr, xr));
+    vst1q_f32(ai + k, vaddq_f32(yi, xi));
+  }
+  vpio_mix_butterfly_f32_scalar(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, n - k, sign);
+}
+#endif // VPIO_MIX_NEON
+
+static const vpio_mix_kernels vpio_mix_scalar = {
+  "scalar", vpio_mix_scale_s16_scalar, vpio_mix_adds_s16_scalar,
+  vpio_mix_s16_to_f32_scalar, vpio_mix_f32_to_s16_scalar, vpio_mix_level_s16_scalar,
+  vpio_mix_crossings_s16_scalar, vpio_mix_butterfly_f32_scalar,
+};
+
+// Kernel table for an ISA name ("scalar", "sse2", "avx2", "neon"), or NULL
+// when this build or CPU can't run it
+static inline const vpio_mix_kernels* vpio_mix_kernels_for(const char* isa) {
+#if defined(VPIO_MIX_X86)
+  static const vpio_mix_kernels sse2 = {
+    "sse2", vpio_mix_scale_s16_sse2, vpio_mix_adds_s16_sse2,
+    vpio_mix_s16_to_f32_sse2, vpio_mix_f32_to_s16_sse2, vpio_mix_level_s16_sse2,
+    vpio_mix_crossings_s16_sse2, vpio_mix_butterfly_f32_sse2,
+  };
+  static const vpio_mix_kernels avx2 = {
+    "avx2", vpio_mix_scale_s16_avx2, vpio_mix_adds_s16_avx2,
+    vpio_mix_s16_to_f32_avx2, vpio_mix_f32_to_s16_avx2, vpio_mix_level_s16_avx2,
+    vpio_mix_crossings_s16_avx2, vpio_mix_butterfly_f32_avx2,
+  };
+  __builtin_cpu_init();
+  if (strcmp(isa, "avx2") == 0) return __builtin_cpu_supports("avx2") ? &avx2 : NULL;
+  if (strcmp(isa, "sse2") == 0) return __builtin_cpu_supports("sse2") ? &sse2 : NULL;
+#elif defined(VPIO_MIX_NEON)
+  static const vpio_mix_kernels neon = {
+    "neon", vpio_mix_scale_s16_neon, vpio_mix_adds_s16_neon,
+    vpio_mix_s16_to_f32_neon, vpio_mix_f32_to_s16_neon, vpio_mix_level_s16_neon,
+    vpio_mix_crossings_s16_neon, vpio_mix_butterfly_f32_neon,
+  };
+  if (strcmp(isa, "neon") == 0) return &neon; // baseline on arm64
+#endif
+  if (strcmp(isa, "scalar") == 0) return &vpio_mix_scalar;
+  return NULL;
+}
+
+// Best table for this CPU. want (e.g. VPIO_KERNELS) names an ISA to use
+// instead when it is available; NULL, "" or an unusable name picks the best.
+static inline const vpio_mix_kernels* vpio_mix_select(const char* want) {
+  static const char* const kOrder[] = {"avx2", "neon", "sse2", "scalar"};
+  const vpio_mix_kernels* k = (want && want[0]) ? vpio_mix_kernels_for(want) : NULL;
+  for (size_t i = 0; !k && i < sizeof(kOrder) / sizeof(kOrder[0]); i++) k = vpio_mix_kernels_for(kOrder[i]);
+  return k;
+}
+
+#endif // VPIO_MIX_H
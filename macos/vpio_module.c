@@ -0,0 +1,836 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <structmember.h>
+
+#include "vpio.h"
+
+// CPython binding for the VPIO helper. Built together with vpio_helper.c into
+// a single extension module (_vpio) so calls skip ctypes argument conversion:
+// capture and playback data move through the buffer protocol (bytes,
+// bytearray, memoryview) and blocking calls release the GIL.
+//
+// The helper keeps its engine state in globals, so at most one Engine object
+// may exist per process.
+
+static int gEngineAlive = 0;
+
+static PyStructSequence_Field frame_info_fields[] = {
+    {"seq", "frame number on the capture grid"},
+    {"sample_index", "capture sample index of the first sample"},
+    {"host_time_ns", "host clock time of the first sample (0 if unknown)"},
+    {"flags", "FRAME_* bits"},
+    {"silence_before", "samples suppressed by DTX right before this frame"},
+    {NULL, NULL},
+};
+
+static PyStructSequence_Desc frame_info_desc = {
+    "_vpio.FrameInfo",
+    "Metadata for one capture frame",
+    frame_info_fields,
+    5,
+};
+
+static PyTypeObject* FrameInfoType = NULL;
+
+typedef struct {
+  PyObject_HEAD
+  int started;
+} EngineObject;
+
+static int Engine_init(EngineObject* self, PyObject* args, PyObject* kwds) {
+  static char* kwlist[] = {NULL};
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) return -1;
+  if (gEngineAlive) {
+    PyErr_SetString(PyExc_RuntimeError, "only one _vpio.Engine may exist per process");
+    return -1;
+  }
+  gEngineAlive = 1;
+  self->started = 0;
+  return 0;
+}
+
+static void Engine_dealloc(EngineObject* self) {
+  if (self->started) {
+    Py_BEGIN_ALLOW_THREADS
+    vpio_stop_stream();
+    vpio_shutdown();
+    Py_END_ALLOW_THREADS
+  }
+  gEngineAlive = 0;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* Engine_start(EngineObject* self, PyObject* args) {
+  double sample_rate;
+  int channels;
+  Py_ssize_t ring_bytes;
+  if (!PyArg_ParseTuple(args, "din", &sample_rate, &channels, &ring_bytes)) return NULL;
+  if (ring_bytes < 0) {
+    PyErr_SetString(PyExc_ValueError, "ring_bytes must be >= 0");
+    return NULL;
+  }
+  int rc;
+  // vpio_init does component lookup, AudioUnitInitialize and start: blocking
+  Py_BEGIN_ALLOW_THREADS
+  rc = vpio_start_stream(sample_rate, channels, (size_t)ring_bytes);
+  Py_END_ALLOW_THREADS
+  if (rc == 0) self->started = 1;
+  return PyBool_FromLong(rc == 0);
+}
+
+static PyObject* Engine_start_async(EngineObject* self, PyObject* args) {
+  double sample_rate;
+  int channels;
+  Py_ssize_t ring_bytes;
+  if (!PyArg_ParseTuple(args, "din", &sample_rate, &channels, &ring_bytes)) return NULL;
+  if (ring_bytes < 0) {
+    PyErr_SetString(PyExc_ValueError, "ring_bytes must be >= 0");
+    return NULL;
+  }
+  int rc;
+  // Joins a finished earlier start, if any
+  Py_BEGIN_ALLOW_THREADS
+  rc = vpio_start_stream_async(sample_rate, channels, (size_t)ring_bytes);
+  Py_END_ALLOW_THREADS
+  // Stopping (or dealloc) waits for the worker and tears down what it built
+  if (rc == 0) self->started = 1;
+  return PyBool_FromLong(rc == 0);
+}
+
+static PyObject* Engine_start_result(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  int rc = 0, state;
+  Py_BEGIN_ALLOW_THREADS
+  state = vpio_start_stream_result(&rc);
+  Py_END_ALLOW_THREADS
+  if (state == 0) Py_RETURN_NONE;
+  return PyLong_FromLong(state > 0 ? rc : -1);
+}
+
+static PyObject* Engine_start_timings(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  vpio_start_timings t;
+  memset(&t, 0, sizeof(t));
+  vpio_get_start_timings(&t, sizeof(t));
+  return Py_BuildValue(
+      "{s:K,s:d,s:d,s:d,s:d,s:d,s:d,s:d,s:d}",
+      "start_ns", (unsigned long long)t.start_ns,
+      "component_ms", t.component_ms,
+      "configure_ms", t.configure_ms,
+      "initialize_ms", t.initialize_ms,
+      "unit_start_ms", t.unit_start_ms,
+      "ready_ms", t.ready_ms,
+      "first_render_ms", t.first_render_ms,
+      "first_capture_ms", t.first_capture_ms,
+      "first_played_ms", t.first_played_ms);
+}
+
+static PyObject* Engine_stop(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  Py_BEGIN_ALLOW_THREADS
+  vpio_stop_stream();
+  vpio_shutdown();
+  Py_END_ALLOW_THREADS
+  self->started = 0;
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_capture_gate(EngineObject* self, PyObject* args) {
+  int gate, keep_echo = 1;
+  if (!PyArg_ParseTuple(args, "i|p", &gate, &keep_echo)) return NULL;
+  return PyBool_FromLong(vpio_set_capture_gate(gate, keep_echo) == 0);
+}
+
+static PyObject* Engine_capture_gate(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  return PyLong_FromLong(vpio_get_capture_gate());
+}
+
+static PyObject* Engine_set_playback_watermarks(EngineObject* self, PyObject* args) {
+  unsigned long long high, low = 0;
+  if (!PyArg_ParseTuple(args, "K|K", &high, &low)) return NULL;
+  return PyBool_FromLong(vpio_set_playback_watermarks((size_t)high, (size_t)low) == 0);
+}
+
+static PyObject* Engine_playback_space(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  size_t queued = 0;
+  size_t space = vpio_get_playback_space(&queued);
+  return Py_BuildValue("(nn)", (Py_ssize_t)space, (Py_ssize_t)queued);
+}
+
+static PyObject* Engine_set_ring_budget(EngineObject* self, PyObject* args) {
+  int ring, shrink_after_ms = 2000;
+  unsigned long long max_bytes;
+  if (!PyArg_ParseTuple(args, "iK|i", &ring, &max_bytes, &shrink_after_ms)) return NULL;
+  return PyBool_FromLong(vpio_set_ring_budget(ring, (size_t)max_bytes, shrink_after_ms) == 0);
+}
+
+static PyObject* Engine_ring_memory(EngineObject* self, PyObject* arg) {
+  int ring = (int)PyLong_AsLong(arg);
+  if (ring == -1 && PyErr_Occurred()) return NULL;
+  vpio_ring_memory m;
+  memset(&m, 0, sizeof(m));
+  if (vpio_get_ring_memory(ring, &m, sizeof(m)) == 0) {
+    PyErr_SetString(PyExc_ValueError, "unknown ring");
+    return NULL;
+  }
+  return Py_BuildValue(
+      "{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K}",
+      "committed", (unsigned long long)m.committed,
+      "committed_high", (unsigned long long)m.committed_high,
+      "level", (unsigned long long)m.level,
+      "level_high", (unsigned long long)m.level_high,
+      "budget", (unsigned long long)m.budget,
+      "grows", (unsigned long long)m.grows,
+      "shrinks", (unsigned long long)m.shrinks,
+      "rejected_bytes", (unsigned long long)m.rejected_bytes);
+}
+
+static PyObject* Engine_set_capture_frame_ms(EngineObject* self, PyObject* arg) {
+  int ms = (int)PyLong_AsLong(arg);
+  if (ms == -1 && PyErr_Occurred()) return NULL;
+  return PyLong_FromSize_t(vpio_set_capture_frame_ms(ms));
+}
+
+static PyObject* frame_info_list(const vpio_frame_info* infos, size_t n) {
+  PyObject* out = PyList_New((Py_ssize_t)n);
+  if (!out) return NULL;
+  for (size_t i = 0; i < n; i++) {
+    PyObject* fi = PyStructSequence_New(FrameInfoType);
+    if (!fi) { Py_DECREF(out); return NULL; }
+    PyStructSequence_SetItem(fi, 0, PyLong_FromUnsignedLongLong(infos[i].seq));
+    PyStructSequence_SetItem(fi, 1, PyLong_FromUnsignedLongLong(infos[i].sample_index));
+    PyStructSequence_SetItem(fi, 2, PyLong_FromUnsignedLongLong(infos[i].host_time_ns));
+    PyStructSequence_SetItem(fi, 3, PyLong_FromUnsignedLong(infos[i].flags));
+    PyStructSequence_SetItem(fi, 4, PyLong_FromUnsignedLong(infos[i].silence_before));
+    PyList_SET_ITEM(out, (Py_ssize_t)i, fi);
+  }
+  return out;
+}
+
+// reader < 0 reads through the default capture reader
+static PyObject* read_frames_common(int reader, PyObject* args) {
+  Py_buffer dst;
+  Py_ssize_t max_frames, frame_bytes;
+  if (!PyArg_ParseTuple(args, "w*nn", &dst, &max_frames, &frame_bytes)) return NULL;
+  if (max_frames <= 0 || frame_bytes <= 0 || dst.len < max_frames * frame_bytes) {
+    PyBuffer_Release(&dst);
+    PyErr_SetString(PyExc_ValueError, "dst must hold max_frames * frame_bytes bytes");
+    return NULL;
+  }
+  vpio_frame_info infos[64];
+  if (max_frames > 64) max_frames = 64;
+  size_t n = reader < 0 ? vpio_read_frames(dst.buf, (size_t)max_frames, (size_t)frame_bytes, infos)
+                        : vpio_capture_reader_read_frames(reader, dst.buf, (size_t)max_frames,
+                                                          (size_t)frame_bytes, infos);
+  PyBuffer_Release(&dst);
+  return frame_info_list(infos, n);
+}
+
+static PyObject* Engine_read_frames(EngineObject* self, PyObject* args) {
+  return read_frames_common(-1, args);
+}
+
+static PyObject* Engine_open_capture_reader(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  return PyLong_FromLong(vpio_capture_reader_open());
+}
+
+static PyObject* Engine_close_capture_reader(EngineObject* self, PyObject* arg) {
+  int reader = (int)PyLong_AsLong(arg);
+  if (reader == -1 && PyErr_Occurred()) return NULL;
+  vpio_capture_reader_close(reader);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_read_reader_frames(EngineObject* self, PyObject* args) {
+  Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+  if (nargs < 1) {
+    PyErr_SetString(PyExc_TypeError, "read_reader_frames(reader, dst, max_frames, frame_bytes)");
+    return NULL;
+  }
+  int reader = (int)PyLong_AsLong(PyTuple_GET_ITEM(args, 0));
+  if (reader == -1 && PyErr_Occurred()) return NULL;
+  if (reader < 0) {
+    PyErr_SetString(PyExc_ValueError, "reader must be >= 0");
+    return NULL;
+  }
+  PyObject* rest = PyTuple_GetSlice(args, 1, nargs);
+  if (!rest) return NULL;
+  PyObject* out = read_frames_common(reader, rest);
+  Py_DECREF(rest);
+  return out;
+}
+
+// Zero-copy: read-only views straight into the capture ring. They are only
+// valid until consume_capture says so; copy out before trusting them.
+static PyObject* Engine_peek_capture(EngineObject* self, PyObject* args) {
+  int reader;
+  Py_ssize_t max_bytes;
+  if (!PyArg_ParseTuple(args, "in", &reader, &max_bytes)) return NULL;
+  if (max_bytes < 0) max_bytes = 0;
+  const void *p1, *p2;
+  size_t n1, n2, pos = 0;
+  vpio_capture_reader_peek(reader, (size_t)max_bytes, &p1, &n1, &p2, &n2, &pos);
+  PyObject* views = PyList_New(0);
+  if (!views) return NULL;
+  const void* ptrs[2] = {p1, p2};
+  size_t lens[2] = {n1, n2};
+  for (int i = 0; i < 2; i++) {
+    if (!lens[i]) continue;
+    PyObject* mv = PyMemoryView_FromMemory((char*)ptrs[i], (Py_ssize_t)lens[i], PyBUF_READ);
+    if (!mv || PyList_Append(views, mv) < 0) { Py_XDECREF(mv); Py_DECREF(views); return NULL; }
+    Py_DECREF(mv);
+  }
+  return Py_BuildValue("(nN)", (Py_ssize_t)pos, views);
+}
+
+static PyObject* Engine_consume_capture(EngineObject* self, PyObject* args) {
+  int reader;
+  Py_ssize_t n;
+  if (!PyArg_ParseTuple(args, "in", &reader, &n)) return NULL;
+  if (n < 0) n = 0;
+  return PyBool_FromLong(vpio_capture_reader_consume(reader, (size_t)n) == 0);
+}
+
+static PyObject* Engine_capture_reader_stats(EngineObject* self, PyObject* arg) {
+  int reader = (int)PyLong_AsLong(arg);
+  if (reader == -1 && PyErr_Occurred()) return NULL;
+  uint64_t overruns = 0, dropped = 0;
+  size_t level = 0;
+  if (vpio_capture_reader_stats(reader, &overruns, &dropped, &level) != 0) Py_RETURN_NONE;
+  return Py_BuildValue("(KKn)", (unsigned long long)overruns, (unsigned long long)dropped, (Py_ssize_t)level);
+}
+
+static PyObject* Engine_write(EngineObject* self, PyObject* arg) {
+  Py_buffer src;
+  if (PyObject_GetBuffer(arg, &src, PyBUF_SIMPLE) < 0) return NULL;
+  size_t n = vpio_write_frame_10ms(src.buf, (size_t)src.len);
+  PyBuffer_Release(&src);
+  return PyLong_FromSize_t(n);
+}
+
+static PyObject* Engine_write_playback(EngineObject* self, PyObject* arg) {
+  Py_buffer src;
+  if (PyObject_GetBuffer(arg, &src, PyBUF_SIMPLE) < 0) return NULL;
+  size_t n = vpio_write_playback(src.buf, (size_t)src.len);
+  PyBuffer_Release(&src);
+  return PyLong_FromSize_t(n);
+}
+
+static PyObject* Engine_flush_playback(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  vpio_flush_playback();
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_flush_input(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  // Takes the staging lock, which the pacing thread may hold
+  Py_BEGIN_ALLOW_THREADS
+  vpio_flush_input();
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_open_play_stream(EngineObject* self, PyObject* args) {
+  int priority;
+  double gain_db, duck_db;
+  if (!PyArg_ParseTuple(args, "idd", &priority, &gain_db, &duck_db)) return NULL;
+  return PyLong_FromLong(vpio_play_stream_open(priority, gain_db, duck_db));
+}
+
+static PyObject* Engine_set_play_stream(EngineObject* self, PyObject* args) {
+  int stream, priority;
+  double gain_db, duck_db;
+  if (!PyArg_ParseTuple(args, "iidd", &stream, &priority, &gain_db, &duck_db)) return NULL;
+  return PyBool_FromLong(vpio_play_stream_set(stream, priority, gain_db, duck_db) == 0);
+}
+
+static PyObject* Engine_write_play_stream(EngineObject* self, PyObject* args) {
+  int stream;
+  Py_buffer src;
+  if (!PyArg_ParseTuple(args, "iy*", &stream, &src)) return NULL;
+  size_t n = vpio_play_stream_write(stream, src.buf, (size_t)src.len);
+  PyBuffer_Release(&src);
+  return PyLong_FromSize_t(n);
+}
+
+static PyObject* Engine_flush_play_stream(EngineObject* self, PyObject* arg) {
+  int stream = (int)PyLong_AsLong(arg);
+  if (stream == -1 && PyErr_Occurred()) return NULL;
+  vpio_play_stream_flush(stream);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_close_play_stream(EngineObject* self, PyObject* arg) {
+  int stream = (int)PyLong_AsLong(arg);
+  if (stream == -1 && PyErr_Occurred()) return NULL;
+  vpio_play_stream_close(stream);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_play_stream_stats(EngineObject* self, PyObject* arg) {
+  int stream = (int)PyLong_AsLong(arg);
+  if (stream == -1 && PyErr_Occurred()) return NULL;
+  size_t queued = 0;
+  uint64_t played = 0;
+  double duck_db = 0.0;
+  if (vpio_play_stream_stats(stream, &queued, &played, &duck_db) != 0) Py_RETURN_NONE;
+  return Py_BuildValue("(nKd)", (Py_ssize_t)queued, (unsigned long long)played, duck_db);
+}
+
+static PyObject* Engine_playout_mark(EngineObject* self, PyObject* args) {
+  int stream;
+  unsigned long long tag;
+  if (!PyArg_ParseTuple(args, "iK", &stream, &tag)) return NULL;
+  return PyBool_FromLong(vpio_playout_mark(stream, (uint64_t)tag) == 0);
+}
+
+static PyObject* Engine_playout_clock(EngineObject* self, PyObject* arg) {
+  int stream = (int)PyLong_AsLong(arg);
+  if (stream == -1 && PyErr_Occurred()) return NULL;
+  vpio_playout_clock c;
+  memset(&c, 0, sizeof(c));
+  if (vpio_get_playout_clock(stream, &c, sizeof(c)) == 0) Py_RETURN_NONE;
+  return Py_BuildValue("{s:K,s:K,s:K,s:K}", "written", (unsigned long long)c.written,
+                       "rendered", (unsigned long long)c.rendered,
+                       "position", (unsigned long long)c.position,
+                       "dropped", (unsigned long long)c.dropped);
+}
+
+static PyObject* Engine_playout_mark_info(EngineObject* self, PyObject* args) {
+  int stream;
+  unsigned long long tag;
+  if (!PyArg_ParseTuple(args, "iK", &stream, &tag)) return NULL;
+  vpio_playout_mark_info m;
+  memset(&m, 0, sizeof(m));
+  if (vpio_get_playout_mark(stream, (uint64_t)tag, &m, sizeof(m)) == 0) Py_RETURN_NONE;
+  return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K}", "tag", (unsigned long long)m.tag,
+                       "start", (unsigned long long)m.start,
+                       "written", (unsigned long long)m.written,
+                       "heard", (unsigned long long)m.heard,
+                       "pending", (unsigned long long)m.pending);
+}
+
+static PyObject* Engine_register_clip(EngineObject* self, PyObject* arg) {
+  Py_buffer src;
+  if (PyObject_GetBuffer(arg, &src, PyBUF_SIMPLE) != 0) return NULL;
+  int clip;
+  Py_BEGIN_ALLOW_THREADS
+  clip = vpio_clip_register(src.buf, (size_t)src.len);
+  Py_END_ALLOW_THREADS
+  PyBuffer_Release(&src);
+  return PyLong_FromLong(clip);
+}
+
+static PyObject* Engine_unregister_clip(EngineObject* self, PyObject* arg) {
+  int clip = (int)PyLong_AsLong(arg);
+  if (clip == -1 && PyErr_Occurred()) return NULL;
+  return PyBool_FromLong(vpio_clip_unregister(clip) == 0);
+}
+
+static PyObject* Engine_trigger_clip(EngineObject* self, PyObject* args) {
+  int clip;
+  double gain_db = 0.0;
+  if (!PyArg_ParseTuple(args, "i|d", &clip, &gain_db)) return NULL;
+  return PyLong_FromLong(vpio_clip_trigger(clip, gain_db));
+}
+
+static PyObject* Engine_stop_clip(EngineObject* self, PyObject* arg) {
+  int voice = (int)PyLong_AsLong(arg);
+  if (voice == -1 && PyErr_Occurred()) return NULL;
+  return PyBool_FromLong(vpio_clip_stop(voice) == 0);
+}
+
+static PyObject* Engine_event_fd(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  return PyLong_FromLong(vpio_event_fd());
+}
+
+static PyObject* Engine_poll_events(EngineObject* self, PyObject* args) {
+  Py_ssize_t max_events = 64;
+  if (!PyArg_ParseTuple(args, "|n", &max_events)) return NULL;
+  vpio_event buf[64];
+  if (max_events < 0) max_events = 0;
+  if ((size_t)max_events > sizeof(buf) / sizeof(buf[0])) max_events = (Py_ssize_t)(sizeof(buf) / sizeof(buf[0]));
+  size_t n = vpio_poll_events(buf, (size_t)max_events);
+  PyObject* out = PyList_New((Py_ssize_t)n);
+  if (!out) return NULL;
+  for (size_t i = 0; i < n; i++) {
+    PyObject* t = Py_BuildValue("(kkKK)", (unsigned long)buf[i].type, (unsigned long)buf[i].id,
+                                (unsigned long long)buf[i].arg, (unsigned long long)buf[i].host_time_ns);
+    if (!t) { Py_DECREF(out); return NULL; }
+    PyList_SET_ITEM(out, (Py_ssize_t)i, t);
+  }
+  return out;
+}
+
+static PyObject* Engine_start_playback_thread(EngineObject* self, PyObject* args) {
+  int slice_ms, preroll_ms;
+  if (!PyArg_ParseTuple(args, "ii", &slice_ms, &preroll_ms)) return NULL;
+  return PyLong_FromLong(vpio_start_playback_thread(slice_ms, preroll_ms));
+}
+
+static PyObject* Engine_stop_playback_thread(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  Py_BEGIN_ALLOW_THREADS
+  vpio_stop_playback_thread();
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_target_headroom_ms(EngineObject* self, PyObject* arg) {
+  int ms = (int)PyLong_AsLong(arg);
+  if (ms == -1 && PyErr_Occurred()) return NULL;
+  vpio_set_target_headroom_ms(ms);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_vad_gate(EngineObject* self, PyObject* args) {
+  int enabled, hangover_ms, onset_blocks;
+  double margin_db;
+  if (!PyArg_ParseTuple(args, "pdii", &enabled, &margin_db, &hangover_ms, &onset_blocks)) return NULL;
+  vpio_set_vad_gate(enabled, margin_db, hangover_ms, onset_blocks);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_dtx(EngineObject* self, PyObject* args) {
+  int enabled, keepalive_ms;
+  if (!PyArg_ParseTuple(args, "pi", &enabled, &keepalive_ms)) return NULL;
+  vpio_set_dtx(enabled, keepalive_ms);
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_aec(EngineObject* self, PyObject* args) {
+  int enabled, tail_ms, delay_ms;
+  if (!PyArg_ParseTuple(args, "pii", &enabled, &tail_ms, &delay_ms)) return NULL;
+  return PyBool_FromLong(vpio_set_aec(enabled, tail_ms, delay_ms) == 0);
+}
+
+static PyObject* Engine_set_delay_estimator(EngineObject* self, PyObject* args) {
+  int enabled, max_delay_ms;
+  if (!PyArg_ParseTuple(args, "pi", &enabled, &max_delay_ms)) return NULL;
+  return PyBool_FromLong(vpio_set_delay_estimator(enabled, max_delay_ms) == 0);
+}
+
+static PyObject* Engine_delay_estimate(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  double delay_ms = 0.0, confidence = 0.0;
+  if (!vpio_get_delay_estimate(&delay_ms, &confidence)) Py_RETURN_NONE;
+  return Py_BuildValue("(dd)", delay_ms, confidence);
+}
+
+static PyObject* Engine_set_noise_suppressor(EngineObject* self, PyObject* args) {
+  int enabled, budget_pct;
+  double max_atten_db;
+  if (!PyArg_ParseTuple(args, "pdi", &enabled, &max_atten_db, &budget_pct)) return NULL;
+  return PyBool_FromLong(vpio_set_noise_suppressor(enabled, max_atten_db, budget_pct) == 0);
+}
+
+static PyObject* Engine_set_agc(EngineObject* self, PyObject* args) {
+  int direction, enabled;
+  double target_dbfs, max_gain_db, ceiling_dbfs;
+  if (!PyArg_ParseTuple(args, "ipddd", &direction, &enabled, &target_dbfs, &max_gain_db, &ceiling_dbfs)) return NULL;
+  return PyBool_FromLong(vpio_set_agc(direction, enabled, target_dbfs, max_gain_db, ceiling_dbfs) == 0);
+}
+
+static PyObject* Engine_start_recording(EngineObject* self, PyObject* args) {
+  const char* prefix;
+  int format;
+  unsigned int taps;
+  if (!PyArg_ParseTuple(args, "siI", &prefix, &format, &taps)) return NULL;
+  int rc;
+  Py_BEGIN_ALLOW_THREADS
+  rc = vpio_start_recording(prefix, format, taps);
+  Py_END_ALLOW_THREADS
+  return PyBool_FromLong(rc == 0);
+}
+
+static PyObject* Engine_stop_recording(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  Py_BEGIN_ALLOW_THREADS
+  vpio_stop_recording();
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+static PyObject* Engine_set_replay(EngineObject* self, PyObject* args) {
+  const char* capture_path;
+  const char* playback_path;
+  int realtime;
+  PyObject* pattern_obj;
+  if (!PyArg_ParseTuple(args, "zzpO", &capture_path, &playback_path, &realtime, &pattern_obj)) return NULL;
+  uint32_t pattern[32];
+  size_t pattern_len = 0;
+  if (pattern_obj != Py_None) {
+    PyObject* seq = PySequence_Fast(pattern_obj, "pattern must be a sequence of frame counts");
+    if (!seq) return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if ((size_t)n > sizeof(pattern) / sizeof(pattern[0])) {
+      Py_DECREF(seq);
+      PyErr_SetString(PyExc_ValueError, "pattern has more than 32 entries");
+      return NULL;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+      unsigned long v = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM(seq, i));
+      if (v == (unsigned long)-1 && PyErr_Occurred()) { Py_DECREF(seq); return NULL; }
+      pattern[i] = (uint32_t)v;
+    }
+    pattern_len = (size_t)n;
+    Py_DECREF(seq);
+  }
+  return PyBool_FromLong(vpio_set_replay(capture_path, playback_path, realtime,
+                                         pattern_len ? pattern : NULL, pattern_len) == 0);
+}
+
+static PyObject* Engine_levels(EngineObject* self, PyObject* args) {
+  int direction;
+  Py_ssize_t max_entries;
+  if (!PyArg_ParseTuple(args, "in", &direction, &max_entries)) return NULL;
+  vpio_level buf[128];
+  if (max_entries < 0) max_entries = 0;
+  if ((size_t)max_entries > sizeof(buf) / sizeof(buf[0])) max_entries = (Py_ssize_t)(sizeof(buf) / sizeof(buf[0]));
+  size_t n = vpio_get_levels(direction, buf, (size_t)max_entries);
+  PyObject* out = PyList_New((Py_ssize_t)n);
+  if (!out) return NULL;
+  for (size_t i = 0; i < n; i++) {
+    PyObject* t = Py_BuildValue("(Kddkk)", (unsigned long long)buf[i].seq, (double)buf[i].rms,
+                                (double)buf[i].peak, (unsigned long)buf[i].clipped,
+                                (unsigned long)buf[i].samples);
+    if (!t) { Py_DECREF(out); return NULL; }
+    PyList_SET_ITEM(out, (Py_ssize_t)i, t);
+  }
+  return out;
+}
+
+static PyObject* Engine_stats(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  vpio_stats st;
+  memset(&st, 0, sizeof(st));
+  vpio_get_stats(&st, sizeof(st));
+  return Py_BuildValue(
+      "{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:d,s:K,s:d,s:d,s:d,s:K,s:K,s:d,s:d,s:d,s:d,s:d,s:d,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K}",
+      "cap_level", (unsigned long long)st.cap_level,
+      "cap_capacity", (unsigned long long)st.cap_capacity,
+      "play_level", (unsigned long long)st.play_level,
+      "play_capacity", (unsigned long long)st.play_capacity,
+      "staging_level", (unsigned long long)st.staging_level,
+      "staging_capacity", (unsigned long long)st.staging_capacity,
+      "underflows", (unsigned long long)st.underflows,
+      "render_last_bytes", (unsigned long long)st.render_last_bytes,
+      "render_max_bytes", (unsigned long long)st.render_max_bytes,
+      "vad_blocks", (unsigned long long)st.vad_blocks,
+      "vad_open_blocks", (unsigned long long)st.vad_open_blocks,
+      "dtx_frames_sent", (unsigned long long)st.dtx_frames_sent,
+      "dtx_frames_suppressed", (unsigned long long)st.dtx_frames_suppressed,
+      "aec_blocks", (unsigned long long)st.aec_blocks,
+      "aec_erle_db", st.aec_erle_db,
+      "delay_blocks", (unsigned long long)st.delay_blocks,
+      "delay_ms", st.delay_ms,
+      "delay_confidence", st.delay_confidence,
+      "aec_delay_ms", st.aec_delay_ms,
+      "ns_blocks", (unsigned long long)st.ns_blocks,
+      "ns_over_budget", (unsigned long long)st.ns_over_budget,
+      "ns_max_block_us", st.ns_max_block_us,
+      "ns_noise_dbfs", st.ns_noise_dbfs,
+      "agc_capture_gain_db", st.agc_capture_gain_db,
+      "agc_capture_limit_db", st.agc_capture_limit_db,
+      "agc_playback_gain_db", st.agc_playback_gain_db,
+      "agc_playback_limit_db", st.agc_playback_limit_db,
+      "rec_bytes", (unsigned long long)st.rec_bytes,
+      "rec_dropped", (unsigned long long)st.rec_dropped,
+      "replay_frames", (unsigned long long)st.replay_frames,
+      "replay_eof", (unsigned long long)st.replay_eof,
+      "ipc_dropped", (unsigned long long)st.ipc_dropped,
+      "cap_overruns", (unsigned long long)st.cap_overruns,
+      "cap_overrun_bytes", (unsigned long long)st.cap_overrun_bytes,
+      "clip_voices", (unsigned long long)st.clip_voices,
+      "events_dropped", (unsigned long long)st.events_dropped,
+      "play_overruns", (unsigned long long)st.play_overruns,
+      "play_overrun_bytes", (unsigned long long)st.play_overrun_bytes,
+      "playout_breaks_lost", (unsigned long long)st.playout_breaks_lost);
+}
+
+static PyObject* Engine_host_time_now_ns(EngineObject* self, PyObject* Py_UNUSED(ignored)) {
+  return PyLong_FromUnsignedLongLong(vpio_host_time_now_ns());
+}
+
+static PyObject* Engine_get_capabilities(EngineObject* self, void* closure) {
+  return PyLong_FromUnsignedLong(vpio_get_capabilities());
+}
+
+static PyMethodDef Engine_methods[] = {
+    {"start", (PyCFunction)Engine_start, METH_VARARGS,
+     "start(sample_rate, channels, ring_bytes) -> bool; starts the stream (GIL released)"},
+    {"start_async", (PyCFunction)Engine_start_async, METH_VARARGS,
+     "start_async(sample_rate, channels, ring_bytes) -> bool; starts on a worker thread"},
+    {"start_result", (PyCFunction)Engine_start_result, METH_NOARGS,
+     "None while an async start is pending, then its result (0 ok; -1 if none)"},
+    {"start_timings", (PyCFunction)Engine_start_timings, METH_NOARGS,
+     "Startup milestones of the last start, in ms since it began (-1 if not reached)"},
+    {"stop", (PyCFunction)Engine_stop, METH_NOARGS, "Stop the stream and shut down the audio unit"},
+    {"set_capture_frame_ms", (PyCFunction)Engine_set_capture_frame_ms, METH_O,
+     "Configure engine-side capture framing; returns frame size in bytes"},
+    {"set_capture_gate", (PyCFunction)Engine_set_capture_gate, METH_VARARGS,
+     "set_capture_gate(gate, keep_echo=True) -> bool; GATE_OPEN/MUTE/PAUSE from the next callback"},
+    {"capture_gate", (PyCFunction)Engine_capture_gate, METH_NOARGS, NULL},
+    {"set_playback_watermarks", (PyCFunction)Engine_set_playback_watermarks, METH_VARARGS,
+     "set_playback_watermarks(high_bytes, low_bytes=0) -> bool; write() refuses past high (0 = unbounded)"},
+    {"playback_space", (PyCFunction)Engine_playback_space, METH_NOARGS,
+     "playback_space() -> (writable_bytes, queued_bytes)"},
+    {"set_ring_budget", (PyCFunction)Engine_set_ring_budget, METH_VARARGS,
+     "set_ring_budget(ring, max_bytes, shrink_after_ms=2000) -> bool; 0 bytes = no budget"},
+    {"ring_memory", (PyCFunction)Engine_ring_memory, METH_O,
+     "ring_memory(ring) -> dict of committed/level bytes, high-water marks and counters"},
+    {"read_frames", (PyCFunction)Engine_read_frames, METH_VARARGS,
+     "read_frames(dst, max_frames, frame_bytes) -> list[FrameInfo]; fills a writable buffer"},
+    {"open_capture_reader", (PyCFunction)Engine_open_capture_reader, METH_NOARGS,
+     "Open an extra capture reader at the newest capture; returns its id or -1"},
+    {"close_capture_reader", (PyCFunction)Engine_close_capture_reader, METH_O, NULL},
+    {"read_reader_frames", (PyCFunction)Engine_read_reader_frames, METH_VARARGS,
+     "read_reader_frames(reader, dst, max_frames, frame_bytes) -> list[FrameInfo]"},
+    {"peek_capture", (PyCFunction)Engine_peek_capture, METH_VARARGS,
+     "peek_capture(reader, max_bytes) -> (pos, [memoryview]); zero-copy, see consume_capture"},
+    {"consume_capture", (PyCFunction)Engine_consume_capture, METH_VARARGS,
+     "consume_capture(reader, n) -> bool; False if the peeked bytes were overwritten"},
+    {"capture_reader_stats", (PyCFunction)Engine_capture_reader_stats, METH_O,
+     "(overruns, dropped_bytes, level) or None if the reader is not open"},
+    {"write", (PyCFunction)Engine_write, METH_O, "Queue 10ms-multiple PCM into the staging ring"},
+    {"write_playback", (PyCFunction)Engine_write_playback, METH_O,
+     "Write PCM straight into the playback ring"},
+    {"flush_playback", (PyCFunction)Engine_flush_playback, METH_NOARGS, "Drop queued playback"},
+    {"flush_input", (PyCFunction)Engine_flush_input, METH_NOARGS, "Drop staged playback input"},
+    {"open_play_stream", (PyCFunction)Engine_open_play_stream, METH_VARARGS,
+     "open_play_stream(priority, gain_db, duck_db) -> stream id or -1"},
+    {"set_play_stream", (PyCFunction)Engine_set_play_stream, METH_VARARGS,
+     "set_play_stream(stream, priority, gain_db, duck_db) -> bool; stream 0 is the main one"},
+    {"write_play_stream", (PyCFunction)Engine_write_play_stream, METH_VARARGS,
+     "write_play_stream(stream, pcm) -> bytes accepted"},
+    {"flush_play_stream", (PyCFunction)Engine_flush_play_stream, METH_O,
+     "Drop what is queued on one extra stream"},
+    {"close_play_stream", (PyCFunction)Engine_close_play_stream, METH_O, NULL},
+    {"play_stream_stats", (PyCFunction)Engine_play_stream_stats, METH_O,
+     "(queued_bytes, played_bytes, duck_db) or None if the stream is not open"},
+    {"playout_mark", (PyCFunction)Engine_playout_mark, METH_VARARGS,
+     "playout_mark(stream, tag) -> bool; tags the next sample written to the stream"},
+    {"playout_clock", (PyCFunction)Engine_playout_clock, METH_O,
+     "playout_clock(stream) -> dict of written/rendered/position/dropped samples, or None"},
+    {"playout_mark_info", (PyCFunction)Engine_playout_mark_info, METH_VARARGS,
+     "playout_mark_info(stream, tag) -> dict of start/written/heard/pending samples, or None"},
+    {"register_clip", (PyCFunction)Engine_register_clip, METH_O,
+     "Copy PCM into the clip bank once -> clip id or -1"},
+    {"unregister_clip", (PyCFunction)Engine_unregister_clip, METH_O, NULL},
+    {"trigger_clip", (PyCFunction)Engine_trigger_clip, METH_VARARGS,
+     "trigger_clip(clip, gain_db=0.0) -> voice handle or -1"},
+    {"stop_clip", (PyCFunction)Engine_stop_clip, METH_O, "Fade a clip voice out"},
+    {"event_fd", (PyCFunction)Engine_event_fd, METH_NOARGS,
+     "Notifier fd, readable while engine events are pending"},
+    {"poll_events", (PyCFunction)Engine_poll_events, METH_VARARGS,
+     "poll_events(max=64) -> [(type, id, arg, host_time_ns)]"},
+    {"start_playback_thread", (PyCFunction)Engine_start_playback_thread, METH_VARARGS,
+     "start_playback_thread(slice_ms, preroll_ms) -> int"},
+    {"stop_playback_thread", (PyCFunction)Engine_stop_playback_thread, METH_NOARGS,
+     "Stop the C pacing thread (GIL released while joining)"},
+    {"set_target_headroom_ms", (PyCFunction)Engine_set_target_headroom_ms, METH_O, NULL},
+    {"set_vad_gate", (PyCFunction)Engine_set_vad_gate, METH_VARARGS,
+     "set_vad_gate(enabled, margin_db, hangover_ms, onset_blocks)"},
+    {"set_dtx", (PyCFunction)Engine_set_dtx, METH_VARARGS, "set_dtx(enabled, keepalive_ms)"},
+    {"set_aec", (PyCFunction)Engine_set_aec, METH_VARARGS,
+     "set_aec(enabled, tail_ms, delay_ms) -> bool"},
+    {"set_delay_estimator", (PyCFunction)Engine_set_delay_estimator, METH_VARARGS,
+     "set_delay_estimator(enabled, max_delay_ms) -> bool"},
+    {"delay_estimate", (PyCFunction)Engine_delay_estimate, METH_NOARGS,
+     "(delay_ms, confidence) or None before the first estimate"},
+    {"set_noise_suppressor", (PyCFunction)Engine_set_noise_suppressor, METH_VARARGS,
+     "set_noise_suppressor(enabled, max_atten_db, budget_pct) -> bool"},
+    {"set_agc", (PyCFunction)Engine_set_agc, METH_VARARGS,
+     "set_agc(direction, enabled, target_dbfs, max_gain_db, ceiling_dbfs) -> bool"},
+    {"start_recording", (PyCFunction)Engine_start_recording, METH_VARARGS,
+     "start_recording(path_prefix, format, taps) -> bool"},
+    {"stop_recording", (PyCFunction)Engine_stop_recording, METH_NOARGS,
+     "Drain and finalize the recording (GIL released)"},
+    {"set_replay", (PyCFunction)Engine_set_replay, METH_VARARGS,
+     "set_replay(capture_path, playback_path, realtime, pattern) -> bool; before start_stream"},
+    {"levels", (PyCFunction)Engine_levels, METH_VARARGS,
+     "levels(direction, max_entries) -> list[(seq, rms, peak, clipped, samples)], oldest first"},
+    {"stats", (PyCFunction)Engine_stats, METH_NOARGS, "Snapshot of all helper counters"},
+    {"host_time_now_ns", (PyCFunction)Engine_host_time_now_ns, METH_NOARGS,
+     "Host clock now, same units as FrameInfo.host_time_ns"},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyGetSetDef Engine_getset[] = {
+    {"capabilities", (getter)Engine_get_capabilities, NULL, "CAP_* bitmask", NULL},
+    {NULL, NULL, NULL, NULL, NULL},
+};
+
+static PyTypeObject EngineType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_vpio.Engine",
+    .tp_basicsize = sizeof(EngineObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "VoiceProcessingIO engine (process-wide singleton)",
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)Engine_init,
+    .tp_dealloc = (destructor)Engine_dealloc,
+    .tp_methods = Engine_methods,
+    .tp_getset = Engine_getset,
+};
+
+static PyModuleDef vpio_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "_vpio",
+    .m_doc = "Native binding for the VPIO helper",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit__vpio(void) {
+  if (PyType_Ready(&EngineType) < 0) return NULL;
+  FrameInfoType = PyStructSequence_NewType(&frame_info_desc);
+  if (!FrameInfoType) return NULL;
+  PyObject* m = PyModule_Create(&vpio_module);
+  if (!m) return NULL;
+  Py_INCREF(&EngineType);
+  if (PyModule_AddObject(m, "Engine", (PyObject*)&EngineType) < 0) goto fail;
+  Py_INCREF(FrameInfoType);
+  if (PyModule_AddObject(m, "FrameInfo", (PyObject*)FrameInfoType) < 0) goto fail;
+  PyModule_AddIntConstant(m, "CAP_STREAM", VPIO_CAP_STREAM);
+  PyModule_AddIntConstant(m, "CAP_PLAY_THREAD", VPIO_CAP_PLAY_THREAD);
+  PyModule_AddIntConstant(m, "CAP_FLUSH", VPIO_CAP_FLUSH);
+  PyModule_AddIntConstant(m, "CAP_DEBUG", VPIO_CAP_DEBUG);
+  PyModule_AddIntConstant(m, "CAP_VAD_GATE", VPIO_CAP_VAD_GATE);
+  PyModule_AddIntConstant(m, "CAP_FRAMES", VPIO_CAP_FRAMES);
+  PyModule_AddIntConstant(m, "CAP_DTX", VPIO_CAP_DTX);
+  PyModule_AddIntConstant(m, "CAP_STATS", VPIO_CAP_STATS);
+  PyModule_AddIntConstant(m, "CAP_AEC", VPIO_CAP_AEC);
+  PyModule_AddIntConstant(m, "CAP_DELAY_EST", VPIO_CAP_DELAY_EST);
+  PyModule_AddIntConstant(m, "CAP_NS", VPIO_CAP_NS);
+  PyModule_AddIntConstant(m, "CAP_AGC", VPIO_CAP_AGC);
+  PyModule_AddIntConstant(m, "CAP_LEVELS", VPIO_CAP_LEVELS);
+  PyModule_AddIntConstant(m, "CAP_RECORDER", VPIO_CAP_RECORDER);
+  PyModule_AddIntConstant(m, "CAP_REPLAY", VPIO_CAP_REPLAY);
+  PyModule_AddIntConstant(m, "CAP_REMOTE", VPIO_CAP_REMOTE);
+  PyModule_AddIntConstant(m, "CAP_READERS", VPIO_CAP_READERS);
+  PyModule_AddIntConstant(m, "CAP_MIXER", VPIO_CAP_MIXER);
+  PyModule_AddIntConstant(m, "CAP_CLIPS", VPIO_CAP_CLIPS);
+  PyModule_AddIntConstant(m, "CAP_EVENTS", VPIO_CAP_EVENTS);
+  PyModule_AddIntConstant(m, "CAP_ASYNC_START", VPIO_CAP_ASYNC_START);
+  PyModule_AddIntConstant(m, "CAP_CAPTURE_GATE", VPIO_CAP_CAPTURE_GATE);
+  PyModule_AddIntConstant(m, "CAP_RING_BUDGET", VPIO_CAP_RING_BUDGET);
+  PyModule_AddIntConstant(m, "CAP_BACKPRESSURE", VPIO_CAP_BACKPRESSURE);
+  PyModule_AddIntConstant(m, "CAP_PLAYOUT", VPIO_CAP_PLAYOUT);
+  PyModule_AddIntConstant(m, "RING_CAPTURE", VPIO_RING_CAPTURE);
+  PyModule_AddIntConstant(m, "RING_PLAYBACK", VPIO_RING_PLAYBACK);
+  PyModule_AddIntConstant(m, "RING_STAGING", VPIO_RING_STAGING);
+  PyModule_AddIntConstant(m, "GATE_OPEN", VPIO_GATE_OPEN);
+  PyModule_AddIntConstant(m, "GATE_MUTE", VPIO_GATE_MUTE);
+  PyModule_AddIntConstant(m, "GATE_PAUSE", VPIO_GATE_PAUSE);
+  PyModule_AddIntConstant(m, "EVENT_CLIP_DONE", VPIO_EVENT_CLIP_DONE);
+  PyModule_AddIntConstant(m, "EVENT_CLIP_STOPPED", VPIO_EVENT_CLIP_STOPPED);
+  PyModule_AddIntConstant(m, "EVENT_STREAM_STARTED", VPIO_EVENT_STREAM_STARTED);
+  PyModule_AddIntConstant(m, "EVENT_PLAYBACK_WRITABLE", VPIO_EVENT_PLAYBACK_WRITABLE);
+  PyModule_AddIntConstant(m, "REC_TAP_MIC_RAW", VPIO_REC_TAP_MIC_RAW);
+  PyModule_AddIntConstant(m, "REC_TAP_CAPTURE", VPIO_REC_TAP_CAPTURE);
+  PyModule_AddIntConstant(m, "REC_TAP_PLAYBACK", VPIO_REC_TAP_PLAYBACK);
+  PyModule_AddIntConstant(m, "REC_WAV", VPIO_REC_WAV);
+  PyModule_AddIntConstant(m, "REC_FRAMED", VPIO_REC_FRAMED);
+  PyModule_AddIntConstant(m, "DIR_CAPTURE", VPIO_DIR_CAPTURE);
+  PyModule_AddIntConstant(m, "DIR_PLAYBACK", VPIO_DIR_PLAYBACK);
+  PyModule_AddIntConstant(m, "FRAME_OVERRUN", VPIO_FRAME_OVERRUN);
+  PyModule_AddIntConstant(m, "FRAME_VAD_KNOWN", VPIO_FRAME_VAD_KNOWN);
+  PyModule_AddIntConstant(m, "FRAME_VAD_OPEN", VPIO_FRAME_VAD_OPEN);
+  PyModule_AddIntConstant(m, "FRAME_KEEPALIVE", VPIO_FRAME_KEEPALIVE);
+  return m;
+fail:
+  Py_DECREF(m);
+  return NULL;
+}
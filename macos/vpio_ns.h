@@ -0,0 +1,138 @@
+#ifndef VPIO_NS_H
+#define VPIO_NS_H
+
+#include "vpio_fft.h"
+
+// STFT noise suppressor: sqrt-Hann windows at 50% overlap (2*block FFT, one
+// block hop), minimum-statistics noise tracking (Martin 2001: smoothing that
+// lets go when the periodogram is far from the noise estimate, simplified to
+// a fixed bias) and a decision-directed Wiener gain with a floor.
+// Create/destroy allocate; vpio_ns_process does not and is RT-safe.
+
+#define VPIO_NS_SUBWIN 8     // minimum search: 8 sub-windows ...
+#define VPIO_NS_WINDOW_MS 1500 // ... spanning ~1.5s
+
+typedef struct {
+  int block, nfft, nbins;
+  vpio_fft fft;
+  float* win;         // nfft sqrt-Hann (analysis and synthesis)
+  float* inbuf;       // nfft: previous + current hop
+  float* olap;        // block: overlap-add tail
+  float* re; float* im; // nfft scratch
+  float* psd;         // smoothed periodogram
+  float* noise;       // noise power estimate
+  float* curmin;      // running minimum of the current sub-window
+  float* submin;      // VPIO_NS_SUBWIN * nbins sub-window minima
+  float* gain;        // last gains (reused in hold mode)
+  float* prev_clean;  // |G*Y|^2 of the previous frame (decision-directed)
+  int sub_len;        // frames per sub-window
+  int sub_count, sub_idx, subs_filled;
+  float gain_floor;   // linear
+  uint64_t frames;
+} vpio_ns;
+
+static void vpio_ns_destroy(vpio_ns* s) {
+  if (!s) return;
+  vpio_fft_free(&s->fft);
+  free(s->win); free(s->inbuf); free(s->olap); free(s->re); free(s->im);
+  free(s->psd); free(s->noise); free(s->curmin); free(s->submin);
+  free(s->gain); free(s->prev_clean);
+  free(s);
+}
+
+// block must be a power of two; max_atten_db bounds the suppression (e.g. 20)
+static vpio_ns* vpio_ns_create(int block, double sample_rate, double max_atten_db) {
+  if (block < 16 || (block & (block - 1))) return NULL;
+  vpio_ns* s = (vpio_ns*)calloc(1, sizeof(*s));
+  if (!s) return NULL;
+  s->block = block;
+  s->nfft = block * 2;
+  s->nbins = block + 1;
+  size_t N = (size_t)s->nfft, K = (size_t)s->nbins;
+  s->win = (float*)calloc(N, sizeof(float));
+  s->inbuf = (float*)calloc(N, sizeof(float));
+  s->olap = (float*)calloc((size_t)block, sizeof(float));
+  s->re = (float*)calloc(N, sizeof(float));
+  s->im = (float*)calloc(N, sizeof(float));
+  s->psd = (float*)calloc(K, sizeof(float));
+  s->noise = (float*)calloc(K, sizeof(float));
+  s->curmin = (float*)calloc(K, sizeof(float));
+  s->submin = (float*)calloc(K * VPIO_NS_SUBWIN, sizeof(float));
+  s->gain = (float*)calloc(K, sizeof(float));
+  s->prev_clean = (float*)calloc(K, sizeof(float));
+  if (vpio_fft_init(&s->fft, s->nfft) != 0 || !s->win || !s->inbuf || !s->olap || !s->re || !s->im ||
+      !s->psd || !s->noise || !s->curmin || !s->submin || !s->gain || !s->prev_clean) {
+    vpio_ns_destroy(s);
+    return NULL;
+  }
+  for (size_t i = 0; i < N; i++) s->win[i] = (float)sqrt(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)N));
+  for (size_t k = 0; k < K; k++) s->gain[k] = 1.0f;
+  double frames = VPIO_NS_WINDOW_MS / 1000.0 * sample_rate / (double)block;
+  s->sub_len = (int)(frames / VPIO_NS_SUBWIN);
+  if (s->sub_len < 1) s->sub_len = 1;
+  if (max_atten_db < 0.0) max_atten_db = 0.0;
+  s->gain_floor = (float)pow(10.0, -max_atten_db / 20.0);
+  return s;
+}
+
+// Suppress noise in one block; output lags input by one block. With hold
+// set the previous gains are reused and tracking is skipped (cheaper).
+static void vpio_ns_process(vpio_ns* s, const float* in, float* out, int hold) {
+  const int B = s->block, N = s->nfft, K = s->nbins;
+  float* re = s->re; float* im = s->im;
+  memmove(s->inbuf, s->inbuf + B, sizeof(float) * (size_t)B);
+  memcpy(s->inbuf + B, in, sizeof(float) * (size_t)B);
+  for (int i = 0; i < N; i++) { re[i] = s->inbuf[i] * s->win[i]; im[i] = 0.0f; }
+  vpio_fft_forward(&s->fft, re, im);
+
+  if (!hold) {
+    const float alpha = 0.9f;    // periodogram smoothing on noise ...
+    const float alpha_min = 0.2f; // ... down to this one well above it
+    const float bias = 2.5f;     // minimum -> mean noise power
+    const float dd = 0.98f;      // decision-directed weight
+    int first = (s->frames == 0);
+    for (int k = 0; k < K; k++) {
+      float p = re[k] * re[k] + im[k] * im[k];
+      // With fixed smoothing the periodogram is still decaying from speech
+      // through a short pause, and the minimum lands well above the noise
+      float q = s->psd[k] / (s->noise[k] + 1e-12f) - 1.0f;
+      float a = alpha / (1.0f + q * q);
+      if (a < alpha_min) a = alpha_min;
+      s->psd[k] = first ? p : a * s->psd[k] + (1.0f - a) * p;
+      if (first || s->psd[k] < s->curmin[k]) s->curmin[k] = s->psd[k];
+    }
+    if (++s->sub_count >= s->sub_len) {
+      memcpy(s->submin + (size_t)s->sub_idx * (size_t)K, s->curmin, sizeof(float) * (size_t)K);
+      s->sub_idx = (s->sub_idx + 1) % VPIO_NS_SUBWIN;
+      if (s->subs_filled < VPIO_NS_SUBWIN) s->subs_filled++;
+      memcpy(s->curmin, s->psd, sizeof(float) * (size_t)K);
+      s->sub_count = 0;
+    }
+    for (int k = 0; k < K; k++) {
+      float m = s->curmin[k];
+      for (int u = 0; u < s->subs_filled; u++) {
+        float v = s->submin[(size_t)u * (size_t)K + (size_t)k];
+        if (v < m) m = v;
+      }
+      float nz = bias * m + 1e-12f;
+      s->noise[k] = nz;
+      float p = re[k] * re[k] + im[k] * im[k];
+      float post = p / nz - 1.0f;
+      if (post < 0.0f) post = 0.0f;
+      float xi = dd * s->prev_clean[k] / nz + (1.0f - dd) * post;
+      float g = xi / (1.0f + xi);
+      if (g < s->gain_floor) g = s->gain_floor;
+      s->gain[k] = g;
+      s->prev_clean[k] = g * g * p;
+    }
+  }
+  for (int k = 0; k < K; k++) { re[k] *= s->gain[k]; im[k] *= s->gain[k]; }
+  vpio_fft_real_inverse(&s->fft, re, im, re);
+  for (int i = 0; i < B; i++) {
+    out[i] = s->olap[i] + re[i] * s->win[i];
+    s->olap[i] = re[B + i] * s->win[B + i];
+  }
+  s->frames++;
+}
+
+#endif // VPIO_NS_H
@@ -0,0 +1,326 @@
+#ifndef VPIO_RING_H
+#define VPIO_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Byte ring behind the engine's queues: capture, main playback, staging,
+// extra playback streams, echo reference, recorder taps. w and r are
+// free-running byte counters and the capacity is a power of two, so a
+// position wraps with a mask. The producer's fields and the consumer's live
+// on separate cache lines, and each side keeps its own copy of the other's
+// counter: it only loads the real one when its copy says the ring is too
+// full (or too empty) for the request at hand. One producer, one consumer;
+// vpio_ring_flush and vpio_ring_level are safe from any thread.
+//
+// vpio_ring_write never touches unread bytes. vpio_ring_overwrite drops the
+// oldest instead: it stores the end of the write in claim before copying,
+// and a reader checks claim after copying to discard a torn copy
+// (vpio_ring_read_lapped for the consumer, vpio_ring_get_intact for readers
+// that keep their own cursor, like the capture readers).
+
+#define VPIO_CACHE_LINE 64
+
+typedef struct {
+  // producer
+  _Alignas(VPIO_CACHE_LINE) _Atomic size_t w;
+  _Atomic size_t claim;      // end of the write in progress
+  size_t r_seen;             // producer's copy of r
+  // consumer
+  _Alignas(VPIO_CACHE_LINE) _Atomic size_t r;
+  size_t w_seen;             // consumer's copy of w
+  // read-mostly
+  _Alignas(VPIO_CACHE_LINE) unsigned char* buf;
+  size_t cap;                // power of two; 0 until allocated
+  size_t mask;
+  _Atomic size_t skip_to;    // flush: the consumer drops everything before this
+} vpio_ring;
+
+// Copy for ring bytes a lapping writer may overwrite at the same moment. The
+// claim check discards torn copies, so memcpy is fine on real hardware; under
+// ThreadSanitizer the bytes move as relaxed atomics, as the C11 model
+// requires of a seqlock, so only genuine races get reported.
+#if defined(__SANITIZE_THREAD__)
+#define VPIO_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define VPIO_TSAN 1
+#endif
+#endif
+
+// Seqlock fences. ThreadSanitizer does not model atomic_thread_fence (GCC
+// warns with -Wtsan), so under it the fence goes and the sequence access
+// next to it becomes seq_cst, which TSan does follow.
+#ifdef VPIO_TSAN
+#define VPIO_SEQ_FENCE(order) ((void)0)
+#define VPIO_SEQ_ORDER(order) memory_order_seq_cst
+#else
+#define VPIO_SEQ_FENCE(order) atomic_thread_fence(order)
+#define VPIO_SEQ_ORDER(order) (order)
+#endif
+
+static inline void* vpio_ring_copy_bytes(void* dst, const void* src, size_t n) {
+#ifdef VPIO_TSAN
+  unsigned char* d = (unsigned char*)dst;
+  const unsigned char* p = (const unsigned char*)src;
+  for (size_t i = 0; i < n; i++)
+    __atomic_store_n(d + i, __atomic_load_n(p + i, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+  return dst;
+#else
+  return memcpy(dst, src, n);
+#endif
+}
+
+// Smallest power of two >= n, and largest <= n (0 for 0)
+static inline size_t vpio_ring_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+static inline size_t vpio_ring_pow2_floor(size_t n) {
+  if (!n) return 0;
+  size_t p = 1;
+  while (p <= n / 2) p <<= 1;
+  return p;
+}
+
+// Copy n bytes into / out of a power-of-two buffer at position pos, wrapping
+static inline void vpio_ring_span_in(unsigned char* base, size_t mask, size_t pos, const void* src,
+                                     size_t n, void* (*copy)(void*, const void*, size_t)) {
+  size_t idx = pos & mask;
+  size_t first = mask + 1 - idx;
+  if (first > n) first = n;
+  copy(base + idx, src, first);
+  if (n > first) copy(base, (const unsigned char*)src + first, n - first);
+}
+static inline void vpio_ring_span_out(const unsigned char* base, size_t mask, size_t pos, void* dst,
+                                      size_t n, void* (*copy)(void*, const void*, size_t)) {
+  size_t idx = pos & mask;
+  size_t first = mask + 1 - idx;
+  if (first > n) first = n;
+  copy(dst, base + idx, first);
+  if (n > first) copy((unsigned char*)dst + first, base, n - first);
+}
+
+// Empty ring at position pos; neither side may be running
+static inline void vpio_ring_reset(vpio_ring* rg, size_t pos) {
+  atomic_store_explicit(&rg->w, pos, memory_order_relaxed);
+  atomic_store_explicit(&rg->claim, pos, memory_order_relaxed);
+  atomic_store_explicit(&rg->r, pos, memory_order_relaxed);
+  atomic_store_explicit(&rg->skip_to, pos, memory_order_release);
+  rg->r_seen = pos;
+  rg->w_seen = pos;
+}
+
+// Allocate at least min_cap bytes (rounded up to a power of two) and reset.
+// Returns 0, or -1 if the buffer could not be allocated.
+static inline int vpio_ring_alloc(vpio_ring* rg, size_t min_cap) {
+  size_t cap = vpio_ring_pow2(min_cap ? min_cap : 1);
+  unsigned char* p = (unsigned char*)malloc(cap);
+  if (!p) return -1;
+  rg->buf = p;
+  rg->cap = cap;
+  rg->mask = cap - 1;
+  vpio_ring_reset(rg, 0);
+  return 0;
+}
+
+static inline void vpio_ring_free(vpio_ring* rg) {
+  free(rg->buf);
+  rg->buf = NULL;
+  rg->cap = 0;
+  rg->mask = 0;
+  vpio_ring_reset(rg, 0);
+}
+
+// Any thread: bytes still to be read (what a flush or a lap has not already
+// discarded), at most cap
+static inline size_t vpio_ring_level(vpio_ring* rg) {
+  size_t r = atomic_load_explicit(&rg->r, memory_order_acquire);
+  size_t skip = atomic_load_explicit(&rg->skip_to, memory_order_acquire);
+  if ((ptrdiff_t)(skip - r) > 0) r = skip;
+  size_t n = atomic_load_explicit(&rg->w, memory_order_acquire) - r;
+  if ((ptrdiff_t)n < 0) return 0;
+  return n < rg->cap ? n : rg->cap;
+}
+
+// Any thread: drop everything written so far from the consumer's next read on
+static inline void vpio_ring_flush(vpio_ring* rg) {
+  atomic_store_explicit(&rg->skip_to, atomic_load_explicit(&rg->w, memory_order_acquire),
+                        memory_order_release);
+}
+
+// Producer: free bytes. Flushed bytes only count once the consumer has
+// skipped them, as it may still be copying them.
+static inline size_t vpio_ring_writable(vpio_ring* rg, size_t want) {
+  size_t w = atomic_load_explicit(&rg->w, memory_order_relaxed);
+  size_t used = w - rg->r_seen;
+  if (used > rg->cap || rg->cap - used < want) {
+    rg->r_seen = atomic_load_explicit(&rg->r, memory_order_acquire);
+    used = w - rg->r_seen;
+  }
+  return used < rg->cap ? rg->cap - used : 0;
+}
+
+static inline size_t vpio_ring_wpos(const vpio_ring* rg) {
+  return atomic_load_explicit(&rg->w, memory_order_relaxed);
+}
+
+// Producer: fill [pos, pos+n) ahead of vpio_ring_commit (the caller checked
+// the space)
+static inline void vpio_ring_put(vpio_ring* rg, size_t pos, const void* src, size_t n) {
+  vpio_ring_span_in(rg->buf, rg->mask, pos, src, n, memcpy);
+}
+
+// Producer: publish everything up to w
+static inline void vpio_ring_commit(vpio_ring* rg, size_t w) {
+  atomic_store_explicit(&rg->claim, w, memory_order_relaxed);
+  atomic_store_explicit(&rg->w, w, memory_order_release);
+}
+
+// Producer: queue up to len bytes; returns how many fit
+static inline size_t vpio_ring_write(vpio_ring* rg, const void* src, size_t len) {
+  size_t room = vpio_ring_writable(rg, len);
+  size_t n = len < room ? len : room;
+  if (!n) return 0;
+  size_t w = vpio_ring_wpos(rg);
+  vpio_ring_put(rg, w, src, n);
+  vpio_ring_commit(rg, w + n);
+  return n;
+}
+
+// Producer, dropping the oldest: write n <= cap bytes whatever the consumer
+// has not read yet
+static inline void vpio_ring_overwrite(vpio_ring* rg, const void* src, size_t n) {
+  size_t w = vpio_ring_wpos(rg);
+  atomic_store_explicit(&rg->claim, w + n, VPIO_SEQ_ORDER(memory_order_relaxed));
+  VPIO_SEQ_FENCE(memory_order_release);
+  vpio_ring_span_in(rg->buf, rg->mask, w, src, n, vpio_ring_copy_bytes);
+  atomic_store_explicit(&rg->w, w + n, memory_order_release);
+}
+
+// Consumer: read position, after applying a pending flush
+static inline size_t vpio_ring_rpos(vpio_ring* rg) {
+  size_t r = atomic_load_explicit(&rg->r, memory_order_relaxed);
+  size_t skip = atomic_load_explicit(&rg->skip_to, memory_order_acquire);
+  if ((ptrdiff_t)(skip - r) > 0) {
+    r = skip;
+    atomic_store_explicit(&rg->r, r, memory_order_release);
+  }
+  return r;
+}
+
+// Consumer: bytes published from the read position on
+static inline size_t vpio_ring_readable(vpio_ring* rg, size_t want) {
+  size_t r = vpio_ring_rpos(rg);
+  size_t n = rg->w_seen - r;
+  if ((ptrdiff_t)n < 0 || n < want) {
+    rg->w_seen = atomic_load_explicit(&rg->w, memory_order_acquire);
+    n = rg->w_seen - r;
+  }
+  return n;
+}
+
+static inline void vpio_ring_get(const vpio_ring* rg, size_t pos, void* dst, size_t n) {
+  vpio_ring_span_out(rg->buf, rg->mask, pos, dst, n, memcpy);
+}
+
+// Contiguous bytes at pos: returns them and stores how many (<= n) in *len
+static inline const unsigned char* vpio_ring_span(const vpio_ring* rg, size_t pos, size_t n, size_t* len) {
+  size_t idx = pos & rg->mask;
+  *len = rg->cap - idx < n ? rg->cap - idx : n;
+  return rg->buf + idx;
+}
+
+// Consumer: release everything before pos to the producer
+static inline void vpio_ring_consume(vpio_ring* rg, size_t pos) {
+  atomic_store_explicit(&rg->r, pos, memory_order_release);
+}
+
+// Consumer: read up to len bytes; returns how many
+static inline size_t vpio_ring_read(vpio_ring* rg, void* dst, size_t len) {
+  size_t avail = vpio_ring_readable(rg, len);
+  size_t n = len < avail ? len : avail;
+  if (!n) return 0;
+  size_t r = atomic_load_explicit(&rg->r, memory_order_relaxed);
+  vpio_ring_get(rg, r, dst, n);
+  vpio_ring_consume(rg, r + n);
+  return n;
+}
+
+// Readers that keep their own cursor: oldest position still intact for a
+// reader at pos (pos itself unless the producer lapped it)
+static inline size_t vpio_ring_oldest(const vpio_ring* rg, size_t pos) {
+  size_t claim = atomic_load_explicit(&rg->claim, memory_order_acquire);
+  return claim - pos <= rg->cap ? pos : claim - rg->cap;
+}
+
+// 1 if the bytes from pos on were not overwritten by the time the caller
+// finished reading them
+static inline int vpio_ring_intact(const vpio_ring* rg, size_t pos) {
+  VPIO_SEQ_FENCE(memory_order_acquire);
+  return atomic_load_explicit(&rg->claim, VPIO_SEQ_ORDER(memory_order_relaxed)) - pos <= rg->cap;
+}
+
+// Copy n published bytes from pos; 0 if the producer got there first
+static inline int vpio_ring_get_intact(const vpio_ring* rg, size_t pos, void* dst, size_t n) {
+  vpio_ring_span_out(rg->buf, rg->mask, pos, dst, n, vpio_ring_copy_bytes);
+  return vpio_ring_intact(rg, pos);
+}
+
+// Any thread: end of the published bytes
+static inline size_t vpio_ring_published(const vpio_ring* rg) {
+  return atomic_load_explicit(&rg->w, memory_order_acquire);
+}
+
+// Consumer of a ring vpio_ring_overwrite may lap: read up to len bytes,
+// skipping what was overwritten before it got there, and copy again if a
+// lap tore the copy (bounded, as each lap needs a new write). Adds the laps
+// and the bytes they cost to *laps and *lost.
+static inline size_t vpio_ring_read_lapped(vpio_ring* rg, void* dst, size_t len, uint64_t* laps,
+                                           uint64_t* lost) {
+  size_t r = vpio_ring_rpos(rg);
+  size_t n = 0;
+  for (int attempt = 0; attempt < 4; attempt++) {
+    size_t oldest = vpio_ring_oldest(rg, r);
+    if (oldest != r) {
+      (*laps)++;
+      *lost += (uint64_t)(oldest - r);
+      r = oldest;
+    }
+    size_t avail = atomic_load_explicit(&rg->w, memory_order_acquire) - r;
+    n = avail < len ? avail : len;
+    if (!n || vpio_ring_get_intact(rg, r, dst, n)) break;
+    n = 0; // torn by a lapping write: skip ahead and copy again
+  }
+  vpio_ring_consume(rg, r + n);
+  return n;
+}
+
+// Move the unread bytes to a new buffer of cap bytes (a power of two no
+// smaller than the backlog), keeping their positions. Both sides must be
+// held off meanwhile. Returns 0, or -1 if the buffer could not be allocated.
+static inline int vpio_ring_resize(vpio_ring* rg, size_t cap) {
+  size_t r = vpio_ring_rpos(rg);
+  size_t w = atomic_load_explicit(&rg->w, memory_order_acquire);
+  unsigned char* p = (unsigned char*)malloc(cap);
+  if (!p) return -1;
+  for (size_t pos = r; pos != w; ) {
+    size_t len;
+    const unsigned char* s = vpio_ring_span(rg, pos, w - pos, &len);
+    vpio_ring_span_in(p, cap - 1, pos, s, len, memcpy);
+    pos += len;
+  }
+  free(rg->buf);
+  rg->buf = p;
+  rg->cap = cap;
+  rg->mask = cap - 1;
+  rg->r_seen = r;
+  rg->w_seen = w;
+  return 0;
+}
+
+#endif // VPIO_RING_H
@@ -0,0 +1,173 @@
+#ifndef VPIO_SHM_H
+#define VPIO_SHM_H
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "vpio.h"
+#include "vpio_ring.h"
+
+// Shared-memory segment between the out-of-process engine (vpio_daemon.c)
+// and its client (vpio_remote_* in vpio_helper.c): this header, then the
+// capture ring, then the playback ring. Both are SPSC byte rings with
+// free-running counters and power-of-two sizes, laid out like vpio_ring
+// (each side on its own cache line with a copy of the other's counter); the
+// daemon produces capture records, the client produces playback bytes. The
+// client rings `bell` after playback writes and mailbox requests; the daemon
+// bumps cmd_done when a request finishes. Both are futex words on Linux;
+// elsewhere waiters poll them in 1ms steps. The client unlinks the name once
+// it has mapped the segment.
+
+#define VPIO_SHM_MAGIC 0x4f495056u // "VPIO"
+#define VPIO_SHM_VERSION 3
+#define VPIO_SHM_CMD_DATA 4096
+#define VPIO_SHM_STATS_WORDS (sizeof(vpio_stats) / sizeof(uint64_t))
+
+// Engine features a client can reach through the segment
+#define VPIO_SHM_CAPS                                                                          \
+  (VPIO_CAP_STREAM | VPIO_CAP_PLAY_THREAD | VPIO_CAP_FLUSH | VPIO_CAP_VAD_GATE |               \
+   VPIO_CAP_FRAMES | VPIO_CAP_DTX | VPIO_CAP_STATS | VPIO_CAP_AEC | VPIO_CAP_DELAY_EST |        \
+   VPIO_CAP_NS | VPIO_CAP_AGC | VPIO_CAP_LEVELS | VPIO_CAP_RECORDER | VPIO_CAP_REPLAY |         \
+   VPIO_CAP_CAPTURE_GATE)
+
+// Mailbox operations; arguments in cmd_i / cmd_d / cmd_data as noted
+enum {
+  VPIO_SHM_OP_NONE = 0,
+  VPIO_SHM_OP_STOP,              // stop the engine and exit
+  VPIO_SHM_OP_FRAME_MS,          // i0 = ms; result = frame bytes
+  VPIO_SHM_OP_VAD_GATE,          // i0 enabled, d0 margin, i1 hangover, i2 onset
+  VPIO_SHM_OP_DTX,               // i0 enabled, i1 keepalive_ms
+  VPIO_SHM_OP_AEC,               // i0 enabled, i1 tail_ms, i2 delay_ms
+  VPIO_SHM_OP_DELAY_EST,         // i0 enabled, i1 max_delay_ms
+  VPIO_SHM_OP_DELAY_ESTIMATE,    // result 1/0; out0 delay_ms, out1 confidence
+  VPIO_SHM_OP_NS,                // i0 enabled, d0 max_atten_db, i1 budget_pct
+  VPIO_SHM_OP_AGC,               // i0 direction, i1 enabled, d0 target, d1 max gain, d2 ceiling
+  VPIO_SHM_OP_START_REC,         // data = path prefix, i0 format, i1 taps
+  VPIO_SHM_OP_STOP_REC,
+  VPIO_SHM_OP_LEVELS,            // i0 direction, i1 max; data = vpio_level[result]
+  VPIO_SHM_OP_FLUSH_PLAYBACK,    // also drops what is still in the playback ring
+  VPIO_SHM_OP_FLUSH_INPUT,
+  VPIO_SHM_OP_HEADROOM,          // i0 ms
+  VPIO_SHM_OP_START_PLAY_THREAD, // i0 slice_ms, i1 preroll_ms
+  VPIO_SHM_OP_STOP_PLAY_THREAD,
+  VPIO_SHM_OP_CAPTURE_GATE,      // i0 gate, i1 keep_echo
+};
+
+typedef struct {
+  _Atomic uint64_t w;   // producer
+  uint64_t r_seen;      // producer's copy of r
+  char pad0[48];
+  _Atomic uint64_t r;   // consumer
+  uint64_t w_seen;      // consumer's copy of w
+  char pad1[48];
+  uint64_t size;        // bytes, a power of two
+  uint64_t offset;      // from the segment base
+} vpio_shm_ring;
+
+// Capture ring record: this header, then `bytes` of PCM
+typedef struct {
+  uint32_t bytes;
+  uint32_t reserved;
+  vpio_frame_info info;
+} vpio_shm_frame;
+
+typedef struct {
+  _Atomic uint32_t magic;       // stored last (release) once the engine runs
+  uint32_t version;
+  int32_t status;               // 0 running, -1 the engine failed to start
+  uint32_t capabilities;        // engine capability mask
+  double sample_rate;
+  int32_t channels;
+  int32_t daemon_pid;
+  _Atomic uint32_t bell;        // client -> daemon: playback written / request posted
+  uint32_t reserved0;
+  _Atomic uint64_t cap_dropped; // capture frames dropped: the client fell behind
+  // One-slot mailbox: the client fills op/args and bumps cmd_req; the daemon
+  // runs it, fills the results and stores cmd_done = cmd_req.
+  _Atomic uint32_t cmd_req;
+  _Atomic uint32_t cmd_done;
+  int32_t cmd_op;
+  int32_t cmd_i[4];
+  double cmd_d[4];
+  int64_t cmd_result;
+  double cmd_out[2];
+  unsigned char cmd_data[VPIO_SHM_CMD_DATA];
+  // Stats snapshot as words under a seqlock (odd while the daemon writes)
+  _Atomic uint32_t stats_seq;
+  uint32_t reserved1;
+  _Atomic uint64_t stats[VPIO_SHM_STATS_WORDS];
+  vpio_shm_ring cap;
+  vpio_shm_ring play;
+} vpio_shm_header;
+
+_Static_assert(sizeof(vpio_stats) % sizeof(uint64_t) == 0, "vpio_stats must be whole 64-bit words");
+
+static inline unsigned char* vpio_shm_ring_data(vpio_shm_header* h, vpio_shm_ring* rg) {
+  return (unsigned char*)h + rg->offset;
+}
+
+// Producer side: free bytes at write position w, loading r only when the
+// cached copy shows fewer than want
+static inline size_t vpio_shm_ring_space(vpio_shm_ring* rg, uint64_t w, size_t want) {
+  size_t space = (size_t)(rg->size - (w - rg->r_seen));
+  if (space < want) {
+    rg->r_seen = atomic_load_explicit(&rg->r, memory_order_acquire);
+    space = (size_t)(rg->size - (w - rg->r_seen));
+  }
+  return space;
+}
+
+// Consumer side: published bytes from read position r, loading w only when
+// the cached copy shows fewer than want
+static inline size_t vpio_shm_ring_avail(vpio_shm_ring* rg, uint64_t r, size_t want) {
+  size_t avail = (size_t)(rg->w_seen - r);
+  if ((int64_t)(rg->w_seen - r) < 0 || avail < want) {
+    rg->w_seen = atomic_load_explicit(&rg->w, memory_order_acquire);
+    avail = (size_t)(rg->w_seen - r);
+  }
+  return avail;
+}
+
+// Producer side: copy len bytes at the write position without publishing
+// (the caller checked the space). Returns the position after them.
+static inline uint64_t vpio_shm_ring_copy_in(vpio_shm_header* h, vpio_shm_ring* rg, uint64_t pos,
+                                             const void* src, size_t len) {
+  vpio_ring_span_in(vpio_shm_ring_data(h, rg), (size_t)rg->size - 1, (size_t)pos, src, len, memcpy);
+  return pos + len;
+}
+
+// Consumer side counterpart of vpio_shm_ring_copy_in
+static inline uint64_t vpio_shm_ring_copy_out(vpio_shm_header* h, vpio_shm_ring* rg, uint64_t pos,
+                                              void* dst, size_t len) {
+  vpio_ring_span_out(vpio_shm_ring_data(h, rg), (size_t)rg->size - 1, (size_t)pos, dst, len, memcpy);
+  return pos + len;
+}
+
+static inline void vpio_shm_wake(_Atomic uint32_t* word) {
+#if defined(__linux__)
+  syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+  (void)word;
+#endif
+}
+
+// Wait until *word moves off `seen` or timeout_ms passes; may return early
+static inline void vpio_shm_wait(_Atomic uint32_t* word, uint32_t seen, int timeout_ms) {
+#if defined(__linux__)
+  struct timespec ts = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+  syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, seen, &ts, NULL, 0);
+#else
+  for (int i = 0; i < timeout_ms && atomic_load_explicit(word, memory_order_acquire) == seen; i++)
+    usleep(1000);
+#endif
+}
+
+#endif // VPIO_SHM_H
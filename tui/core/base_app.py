@@ -12,6 +12,7 @@ from tui.core.services.transport_manager import TransportManager
 from tui.core.services.bot_runner import BotRunner
 from tui.core.utils.clipboard import copy_text
 
+from tui.widgets.level_meter import LevelMeter
 from tui.widgets.syslog_panel import SyslogPanel
 from tui.widgets.rtvi_list_panel import RTVIListPanel
 
@@ -75,6 +76,7 @@ class BotTUIBase(App):
         with Vertical():
             self.status = Static("Status: initializing", id="status")
             yield self.status
+            yield LevelMeter(self.transport_mgr.levels, id="levels")
             with Horizontal(id="rtvi_panes"):
                 self.rtvi_inbox = RTVIListPanel(id="inbox", classes="log")
                 self.rtvi_outbox = RTVIListPanel(id="outbox", classes="log")
@@ -70,6 +70,12 @@ class TransportManager:
     def on_outbound(self, callback: Callable[[Any], Awaitable[None] | None]) -> None:
         self._on_outbound.append(callback)
 
+    def levels(self) -> Optional[dict]:
+        """Latest capture/playback meter readings (see LocalMacTransport.audio_levels)."""
+        if self.transport is None:
+            return None
+        return self.transport.audio_levels()
+
     async def send_app_message(self, msg: Any) -> None:
         if not self.transport:
             raise RuntimeError("Transport not started")
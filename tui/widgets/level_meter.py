@@ -0,0 +1,76 @@
+from __future__ import annotations
+
+from typing import Callable, Optional
+
+from textual.widgets import Static
+
+# (rms_dbfs, peak_dbfs, clipped) per direction, or None when unavailable
+LevelSource = Callable[[], Optional[dict]]
+
+
+class LevelMeter(Static):
+    """Two-line VU meter (mic / speaker) fed by the transport's native meters.
+
+    Polls `source` at 30 Hz; the helper keeps the 10 ms level history, so
+    nothing here touches audio data. Peaks hold briefly, then fall.
+    """
+
+    DEFAULT_CSS = """
+    LevelMeter { height: 2; padding: 0 1; }
+    """
+
+    FLOOR_DB = -60.0
+    REFRESH_HZ = 30.0
+    PEAK_HOLD_S = 1.0
+    PEAK_FALL_DB_S = 20.0
+    CLIP_HOLD_S = 2.0
+
+    def __init__(self, source: LevelSource, **kwargs):  # type: ignore[no-untyped-def]
+        super().__init__("", **kwargs)
+        self._source = source
+        self._peak = {"capture": self.FLOOR_DB, "playback": self.FLOOR_DB}
+        self._peak_age = {"capture": 0.0, "playback": 0.0}
+        self._clip_left = {"capture": 0.0, "playback": 0.0}
+
+    def on_mount(self) -> None:
+        self.set_interval(1.0 / self.REFRESH_HZ, self._tick)
+
+    def _tick(self) -> None:
+        try:
+            levels = self._source()
+        except Exception:
+            levels = None
+        if not levels:
+            self.update("")
+            return
+        dt = 1.0 / self.REFRESH_HZ
+        width = max(10, self.size.width - 26)
+        lines = []
+        for name, label in (("capture", "Mic"), ("playback", "Out")):
+            rms_db, peak_db, clipped = levels.get(name, (self.FLOOR_DB, self.FLOOR_DB, 0))
+            self._peak_age[name] += dt
+            if peak_db >= self._peak[name]:
+                self._peak[name] = peak_db
+                self._peak_age[name] = 0.0
+            elif self._peak_age[name] > self.PEAK_HOLD_S:
+                self._peak[name] = max(peak_db, self._peak[name] - self.PEAK_FALL_DB_S * dt)
+            if clipped:
+                self._clip_left[name] = self.CLIP_HOLD_S
+            else:
+                self._clip_left[name] = max(0.0, self._clip_left[name] - dt)
+            lines.append(self._render_line(label, rms_db, self._peak[name], self._clip_left[name] > 0, width))
+        self.update("\n".join(lines))
+
+    def _render_line(self, label: str, rms_db: float, peak_db: float, clip: bool, width: int) -> str:
+        def col(db: float) -> int:
+            frac = (max(self.FLOOR_DB, min(0.0, db)) - self.FLOOR_DB) / -self.FLOOR_DB
+            return int(round(frac * width))
+
+        fill = col(rms_db)
+        mark = min(col(peak_db), width - 1)
+        cells = ["█" if i < fill else "·" for i in range(width)]
+        if mark >= fill:
+            cells[mark] = "│"
+        bar = "".join(cells)
+        tag = "[b red]CLIP[/]" if clip else "    "
+        return f"{label} {bar} {max(rms_db, self.FLOOR_DB):6.1f} dB {tag}"
@@ -11,6 +11,7 @@ from textual.containers import Vertical, Horizontal
 from loguru import logger
 
 from tui.core.base_app import BotTUIBase
+from tui.widgets.level_meter import LevelMeter
 from tui.widgets.text_list_panel import TextListPanel
 from tui.core.utils.imports import import_bot_module
 
@@ -20,6 +21,7 @@ class DictationTUI(BotTUIBase):
 
     Layout:
     - Status bar
+    - Mic/speaker level meter
     - Main split (1fr): left Dictated, right Sent
     - Messages list (6 rows)
     Overlays:
@@ -60,6 +62,7 @@ class DictationTUI(BotTUIBase):
         with Vertical(id="main"):
             self.status = Static("Status: initializing", id="status")
             yield self.status
+            yield LevelMeter(self.transport_mgr.levels, id="levels")
             with Horizontal(id="split"):
                 self.dictated = TextListPanel(id="dictated")
                 yield self.dictated